@@ -0,0 +1,389 @@
+//--------------------------------------------------------------------------------------
+// File: DescriptorRangeAllocatorTest.cpp
+//
+// DescriptorRangeAllocator against a shadow map that records who owns every index: random
+// allocations, frees, fences and growth must hand out only free indices, pick the best fit,
+// hold freed ranges until their fence completes, and report matching statistics.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "DescriptorRangeAllocator.h"
+#include "TestUtil.h"
+
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+    using IndexType = DescriptorRangeAllocator::IndexType;
+
+    void TestAllocateAndFree()
+    {
+        DescriptorRangeAllocator ranges(100, 4);
+
+        IndexType a, b, c, x;
+        CHECK(ranges.Allocate(10, a) && a == 4);
+        CHECK(ranges.Allocate(20, b) && b == 14);
+        CHECK(ranges.Allocate(5, c) && c == 34);
+
+        // The freed range is held until its fence completes
+        ranges.Free(b, 20);
+        CHECK(ranges.Allocate(60, x) && x == 39);
+        CHECK(!ranges.Allocate(2, x));
+        ranges.Submit(1);
+        ranges.Retire(0);
+        CHECK(!ranges.Allocate(2, x));
+        ranges.Retire(1);
+
+        auto stats = ranges.GetStatistics();
+        CHECK(stats.free == 21 && stats.freeRanges == 2 && stats.largestFreeRange == 20);
+        CHECK(stats.allocated == 75 && stats.pendingFree == 0);
+
+        // Best fit takes the single free descriptor at the end, not the 20 in the middle
+        CHECK(ranges.Allocate(1, x) && x == 99);
+
+        // Neighbouring frees coalesce
+        ranges.Free(a, 10);
+        ranges.Free(c, 5);
+        ranges.Submit(2);
+        ranges.Retire(2);
+        stats = ranges.GetStatistics();
+        CHECK(stats.freeRanges == 1 && stats.free == 35 && stats.largestFreeRange == 35);
+
+        ranges.Grow(200);
+        stats = ranges.GetStatistics();
+        CHECK(stats.capacity == 200 && stats.freeRanges == 2 && stats.free == 135);
+        CHECK(ranges.Allocate(100, x) && x == 100);
+    }
+
+    void TestInvalidUse()
+    {
+        bool caught = false;
+        try
+        {
+            DescriptorRangeAllocator ranges(4, 5);
+        }
+        catch (const std::out_of_range&)
+        {
+            caught = true;
+        }
+        CHECK(caught);
+
+        DescriptorRangeAllocator ranges(16, 2);
+        IndexType start;
+
+        caught = false;
+        try
+        {
+            ranges.Allocate(0, start);
+        }
+        catch (const std::invalid_argument&)
+        {
+            caught = true;
+        }
+        CHECK(caught);
+
+        // Reserved and out-of-range indices can't be freed
+        CHECK(ranges.Allocate(4, start) && start == 2);
+        for (auto range : { std::make_pair(0, 2), std::make_pair(14, 4), std::make_pair(2, 0) })
+        {
+            caught = false;
+            try
+            {
+                ranges.Free(IndexType(range.first), size_t(range.second));
+            }
+            catch (const std::out_of_range&)
+            {
+                caught = true;
+            }
+            CHECK(caught);
+        }
+
+        // Freeing a free range is caught once it would return to the free list
+        ranges.Free(10, 2);
+        ranges.Submit(1);
+        caught = false;
+        try
+        {
+            ranges.Retire(1);
+        }
+        catch (const std::logic_error&)
+        {
+            caught = true;
+        }
+        CHECK(caught);
+    }
+
+    //----------------------------------------------------------------------------------
+    // The state of every index, kept independently of the allocator.
+    class ShadowMap
+    {
+    public:
+        ShadowMap(size_t capacity, size_t reserve)
+            : mOwner(capacity, Unowned)
+            , mReserve(reserve)
+        {
+            std::fill(mOwner.begin(), mOwner.begin() + ptrdiff_t(reserve), Reserved);
+        }
+
+        void Allocate(IndexType start, size_t count, int owner)
+        {
+            CHECK(start >= mReserve && start + count <= mOwner.size());
+            for (size_t i = start; i < start + count; ++i)
+            {
+                CHECK(mOwner[i] == Unowned);
+                mOwner[i] = owner;
+            }
+        }
+
+        void Free(IndexType start, size_t count, int owner)
+        {
+            for (size_t i = start; i < start + count; ++i)
+            {
+                CHECK(mOwner[i] == owner);
+                mOwner[i] = Pending;
+            }
+            mPending.push_back({ start, count, 0 });
+        }
+
+        void Submit(uint64_t fenceValue)
+        {
+            for (auto& range : mPending)
+            {
+                if (range.fenceValue == 0)
+                {
+                    range.fenceValue = fenceValue;
+                }
+            }
+        }
+
+        void Retire(uint64_t completedFenceValue)
+        {
+            auto it = mPending.begin();
+            while (it != mPending.end())
+            {
+                if (it->fenceValue != 0 && it->fenceValue <= completedFenceValue)
+                {
+                    std::fill(mOwner.begin() + ptrdiff_t(it->start), mOwner.begin() + ptrdiff_t(it->start + it->count), Unowned);
+                    it = mPending.erase(it);
+                }
+                else
+                {
+                    ++it;
+                }
+            }
+        }
+
+        void Grow(size_t newCapacity)
+        {
+            mOwner.resize(std::max(newCapacity, mOwner.size()), Unowned);
+        }
+
+        // The smallest run of free indices that holds count, lowest start first. Returns
+        // false when there is none.
+        bool FindBestFit(size_t count, IndexType& start) const
+        {
+            size_t bestCount = 0;
+            for (auto& run : GetFreeRuns())
+            {
+                if (run.second >= count && (bestCount == 0 || run.second < bestCount))
+                {
+                    start = run.first;
+                    bestCount = run.second;
+                }
+            }
+            return bestCount != 0;
+        }
+
+        void CheckStatistics(DescriptorPileStatistics const& stats) const
+        {
+            size_t allocated = 0;
+            size_t pending = 0;
+            for (int owner : mOwner)
+            {
+                if (owner > 0)
+                    allocated++;
+                else if (owner == Pending)
+                    pending++;
+            }
+
+            size_t free = 0;
+            size_t largest = 0;
+            const auto runs = GetFreeRuns();
+            for (auto& run : runs)
+            {
+                free += run.second;
+                largest = std::max(largest, run.second);
+            }
+
+            CHECK(stats.capacity == mOwner.size());
+            CHECK(stats.reserved == mReserve);
+            CHECK(stats.allocated == allocated);
+            CHECK(stats.pendingFree == pending);
+            CHECK(stats.free == free);
+            CHECK(stats.freeRanges == runs.size());
+            CHECK(stats.largestFreeRange == largest);
+        }
+
+    private:
+        static constexpr int Unowned = 0;
+        static constexpr int Reserved = -1;
+        static constexpr int Pending = -2;
+
+        struct PendingRange
+        {
+            IndexType start;
+            size_t count;
+            uint64_t fenceValue;
+        };
+
+        // Maximal runs of free indices, as (start, count)
+        std::vector<std::pair<IndexType, size_t>> GetFreeRuns() const
+        {
+            std::vector<std::pair<IndexType, size_t>> runs;
+            for (size_t i = 0; i < mOwner.size(); ++i)
+            {
+                if (mOwner[i] != Unowned)
+                    continue;
+
+                if (i > 0 && mOwner[i - 1] == Unowned)
+                {
+                    runs.back().second++;
+                }
+                else
+                {
+                    runs.emplace_back(i, 1);
+                }
+            }
+            return runs;
+        }
+
+        std::vector<int> mOwner; // Owner id, or Unowned, Reserved or Pending
+        size_t mReserve;
+        std::vector<PendingRange> mPending;
+    };
+
+    struct LiveRange
+    {
+        IndexType start;
+        size_t count;
+        int owner;
+    };
+
+    void TestAgainstShadowMap(uint32_t seed)
+    {
+        constexpr size_t Reserve = 7;
+        constexpr size_t MaxCapacity = 4096;
+        constexpr uint64_t GpuLatency = 3;
+
+        std::mt19937 random(seed);
+
+        size_t capacity = 512;
+        DescriptorRangeAllocator ranges(capacity, Reserve);
+        ShadowMap shadow(capacity, Reserve);
+
+        std::vector<LiveRange> live;
+        int nextOwner = 1;
+        uint64_t fenceValue = 0;
+        size_t failedAllocations = 0;
+
+        for (int step = 0; step < 40000; ++step)
+        {
+            const uint32_t op = random() % 100;
+            if (op < 50)
+            {
+                // Mostly single descriptors and small tables, now and then a large one
+                const size_t count = (random() % 20 == 0) ? 32 + random() % 200 : 1 + random() % 8;
+
+                IndexType expected = 0;
+                const bool fits = shadow.FindBestFit(count, expected);
+
+                IndexType start = 0;
+                const bool allocated = ranges.Allocate(count, start);
+                CHECK(allocated == fits);
+                if (allocated)
+                {
+                    CHECK(start == expected);
+                    shadow.Allocate(start, count, nextOwner);
+                    live.push_back({ start, count, nextOwner++ });
+                }
+                else
+                {
+                    failedAllocations++;
+                }
+            }
+            else if (op < 92)
+            {
+                if (!live.empty())
+                {
+                    const size_t index = random() % live.size();
+                    const LiveRange range = live[index];
+                    live[index] = live.back();
+                    live.pop_back();
+
+                    shadow.Free(range.start, range.count, range.owner);
+                    ranges.Free(range.start, range.count);
+                }
+            }
+            else if (op < 99)
+            {
+                // End of a frame; the GPU finishes frames GpuLatency behind
+                fenceValue++;
+                ranges.Submit(fenceValue);
+                shadow.Submit(fenceValue);
+
+                const uint64_t completed = (fenceValue > GpuLatency) ? fenceValue - GpuLatency : 0;
+                ranges.Retire(completed);
+                shadow.Retire(completed);
+            }
+            else if (capacity < MaxCapacity)
+            {
+                capacity += 1 + random() % capacity;
+                capacity = std::min(capacity, MaxCapacity);
+                ranges.Grow(capacity);
+                shadow.Grow(capacity);
+                CHECK(ranges.Capacity() == capacity);
+            }
+
+            shadow.CheckStatistics(ranges.GetStatistics());
+        }
+
+        // The run must have exercised both full and growing piles
+        CHECK(failedAllocations > 0);
+        CHECK(capacity > 512);
+
+        // Once everything is freed and retired the pile is one free range again
+        for (auto& range : live)
+        {
+            shadow.Free(range.start, range.count, range.owner);
+            ranges.Free(range.start, range.count);
+        }
+        fenceValue++;
+        ranges.Submit(fenceValue);
+        shadow.Submit(fenceValue);
+        ranges.Retire(fenceValue);
+        shadow.Retire(fenceValue);
+        shadow.CheckStatistics(ranges.GetStatistics());
+
+        const auto stats = ranges.GetStatistics();
+        CHECK(stats.freeRanges == 1 && stats.free == capacity - Reserve);
+    }
+}
+
+int main()
+{
+    TestAllocateAndFree();
+    TestInvalidUse();
+    for (uint32_t seed = 1; seed <= 4; ++seed)
+    {
+        TestAgainstShadowMap(seed);
+    }
+    std::printf("DescriptorRangeAllocatorTest passed\n");
+    return 0;
+}
@@ -0,0 +1,290 @@
+//--------------------------------------------------------------------------------------
+// File: GraphicsMemoryTelemetryTest.cpp
+//
+// GraphicsMemory allocation telemetry on the mock device: per-tag counts, alignment waste,
+// per-frame peaks and the size histogram, and the JSON and CSV reports built from them.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "GraphicsMemory.h"
+#include "TestUtil.h"
+
+#include <cstring>
+#include <sstream>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    constexpr size_t BucketCount = GraphicsMemoryTagStatistics::SizeHistogramBuckets;
+
+    // A tag outside the Tag enumeration, counted as TAG_GENERIC
+    constexpr uint32_t UnknownTag = 100;
+
+    struct ExpectedStatistics
+    {
+        size_t allocations;
+        size_t bytes;
+        size_t alignmentWaste;
+        size_t peakFrameAllocations;
+        size_t peakFrameBytes;
+        std::vector<std::pair<size_t, size_t>> buckets; // (bucket, count), all others are 0
+    };
+
+    void CheckStatistics(GraphicsMemoryTagStatistics const& stats, ExpectedStatistics const& expected)
+    {
+        CHECK(stats.allocations == expected.allocations);
+        CHECK(stats.bytes == expected.bytes);
+        CHECK(stats.alignmentWaste == expected.alignmentWaste);
+        CHECK(stats.peakFrameAllocations == expected.peakFrameAllocations);
+        CHECK(stats.peakFrameBytes == expected.peakFrameBytes);
+
+        size_t histogram[BucketCount] = {};
+        for (auto& bucket : expected.buckets)
+        {
+            histogram[bucket.first] = bucket.second;
+        }
+        for (size_t i = 0; i < BucketCount; ++i)
+        {
+            CHECK(stats.sizeHistogram[i] == histogram[i]);
+        }
+    }
+
+    void CheckEmpty(GraphicsMemory const& memory)
+    {
+        for (uint32_t tag = 0; tag < GraphicsMemory::TAG_COUNT; ++tag)
+        {
+            CheckStatistics(memory.GetTagStatistics(tag), {});
+        }
+        CheckStatistics(memory.GetTagStatistics(UnknownTag), {});
+    }
+
+    // The number after "key": in the JSON object of the given tag.
+    size_t ReadJSONValue(std::string const& json, const char* tagName, const char* key)
+    {
+        const size_t object = json.find(std::string("\"tag\": \"") + tagName + "\"");
+        CHECK(object != std::string::npos);
+        const size_t end = json.find('}', object);
+        const size_t value = json.find(std::string("\"") + key + "\": ", object);
+        CHECK(value != std::string::npos && value < end);
+        return std::stoull(json.substr(value + std::strlen(key) + 4));
+    }
+
+    std::vector<size_t> ReadJSONHistogram(std::string const& json, const char* tagName)
+    {
+        const size_t object = json.find(std::string("\"tag\": \"") + tagName + "\"");
+        CHECK(object != std::string::npos);
+        const size_t first = json.find("\"sizeHistogram\": [", object);
+        CHECK(first != std::string::npos);
+        const size_t last = json.find(']', first);
+        CHECK(last != std::string::npos && last < json.find('}', object));
+
+        std::vector<size_t> histogram;
+        std::istringstream values(json.substr(first + 18, last - first - 18));
+        std::string value;
+        while (std::getline(values, value, ','))
+        {
+            histogram.push_back(std::stoull(value));
+        }
+        return histogram;
+    }
+
+    std::vector<std::string> SplitCSV(std::string const& line)
+    {
+        std::vector<std::string> fields;
+        std::istringstream values(line);
+        std::string value;
+        while (std::getline(values, value, ','))
+        {
+            fields.push_back(value);
+        }
+        return fields;
+    }
+
+    void CheckJSON(GraphicsMemory const& memory, size_t frames)
+    {
+        static const char* s_tagNames[GraphicsMemory::TAG_COUNT] =
+        {
+            "generic", "constant", "vertex", "index", "sprites", "texture", "compute"
+        };
+
+        const std::string json = memory.GetTelemetryJSON();
+        CHECK(json.compare(0, 14, "{\n  \"frames\": ") == 0);
+        CHECK(std::stoull(json.substr(14)) == frames);
+        CHECK(json.size() >= 6 && json.compare(json.size() - 6, 6, "  ]\n}\n") == 0);
+        CHECK(std::count(json.begin(), json.end(), '{') == GraphicsMemory::TAG_COUNT + 1);
+        CHECK(std::count(json.begin(), json.end(), '{') == std::count(json.begin(), json.end(), '}'));
+
+        for (uint32_t tag = 0; tag < GraphicsMemory::TAG_COUNT; ++tag)
+        {
+            const auto stats = memory.GetTagStatistics(tag);
+            const char* name = s_tagNames[tag];
+            CHECK(ReadJSONValue(json, name, "allocations") == stats.allocations);
+            CHECK(ReadJSONValue(json, name, "bytes") == stats.bytes);
+            CHECK(ReadJSONValue(json, name, "alignmentWaste") == stats.alignmentWaste);
+            CHECK(ReadJSONValue(json, name, "peakFrameAllocations") == stats.peakFrameAllocations);
+            CHECK(ReadJSONValue(json, name, "peakFrameBytes") == stats.peakFrameBytes);
+
+            const auto histogram = ReadJSONHistogram(json, name);
+            CHECK(histogram.size() == BucketCount);
+            for (size_t i = 0; i < BucketCount; ++i)
+            {
+                CHECK(histogram[i] == stats.sizeHistogram[i]);
+            }
+        }
+    }
+
+    void CheckCSV(GraphicsMemory const& memory)
+    {
+        static const char* s_tagNames[GraphicsMemory::TAG_COUNT] =
+        {
+            "generic", "constant", "vertex", "index", "sprites", "texture", "compute"
+        };
+
+        std::istringstream csv(memory.GetTelemetryCSV());
+        std::string line;
+
+        CHECK(std::getline(csv, line));
+        const auto header = SplitCSV(line);
+        CHECK(header.size() == 6 + BucketCount);
+        CHECK(header[0] == "tag" && header[1] == "allocations" && header[2] == "bytes");
+        CHECK(header[3] == "alignment_waste" && header[4] == "peak_frame_allocations" && header[5] == "peak_frame_bytes");
+        CHECK(header[6] == "size_le_1");
+        CHECK(header[7] == "size_le_2");
+        CHECK(header[8] == "size_le_4");
+        CHECK(header[6 + 30] == "size_le_1073741824");
+        CHECK(header[6 + 31] == "size_gt_1073741824");
+
+        for (uint32_t tag = 0; tag < GraphicsMemory::TAG_COUNT; ++tag)
+        {
+            CHECK(std::getline(csv, line));
+            const auto row = SplitCSV(line);
+            CHECK(row.size() == header.size());
+
+            const auto stats = memory.GetTagStatistics(tag);
+            CHECK(row[0] == s_tagNames[tag]);
+            CHECK(std::stoull(row[1]) == stats.allocations);
+            CHECK(std::stoull(row[2]) == stats.bytes);
+            CHECK(std::stoull(row[3]) == stats.alignmentWaste);
+            CHECK(std::stoull(row[4]) == stats.peakFrameAllocations);
+            CHECK(std::stoull(row[5]) == stats.peakFrameBytes);
+            for (size_t i = 0; i < BucketCount; ++i)
+            {
+                CHECK(std::stoull(row[6 + i]) == stats.sizeHistogram[i]);
+            }
+        }
+        CHECK(!std::getline(csv, line));
+    }
+
+    // The pools only serve allocations up to 2GB, so the buckets past that are checked on
+    // the mapping itself rather than through Allocate.
+    void TestHistogramBuckets()
+    {
+        CHECK(GraphicsMemoryTagStatistics::GetSizeHistogramBucket(0) == 0);
+        CHECK(GraphicsMemoryTagStatistics::GetSizeHistogramBucket(1) == 0);
+        CHECK(GraphicsMemoryTagStatistics::GetSizeHistogramBucket(2) == 1);
+        CHECK(GraphicsMemoryTagStatistics::GetSizeHistogramBucket(3) == 2);
+        CHECK(GraphicsMemoryTagStatistics::GetSizeHistogramBucket(4) == 2);
+        CHECK(GraphicsMemoryTagStatistics::GetSizeHistogramBucket(5) == 3);
+        CHECK(GraphicsMemoryTagStatistics::GetSizeHistogramBucket(size_t(1) << 30) == 30);
+
+        // The last bucket is open-ended
+        CHECK(GraphicsMemoryTagStatistics::GetSizeHistogramBucket((size_t(1) << 30) + 1) == 31);
+        CHECK(GraphicsMemoryTagStatistics::GetSizeHistogramBucket(size_t(1) << 31) == 31);
+        CHECK(GraphicsMemoryTagStatistics::GetSizeHistogramBucket((size_t(1) << 31) + 1) == 31);
+        CHECK(GraphicsMemoryTagStatistics::GetSizeHistogramBucket(SIZE_MAX) == 31);
+    }
+
+    void TestTelemetry()
+    {
+        ComPtr<ID3D12Device> device;
+        device.Attach(new ID3D12Device);
+        ComPtr<ID3D12CommandQueue> queue;
+        queue.Attach(new ID3D12CommandQueue(1));
+
+        {
+            GraphicsMemory memory(device.Get());
+            CHECK(!memory.IsTelemetryEnabled());
+            memory.SetTelemetryEnabled(true);
+            CHECK(memory.IsTelemetryEnabled());
+            CheckEmpty(memory);
+
+            // Frame 1. The first four share the fresh page of the smallest pool: a 1 byte
+            // allocation leaves the next 256 byte boundary 255 bytes away, and the 3 byte one
+            // skips 2 bytes to the next DWORD.
+            std::vector<GraphicsResource> resources;
+            resources.push_back(memory.Allocate(1, 16, GraphicsMemory::TAG_VERTEX));
+            resources.push_back(memory.Allocate(16, 256, GraphicsMemory::TAG_VERTEX));
+            resources.push_back(memory.Allocate(2, 4, GraphicsMemory::TAG_CONSTANT));
+            resources.push_back(memory.Allocate(3, 4, GraphicsMemory::TAG_CONSTANT));
+            resources.push_back(memory.Allocate(3000, 4, UnknownTag));
+            CHECK(resources[1].GpuAddress() - resources[0].GpuAddress() == 256);
+            CHECK(resources[3].GpuAddress() - resources[1].GpuAddress() == 20);
+
+            // The frame in progress counts towards the peaks
+            CheckStatistics(memory.GetTagStatistics(GraphicsMemory::TAG_VERTEX), { 2, 17, 255, 2, 17, { { 0, 1 }, { 4, 1 } } });
+            CheckStatistics(memory.GetTagStatistics(GraphicsMemory::TAG_CONSTANT), { 2, 5, 2, 2, 5, { { 1, 1 }, { 2, 1 } } });
+            CheckStatistics(memory.GetTagStatistics(GraphicsMemory::TAG_GENERIC), { 1, 3000, 0, 1, 3000, { { 12, 1 } } });
+            CheckStatistics(memory.GetTagStatistics(UnknownTag), { 1, 3000, 0, 1, 3000, { { 12, 1 } } });
+            CheckStatistics(memory.GetTagStatistics(GraphicsMemory::TAG_INDEX), {});
+            CheckJSON(memory, 0);
+
+            resources.clear();
+            memory.Commit(queue.Get());
+            queue->EndFrame();
+
+            // Frame 2: more vertex allocations, fewer but larger constant ones, nothing generic.
+            // These come from fresh pages of a larger pool, so nothing is skipped.
+            for (int i = 0; i < 3; ++i)
+            {
+                resources.push_back(memory.Allocate(5000, 4, GraphicsMemory::TAG_VERTEX));
+            }
+            resources.push_back(memory.Allocate(6000, 4, GraphicsMemory::TAG_CONSTANT));
+            resources.clear();
+            memory.Commit(queue.Get());
+            queue->EndFrame();
+
+            // Each peak is the largest frame for that counter, which for constants means the
+            // allocation count of frame 1 and the bytes of frame 2
+            CheckStatistics(memory.GetTagStatistics(GraphicsMemory::TAG_VERTEX), { 5, 15017, 255, 3, 15000, { { 0, 1 }, { 4, 1 }, { 13, 3 } } });
+            CheckStatistics(memory.GetTagStatistics(GraphicsMemory::TAG_CONSTANT), { 3, 6005, 2, 2, 6000, { { 1, 1 }, { 2, 1 }, { 13, 1 } } });
+            CheckStatistics(memory.GetTagStatistics(GraphicsMemory::TAG_GENERIC), { 1, 3000, 0, 1, 3000, { { 12, 1 } } });
+            for (uint32_t tag = GraphicsMemory::TAG_INDEX; tag < GraphicsMemory::TAG_COUNT; ++tag)
+            {
+                CheckStatistics(memory.GetTagStatistics(tag), {});
+            }
+            CheckJSON(memory, 2);
+            CheckCSV(memory);
+
+            // Reset clears every counter, including the peaks and the frame count
+            memory.ResetStatistics();
+            CheckEmpty(memory);
+            CheckJSON(memory, 0);
+            CheckCSV(memory);
+
+            // Nothing is recorded while telemetry is off
+            memory.SetTelemetryEnabled(false);
+            std::ignore = memory.Allocate(64, 16, GraphicsMemory::TAG_SPRITES);
+            memory.Commit(queue.Get());
+            queue->EndFrame();
+            CheckEmpty(memory);
+            CheckJSON(memory, 0);
+
+            queue->Flush();
+        }
+    }
+}
+
+int main()
+{
+    TestHistogramBuckets();
+    TestTelemetry();
+    std::printf("GraphicsMemoryTelemetryTest passed\n");
+    return 0;
+}
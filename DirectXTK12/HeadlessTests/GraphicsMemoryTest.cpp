@@ -0,0 +1,273 @@
+//--------------------------------------------------------------------------------------
+// File: GraphicsMemoryTest.cpp
+//
+// GraphicsMemory on the mock device: allocations are aligned and never overlap, also when
+// many threads allocate while another commits, and pages cached by a thread are only fenced
+// once the thread lets go of them.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "GraphicsMemory.h"
+#include "TestUtil.h"
+
+#include <condition_variable>
+#include <random>
+#include <thread>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    constexpr size_t PageSize = 64 * 1024;
+
+    ComPtr<ID3D12Device> CreateDevice()
+    {
+        ComPtr<ID3D12Device> device;
+        device.Attach(new ID3D12Device);
+        return device;
+    }
+
+    // Fills an allocation with a pattern that CheckPattern can verify later.
+    void FillPattern(GraphicsResource const& resource, uint32_t seed) noexcept
+    {
+        auto bytes = static_cast<uint8_t*>(resource.Memory());
+        for (size_t i = 0; i < resource.Size(); ++i)
+        {
+            bytes[i] = static_cast<uint8_t>(seed + i * 7);
+        }
+    }
+
+    bool CheckPattern(GraphicsResource const& resource, uint32_t seed) noexcept
+    {
+        auto bytes = static_cast<const uint8_t*>(resource.Memory());
+        for (size_t i = 0; i < resource.Size(); ++i)
+        {
+            if (bytes[i] != static_cast<uint8_t>(seed + i * 7))
+                return false;
+        }
+        return true;
+    }
+
+    void CheckResource(GraphicsResource const& resource, size_t size, size_t alignment)
+    {
+        CHECK(resource);
+        CHECK(resource.Size() == size);
+        CHECK(resource.GpuAddress() % alignment == 0);
+        CHECK(reinterpret_cast<uintptr_t>(resource.Memory()) % alignment == 0);
+        CHECK(resource.GpuAddress() == resource.Resource()->GetGPUVirtualAddress() + resource.ResourceOffset());
+    }
+
+    // Live allocations must not share any bytes.
+    void CheckNoOverlap(std::vector<GraphicsResource> const& resources)
+    {
+        std::vector<std::pair<D3D12_GPU_VIRTUAL_ADDRESS, size_t>> ranges;
+        ranges.reserve(resources.size());
+        for (auto& resource : resources)
+        {
+            ranges.emplace_back(resource.GpuAddress(), resource.Size());
+        }
+        std::sort(ranges.begin(), ranges.end());
+        for (size_t i = 1; i < ranges.size(); ++i)
+        {
+            CHECK(ranges[i - 1].first + ranges[i - 1].second <= ranges[i].first);
+        }
+    }
+
+    void TestAllocate()
+    {
+        auto device = CreateDevice();
+        ComPtr<ID3D12CommandQueue> queue;
+        queue.Attach(new ID3D12CommandQueue(1));
+
+        {
+            GraphicsMemory memory(device.Get());
+
+            std::mt19937 random(3);
+            for (int frame = 0; frame < 8; ++frame)
+            {
+                std::vector<GraphicsResource> resources;
+                for (int i = 0; i < 500; ++i)
+                {
+                    // Mostly small requests that share pages, with the odd large one
+                    const size_t size = (i % 50 == 0) ? 40000 + random() % 100000 : 1 + random() % 3000;
+                    const size_t alignment = size_t(4) << (random() % 7);
+
+                    resources.push_back(memory.Allocate(size, alignment));
+                    CheckResource(resources.back(), size, alignment);
+                    FillPattern(resources.back(), uint32_t(i));
+                }
+
+                auto constant = memory.AllocateConstant<std::array<float, 20>>();
+                CheckResource(constant, 256, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+                resources.push_back(std::move(constant));
+
+                CheckNoOverlap(resources);
+                for (size_t i = 0; i < 500; ++i)
+                {
+                    CHECK(CheckPattern(resources[i], uint32_t(i)));
+                }
+
+                resources.clear();
+                memory.Commit(queue.Get());
+                queue->EndFrame();
+            }
+
+            // Pages are recycled once the GPU is done with them, so a steady workload stops
+            // creating pages after a few frames
+            size_t pageCount = 0;
+            for (int frame = 0; frame < 12; ++frame)
+            {
+                if (frame == 4)
+                {
+                    pageCount = device->ResourceCount();
+                }
+                for (int i = 0; i < 500; ++i)
+                {
+                    std::ignore = memory.Allocate(1 + size_t(i) * 5, 16);
+                }
+                memory.Commit(queue.Get());
+                queue->EndFrame();
+            }
+            CHECK(device->ResourceCount() == pageCount);
+
+            queue->Flush();
+        }
+    }
+
+    // Workers allocate and fill allocations while the main thread commits frames.
+    void TestThreads()
+    {
+        constexpr int ThreadCount = 8;
+        constexpr int AllocationsPerBatch = 200;
+        constexpr int BatchCount = 50;
+
+        auto device = CreateDevice();
+        ComPtr<ID3D12CommandQueue> queue;
+        queue.Attach(new ID3D12CommandQueue(1));
+
+        {
+            GraphicsMemory memory(device.Get());
+
+            std::atomic<int> running(ThreadCount);
+            std::vector<std::thread> threads;
+            for (int t = 0; t < ThreadCount; ++t)
+            {
+                threads.emplace_back([&memory, &running, t]()
+                {
+                    std::mt19937 random(static_cast<uint32_t>(t));
+                    for (int batch = 0; batch < BatchCount; ++batch)
+                    {
+                        std::vector<GraphicsResource> resources;
+                        for (int i = 0; i < AllocationsPerBatch; ++i)
+                        {
+                            const size_t size = 16 + random() % 2000;
+                            resources.push_back(memory.Allocate(size, 16));
+                            FillPattern(resources.back(), uint32_t(t * 1000 + i));
+                        }
+                        for (int i = 0; i < AllocationsPerBatch; ++i)
+                        {
+                            CHECK(CheckPattern(resources[size_t(i)], uint32_t(t * 1000 + i)));
+                        }
+                    }
+                    running--;
+                });
+            }
+
+            while (running > 0)
+            {
+                memory.Commit(queue.Get());
+                queue->EndFrame();
+                std::this_thread::yield();
+            }
+
+            for (auto& thread : threads)
+            {
+                thread.join();
+            }
+
+            queue->Flush();
+        }
+    }
+
+    // A thread that stops allocating keeps its page out of the fences until it calls
+    // ReleaseThreadPages (or exits).
+    void TestReleaseThreadPages()
+    {
+        auto device = CreateDevice();
+        ComPtr<ID3D12CommandQueue> queue;
+        queue.Attach(new ID3D12CommandQueue(0));
+
+        {
+            GraphicsMemory memory(device.Get());
+
+            std::mutex mutex;
+            std::condition_variable changed;
+            int step = 0;
+            auto waitFor = [&](int value)
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&]() { return step == value; });
+            };
+            auto advance = [&]()
+            {
+                const std::lock_guard<std::mutex> lock(mutex);
+                step++;
+                changed.notify_all();
+            };
+
+            std::thread worker([&]()
+            {
+                std::ignore = memory.Allocate(1024, 256);
+                advance();
+
+                // Idle until asked to let go of the page
+                waitFor(2);
+                memory.ReleaseThreadPages();
+                advance();
+
+                waitFor(4);
+            });
+
+            waitFor(1);
+            const size_t pageCount = device->ResourceCount();
+
+            // The worker's page is still referenced, so it is not fenced
+            memory.Commit(queue.Get());
+            CHECK(memory.GetStatistics().committedMemory == 0);
+            memory.Commit(queue.Get());
+            CHECK(memory.GetStatistics().committedMemory == 0);
+
+            advance();
+            waitFor(3);
+
+            memory.Commit(queue.Get());
+            CHECK(memory.GetStatistics().committedMemory == PageSize);
+
+            // Once the GPU passes the fence the page is reused rather than a new one created
+            queue->EndFrame();
+            memory.Commit(queue.Get());
+            CHECK(memory.GetStatistics().committedMemory == 0);
+            std::ignore = memory.Allocate(1024, 256);
+            CHECK(device->ResourceCount() == pageCount);
+
+            advance();
+            worker.join();
+            queue->Flush();
+        }
+    }
+}
+
+int main()
+{
+    TestAllocate();
+    TestThreads();
+    TestReleaseThreadPages();
+    std::printf("GraphicsMemoryTest passed\n");
+    return 0;
+}
@@ -0,0 +1,345 @@
+//--------------------------------------------------------------------------------------
+// File: LinearAllocatorBenchmark.cpp
+//
+// Allocations per second for LinearAllocator on the mock device against
+// PreviousLinearAllocator, a copy of the page handling it replaced: a first-fit scan of the
+// used pages for every sub-page request, and one fence signal per page.
+//
+// Both allocators see the same requests. Each frame makes a set number of requests, then
+// retires and fences pages on a queue that runs two frames behind, as GraphicsMemory::Commit
+// does. The mock device creates pages in system memory, so the numbers show the page
+// handling itself; a real device adds the cost of each Signal and page creation.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "DirectXHelpers.h"
+#include "LinearAllocator.h"
+#include "PlatformHelpers.h"
+#include "TestUtil.h"
+
+#include <random>
+
+using namespace DirectX;
+using Microsoft::WRL::ComPtr;
+
+namespace
+{
+    constexpr size_t PageSize = 64 * 1024;
+    constexpr size_t FrameCount = 60;
+
+    //----------------------------------------------------------------------------------
+    // LinearAllocator before the current page, reduced to what the benchmark calls. Keep
+    // it as it was so the comparison stays meaningful.
+    class PreviousLinearAllocator
+    {
+    public:
+        PreviousLinearAllocator(_In_ ID3D12Device* device, size_t pageSize)
+            : mPendingPages(nullptr)
+            , mUsedPages(nullptr)
+            , mUnusedPages(nullptr)
+            , mIncrement(pageSize)
+            , mTotalPages(0)
+            , mFenceCount(0)
+            , mDevice(device)
+        {
+            ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_GRAPHICS_PPV_ARGS(mFence.ReleaseAndGetAddressOf())));
+        }
+
+        PreviousLinearAllocator(PreviousLinearAllocator const&) = delete;
+        PreviousLinearAllocator& operator= (PreviousLinearAllocator const&) = delete;
+
+        ~PreviousLinearAllocator()
+        {
+            while (mPendingPages != nullptr)
+            {
+                RetirePendingPages();
+            }
+            FreePages(mUnusedPages);
+            FreePages(mUsedPages);
+        }
+
+        void* Allocate(size_t size, size_t alignment)
+        {
+            Page* page = GetPageForAlloc(size, alignment);
+            if (!page)
+                throw std::bad_alloc();
+
+            const size_t offset = page->Suballocate(size, alignment);
+            return static_cast<BYTE*>(page->BaseMemory()) + offset;
+        }
+
+        void RetirePendingPages() noexcept
+        {
+            const uint64_t fenceValue = mFence->GetCompletedValue();
+            for (Page* page = mPendingPages; page != nullptr;)
+            {
+                Page* nextPage = page->next;
+                if (fenceValue >= page->pendingFence)
+                {
+                    Unlink(page);
+                    Link(page, mUnusedPages);
+                    page->Recycle();
+                }
+                page = nextPage;
+            }
+        }
+
+        // Every used page is fenced: the benchmark holds no references to them.
+        void FenceCommittedPages(_In_ ID3D12CommandQueue* commandQueue)
+        {
+            while (mUsedPages != nullptr)
+            {
+                Page* page = mUsedPages;
+                Unlink(page);
+                page->pendingFence = ++mFenceCount;
+                ThrowIfFailed(commandQueue->Signal(mFence.Get(), mFenceCount));
+                Link(page, mPendingPages);
+            }
+        }
+
+        size_t TotalPageCount() const noexcept { return mTotalPages; }
+
+    private:
+        // Suballocates as LinearAllocatorPage does, so only the page handling differs.
+        class Page : public LinearAllocatorPage
+        {
+        public:
+            Page(ComPtr<ID3D12Resource>& resource, _In_ void* memory, size_t size) noexcept
+            {
+                mMemory = memory;
+                mGpuAddress = resource->GetGPUVirtualAddress();
+                mSize = size;
+                mUploadResource.Swap(resource);
+            }
+
+            void Recycle() noexcept { mOffset = 0; }
+
+            Page* prev = nullptr;
+            Page* next = nullptr;
+            uint64_t pendingFence = 0;
+        };
+
+        Page* GetPageForAlloc(size_t sizeBytes, size_t alignment)
+        {
+            if (sizeBytes == mIncrement && (alignment == 0 || alignment == mIncrement))
+            {
+                return GetCleanPageForAlloc();
+            }
+
+            // Find a page in the used pages list that has space
+            for (Page* page = mUsedPages; page != nullptr; page = page->next)
+            {
+                const size_t offset = AlignUp(page->BytesUsed(), alignment);
+                if (offset + sizeBytes <= mIncrement)
+                    return page;
+            }
+
+            return GetCleanPageForAlloc();
+        }
+
+        Page* GetCleanPageForAlloc()
+        {
+            Page* page = mUnusedPages;
+            if (!page)
+            {
+                page = GetNewPage();
+            }
+
+            Unlink(page);
+            Link(page, mUsedPages);
+            return page;
+        }
+
+        Page* GetNewPage()
+        {
+            const CD3DX12_HEAP_PROPERTIES uploadHeapProperties(D3D12_HEAP_TYPE_UPLOAD);
+            const CD3DX12_RESOURCE_DESC bufferDesc = CD3DX12_RESOURCE_DESC::Buffer(mIncrement);
+
+            ComPtr<ID3D12Resource> resource;
+            ThrowIfFailed(mDevice->CreateCommittedResource(
+                &uploadHeapProperties,
+                D3D12_HEAP_FLAG_NONE,
+                &bufferDesc,
+                D3D12_RESOURCE_STATE_GENERIC_READ,
+                nullptr,
+                IID_GRAPHICS_PPV_ARGS(resource.ReleaseAndGetAddressOf())));
+
+            void* memory = nullptr;
+            ThrowIfFailed(resource->Map(0, nullptr, &memory));
+            memset(memory, 0, mIncrement);
+
+            auto page = new Page(resource, memory, mIncrement);
+            Link(page, mUnusedPages);
+            mTotalPages++;
+            return page;
+        }
+
+        void Unlink(Page* page) noexcept
+        {
+            if (page->prev)
+                page->prev->next = page->next;
+            else if (page == mUnusedPages)
+                mUnusedPages = page->next;
+            else if (page == mUsedPages)
+                mUsedPages = page->next;
+            else if (page == mPendingPages)
+                mPendingPages = page->next;
+
+            if (page->next)
+                page->next->prev = page->prev;
+
+            page->next = nullptr;
+            page->prev = nullptr;
+        }
+
+        static void Link(Page* page, Page*& list) noexcept
+        {
+            page->next = list;
+            if (list)
+                list->prev = page;
+            list = page;
+        }
+
+        static void FreePages(Page* page) noexcept
+        {
+            while (page != nullptr)
+            {
+                Page* nextPage = page->next;
+                delete page;
+                page = nextPage;
+            }
+        }
+
+        Page*                   mPendingPages;
+        Page*                   mUsedPages;
+        Page*                   mUnusedPages;
+        size_t                  mIncrement;
+        size_t                  mTotalPages;
+        uint64_t                mFenceCount;
+        ComPtr<ID3D12Device>    mDevice;
+        ComPtr<ID3D12Fence>     mFence;
+    };
+
+    // The current LinearAllocator, called the way GraphicsMemory calls it.
+    class CurrentLinearAllocator
+    {
+    public:
+        CurrentLinearAllocator(_In_ ID3D12Device* device, size_t pageSize)
+            : mAllocator(device, pageSize)
+        {
+        }
+
+        void* Allocate(size_t size, size_t alignment)
+        {
+            LinearAllocatorPage* page = mAllocator.FindPageForAlloc(size, alignment);
+            if (!page)
+                throw std::bad_alloc();
+
+            const size_t offset = page->Suballocate(size, alignment);
+            return static_cast<BYTE*>(page->BaseMemory()) + offset;
+        }
+
+        void RetirePendingPages() noexcept { mAllocator.RetirePendingPages(); }
+        void FenceCommittedPages(_In_ ID3D12CommandQueue* commandQueue) { mAllocator.FenceCommittedPages(commandQueue); }
+        size_t TotalPageCount() const noexcept { return mAllocator.TotalPageCount(); }
+
+    private:
+        LinearAllocator mAllocator;
+    };
+
+    struct Request
+    {
+        size_t size;
+        size_t alignment;
+    };
+
+    // Requests shaped like a frame of GraphicsMemory use: mostly constant buffers, some
+    // dynamic vertex and index data, and the odd larger upload.
+    std::vector<Request> MakeFrame(size_t count, uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::vector<Request> requests(count);
+        for (auto& request : requests)
+        {
+            const uint32_t kind = random() % 100;
+            if (kind < 60)
+            {
+                request = { 256, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT };
+            }
+            else if (kind < 95)
+            {
+                request = { 16 + random() % 4096, 16 };
+            }
+            else
+            {
+                request = { 4096 + random() % 28672, D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT };
+            }
+        }
+        return requests;
+    }
+
+    struct Result
+    {
+        double allocationsPerSecond;
+        size_t pages;
+        size_t signals;
+    };
+
+    template<typename Allocator>
+    Result Run(std::vector<Request> const& requests)
+    {
+        ComPtr<ID3D12Device> device;
+        device.Attach(new ID3D12Device);
+        ComPtr<ID3D12CommandQueue> queue;
+        queue.Attach(new ID3D12CommandQueue(2));
+
+        Result result = {};
+        {
+            Allocator allocator(device.Get(), PageSize);
+            const double seconds = MeasureSeconds([&]()
+            {
+                for (size_t frame = 0; frame < FrameCount; ++frame)
+                {
+                    for (size_t i = 0; i < requests.size(); ++i)
+                    {
+                        *static_cast<uint32_t*>(allocator.Allocate(requests[i].size, requests[i].alignment)) = uint32_t(i);
+                    }
+                    allocator.RetirePendingPages();
+                    allocator.FenceCommittedPages(queue.Get());
+                    queue->EndFrame();
+                }
+            });
+
+            result.allocationsPerSecond = double(requests.size() * FrameCount) / seconds;
+            result.pages = allocator.TotalPageCount();
+            result.signals = queue->SignalCount();
+            queue->Flush();
+        }
+        return result;
+    }
+}
+
+int main()
+{
+    std::printf("%zu frames, 64KB pages, queue two frames behind\n\n", FrameCount);
+    std::printf("allocs/frame   previous allocs/s   current allocs/s   speedup   pages (prev/cur)   signals (prev/cur)\n");
+
+    for (size_t count : { 100, 1000, 10000, 50000 })
+    {
+        const auto requests = MakeFrame(count, 7);
+        const Result previous = Run<PreviousLinearAllocator>(requests);
+        const Result current = Run<CurrentLinearAllocator>(requests);
+
+        std::printf("%12zu   %17.0f   %16.0f   %6.2fx   %8zu/%-7zu   %9zu/%zu\n",
+            count, previous.allocationsPerSecond, current.allocationsPerSecond,
+            current.allocationsPerSecond / previous.allocationsPerSecond,
+            previous.pages, current.pages, previous.signals, current.signals);
+    }
+
+    return 0;
+}
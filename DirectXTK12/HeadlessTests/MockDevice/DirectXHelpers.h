@@ -0,0 +1,54 @@
+//--------------------------------------------------------------------------------------
+// File: DirectXHelpers.h
+//
+// Stands in for Inc/DirectXHelpers.h in the tests, which would pull in DirectXMath and
+// the rest of the Direct3D headers. Keep these in step with the originals.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "d3d12.h"
+
+#include <cassert>
+#include <cstddef>
+
+#define IID_GRAPHICS_PPV_ARGS(x) IID_PPV_ARGS(x)
+
+namespace DirectX
+{
+    inline namespace DX12
+    {
+        template<typename T>
+        constexpr bool IsPowerOf2(T x) noexcept { return ((x != 0) && !(x & (x - 1))); }
+
+        // Helpers for aligning values by a power of 2
+        template<typename T>
+        inline T AlignDown(T size, size_t alignment) noexcept
+        {
+            if (alignment > 0)
+            {
+                assert(((alignment - 1) & alignment) == 0);
+                auto mask = static_cast<T>(alignment - 1);
+                return size & ~mask;
+            }
+            return size;
+        }
+
+        template<typename T>
+        inline T AlignUp(T size, size_t alignment) noexcept
+        {
+            if (alignment > 0)
+            {
+                assert(((alignment - 1) & alignment) == 0);
+                auto mask = static_cast<T>(alignment - 1);
+                return (size + mask) & ~mask;
+            }
+            return size;
+        }
+    }
+}
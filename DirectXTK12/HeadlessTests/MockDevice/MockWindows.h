@@ -0,0 +1,142 @@
+//--------------------------------------------------------------------------------------
+// File: MockWindows.h
+//
+// The few Windows types, macros and functions the library sources built by the tests
+// use, so they compile without the Windows SDK.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#ifndef _MSC_VER
+#ifndef __cdecl
+#define __cdecl
+#endif
+#endif
+
+// SAL annotations
+#ifndef _In_
+#define _In_
+#endif
+#ifndef _In_opt_
+#define _In_opt_
+#endif
+#ifndef _In_z_
+#define _In_z_
+#endif
+#ifndef _In_reads_
+#define _In_reads_(size)
+#endif
+#ifndef _Out_
+#define _Out_
+#endif
+#ifndef _Out_opt_
+#define _Out_opt_
+#endif
+#ifndef _Out_writes_
+#define _Out_writes_(size)
+#endif
+#ifndef _Inout_
+#define _Inout_
+#endif
+#ifndef _Inout_updates_
+#define _Inout_updates_(size)
+#endif
+#ifndef _Printf_format_string_
+#define _Printf_format_string_
+#endif
+#ifndef _Success_
+#define _Success_(expr)
+#endif
+
+using BYTE = uint8_t;
+using UINT = unsigned int;
+using UINT64 = uint64_t;
+using ULONG = unsigned long;
+using SIZE_T = size_t;
+using HRESULT = int32_t;
+using HANDLE = void*;
+using LPCWSTR = const wchar_t*;
+
+#define S_OK            static_cast<HRESULT>(0)
+#define E_FAIL          static_cast<HRESULT>(0x80004005L)
+#define E_INVALIDARG    static_cast<HRESULT>(0x80070057L)
+#define E_OUTOFMEMORY   static_cast<HRESULT>(0x8007000EL)
+
+#define SUCCEEDED(hr)   ((static_cast<HRESULT>(hr)) >= 0)
+#define FAILED(hr)      ((static_cast<HRESULT>(hr)) < 0)
+
+#define UNREFERENCED_PARAMETER(P) (void)(P)
+
+#define INVALID_HANDLE_VALUE reinterpret_cast<HANDLE>(-1)
+#define MEM_RELEASE 0x00008000
+
+// Nothing the tests build opens handles or reserves virtual memory.
+inline int CloseHandle(HANDLE) noexcept { return 1; }
+inline int VirtualFree(void*, SIZE_T, unsigned long) noexcept { return 1; }
+
+inline void OutputDebugStringA(const char* text) noexcept
+{
+    std::fputs(text, stderr);
+}
+
+#ifndef _MSC_VER
+template<size_t size>
+inline int sprintf_s(char (&buffer)[size], const char* format, ...) noexcept
+{
+    va_list args;
+    va_start(args, format);
+    const int result = std::vsnprintf(buffer, size, format, args);
+    va_end(args);
+    return result;
+}
+
+template<size_t size>
+inline int vsprintf_s(char (&buffer)[size], const char* format, va_list args) noexcept
+{
+    return std::vsnprintf(buffer, size, format, args);
+}
+#endif
+
+// COM objects are reference counted C++ objects. Interface ids are not needed, since every
+// creation method knows which object it makes.
+struct IID {};
+using REFIID = const IID&;
+
+#define IID_PPV_ARGS(ppType) IID{}, reinterpret_cast<void**>(ppType)
+
+class IUnknown
+{
+public:
+    IUnknown() noexcept : mRefCount(1) {}
+
+    IUnknown(IUnknown const&) = delete;
+    IUnknown& operator= (IUnknown const&) = delete;
+
+    virtual ~IUnknown() = default;
+
+    ULONG AddRef() noexcept { return ++mRefCount; }
+
+    ULONG Release() noexcept
+    {
+        const ULONG count = --mRefCount;
+        if (count == 0)
+        {
+            delete this;
+        }
+        return count;
+    }
+
+private:
+    std::atomic<ULONG> mRefCount;
+};
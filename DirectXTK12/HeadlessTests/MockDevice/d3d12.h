@@ -0,0 +1,286 @@
+//--------------------------------------------------------------------------------------
+// File: d3d12.h
+//
+// A mock Direct3D 12 device for the tests. It implements just the calls the library
+// sources built by the tests make: committed resources live in system memory, and the
+// command queue stands in for a GPU that runs a set number of frames behind the CPU.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include "MockWindows.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+
+using D3D12_GPU_VIRTUAL_ADDRESS = UINT64;
+
+#define D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT ( 256 )
+#define D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT ( 65536 )
+
+enum D3D12_HEAP_TYPE
+{
+    D3D12_HEAP_TYPE_DEFAULT = 1,
+    D3D12_HEAP_TYPE_UPLOAD = 2,
+    D3D12_HEAP_TYPE_READBACK = 3,
+};
+
+enum D3D12_HEAP_FLAGS
+{
+    D3D12_HEAP_FLAG_NONE = 0,
+};
+
+enum D3D12_RESOURCE_STATES
+{
+    D3D12_RESOURCE_STATE_COMMON = 0,
+    D3D12_RESOURCE_STATE_GENERIC_READ = 0xac3,
+};
+
+enum D3D12_RESOURCE_DIMENSION
+{
+    D3D12_RESOURCE_DIMENSION_UNKNOWN = 0,
+    D3D12_RESOURCE_DIMENSION_BUFFER = 1,
+};
+
+enum D3D12_RESOURCE_FLAGS
+{
+    D3D12_RESOURCE_FLAG_NONE = 0,
+};
+
+enum D3D12_FENCE_FLAGS
+{
+    D3D12_FENCE_FLAG_NONE = 0,
+};
+
+struct D3D12_HEAP_PROPERTIES
+{
+    D3D12_HEAP_TYPE Type;
+};
+
+struct D3D12_RESOURCE_DESC
+{
+    D3D12_RESOURCE_DIMENSION Dimension;
+    UINT64 Alignment;
+    UINT64 Width;
+    UINT Height;
+    uint16_t DepthOrArraySize;
+    uint16_t MipLevels;
+    D3D12_RESOURCE_FLAGS Flags;
+};
+
+struct D3D12_RANGE
+{
+    SIZE_T Begin;
+    SIZE_T End;
+};
+
+struct D3D12_CLEAR_VALUE {};
+
+class ID3D12Object : public IUnknown
+{
+public:
+    HRESULT SetName(LPCWSTR) noexcept { return S_OK; }
+};
+
+class ID3D12DeviceChild : public ID3D12Object {};
+class ID3D12Pageable : public ID3D12DeviceChild {};
+
+//--------------------------------------------------------------------------------------
+// A buffer in system memory, aligned like a committed resource. Its GPU virtual address
+// is made up by the device; it is unique and aligned the same way.
+class ID3D12Resource : public ID3D12Pageable
+{
+public:
+    ID3D12Resource(UINT64 size, D3D12_GPU_VIRTUAL_ADDRESS gpuAddress)
+        : mStorage(new BYTE[static_cast<size_t>(size) + D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT])
+        , mGpuAddress(gpuAddress)
+    {
+        const auto address = reinterpret_cast<uintptr_t>(mStorage.get());
+        const uintptr_t mask = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1;
+        mMemory = reinterpret_cast<BYTE*>((address + mask) & ~mask);
+    }
+
+    HRESULT Map(UINT, const D3D12_RANGE*, void** data) noexcept
+    {
+        if (data)
+        {
+            *data = mMemory;
+        }
+        return S_OK;
+    }
+
+    void Unmap(UINT, const D3D12_RANGE*) noexcept {}
+
+    D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const noexcept { return mGpuAddress; }
+
+private:
+    std::unique_ptr<BYTE[]> mStorage;
+    BYTE* mMemory;
+    D3D12_GPU_VIRTUAL_ADDRESS mGpuAddress;
+};
+
+//--------------------------------------------------------------------------------------
+class ID3D12Fence : public ID3D12Pageable
+{
+public:
+    explicit ID3D12Fence(UINT64 initialValue) noexcept : mCompletedValue(initialValue) {}
+
+    UINT64 GetCompletedValue() noexcept { return mCompletedValue.load(); }
+
+    // Sets the value from the CPU, as the mock queue does once the GPU reaches a signal.
+    HRESULT Signal(UINT64 value) noexcept
+    {
+        mCompletedValue.store(value);
+        return S_OK;
+    }
+
+private:
+    std::atomic<UINT64> mCompletedValue;
+};
+
+//--------------------------------------------------------------------------------------
+// The GPU behind this queue runs framesInFlight frames behind the CPU: a fence signaled
+// during a frame completes when EndFrame closes the frame framesInFlight frames later (0
+// completes it at the end of its own frame). Flush completes every pending signal, like
+// waiting for the GPU to idle; it must be called before destroying objects that wait on
+// their fences.
+class ID3D12CommandQueue : public ID3D12Pageable
+{
+public:
+    explicit ID3D12CommandQueue(UINT framesInFlight = 2) noexcept
+        : mFramesInFlight(framesInFlight)
+        , mFrame(0)
+        , mSignalCount(0)
+    {
+    }
+
+    ~ID3D12CommandQueue() override
+    {
+        Flush();
+    }
+
+    HRESULT Signal(_In_ ID3D12Fence* fence, UINT64 value)
+    {
+        if (!fence)
+            return E_INVALIDARG;
+
+        const std::lock_guard<std::mutex> lock(mMutex);
+        fence->AddRef();
+        mPending.push_back({ fence, value, mFrame });
+        mSignalCount++;
+        return S_OK;
+    }
+
+    void EndFrame()
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        mFrame++;
+        while (!mPending.empty() && mPending.front().frame + mFramesInFlight < mFrame)
+        {
+            Complete(mPending.front());
+            mPending.pop_front();
+        }
+    }
+
+    void Flush()
+    {
+        const std::lock_guard<std::mutex> lock(mMutex);
+        for (auto& signal : mPending)
+        {
+            Complete(signal);
+        }
+        mPending.clear();
+    }
+
+    size_t SignalCount() const noexcept { return mSignalCount; }
+
+private:
+    struct PendingSignal
+    {
+        ID3D12Fence* fence;
+        UINT64 value;
+        UINT64 frame;
+    };
+
+    static void Complete(PendingSignal const& signal) noexcept
+    {
+        if (signal.fence->GetCompletedValue() < signal.value)
+        {
+            signal.fence->Signal(signal.value);
+        }
+        signal.fence->Release();
+    }
+
+    std::mutex mMutex;
+    std::deque<PendingSignal> mPending;
+    UINT64 mFramesInFlight;
+    UINT64 mFrame;
+    size_t mSignalCount;
+};
+
+//--------------------------------------------------------------------------------------
+class ID3D12Device : public ID3D12Object
+{
+public:
+    ID3D12Device() noexcept
+        : mNextGpuAddress(D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)
+        , mResourceCount(0)
+    {
+    }
+
+    HRESULT CreateCommittedResource(
+        _In_ const D3D12_HEAP_PROPERTIES*,
+        D3D12_HEAP_FLAGS,
+        _In_ const D3D12_RESOURCE_DESC* desc,
+        D3D12_RESOURCE_STATES,
+        _In_opt_ const D3D12_CLEAR_VALUE*,
+        REFIID,
+        _Out_ void** resource) noexcept
+    {
+        if (!desc || !resource)
+            return E_INVALIDARG;
+
+        *resource = nullptr;
+
+        const UINT64 mask = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT - 1;
+        const UINT64 reservedSize = (desc->Width + mask) & ~mask;
+
+        ID3D12Resource* object = nullptr;
+        try
+        {
+            object = new ID3D12Resource(desc->Width, mNextGpuAddress.fetch_add(reservedSize));
+        }
+        catch (const std::bad_alloc&)
+        {
+            return E_OUTOFMEMORY;
+        }
+
+        mResourceCount++;
+        *resource = object;
+        return S_OK;
+    }
+
+    HRESULT CreateFence(UINT64 initialValue, D3D12_FENCE_FLAGS, REFIID, _Out_ void** fence) noexcept
+    {
+        if (!fence)
+            return E_INVALIDARG;
+
+        *fence = new (std::nothrow) ID3D12Fence(initialValue);
+        return *fence ? S_OK : E_OUTOFMEMORY;
+    }
+
+    // Committed resources created so far.
+    size_t ResourceCount() const noexcept { return mResourceCount.load(); }
+
+private:
+    std::atomic<UINT64> mNextGpuAddress;
+    std::atomic<size_t> mResourceCount;
+};
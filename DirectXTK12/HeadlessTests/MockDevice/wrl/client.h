@@ -0,0 +1,117 @@
+//--------------------------------------------------------------------------------------
+// File: wrl/client.h
+//
+// The parts of Microsoft::WRL::ComPtr used by the library sources built by the tests.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <utility>
+
+namespace Microsoft
+{
+    namespace WRL
+    {
+        template<typename T>
+        class ComPtr
+        {
+        public:
+            ComPtr() noexcept : mPtr(nullptr) {}
+            ComPtr(std::nullptr_t) noexcept : mPtr(nullptr) {}
+
+            ComPtr(T* ptr) noexcept : mPtr(ptr)
+            {
+                InternalAddRef();
+            }
+
+            ComPtr(const ComPtr& other) noexcept : mPtr(other.mPtr)
+            {
+                InternalAddRef();
+            }
+
+            ComPtr(ComPtr&& other) noexcept : mPtr(other.mPtr)
+            {
+                other.mPtr = nullptr;
+            }
+
+            ~ComPtr()
+            {
+                InternalRelease();
+            }
+
+            ComPtr& operator= (ComPtr other) noexcept
+            {
+                Swap(other);
+                return *this;
+            }
+
+            T* Get() const noexcept { return mPtr; }
+            T* operator->() const noexcept { return mPtr; }
+            explicit operator bool() const noexcept { return mPtr != nullptr; }
+
+            T* const* GetAddressOf() const noexcept { return &mPtr; }
+            T** GetAddressOf() noexcept { return &mPtr; }
+
+            T** ReleaseAndGetAddressOf() noexcept
+            {
+                InternalRelease();
+                return &mPtr;
+            }
+
+            // Takes ownership of a reference the caller already holds.
+            void Attach(T* ptr) noexcept
+            {
+                InternalRelease();
+                mPtr = ptr;
+            }
+
+            T* Detach() noexcept
+            {
+                T* ptr = mPtr;
+                mPtr = nullptr;
+                return ptr;
+            }
+
+            void Reset() noexcept
+            {
+                InternalRelease();
+            }
+
+            void Swap(ComPtr& other) noexcept
+            {
+                std::swap(mPtr, other.mPtr);
+            }
+
+            void Swap(ComPtr&& other) noexcept
+            {
+                std::swap(mPtr, other.mPtr);
+            }
+
+        private:
+            void InternalAddRef() const noexcept
+            {
+                if (mPtr)
+                {
+                    mPtr->AddRef();
+                }
+            }
+
+            void InternalRelease() noexcept
+            {
+                T* ptr = mPtr;
+                if (ptr)
+                {
+                    mPtr = nullptr;
+                    ptr->Release();
+                }
+            }
+
+            T* mPtr;
+        };
+    }
+}
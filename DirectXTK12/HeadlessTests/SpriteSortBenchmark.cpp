@@ -0,0 +1,184 @@
+//--------------------------------------------------------------------------------------
+// File: SpriteSortBenchmark.cpp
+//
+// Time to sort a batch of sprites with SpriteSort::RadixSort, as SpriteBatch now does,
+// against the std::sort with comparison lambdas over sprite pointers that it replaced.
+//
+// Sprites are laid out like SpriteBatch's SpriteInfo, so the comparison sort pays the same
+// cache misses for each key it reads. Each run starts from queue order, as a fresh batch
+// does; the SpriteSort time includes building the keys and the sorted pointer array.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "SpriteSort.h"
+#include "TestUtil.h"
+
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+    enum SortMode
+    {
+        Texture,
+        BackToFront,
+        FrontToBack,
+    };
+
+    const char* const SortModeNames[] = { "Texture", "BackToFront", "FrontToBack" };
+
+    struct alignas(16) SpriteInfo
+    {
+        float source[4];
+        float destination[4];
+        float color[4];
+        float originRotationDepth[4];
+        uint64_t texture;
+        float textureSize[4];
+        unsigned int flags;
+    };
+
+    std::vector<SpriteInfo> MakeSprites(size_t count)
+    {
+        std::mt19937 random(25);
+        std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+
+        std::vector<SpriteInfo> sprites(count);
+        for (auto& sprite : sprites)
+        {
+            sprite = {};
+            sprite.texture = 0x10000000000ull + 32 * (random() % 64);
+            sprite.originRotationDepth[3] = depth(random);
+        }
+        return sprites;
+    }
+
+    // SortSprites before the radix sort.
+    void ComparisonSort(std::vector<SpriteInfo const*>& sorted, SortMode mode)
+    {
+        switch (mode)
+        {
+        case Texture:
+            std::sort(sorted.begin(), sorted.end(),
+                [](SpriteInfo const* x, SpriteInfo const* y) noexcept -> bool
+                {
+                    return x->texture < y->texture;
+                });
+            break;
+
+        case BackToFront:
+            std::sort(sorted.begin(), sorted.end(),
+                [](SpriteInfo const* x, SpriteInfo const* y) noexcept -> bool
+                {
+                    return x->originRotationDepth[3] > y->originRotationDepth[3];
+                });
+            break;
+
+        default:
+            std::sort(sorted.begin(), sorted.end(),
+                [](SpriteInfo const* x, SpriteInfo const* y) noexcept -> bool
+                {
+                    return x->originRotationDepth[3] < y->originRotationDepth[3];
+                });
+            break;
+        }
+    }
+
+    // SortSprites now.
+    void KeySort(std::vector<SpriteInfo> const& sprites, std::vector<SpriteSort::Key>& keys,
+        std::vector<SpriteSort::Key>& scratch, std::vector<SpriteInfo const*>& sorted, SortMode mode)
+    {
+        for (size_t i = 0; i < sprites.size(); i++)
+        {
+            SpriteInfo const& sprite = sprites[i];
+
+            uint64_t key;
+            switch (mode)
+            {
+            case Texture:
+                key = sprite.texture;
+                break;
+
+            case BackToFront:
+                key = ~SpriteSort::FloatToSortableKey(sprite.originRotationDepth[3]);
+                break;
+
+            default:
+                key = SpriteSort::FloatToSortableKey(sprite.originRotationDepth[3]);
+                break;
+            }
+
+            keys[i] = { key, static_cast<uint32_t>(i) };
+        }
+
+        SpriteSort::Key const* result = SpriteSort::RadixSort(keys.data(), scratch.data(), sprites.size());
+
+        for (size_t i = 0; i < sprites.size(); i++)
+        {
+            sorted[i] = &sprites[result[i].index];
+        }
+    }
+
+    void ResetOrder(std::vector<SpriteInfo> const& sprites, std::vector<SpriteInfo const*>& sorted)
+    {
+        for (size_t i = 0; i < sprites.size(); i++)
+        {
+            sorted[i] = &sprites[i];
+        }
+    }
+}
+
+int main()
+{
+    std::printf("sprites   mode          std::sort us   SpriteSort us   speedup\n");
+
+    for (size_t count : { 100, 1000, 10000, 100000, 1000000 })
+    {
+        const auto sprites = MakeSprites(count);
+        std::vector<SpriteSort::Key> keys(count);
+        std::vector<SpriteSort::Key> scratch(count);
+        std::vector<SpriteInfo const*> sorted(count);
+
+        // Enough runs to sort about ten million sprites at each size
+        const size_t runs = std::max<size_t>(1, 10000000 / count);
+
+        for (SortMode mode : { Texture, BackToFront, FrontToBack })
+        {
+            double comparisonSeconds = 0;
+            double keySortSeconds = 0;
+            for (size_t run = 0; run < runs; ++run)
+            {
+                ResetOrder(sprites, sorted);
+                comparisonSeconds += MeasureSeconds([&]() { ComparisonSort(sorted, mode); });
+
+                ResetOrder(sprites, sorted);
+                keySortSeconds += MeasureSeconds([&]() { KeySort(sprites, keys, scratch, sorted, mode); });
+            }
+
+            // Keep the result live, and check the key sort really sorted
+            CHECK(std::is_sorted(sorted.begin(), sorted.end(),
+                [mode](SpriteInfo const* x, SpriteInfo const* y) noexcept -> bool
+                {
+                    switch (mode)
+                    {
+                    case Texture:       return x->texture < y->texture;
+                    case BackToFront:   return x->originRotationDepth[3] > y->originRotationDepth[3];
+                    default:            return x->originRotationDepth[3] < y->originRotationDepth[3];
+                    }
+                }));
+
+            const double comparisonUs = comparisonSeconds * 1000000.0 / double(runs);
+            const double keySortUs = keySortSeconds * 1000000.0 / double(runs);
+            std::printf("%7zu   %-11s   %12.1f   %13.1f   %6.2fx\n",
+                count, SortModeNames[mode], comparisonUs, keySortUs, comparisonUs / keySortUs);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,194 @@
+//--------------------------------------------------------------------------------------
+// File: SpriteSortTest.cpp
+//
+// SpriteSort::RadixSort must put sprites in exactly the order std::stable_sort gives with
+// the comparisons SpriteBatch used before: by texture handle, back to front and front to
+// back, with equal keys (including -0.0 and +0.0) left in the order they were drawn.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "SpriteSort.h"
+#include "TestUtil.h"
+
+#include <limits>
+#include <random>
+
+using namespace DirectX;
+
+namespace
+{
+    enum SortMode
+    {
+        Texture,
+        BackToFront,
+        FrontToBack,
+    };
+
+    struct Sprite
+    {
+        uint64_t texture;
+        float depth;
+    };
+
+    // Keys built as SpriteBatch::Impl::SortSprites builds them.
+    uint64_t MakeKey(Sprite const& sprite, SortMode mode) noexcept
+    {
+        switch (mode)
+        {
+        case Texture:
+            return sprite.texture;
+
+        case BackToFront:
+            return ~SpriteSort::FloatToSortableKey(sprite.depth);
+
+        default:
+            return SpriteSort::FloatToSortableKey(sprite.depth);
+        }
+    }
+
+    bool Less(Sprite const& x, Sprite const& y, SortMode mode) noexcept
+    {
+        switch (mode)
+        {
+        case Texture:
+            return x.texture < y.texture;
+
+        case BackToFront:
+            return x.depth > y.depth;
+
+        default:
+            return x.depth < y.depth;
+        }
+    }
+
+    // Depths with many repeats, signed zeros, negatives and extremes; textures from a few
+    // heaps, each a run of descriptors that differ only in their low bits.
+    std::vector<Sprite> MakeSprites(size_t count, std::mt19937& random)
+    {
+        static const float specialDepths[] =
+        {
+            0.0f, -0.0f, 0.5f, -0.5f, 1.0f, -1.0f,
+            std::numeric_limits<float>::min(),
+            -std::numeric_limits<float>::min(),
+            std::numeric_limits<float>::denorm_min(),
+            std::numeric_limits<float>::max(),
+            -std::numeric_limits<float>::max(),
+            std::numeric_limits<float>::infinity(),
+            -std::numeric_limits<float>::infinity(),
+        };
+
+        std::uniform_real_distribution<float> depth(-100.0f, 100.0f);
+
+        std::vector<Sprite> sprites(count);
+        for (auto& sprite : sprites)
+        {
+            const uint64_t heap = 0x10000000000ull * (1 + random() % 3);
+            sprite.texture = heap + 32 * (random() % 300);
+
+            sprite.depth = (random() % 2)
+                ? specialDepths[random() % std::size(specialDepths)]
+                : depth(random);
+        }
+        return sprites;
+    }
+
+    void CheckOrder(std::vector<Sprite> const& sprites, SortMode mode)
+    {
+        const size_t count = sprites.size();
+
+        std::vector<SpriteSort::Key> keys(count);
+        std::vector<SpriteSort::Key> scratch(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            keys[i] = { MakeKey(sprites[i], mode), static_cast<uint32_t>(i) };
+        }
+
+        SpriteSort::Key const* sorted = SpriteSort::RadixSort(keys.data(), scratch.data(), count);
+        CHECK(sorted == keys.data() || sorted == scratch.data());
+
+        std::vector<uint32_t> expected(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            expected[i] = static_cast<uint32_t>(i);
+        }
+        std::stable_sort(expected.begin(), expected.end(), [&](uint32_t x, uint32_t y)
+        {
+            return Less(sprites[x], sprites[y], mode);
+        });
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            CHECK(sorted[i].index == expected[i]);
+        }
+    }
+
+    void TestFloatToSortableKey()
+    {
+        const float ordered[] =
+        {
+            -std::numeric_limits<float>::infinity(),
+            -std::numeric_limits<float>::max(),
+            -1.0f,
+            -std::numeric_limits<float>::min(),
+            -std::numeric_limits<float>::denorm_min(),
+            0.0f,
+            std::numeric_limits<float>::denorm_min(),
+            std::numeric_limits<float>::min(),
+            1.0f,
+            std::numeric_limits<float>::max(),
+            std::numeric_limits<float>::infinity(),
+        };
+
+        for (size_t i = 1; i < std::size(ordered); ++i)
+        {
+            CHECK(SpriteSort::FloatToSortableKey(ordered[i - 1]) < SpriteSort::FloatToSortableKey(ordered[i]));
+        }
+
+        CHECK(SpriteSort::FloatToSortableKey(-0.0f) == SpriteSort::FloatToSortableKey(0.0f));
+    }
+
+    void TestEqualKeys()
+    {
+        // Every key the same: each pass is skipped and the input comes back untouched.
+        std::vector<SpriteSort::Key> keys(4096);
+        std::vector<SpriteSort::Key> scratch(keys.size());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            keys[i] = { 0x1234567800000000ull, static_cast<uint32_t>(i) };
+        }
+
+        SpriteSort::Key const* sorted = SpriteSort::RadixSort(keys.data(), scratch.data(), keys.size());
+        CHECK(sorted == keys.data());
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            CHECK(sorted[i].index == i);
+        }
+    }
+}
+
+int main()
+{
+    TestFloatToSortableKey();
+    TestEqualKeys();
+
+    // Sizes either side of the switch from comparison sort to radix sort
+    constexpr size_t Threshold = SpriteSort::RadixSortThreshold;
+
+    std::mt19937 random(25);
+    for (size_t count : { size_t(1), size_t(2), size_t(7), Threshold - 1, Threshold, Threshold + 1, size_t(100000) })
+    {
+        const auto sprites = MakeSprites(count, random);
+        for (SortMode mode : { Texture, BackToFront, FrontToBack })
+        {
+            CheckOrder(sprites, mode);
+        }
+    }
+
+    std::printf("SpriteSortTest passed\n");
+    return 0;
+}
@@ -0,0 +1,36 @@
+//--------------------------------------------------------------------------------------
+// File: TestUtil.h
+//
+// Minimal checks for the headless tests. A failed check prints its location and ends
+// the test with a non-zero exit code, which is all ctest looks at.
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+#define CHECK(condition) \
+    do \
+    { \
+        if (!(condition)) \
+        { \
+            std::fprintf(stderr, "%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            std::exit(1); \
+        } \
+    } while (0)
+
+// Wall-clock seconds spent in fn().
+template<typename Fn>
+double MeasureSeconds(Fn&& fn)
+{
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
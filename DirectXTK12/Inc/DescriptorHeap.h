@@ -23,10 +23,15 @@
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <stdexcept>
+#include <utility>
+#include <vector>
 
 #include <wrl/client.h>
 
+#include "DescriptorRangeAllocator.h"
+
 
 namespace DirectX
 {
@@ -142,7 +147,20 @@ namespace DirectX
 
 
     // Helper class for dynamically allocating descriptor indices.
-    // The pile is statically sized and will throw an exception if it becomes full.
+    //
+    // Ranges can be returned with Free. They are recycled once the GPU has passed the fence
+    // signaled by the next call to Commit, which should be made once a frame after submitting
+    // the command lists that use the pile.
+    //
+    // The pile throws an exception when it becomes full, unless SetMaxCapacity allowed it to
+    // grow. Growing replaces the heap with a larger one, so Heap() and every GPU handle change
+    // and the new heap must be bound again; indices stay valid. Shader-visible piles can only
+    // grow with a staging heap, as their descriptors are copied from it, so all of their
+    // descriptors must be written through the staging heap.
+    //
+    // With EnableStaging, descriptors are written to a CPU-only mirror of the heap through
+    // GetStagingCpuHandle and MarkDirty, and FlushStaging copies every dirty range to the heap
+    // in one CopyDescriptors call. This suits tables that are rewritten every frame.
     class DescriptorPile : public DescriptorHeap
     {
     public:
@@ -153,9 +171,11 @@ namespace DirectX
             _In_ ID3D12DescriptorHeap* pExistingHeap,
             size_t reserve = 0) noexcept(false)
             : DescriptorHeap(pExistingHeap),
-            m_top(reserve)
+            m_ranges(Count(), reserve),
+            m_maxCapacity(Count()),
+            m_fenceValue(0)
         {
-            if (reserve > 0 && m_top >= Count())
+            if (reserve > 0 && reserve >= Count())
             {
                 throw std::out_of_range("Reserve descriptor range is too large");
             }
@@ -166,9 +186,11 @@ namespace DirectX
             _In_ const D3D12_DESCRIPTOR_HEAP_DESC* pDesc,
             size_t reserve = 0) noexcept(false)
             : DescriptorHeap(device, pDesc),
-            m_top(reserve)
+            m_ranges(Count(), reserve),
+            m_maxCapacity(Count()),
+            m_fenceValue(0)
         {
-            if (reserve > 0 && m_top >= Count())
+            if (reserve > 0 && reserve >= Count())
             {
                 throw std::out_of_range("Reserve descriptor range is too large");
             }
@@ -181,9 +203,11 @@ namespace DirectX
             size_t capacity,
             size_t reserve = 0) noexcept(false)
             : DescriptorHeap(device, type, flags, capacity),
-            m_top(reserve)
+            m_ranges(Count(), reserve),
+            m_maxCapacity(Count()),
+            m_fenceValue(0)
         {
-            if (reserve > 0 && m_top >= Count())
+            if (reserve > 0 && reserve >= Count())
             {
                 throw std::out_of_range("Reserve descriptor range is too large");
             }
@@ -215,7 +239,42 @@ namespace DirectX
 
         void AllocateRange(size_t numDescriptors, _Out_ IndexType& start, _Out_ IndexType& end);
 
+        // Returns [start, end) to the pile once the GPU is done with it.
+        void __cdecl Free(IndexType index) { Free(index, index + 1); }
+        void __cdecl Free(IndexType start, IndexType end);
+
+        // Signals the fence that guards ranges freed since the last call, and recycles ranges
+        // and old heaps whose fence has completed.
+        void __cdecl Commit(_In_ ID3D12CommandQueue* commandQueue);
+
+        // Allows the pile to grow, doubling in size, up to maxCapacity descriptors.
+        void __cdecl SetMaxCapacity(size_t maxCapacity);
+
+        // Staging heap
+        void __cdecl EnableStaging();
+        bool IsStagingEnabled() const noexcept { return m_staging != nullptr; }
+        D3D12_CPU_DESCRIPTOR_HANDLE __cdecl GetStagingCpuHandle(_In_ size_t index) const;
+        void __cdecl MarkDirty(IndexType start, IndexType end);
+        void __cdecl FlushStaging();
+
+        DescriptorPileStatistics GetStatistics() const noexcept { return m_ranges.GetStatistics(); }
+
     private:
-        IndexType m_top;
+        struct RetiredHeap
+        {
+            Microsoft::WRL::ComPtr<ID3D12DescriptorHeap>    heap;
+            uint64_t                                        fenceValue; // Zero until committed
+        };
+
+        void Grow(size_t numDescriptors);
+        Microsoft::WRL::ComPtr<ID3D12Device> GetDevice() const;
+
+        DescriptorRangeAllocator                        m_ranges;
+        size_t                                          m_maxCapacity;
+        std::unique_ptr<DescriptorHeap>                 m_staging;
+        std::vector<std::pair<IndexType, size_t>>       m_dirtyRanges;
+        std::vector<RetiredHeap>                        m_retiredHeaps;
+        Microsoft::WRL::ComPtr<ID3D12Fence>             m_fence;
+        uint64_t                                        m_fenceValue;
     };
 }
@@ -0,0 +1,85 @@
+//--------------------------------------------------------------------------------------
+// File: DescriptorRangeAllocator.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+
+namespace DirectX
+{
+    struct DescriptorPileStatistics
+    {
+        size_t capacity;            // Total descriptors in the heap
+        size_t reserved;            // Descriptors at the start of the heap that are never allocated
+        size_t allocated;           // Descriptors in live ranges
+        size_t pendingFree;         // Descriptors freed but still possibly in use by the GPU
+        size_t free;                // Descriptors available for allocation
+        size_t freeRanges;          // Number of separate free ranges
+        size_t largestFreeRange;    // Largest range that can be allocated without growing
+    };
+
+
+    // Index bookkeeping for DescriptorPile. It holds no D3D objects, so it can be used
+    // and tested without a device.
+    //
+    // Free ranges are kept sorted and coalesced; allocation picks the smallest range that
+    // fits. Freed ranges are not reused right away: they wait for the fence value given to the
+    // next Submit, and return to the free list once Retire is called with a completed value
+    // at least that large.
+    class DescriptorRangeAllocator
+    {
+    public:
+        using IndexType = size_t;
+
+        explicit DescriptorRangeAllocator(size_t capacity = 0, size_t reserve = 0) noexcept(false);
+
+        DescriptorRangeAllocator(DescriptorRangeAllocator&&) = default;
+        DescriptorRangeAllocator& operator=(DescriptorRangeAllocator&&) = default;
+
+        DescriptorRangeAllocator(const DescriptorRangeAllocator&) = default;
+        DescriptorRangeAllocator& operator=(const DescriptorRangeAllocator&) = default;
+
+        // Returns false if no free range holds count descriptors.
+        bool __cdecl Allocate(size_t count, _Out_ IndexType& start);
+
+        void __cdecl Free(IndexType start, size_t count);
+
+        // Fence values must be non-zero and increasing.
+        void __cdecl Submit(uint64_t fenceValue) noexcept;
+        void __cdecl Retire(uint64_t completedFenceValue);
+
+        // Adds [Capacity(), newCapacity) to the free list.
+        void __cdecl Grow(size_t newCapacity);
+
+        size_t Capacity() const noexcept { return m_capacity; }
+
+        DescriptorPileStatistics __cdecl GetStatistics() const noexcept;
+
+    private:
+        struct PendingRange
+        {
+            IndexType   start;
+            size_t      count;
+            uint64_t    fenceValue; // Zero until submitted
+        };
+
+        void Release(IndexType start, size_t count);
+
+        std::map<IndexType, size_t> m_freeRanges;   // start -> count
+        std::vector<PendingRange>   m_pendingRanges;
+        size_t                      m_capacity;
+        size_t                      m_reserve;
+        size_t                      m_allocated;
+        size_t                      m_pendingFree;
+    };
+}
@@ -21,8 +21,10 @@
 #endif
 
 #include <cstddef>
+#include <cstdint>
 #include <cstring>
 #include <memory>
+#include <string>
 
 #ifdef _GAMING_XBOX
 #include <gxdk.h>
@@ -133,6 +135,24 @@ namespace DirectX
             size_t peakTotalPages;      // Peak total page count
         };
 
+        //------------------------------------------------------------------------------
+        // Allocation telemetry for one GraphicsMemory::Tag, gathered while telemetry is enabled
+        struct GraphicsMemoryTagStatistics
+        {
+            static constexpr size_t SizeHistogramBuckets = 32;
+
+            size_t allocations;             // Allocations since last reset
+            size_t bytes;                   // Bytes requested since last reset
+            size_t alignmentWaste;          // Bytes skipped in pages to honor the requested alignment
+            size_t peakFrameAllocations;    // Most allocations made between two Commit calls
+            size_t peakFrameBytes;          // Most bytes requested between two Commit calls
+            size_t sizeHistogram[SizeHistogramBuckets]; // See GetSizeHistogramBucket
+
+            // Bucket 0 counts sizes up to 1 byte, bucket i counts sizes in (2^(i-1), 2^i] bytes, and
+            // the last bucket is open-ended: it counts every size above 2^(SizeHistogramBuckets - 2).
+            static size_t __cdecl GetSizeHistogramBucket(size_t size) noexcept;
+        };
+
         //------------------------------------------------------------------------------
         class GraphicsMemory
         {
@@ -146,6 +166,8 @@ namespace DirectX
                 TAG_SPRITES,
                 TAG_TEXTURE,
                 TAG_COMPUTE,
+
+                TAG_COUNT
             };
 
             explicit GraphicsMemory(_In_ ID3D12Device* device);
@@ -163,11 +185,9 @@ namespace DirectX
             // the GraphicsResource object, or your memory may be overwritten later.
             GraphicsResource __cdecl Allocate(size_t size, size_t alignment = 16, uint32_t tag = TAG_GENERIC)
             {
-                auto alloc = AllocateImpl(size, alignment);
+                auto alloc = AllocateImpl(size, alignment, tag);
 #ifdef USING_PIX_CUSTOM_MEMORY_EVENTS
                 std::ignore = ReportCustomMemoryAlloc(alloc.Memory(), alloc.Size(), tag);
-#else
-                UNREFERENCED_PARAMETER(tag);
 #endif
                 return alloc;
             }
@@ -177,7 +197,7 @@ namespace DirectX
             {
                 constexpr size_t alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
                 constexpr size_t alignedSize = (sizeof(T) + alignment - 1) & ~(alignment - 1);
-                auto alloc = AllocateImpl(alignedSize, alignment);
+                auto alloc = AllocateImpl(alignedSize, alignment, TAG_CONSTANT);
 #ifdef USING_PIX_CUSTOM_MEMORY_EVENTS
                 // This cast is needed to capture the type information in the PDB
                 std::ignore = reinterpret_cast<T*>(ReportCustomMemoryAlloc(alloc.Memory(), alloc.Size(), TAG_CONSTANT));
@@ -195,6 +215,14 @@ namespace DirectX
             // The memory will be recycled once the GPU is done with it.
             void __cdecl Commit(_In_ ID3D12CommandQueue* commandQueue);
 
+            // Each thread that allocates keeps its current 64KB page for each of the six pools
+            // serving requests up to 64KB (size plus alignment), so it can suballocate without
+            // locking. A page stays referenced by the thread, and so is neither fenced by Commit
+            // nor reused, until that thread allocates again after the Commit or exits. A worker
+            // thread that goes idle for several frames holds up to 384KB this way; calling this
+            // from the thread before it idles lets the next Commit fence those pages.
+            void __cdecl ReleaseThreadPages() noexcept;
+
             // This frees up any unused memory.
             // If you want to make sure all memory is reclaimed, idle the GPU before calling this.
             // It is not recommended that you call this unless absolutely necessary (e.g. your
@@ -205,6 +233,18 @@ namespace DirectX
             GraphicsMemoryStatistics __cdecl GetStatistics();
             void __cdecl ResetStatistics();
 
+            // Allocation telemetry, broken down by the tag passed to Allocate. Tags outside the
+            // Tag enumeration are counted as TAG_GENERIC. Telemetry is off by default, as it adds
+            // a few atomic updates to every allocation. Commit marks the end of a frame for the
+            // per-frame peaks, and ResetStatistics clears the telemetry as well.
+            void __cdecl SetTelemetryEnabled(bool enabled) noexcept;
+            bool __cdecl IsTelemetryEnabled() const noexcept;
+            GraphicsMemoryTagStatistics __cdecl GetTagStatistics(uint32_t tag) const noexcept;
+
+            // Telemetry for every tag as a JSON document or as CSV with one row per tag
+            std::string __cdecl GetTelemetryJSON() const;
+            std::string __cdecl GetTelemetryCSV() const;
+
             // Singleton
             // Should only use nullptr for single GPU scenarios; mGPU requires a specific device
             static GraphicsMemory& __cdecl Get(_In_opt_ ID3D12Device* device = nullptr);
@@ -213,7 +253,7 @@ namespace DirectX
             // Private implementation.
             class Impl;
 
-            GraphicsResource __cdecl AllocateImpl(size_t size, size_t alignment);
+            GraphicsResource __cdecl AllocateImpl(size_t size, size_t alignment, uint32_t tag);
 
 #ifdef USING_PIX_CUSTOM_MEMORY_EVENTS
             // The declspec is required to ensure the proper information is captured in the PDB
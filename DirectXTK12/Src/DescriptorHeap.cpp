@@ -214,17 +214,213 @@ void DescriptorPile::AllocateRange(size_t numDescriptors, _Out_ IndexType& start
         throw std::invalid_argument("Can't allocate zero descriptors");
     }
 
-    // get the current top
-    start = m_top;
+    if (!m_ranges.Allocate(numDescriptors, start))
+    {
+        Grow(numDescriptors);
+
+        if (!m_ranges.Allocate(numDescriptors, start))
+        {
+            const auto stats = m_ranges.GetStatistics();
+            DebugTrace("DescriptorPile has %zu of %zu descriptors in use (largest free range %zu); failed request for %zu more\n",
+                stats.allocated + stats.pendingFree, Count(), stats.largestFreeRange, numDescriptors);
+            throw std::runtime_error("Can't allocate more descriptors");
+        }
+    }
+
+    end = start + numDescriptors;
+}
+
+void DescriptorPile::Free(IndexType start, IndexType end)
+{
+    if (end <= start)
+    {
+        throw std::invalid_argument("Invalid descriptor range");
+    }
+
+    m_ranges.Free(start, end - start);
+}
+
+void DescriptorPile::Commit(_In_ ID3D12CommandQueue* commandQueue)
+{
+    if (!m_fence)
+    {
+        ComPtr<ID3D12Device> device;
+        ThrowIfFailed(commandQueue->GetDevice(IID_GRAPHICS_PPV_ARGS(device.GetAddressOf())));
+
+        ThrowIfFailed(device->CreateFence(
+            0,
+            D3D12_FENCE_FLAG_NONE,
+            IID_GRAPHICS_PPV_ARGS(m_fence.ReleaseAndGetAddressOf())));
+
+        SetDebugObjectName(m_fence.Get(), L"DescriptorPile");
+    }
+
+    ThrowIfFailed(commandQueue->Signal(m_fence.Get(), ++m_fenceValue));
+
+    m_ranges.Submit(m_fenceValue);
+    for (auto& retired : m_retiredHeaps)
+    {
+        if (retired.fenceValue == 0)
+        {
+            retired.fenceValue = m_fenceValue;
+        }
+    }
+
+    const uint64_t completedValue = m_fence->GetCompletedValue();
+
+    m_ranges.Retire(completedValue);
+    m_retiredHeaps.erase(
+        std::remove_if(m_retiredHeaps.begin(), m_retiredHeaps.end(),
+            [completedValue](const RetiredHeap& retired) noexcept
+            {
+                return retired.fenceValue != 0 && retired.fenceValue <= completedValue;
+            }),
+        m_retiredHeaps.end());
+}
+
+void DescriptorPile::SetMaxCapacity(size_t maxCapacity)
+{
+    if (maxCapacity > UINT32_MAX)
+        throw std::invalid_argument("Too many descriptors");
+
+    if (maxCapacity > Count() && (Flags() & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) && !m_staging)
+    {
+        throw std::logic_error("Shader-visible DescriptorPile requires EnableStaging to grow");
+    }
+
+    m_maxCapacity = std::max(maxCapacity, Count());
+}
+
+void DescriptorPile::EnableStaging()
+{
+    if (m_staging)
+        return;
+
+    auto device = GetDevice();
+
+    m_staging = std::make_unique<DescriptorHeap>(device.Get(), Type(), D3D12_DESCRIPTOR_HEAP_FLAG_NONE, Count());
+}
+
+D3D12_CPU_DESCRIPTOR_HANDLE DescriptorPile::GetStagingCpuHandle(_In_ size_t index) const
+{
+    if (!m_staging)
+        throw std::logic_error("DescriptorPile staging is not enabled");
+
+    return m_staging->GetCpuHandle(index);
+}
+
+void DescriptorPile::MarkDirty(IndexType start, IndexType end)
+{
+    if (!m_staging)
+        throw std::logic_error("DescriptorPile staging is not enabled");
+
+    if (end <= start || end > Count())
+        throw std::out_of_range("Invalid descriptor range");
+
+    m_dirtyRanges.emplace_back(start, end - start);
+}
+
+void DescriptorPile::FlushStaging()
+{
+    if (m_dirtyRanges.empty())
+        return;
+
+    // Merge overlapping and adjacent ranges
+    std::sort(m_dirtyRanges.begin(), m_dirtyRanges.end());
+
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> destStarts;
+    std::vector<D3D12_CPU_DESCRIPTOR_HANDLE> srcStarts;
+    std::vector<UINT> sizes;
+    destStarts.reserve(m_dirtyRanges.size());
+    srcStarts.reserve(m_dirtyRanges.size());
+    sizes.reserve(m_dirtyRanges.size());
+
+    IndexType rangeStart = m_dirtyRanges[0].first;
+    IndexType rangeEnd = rangeStart + m_dirtyRanges[0].second;
+    for (size_t i = 1; i <= m_dirtyRanges.size(); ++i)
+    {
+        if (i < m_dirtyRanges.size() && m_dirtyRanges[i].first <= rangeEnd)
+        {
+            rangeEnd = std::max(rangeEnd, m_dirtyRanges[i].first + m_dirtyRanges[i].second);
+            continue;
+        }
+
+        destStarts.push_back(GetCpuHandle(rangeStart));
+        srcStarts.push_back(m_staging->GetCpuHandle(rangeStart));
+        sizes.push_back(static_cast<UINT>(rangeEnd - rangeStart));
+
+        if (i < m_dirtyRanges.size())
+        {
+            rangeStart = m_dirtyRanges[i].first;
+            rangeEnd = rangeStart + m_dirtyRanges[i].second;
+        }
+    }
+
+    auto device = GetDevice();
+
+    const auto rangeCount = static_cast<UINT>(sizes.size());
+    device->CopyDescriptors(
+        rangeCount, destStarts.data(), sizes.data(),
+        rangeCount, srcStarts.data(), sizes.data(),
+        Type());
 
-    // increment top with new request
-    m_top += numDescriptors;
-    end = m_top;
+    m_dirtyRanges.clear();
+}
+
+void DescriptorPile::Grow(size_t numDescriptors)
+{
+    const size_t oldCount = Count();
+    if (oldCount >= m_maxCapacity)
+        return;
+
+    // Double until the new descriptors alone can hold the request
+    size_t newCount = std::max<size_t>(oldCount, 1);
+    do
+    {
+        newCount = std::min(newCount * 2, m_maxCapacity);
+    } while (newCount < m_maxCapacity && newCount - oldCount < numDescriptors);
+
+    auto device = GetDevice();
+    const bool shaderVisible = (Flags() & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) != 0;
+    assert(!shaderVisible || m_staging);
+
+    DescriptorHeap heap(device.Get(), Type(), static_cast<D3D12_DESCRIPTOR_HEAP_FLAGS>(Flags()), newCount);
+
+    if (m_staging)
+    {
+        DescriptorHeap staging(device.Get(), Type(), D3D12_DESCRIPTOR_HEAP_FLAG_NONE, newCount);
+        if (oldCount > 0)
+        {
+            device->CopyDescriptorsSimple(static_cast<UINT>(oldCount), staging.GetFirstCpuHandle(), m_staging->GetFirstCpuHandle(), Type());
+        }
+        *m_staging = std::move(staging);
+    }
+
+    // Shader-visible heaps are slow to read on the CPU, so copy from the staging heap
+    if (oldCount > 0)
+    {
+        const D3D12_CPU_DESCRIPTOR_HANDLE src = shaderVisible ? m_staging->GetFirstCpuHandle() : GetFirstCpuHandle();
+        device->CopyDescriptorsSimple(static_cast<UINT>(oldCount), heap.GetFirstCpuHandle(), src, Type());
+    }
 
-    // make sure we have enough room
-    if (m_top > Count())
+    // The old heap may still be bound by command lists in flight
+    if (Heap())
     {
-        DebugTrace("DescriptorPile has %zu of %zu descriptors; failed request for %zu more\n", start, Count(), numDescriptors);
-        throw std::runtime_error("Can't allocate more descriptors");
+        m_retiredHeaps.push_back({ Heap(), 0 });
     }
+
+    DescriptorHeap::operator=(std::move(heap));
+    m_ranges.Grow(newCount);
+
+    DebugTrace("INFO: DescriptorPile grew from %zu to %zu descriptors\n", oldCount, newCount);
+}
+
+ComPtr<ID3D12Device> DescriptorPile::GetDevice() const
+{
+    if (!Heap())
+        throw std::logic_error("DescriptorPile has no heap");
+
+    ComPtr<ID3D12Device> device;
+    ThrowIfFailed(Heap()->GetDevice(IID_GRAPHICS_PPV_ARGS(device.GetAddressOf())));
+    return device;
 }
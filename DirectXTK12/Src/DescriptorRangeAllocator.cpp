@@ -0,0 +1,177 @@
+//--------------------------------------------------------------------------------------
+// File: DescriptorRangeAllocator.cpp
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#include "pch.h"
+#include "PlatformHelpers.h"
+#include "DescriptorRangeAllocator.h"
+
+using namespace DirectX;
+
+DescriptorRangeAllocator::DescriptorRangeAllocator(size_t capacity, size_t reserve) noexcept(false) :
+    m_capacity(capacity),
+    m_reserve(reserve),
+    m_allocated(0),
+    m_pendingFree(0)
+{
+    if (reserve > capacity)
+    {
+        throw std::out_of_range("Reserve descriptor range is too large");
+    }
+
+    if (capacity > reserve)
+    {
+        m_freeRanges.emplace(reserve, capacity - reserve);
+    }
+}
+
+bool DescriptorRangeAllocator::Allocate(size_t count, _Out_ IndexType& start)
+{
+    start = 0;
+
+    if (count == 0)
+    {
+        throw std::invalid_argument("Can't allocate zero descriptors");
+    }
+
+    // Best fit, to keep large ranges intact for large requests
+    auto best = m_freeRanges.end();
+    for (auto it = m_freeRanges.begin(); it != m_freeRanges.end(); ++it)
+    {
+        if (it->second >= count && (best == m_freeRanges.end() || it->second < best->second))
+        {
+            best = it;
+            if (it->second == count)
+                break;
+        }
+    }
+
+    if (best == m_freeRanges.end())
+    {
+        return false;
+    }
+
+    start = best->first;
+    const size_t remaining = best->second - count;
+    m_freeRanges.erase(best);
+    if (remaining > 0)
+    {
+        m_freeRanges.emplace(start + count, remaining);
+    }
+
+    m_allocated += count;
+    return true;
+}
+
+void DescriptorRangeAllocator::Free(IndexType start, size_t count)
+{
+    if (count == 0 || start < m_reserve || start + count > m_capacity || count > m_allocated)
+    {
+        DebugTrace("ERROR: DescriptorRangeAllocator can't free range [%zu, %zu) (%zu allocated of %zu)\n", start, start + count, m_allocated, m_capacity);
+        throw std::out_of_range("Invalid descriptor range");
+    }
+
+    m_pendingRanges.push_back({ start, count, 0 });
+    m_allocated -= count;
+    m_pendingFree += count;
+}
+
+void DescriptorRangeAllocator::Submit(uint64_t fenceValue) noexcept
+{
+    assert(fenceValue != 0);
+
+    for (auto& range : m_pendingRanges)
+    {
+        if (range.fenceValue == 0)
+        {
+            range.fenceValue = fenceValue;
+        }
+    }
+}
+
+void DescriptorRangeAllocator::Retire(uint64_t completedFenceValue)
+{
+    auto it = m_pendingRanges.begin();
+    while (it != m_pendingRanges.end())
+    {
+        if (it->fenceValue != 0 && it->fenceValue <= completedFenceValue)
+        {
+            m_pendingFree -= it->count;
+            Release(it->start, it->count);
+            it = m_pendingRanges.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void DescriptorRangeAllocator::Grow(size_t newCapacity)
+{
+    if (newCapacity <= m_capacity)
+    {
+        return;
+    }
+
+    const size_t oldCapacity = m_capacity;
+    m_capacity = newCapacity;
+    Release(oldCapacity, newCapacity - oldCapacity);
+}
+
+DescriptorPileStatistics DescriptorRangeAllocator::GetStatistics() const noexcept
+{
+    DescriptorPileStatistics stats = {};
+    stats.capacity = m_capacity;
+    stats.reserved = m_reserve;
+    stats.allocated = m_allocated;
+    stats.pendingFree = m_pendingFree;
+    stats.freeRanges = m_freeRanges.size();
+
+    for (const auto& range : m_freeRanges)
+    {
+        stats.free += range.second;
+        stats.largestFreeRange = std::max(stats.largestFreeRange, range.second);
+    }
+
+    return stats;
+}
+
+void DescriptorRangeAllocator::Release(IndexType start, size_t count)
+{
+    // Merge with the free ranges on either side
+    auto next = m_freeRanges.lower_bound(start);
+    if (next != m_freeRanges.end() && next->first < start + count)
+    {
+        throw std::logic_error("Descriptor range freed twice");
+    }
+
+    if (next != m_freeRanges.begin())
+    {
+        auto prev = std::prev(next);
+        if (prev->first + prev->second > start)
+        {
+            throw std::logic_error("Descriptor range freed twice");
+        }
+
+        if (prev->first + prev->second == start)
+        {
+            start = prev->first;
+            count += prev->second;
+            m_freeRanges.erase(prev);
+        }
+    }
+
+    if (next != m_freeRanges.end() && next->first == start + count)
+    {
+        count += next->second;
+        m_freeRanges.erase(next);
+    }
+
+    m_freeRanges.emplace(start, count);
+}
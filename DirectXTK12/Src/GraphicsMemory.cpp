@@ -34,6 +34,12 @@ namespace
     static_assert((MinAllocSize & (MinAllocSize - 1)) == 0, "MinAllocSize size must be a power of 2");
     static_assert(MinAllocSize >= (4 * 1024), "MinAllocSize size must be greater than 4K");
 
+    // Pools 0 through 5 all use MinPageSize pages, which hold many allocations each. Each thread
+    // keeps its current page for these pools and bumps into it without taking the allocator lock.
+    constexpr size_t ThreadCachePoolCount = 6;
+
+    static_assert((MinPageSize >> AllocatorIndexShift) == (size_t(1) << (ThreadCachePoolCount - 2)), "ThreadCachePoolCount must cover the MinPageSize pools");
+
     constexpr size_t NextPow2(size_t x) noexcept
     {
         x--;
@@ -87,6 +93,47 @@ namespace
         return std::max<size_t>(MinPageSize, size_t(1) << (x + AllocatorIndexShift));
     }
 
+    //--------------------------------------------------------------------------------------
+    // ThreadPageCache : the pages a thread is currently suballocating from
+    //--------------------------------------------------------------------------------------
+    // Each cached page holds a reference, so the page stays on the used list and is not
+    // fenced while the thread may still allocate from it. The cache belongs to one
+    // DeviceAllocator at a time and is dropped whenever that allocator's generation moves on
+    // (every Commit), so pages retire once the owning thread allocates again, calls
+    // GraphicsMemory::ReleaseThreadPages, or exits.
+    struct ThreadPageCache
+    {
+        uint64_t allocatorId = 0;
+        uint64_t generation = 0;
+        std::array<LinearAllocatorPage*, ThreadCachePoolCount> pages = {};
+
+        ThreadPageCache() = default;
+
+        ThreadPageCache(ThreadPageCache const&) = delete;
+        ThreadPageCache& operator= (ThreadPageCache const&) = delete;
+
+        ~ThreadPageCache()
+        {
+            Flush();
+        }
+
+        void Flush() noexcept
+        {
+            for (auto& page : pages)
+            {
+                if (page)
+                {
+                    page->Release();
+                    page = nullptr;
+                }
+            }
+        }
+    };
+
+    thread_local ThreadPageCache t_pageCache;
+
+    std::atomic<uint64_t> s_nextAllocatorId(1);
+
     //--------------------------------------------------------------------------------------
     // DeviceAllocator : honors memory requests associated with a particular device
     //--------------------------------------------------------------------------------------
@@ -95,6 +142,8 @@ namespace
     public:
         DeviceAllocator(_In_ ID3D12Device* device) noexcept(false)
             : mDevice(device)
+            , mId(s_nextAllocatorId.fetch_add(1))
+            , mGeneration(0)
         {
             if (!device)
                 throw std::invalid_argument("Invalid device parameter");
@@ -119,43 +168,81 @@ namespace
         {
             const ScopedLock lock(mMutex);
 
+            // Pages cached by other threads are released when those threads next allocate or exit
+            FlushThreadCache();
+
             for (auto& allocator : mPools)
             {
                 allocator.reset();
             }
         }
 
-        GraphicsResource Alloc(_In_ size_t size, _In_ size_t alignment)
+        GraphicsResource Alloc(_In_ size_t size, _In_ size_t alignment, _Out_ size_t& padding)
         {
-            ScopedLock lock(mMutex);
+        #ifdef _DEBUG
+            if (size == 0)
+                throw std::invalid_argument("Cannot honor zero size allocation request.");
+        #endif
 
             // Which memory pool does it live in?
             const size_t poolSize = NextPow2((alignment + size) * PoolIndexScale);
             const size_t poolIndex = GetPoolIndexFromSize(poolSize);
             assert(poolIndex < mPools.size());
 
+            // Fast path: bump into this thread's current page for the pool without locking
+            ThreadPageCache* cache = nullptr;
+            if (poolIndex < ThreadCachePoolCount)
+            {
+                cache = &t_pageCache;
+
+                const uint64_t generation = mGeneration.load(std::memory_order_acquire);
+                if (cache->allocatorId != mId || cache->generation != generation)
+                {
+                    cache->Flush();
+                    cache->allocatorId = mId;
+                    cache->generation = generation;
+                }
+
+                auto page = cache->pages[poolIndex];
+                size_t offset = 0;
+                if (page && page->TrySuballocate(size, alignment, offset, &padding))
+                {
+                    return MakeResource(page, offset, size);
+                }
+            }
+
+            ScopedLock lock(mMutex);
+
             // If the allocator isn't initialized yet, do so now
             auto& allocator = mPools[poolIndex];
             assert(allocator != nullptr);
             assert(poolSize < MinPageSize || poolSize == allocator->PageSize());
 
-            auto page = allocator->FindPageForAlloc(size, alignment);
-            if (!page)
+            // Other threads may fill the pool's current page between finding it and suballocating
+            // from it, in which case it no longer has room and the next lookup starts a new page.
+            LinearAllocatorPage* page = nullptr;
+            size_t offset = 0;
+            do
             {
-                DebugTrace("GraphicsMemory failed to allocate page (%zu requested bytes, %zu alignment)\n", size, alignment);
-                throw std::bad_alloc();
-            }
+                page = allocator->FindPageForAlloc(size, alignment);
+                if (!page)
+                {
+                    DebugTrace("GraphicsMemory failed to allocate page (%zu requested bytes, %zu alignment)\n", size, alignment);
+                    throw std::bad_alloc();
+                }
+            } while (!page->TrySuballocate(size, alignment, offset, &padding));
 
-            size_t offset = page->Suballocate(size, alignment);
+            if (cache && cache->pages[poolIndex] != page)
+            {
+                page->AddRef();
+                if (cache->pages[poolIndex])
+                {
+                    cache->pages[poolIndex]->Release();
+                }
+                cache->pages[poolIndex] = page;
+            }
 
-            // Return the information to the user
-            return GraphicsResource(
-                page,
-                page->GpuAddress() + offset,
-                page->UploadResource(),
-                static_cast<BYTE*>(page->BaseMemory()) + offset,
-                offset,
-                size);
+            return MakeResource(page, offset, size);
         }
 
         // Submit page fences to the command queue
@@ -163,6 +250,11 @@ namespace
         {
             ScopedLock lock(mMutex);
 
+            // Ask every thread to let go of its cached pages so they can be fenced. The calling
+            // thread does so now; the others do so on their next allocation.
+            mGeneration.fetch_add(1, std::memory_order_release);
+            FlushThreadCache();
+
             for (auto& i : mPools)
             {
                 if (i)
@@ -173,10 +265,20 @@ namespace
             }
         }
 
+        // Drop the calling thread's cached pages. Only touches thread-local state and page
+        // reference counts, so no lock is needed.
+        void ReleaseThreadPages() noexcept
+        {
+            FlushThreadCache();
+        }
+
         void GarbageCollect()
         {
             ScopedLock lock(mMutex);
 
+            mGeneration.fetch_add(1, std::memory_order_release);
+            FlushThreadCache();
+
             for (auto& i : mPools)
             {
                 if (i)
@@ -215,17 +317,187 @@ namespace
     #endif
 
     private:
+        static GraphicsResource MakeResource(_In_ LinearAllocatorPage* page, size_t offset, size_t size) noexcept
+        {
+            // Return the information to the user
+            return GraphicsResource(
+                page,
+                page->GpuAddress() + offset,
+                page->UploadResource(),
+                static_cast<BYTE*>(page->BaseMemory()) + offset,
+                offset,
+                size);
+        }
+
+        void FlushThreadCache() noexcept
+        {
+            if (t_pageCache.allocatorId == mId)
+            {
+                t_pageCache.Flush();
+                t_pageCache.allocatorId = 0;
+            }
+        }
+
         ComPtr<ID3D12Device> mDevice;
         std::array<std::unique_ptr<LinearAllocator>, AllocatorPoolCount> mPools;
+        const uint64_t mId;
+        std::atomic<uint64_t> mGeneration;
         mutable std::mutex mMutex;
     };
 
+    //--------------------------------------------------------------------------------------
+    // AllocationTelemetry : per-tag allocation counters
+    //--------------------------------------------------------------------------------------
+    // Counters are relaxed atomics so recording threads never wait on each other. The frame
+    // counters are folded into the peaks by EndFrame, which is only called from Commit.
+    class AllocationTelemetry
+    {
+    public:
+        static constexpr size_t TagCount = GraphicsMemory::TAG_COUNT;
+        static constexpr size_t HistogramBuckets = GraphicsMemoryTagStatistics::SizeHistogramBuckets;
+
+        AllocationTelemetry() noexcept
+        {
+            Reset();
+        }
+
+        AllocationTelemetry(AllocationTelemetry const&) = delete;
+        AllocationTelemetry& operator= (AllocationTelemetry const&) = delete;
+
+        void Record(uint32_t tag, size_t size, size_t padding) noexcept
+        {
+            auto& counters = mTags[GetTagIndex(tag)];
+            counters.allocations.fetch_add(1, std::memory_order_relaxed);
+            counters.bytes.fetch_add(size, std::memory_order_relaxed);
+            counters.alignmentWaste.fetch_add(padding, std::memory_order_relaxed);
+            counters.frameAllocations.fetch_add(1, std::memory_order_relaxed);
+            counters.frameBytes.fetch_add(size, std::memory_order_relaxed);
+            counters.sizeHistogram[GraphicsMemoryTagStatistics::GetSizeHistogramBucket(size)].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void EndFrame() noexcept
+        {
+            for (auto& counters : mTags)
+            {
+                const size_t frameAllocations = counters.frameAllocations.exchange(0, std::memory_order_relaxed);
+                const size_t frameBytes = counters.frameBytes.exchange(0, std::memory_order_relaxed);
+
+                if (frameAllocations > counters.peakFrameAllocations.load(std::memory_order_relaxed))
+                {
+                    counters.peakFrameAllocations.store(frameAllocations, std::memory_order_relaxed);
+                }
+                if (frameBytes > counters.peakFrameBytes.load(std::memory_order_relaxed))
+                {
+                    counters.peakFrameBytes.store(frameBytes, std::memory_order_relaxed);
+                }
+            }
+            mFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        void Reset() noexcept
+        {
+            for (auto& counters : mTags)
+            {
+                counters.allocations.store(0, std::memory_order_relaxed);
+                counters.bytes.store(0, std::memory_order_relaxed);
+                counters.alignmentWaste.store(0, std::memory_order_relaxed);
+                counters.frameAllocations.store(0, std::memory_order_relaxed);
+                counters.frameBytes.store(0, std::memory_order_relaxed);
+                counters.peakFrameAllocations.store(0, std::memory_order_relaxed);
+                counters.peakFrameBytes.store(0, std::memory_order_relaxed);
+                for (auto& bucket : counters.sizeHistogram)
+                {
+                    bucket.store(0, std::memory_order_relaxed);
+                }
+            }
+            mFrames.store(0, std::memory_order_relaxed);
+        }
+
+        void Get(uint32_t tag, GraphicsMemoryTagStatistics& stats) const noexcept
+        {
+            const auto& counters = mTags[GetTagIndex(tag)];
+
+            stats = {};
+            stats.allocations = counters.allocations.load(std::memory_order_relaxed);
+            stats.bytes = counters.bytes.load(std::memory_order_relaxed);
+            stats.alignmentWaste = counters.alignmentWaste.load(std::memory_order_relaxed);
+
+            // Include the frame in progress
+            stats.peakFrameAllocations = std::max(
+                counters.peakFrameAllocations.load(std::memory_order_relaxed),
+                counters.frameAllocations.load(std::memory_order_relaxed));
+            stats.peakFrameBytes = std::max(
+                counters.peakFrameBytes.load(std::memory_order_relaxed),
+                counters.frameBytes.load(std::memory_order_relaxed));
+
+            for (size_t i = 0; i < HistogramBuckets; ++i)
+            {
+                stats.sizeHistogram[i] = counters.sizeHistogram[i].load(std::memory_order_relaxed);
+            }
+        }
+
+        size_t GetFrameCount() const noexcept { return mFrames.load(std::memory_order_relaxed); }
+
+        static const char* GetTagName(uint32_t tag) noexcept
+        {
+            static const char* s_tagNames[TagCount] =
+            {
+                "generic",
+                "constant",
+                "vertex",
+                "index",
+                "sprites",
+                "texture",
+                "compute",
+            };
+            return s_tagNames[GetTagIndex(tag)];
+        }
+
+    private:
+        struct TagCounters
+        {
+            std::atomic<size_t> allocations;
+            std::atomic<size_t> bytes;
+            std::atomic<size_t> alignmentWaste;
+            std::atomic<size_t> frameAllocations;
+            std::atomic<size_t> frameBytes;
+            std::atomic<size_t> peakFrameAllocations;
+            std::atomic<size_t> peakFrameBytes;
+            std::atomic<size_t> sizeHistogram[HistogramBuckets];
+        };
+
+        static size_t GetTagIndex(uint32_t tag) noexcept
+        {
+            return (tag < TagCount) ? size_t(tag) : size_t(GraphicsMemory::TAG_GENERIC);
+        }
+
+        std::array<TagCounters, TagCount> mTags;
+        std::atomic<size_t> mFrames;
+    };
+
+    static_assert(GraphicsMemory::TAG_COUNT == 7, "AllocationTelemetry::GetTagName needs updating");
+
 #ifdef USING_PIX_CUSTOM_MEMORY_EVENTS
     constexpr uint16_t c_PIXAllocatorID = 1001;
 #endif
 } // anonymous namespace
 
 
+//--------------------------------------------------------------------------------------
+// GraphicsMemoryTagStatistics
+//--------------------------------------------------------------------------------------
+
+size_t GraphicsMemoryTagStatistics::GetSizeHistogramBucket(size_t size) noexcept
+{
+    size_t bucket = 0;
+    while (bucket + 1 < SizeHistogramBuckets && (size_t(1) << bucket) < size)
+    {
+        ++bucket;
+    }
+    return bucket;
+}
+
+
 //--------------------------------------------------------------------------------------
 // GraphicsMemory::Impl
 //--------------------------------------------------------------------------------------
@@ -238,6 +510,7 @@ public:
         , m_peakCommited(0)
         , m_peakBytes(0)
         , m_peakPages(0)
+        , mTelemetryEnabled(false)
     {
     #if (defined(_XBOX_ONE) && defined(_TITLE)) || defined(_GAMING_XBOX)
         if (s_graphicsMemory)
@@ -285,14 +558,32 @@ public:
     #endif
     }
 
-    GraphicsResource Allocate(size_t size, size_t alignment)
+    GraphicsResource Allocate(size_t size, size_t alignment, uint32_t tag)
     {
-        return mDeviceAllocator->Alloc(size, alignment);
+        size_t padding = 0;
+        auto alloc = mDeviceAllocator->Alloc(size, alignment, padding);
+
+        if (mTelemetryEnabled.load(std::memory_order_relaxed))
+        {
+            mTelemetry.Record(tag, size, padding);
+        }
+
+        return alloc;
     }
 
     void Commit(_In_ ID3D12CommandQueue* commandQueue)
     {
         mDeviceAllocator->KickFences(commandQueue);
+
+        if (mTelemetryEnabled.load(std::memory_order_relaxed))
+        {
+            mTelemetry.EndFrame();
+        }
+    }
+
+    void ReleaseThreadPages() noexcept
+    {
+        mDeviceAllocator->ReleaseThreadPages();
     }
 
     void GarbageCollect()
@@ -328,6 +619,95 @@ public:
         m_peakCommited = 0;
         m_peakBytes = 0;
         m_peakPages = 0;
+
+        mTelemetry.Reset();
+    }
+
+    void SetTelemetryEnabled(bool enabled) noexcept
+    {
+        mTelemetryEnabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    bool IsTelemetryEnabled() const noexcept
+    {
+        return mTelemetryEnabled.load(std::memory_order_relaxed);
+    }
+
+    void GetTagStatistics(uint32_t tag, GraphicsMemoryTagStatistics& stats) const noexcept
+    {
+        mTelemetry.Get(tag, stats);
+    }
+
+    std::string GetTelemetryJSON() const
+    {
+        std::string json = "{\n  \"frames\": " + std::to_string(mTelemetry.GetFrameCount()) + ",\n  \"tags\": [\n";
+
+        for (uint32_t tag = 0; tag < GraphicsMemory::TAG_COUNT; ++tag)
+        {
+            GraphicsMemoryTagStatistics stats;
+            mTelemetry.Get(tag, stats);
+
+            json += "    {\n      \"tag\": \"";
+            json += AllocationTelemetry::GetTagName(tag);
+            json += "\",\n      \"allocations\": " + std::to_string(stats.allocations);
+            json += ",\n      \"bytes\": " + std::to_string(stats.bytes);
+            json += ",\n      \"alignmentWaste\": " + std::to_string(stats.alignmentWaste);
+            json += ",\n      \"peakFrameAllocations\": " + std::to_string(stats.peakFrameAllocations);
+            json += ",\n      \"peakFrameBytes\": " + std::to_string(stats.peakFrameBytes);
+            json += ",\n      \"sizeHistogram\": [";
+
+            for (size_t i = 0; i < GraphicsMemoryTagStatistics::SizeHistogramBuckets; ++i)
+            {
+                if (i > 0)
+                {
+                    json += ", ";
+                }
+                json += std::to_string(stats.sizeHistogram[i]);
+            }
+
+            json += (tag + 1 < GraphicsMemory::TAG_COUNT) ? "]\n    },\n" : "]\n    }\n";
+        }
+
+        json += "  ]\n}\n";
+        return json;
+    }
+
+    std::string GetTelemetryCSV() const
+    {
+        char buff[256] = {};
+        std::string csv = "tag,allocations,bytes,alignment_waste,peak_frame_allocations,peak_frame_bytes";
+
+        // Histogram columns are named by the largest size counted in the bucket, except the
+        // open-ended last one, which is named by the size it starts above
+        constexpr size_t lastBucket = GraphicsMemoryTagStatistics::SizeHistogramBuckets - 1;
+        for (size_t i = 0; i < lastBucket; ++i)
+        {
+            std::snprintf(buff, sizeof(buff), ",size_le_%zu", size_t(1) << i);
+            csv += buff;
+        }
+        std::snprintf(buff, sizeof(buff), ",size_gt_%zu", size_t(1) << (lastBucket - 1));
+        csv += buff;
+        csv += "\n";
+
+        for (uint32_t tag = 0; tag < GraphicsMemory::TAG_COUNT; ++tag)
+        {
+            GraphicsMemoryTagStatistics stats;
+            mTelemetry.Get(tag, stats);
+
+            std::snprintf(buff, sizeof(buff), "%s,%zu,%zu,%zu,%zu,%zu",
+                AllocationTelemetry::GetTagName(tag), stats.allocations, stats.bytes,
+                stats.alignmentWaste, stats.peakFrameAllocations, stats.peakFrameBytes);
+            csv += buff;
+
+            for (size_t i = 0; i < GraphicsMemoryTagStatistics::SizeHistogramBuckets; ++i)
+            {
+                std::snprintf(buff, sizeof(buff), ",%zu", stats.sizeHistogram[i]);
+                csv += buff;
+            }
+            csv += "\n";
+        }
+
+        return csv;
     }
 
     GraphicsMemory* mOwner;
@@ -343,6 +723,9 @@ private:
     size_t  m_peakCommited;
     size_t  m_peakBytes;
     size_t  m_peakPages;
+
+    std::atomic<bool>   mTelemetryEnabled;
+    AllocationTelemetry mTelemetry;
 };
 
 #if (defined(_XBOX_ONE) && defined(_TITLE)) || defined(_GAMING_XBOX)
@@ -385,10 +768,10 @@ GraphicsMemory& GraphicsMemory::operator= (GraphicsMemory&& moveFrom) noexcept
 GraphicsMemory::~GraphicsMemory() = default;
 
 
-GraphicsResource GraphicsMemory::AllocateImpl(size_t size, size_t alignment)
+GraphicsResource GraphicsMemory::AllocateImpl(size_t size, size_t alignment, uint32_t tag)
 {
     assert(alignment >= 4); // Should use at least DWORD alignment
-    return pImpl->Allocate(size, alignment);
+    return pImpl->Allocate(size, alignment, tag);
 }
 
 
@@ -398,6 +781,12 @@ void GraphicsMemory::Commit(_In_ ID3D12CommandQueue* commandQueue)
 }
 
 
+void GraphicsMemory::ReleaseThreadPages() noexcept
+{
+    pImpl->ReleaseThreadPages();
+}
+
+
 void GraphicsMemory::GarbageCollect()
 {
     pImpl->GarbageCollect();
@@ -415,6 +804,33 @@ void GraphicsMemory::ResetStatistics()
     pImpl->ResetStatistics();
 }
 
+void GraphicsMemory::SetTelemetryEnabled(bool enabled) noexcept
+{
+    pImpl->SetTelemetryEnabled(enabled);
+}
+
+bool GraphicsMemory::IsTelemetryEnabled() const noexcept
+{
+    return pImpl->IsTelemetryEnabled();
+}
+
+GraphicsMemoryTagStatistics GraphicsMemory::GetTagStatistics(uint32_t tag) const noexcept
+{
+    GraphicsMemoryTagStatistics stats;
+    pImpl->GetTagStatistics(tag, stats);
+    return stats;
+}
+
+std::string GraphicsMemory::GetTelemetryJSON() const
+{
+    return pImpl->GetTelemetryJSON();
+}
+
+std::string GraphicsMemory::GetTelemetryCSV() const
+{
+    return pImpl->GetTelemetryCSV();
+}
+
 #if (defined(_XBOX_ONE) && defined(_TITLE)) || defined(_GAMING_XBOX)
 GraphicsMemory& GraphicsMemory::Get(_In_opt_ ID3D12Device*)
 {
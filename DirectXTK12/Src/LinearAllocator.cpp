@@ -36,17 +36,36 @@ LinearAllocatorPage::LinearAllocatorPage() noexcept
 
 size_t LinearAllocatorPage::Suballocate(_In_ size_t size, _In_ size_t alignment)
 {
-    const size_t offset = AlignUp(mOffset, alignment);
-    if (offset + size > mSize)
+    size_t offset = 0;
+    if (!TrySuballocate(size, alignment, offset))
     {
         // Use of suballocate should be limited to pages with free space,
         // so really shouldn't happen.
         throw std::runtime_error("LinearAllocatorPage::Suballocate");
     }
-    mOffset = offset + size;
     return offset;
 }
 
+bool LinearAllocatorPage::TrySuballocate(_In_ size_t size, _In_ size_t alignment, _Out_ size_t& offset, _Out_opt_ size_t* padding) noexcept
+{
+    size_t current = mOffset.load(std::memory_order_relaxed);
+    do
+    {
+        offset = AlignUp(current, alignment);
+        if (offset + size > mSize)
+        {
+            offset = 0;
+            return false;
+        }
+    } while (!mOffset.compare_exchange_weak(current, offset + size, std::memory_order_relaxed));
+
+    if (padding)
+    {
+        *padding = offset - current;
+    }
+    return true;
+}
+
 void LinearAllocatorPage::Release() noexcept
 {
     assert(mRefCount > 0);
@@ -67,6 +86,7 @@ LinearAllocator::LinearAllocator(
     : m_pendingPages(nullptr)
     , m_usedPages(nullptr)
     , m_unusedPages(nullptr)
+    , m_currentPage(nullptr)
     , m_increment(pageSize)
     , m_numPending(0)
     , m_totalPages(0)
@@ -112,6 +132,7 @@ LinearAllocator::~LinearAllocator()
     m_pendingPages = nullptr;
     m_usedPages = nullptr;
     m_unusedPages = nullptr;
+    m_currentPage = nullptr;
     m_increment = 0;
 }
 
@@ -142,7 +163,9 @@ void LinearAllocator::FenceCommittedPages(_In_ ID3D12CommandQueue* commandQueue)
     if (m_usedPages == nullptr)
         return;
 
-    // For all the used pages, fence them
+    // For all the used pages, fence them. Every page that is ready this frame shares one
+    // fence value, so the queue is signaled once per call rather than once per page.
+    const uint64_t fenceValue = m_fenceCount + 1;
     UINT numReady = 0;
     LinearAllocatorPage* readyPages = nullptr;
     LinearAllocatorPage* unreadyPages = nullptr;
@@ -157,10 +180,14 @@ void LinearAllocator::FenceCommittedPages(_In_ ID3D12CommandQueue* commandQueue)
         // This implies the allocator is the only remaining reference to the page, and therefore the memory is ready for re-use.
         if (page->RefCount() == 1)
         {
-            // Signal the fence
             numReady++;
-            page->mPendingFence = ++m_fenceCount;
-            ThrowIfFailed(commandQueue->Signal(m_fence.Get(), m_fenceCount));
+            page->mPendingFence = fenceValue;
+
+            // The page can't take any more allocations once it is in flight
+            if (page == m_currentPage)
+            {
+                m_currentPage = nullptr;
+            }
 
             // Link to the ready pages list
             page->pNextPage = readyPages;
@@ -176,6 +203,13 @@ void LinearAllocator::FenceCommittedPages(_In_ ID3D12CommandQueue* commandQueue)
         }
     }
 
+    // Signal the fence
+    if (numReady > 0)
+    {
+        m_fenceCount = fenceValue;
+        ThrowIfFailed(commandQueue->Signal(m_fence.Get(), m_fenceCount));
+    }
+
     // Replace the used pages list with the new unready list
     m_usedPages = unreadyPages;
 
@@ -259,28 +293,22 @@ LinearAllocatorPage* LinearAllocator::GetPageForAlloc(
         return GetCleanPageForAlloc();
     }
 
-    // Find a page in the pending pages list that has space.
-    auto page = FindPageForAlloc(m_usedPages, sizeBytes, alignment);
-    if (!page)
+    // Bump into the current page while it has room, otherwise start a new one. Partly used
+    // pages left behind are not searched again; they are fenced with the rest of the used pages.
+    if (m_currentPage)
     {
-        page = GetCleanPageForAlloc();
+        const size_t offset = AlignUp(m_currentPage->BytesUsed(), alignment);
+        if (offset + sizeBytes <= m_increment)
+            return m_currentPage;
     }
 
-    return page;
-}
-
-LinearAllocatorPage* LinearAllocator::FindPageForAlloc(
-    LinearAllocatorPage* list,
-    size_t sizeBytes,
-    size_t alignment) noexcept
-{
-    for (auto page = list; page != nullptr; page = page->pNextPage)
+    auto page = GetCleanPageForAlloc();
+    if (page)
     {
-        const size_t offset = AlignUp(page->mOffset, alignment);
-        if (offset + sizeBytes <= m_increment)
-            return page;
+        m_currentPage = page;
     }
-    return nullptr;
+
+    return page;
 }
 
 LinearAllocatorPage* LinearAllocator::GetNewPage()
@@ -60,10 +60,15 @@ namespace DirectX
 
         size_t Suballocate(_In_ size_t size, _In_ size_t alignment);
 
+        // Lock-free version of Suballocate that returns false when the page is full.
+        // Safe to call concurrently from multiple threads holding a reference to the page.
+        // padding receives the bytes skipped to align the allocation.
+        bool TrySuballocate(_In_ size_t size, _In_ size_t alignment, _Out_ size_t& offset, _Out_opt_ size_t* padding = nullptr) noexcept;
+
         void* BaseMemory() const noexcept { return mMemory; }
         ID3D12Resource* UploadResource() const noexcept { return mUploadResource.Get(); }
         D3D12_GPU_VIRTUAL_ADDRESS GpuAddress() const noexcept { return mGpuAddress; }
-        size_t BytesUsed() const noexcept { return mOffset; }
+        size_t BytesUsed() const noexcept { return mOffset.load(std::memory_order_relaxed); }
         size_t Size() const noexcept { return mSize; }
 
         void AddRef() noexcept { mRefCount.fetch_add(1); }
@@ -79,7 +84,7 @@ namespace DirectX
         void*                                   mMemory;
         uint64_t                                mPendingFence;
         D3D12_GPU_VIRTUAL_ADDRESS               mGpuAddress;
-        size_t                                  mOffset;
+        std::atomic<size_t>                     mOffset;
         size_t                                  mSize;
         Microsoft::WRL::ComPtr<ID3D12Resource>  mUploadResource;
 
@@ -136,6 +141,7 @@ namespace DirectX
         LinearAllocatorPage*                    m_pendingPages; // Pages in use by the GPU
         LinearAllocatorPage*                    m_usedPages;    // Pages to be submitted to the GPU
         LinearAllocatorPage*                    m_unusedPages;  // Pages not being used right now
+        LinearAllocatorPage*                    m_currentPage;  // Used page that sub-page requests are bumped into
         size_t                                  m_increment;
         size_t                                  m_numPending;
         size_t                                  m_totalPages;
@@ -146,8 +152,6 @@ namespace DirectX
         LinearAllocatorPage* GetPageForAlloc(size_t sizeBytes, size_t alignment);
         LinearAllocatorPage* GetCleanPageForAlloc();
 
-        LinearAllocatorPage* FindPageForAlloc(LinearAllocatorPage* list, size_t sizeBytes, size_t alignment) noexcept;
-
         LinearAllocatorPage* GetNewPage();
 
         void UnlinkPage(LinearAllocatorPage* page) noexcept;
@@ -17,6 +17,7 @@
 #include "PlatformHelpers.h"
 #include "ResourceUploadBatch.h"
 #include "SharedResourcePool.h"
+#include "SpriteSort.h"
 #include "VertexTypes.h"
 
 using namespace DirectX;
@@ -51,10 +52,6 @@ namespace
     {
         return a.ptr != b.ptr;
     }
-    inline bool operator < (D3D12_GPU_DESCRIPTOR_HANDLE a, D3D12_GPU_DESCRIPTOR_HANDLE b) noexcept
-    {
-        return a.ptr < b.ptr;
-    }
 
     // Helper converts a RECT to XMVECTOR.
     inline XMVECTOR LoadRect(_In_ RECT const* rect) noexcept
@@ -169,6 +166,10 @@ private:
     // mSpriteQueue array, and we take care to keep them in order when sorting is disabled.
     std::vector<SpriteInfo const*> mSortedSprites;
 
+    // Key arrays for SortSprites, kept between batches to avoid reallocating.
+    std::vector<SpriteSort::Key> mSortKeys;
+    std::vector<SpriteSort::Key> mSortKeysScratch;
+
 
     // Mode settings from the last Begin call.
     bool mInBeginEndPair;
@@ -733,40 +734,53 @@ void SpriteBatch::Impl::SortSprites()
         GrowSortedSprites();
     }
 
-    switch (mSortMode)
+    if (mSortMode != SpriteSortMode_Texture
+        && mSortMode != SpriteSortMode_BackToFront
+        && mSortMode != SpriteSortMode_FrontToBack)
     {
-    case SpriteSortMode_Texture:
-        // Sort by texture.
-        std::sort(mSortedSprites.begin(),
-            mSortedSprites.begin() + static_cast<int>(mSpriteQueueCount),
-            [](SpriteInfo const* x, SpriteInfo const* y) noexcept -> bool
-            {
-                return x->texture < y->texture;
-            });
-        break;
-
-    case SpriteSortMode_BackToFront:
-        // Sort back to front.
-        std::sort(mSortedSprites.begin(),
-            mSortedSprites.begin() + static_cast<int>(mSpriteQueueCount),
-            [](SpriteInfo const* x, SpriteInfo const* y) noexcept -> bool
-            {
-                return x->originRotationDepth.w > y->originRotationDepth.w;
-            });
-        break;
-
-    case SpriteSortMode_FrontToBack:
-        // Sort front to back.
-        std::sort(mSortedSprites.begin(),
-            mSortedSprites.begin() + static_cast<int>(mSpriteQueueCount),
-            [](SpriteInfo const* x, SpriteInfo const* y) noexcept -> bool
-            {
-                return x->originRotationDepth.w < y->originRotationDepth.w;
-            });
-        break;
+        return;
+    }
 
-    default:
-        break;
+    if (mSpriteQueueCount > UINT32_MAX)
+        throw std::overflow_error("Too many sprites to sort");
+
+    // Build a key for each sprite in queue order. The radix sort is stable, so sprites with equal
+    // keys keep the order they were drawn in.
+
+    mSortKeys.resize(mSpriteQueueCount);
+    mSortKeysScratch.resize(mSpriteQueueCount);
+
+    for (size_t i = 0; i < mSpriteQueueCount; i++)
+    {
+        SpriteInfo const& sprite = mSpriteQueue[i];
+
+        uint64_t key;
+        switch (mSortMode)
+        {
+        case SpriteSortMode_Texture:
+            // Sort by texture.
+            key = sprite.texture.ptr;
+            break;
+
+        case SpriteSortMode_BackToFront:
+            // Sort back to front.
+            key = ~SpriteSort::FloatToSortableKey(sprite.originRotationDepth.w);
+            break;
+
+        default:
+            // Sort front to back.
+            key = SpriteSort::FloatToSortableKey(sprite.originRotationDepth.w);
+            break;
+        }
+
+        mSortKeys[i] = { key, static_cast<uint32_t>(i) };
+    }
+
+    SpriteSort::Key const* sorted = SpriteSort::RadixSort(mSortKeys.data(), mSortKeysScratch.data(), mSpriteQueueCount);
+
+    for (size_t i = 0; i < mSpriteQueueCount; i++)
+    {
+        mSortedSprites[i] = &mSpriteQueue[sorted[i].index];
     }
 }
 
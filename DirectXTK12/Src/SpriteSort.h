@@ -0,0 +1,105 @@
+//--------------------------------------------------------------------------------------
+// File: SpriteSort.h
+//
+// Copyright (c) Microsoft Corporation.
+// Licensed under the MIT License.
+//
+// http://go.microsoft.com/fwlink/?LinkId=248929
+// http://go.microsoft.com/fwlink/?LinkID=615561
+//--------------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+
+namespace DirectX
+{
+    namespace SpriteSort
+    {
+        // Sort key for one queued sprite, and its position in the queue.
+        struct Key
+        {
+            uint64_t key;
+            uint32_t index;
+        };
+
+        // Maps a float to an unsigned integer with the same ordering. -0.0 maps to the same key
+        // as +0.0, since they compare equal.
+        inline uint32_t FloatToSortableKey(float value) noexcept
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            if (bits == 0x80000000u)
+                bits = 0;
+            return (bits & 0x80000000u) ? ~bits : (bits | 0x80000000u);
+        }
+
+        // Below this many keys a comparison sort is faster than the radix passes.
+        constexpr size_t RadixSortThreshold = 1024;
+
+        // Stable LSD radix sort by key, eight bits per pass. A pass in which every key has the same
+        // digit is skipped, so depth keys cost at most four passes and descriptor handles (which
+        // differ only in their low bits) usually two or three. Short arrays are sorted in place by
+        // key then index instead, which gives the same order. Returns whichever of keys or scratch
+        // holds the result.
+        inline Key* RadixSort(_Inout_updates_(count) Key* keys, _Inout_updates_(count) Key* scratch, size_t count) noexcept
+        {
+            assert(count > 0);
+
+            if (count < RadixSortThreshold)
+            {
+                std::sort(keys, keys + count, [](Key const& x, Key const& y) noexcept -> bool
+                    {
+                        return (x.key != y.key) ? (x.key < y.key) : (x.index < y.index);
+                    });
+                return keys;
+            }
+
+            constexpr size_t DigitCount = sizeof(uint64_t);
+            constexpr size_t BucketCount = 256;
+
+            uint32_t histograms[DigitCount][BucketCount] = {};
+            for (size_t i = 0; i < count; ++i)
+            {
+                const uint64_t key = keys[i].key;
+                for (size_t digit = 0; digit < DigitCount; ++digit)
+                {
+                    histograms[digit][(key >> (digit * 8)) & 0xff]++;
+                }
+            }
+
+            Key* src = keys;
+            Key* dest = scratch;
+            for (size_t digit = 0; digit < DigitCount; ++digit)
+            {
+                uint32_t* histogram = histograms[digit];
+                const size_t shift = digit * 8;
+                if (histogram[(src[0].key >> shift) & 0xff] == count)
+                    continue;
+
+                uint32_t offset = 0;
+                for (size_t bucket = 0; bucket < BucketCount; ++bucket)
+                {
+                    const uint32_t bucketCount = histogram[bucket];
+                    histogram[bucket] = offset;
+                    offset += bucketCount;
+                }
+
+                for (size_t i = 0; i < count; ++i)
+                {
+                    dest[histogram[(src[i].key >> shift) & 0xff]++] = src[i];
+                }
+
+                std::swap(src, dest);
+            }
+
+            return src;
+        }
+    }
+}
@@ -70,6 +70,8 @@ void D3D12App::InitCommandQueue()
     ThrowIfFailed(Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&CommandAllocator)));
     ThrowIfFailed(Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, CommandAllocator.Get(), nullptr, IID_PPV_ARGS(&CommandList)));
     CommandList->Close();
+
+    QueueSync = std::make_unique<D3D12QueueFence>(CommandQueue.Get(), Fence.Get());
 }
 
 void D3D12App::InitDescriptorHeap()
@@ -363,14 +365,31 @@ void D3D12App::OnResize()
 
 void D3D12App::FlushCommandQueue()
 {
-    CurrentFence++;
+    QueueSync->Flush();
+}
+
+D3D12QueueFence::D3D12QueueFence(ID3D12CommandQueue* queue, ID3D12Fence* fence)
+    : Queue(queue), Fence(fence), LastValue(fence->GetCompletedValue())
+{
+}
+
+std::uint64_t D3D12QueueFence::Signal()
+{
+    ThrowIfFailed(Queue->Signal(Fence, ++LastValue));
+    return LastValue;
+}
 
-    ThrowIfFailed(CommandQueue->Signal(Fence.Get(), CurrentFence));
+std::uint64_t D3D12QueueFence::GetCompletedValue()
+{
+    return Fence->GetCompletedValue();
+}
 
-    if(Fence->GetCompletedValue() < CurrentFence)
+void D3D12QueueFence::WaitForValue(std::uint64_t value)
+{
+    if(Fence->GetCompletedValue() < value)
     {
         HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
-        ThrowIfFailed(Fence->SetEventOnCompletion(CurrentFence, eventHandle));
+        ThrowIfFailed(Fence->SetEventOnCompletion(value, eventHandle));
         WaitForSingleObject(eventHandle, INFINITE);
         CloseHandle(eventHandle);
     }
@@ -394,6 +413,7 @@ void D3D12App::Main()
             Timer.Tick();
             Update(Timer);
             Render(Timer);
+            UpdateFrameStats();
             /*
             if(!Paused)
             {
@@ -410,6 +430,26 @@ void D3D12App::Main()
 
 }
 
+void D3D12App::UpdateFrameStats()
+{
+    // Averaged over a second, so the numbers stay readable.
+    FrameStatsCount++;
+    float elapsed = Timer.GetTotalTime() - FrameStatsStart;
+    if(elapsed < 1.0f)
+    {
+        return;
+    }
+
+    float fps = FrameStatsCount / elapsed;
+    wchar_t caption[128];
+    StringCchPrintfW(caption, ARRAYSIZE(caption), L"D3D12App    fps: %.0f    frame: %.2f ms", fps, 1000.0f / fps);
+    std::wstring title = caption + GetFrameStatsText();
+    SetWindowText(mHWnd, title.c_str());
+
+    FrameStatsCount = 0;
+    FrameStatsStart += elapsed;
+}
+
 D3D12App *D3D12App::Get()
 {
     return AppInstance;
@@ -1,9 +1,26 @@
 #pragma once
 #include "D3DUtil.h"
 #include "GameTimer.h"
+#include "FrameRing.h"
 
 using Microsoft::WRL::ComPtr;
 
+// QueueFence on a command queue and a fence owned by the caller.
+class D3D12QueueFence : public QueueFence
+{
+public:
+	D3D12QueueFence(ID3D12CommandQueue* queue, ID3D12Fence* fence);
+
+	std::uint64_t Signal() override;
+	std::uint64_t GetCompletedValue() override;
+	void WaitForValue(std::uint64_t value) override;
+
+private:
+	ID3D12CommandQueue* Queue = nullptr;
+	ID3D12Fence* Fence = nullptr;
+	UINT64 LastValue = 0;
+};
+
 class D3D12App
 {
 
@@ -25,6 +42,9 @@ protected:
 	virtual void OnMouseUp(WPARAM btnState, int x, int y) { }
 	virtual void OnMouseMove(WPARAM btnState, int x, int y) { }
 
+	// Appended to the frame rate in the window title, which is updated once a second.
+	virtual std::wstring GetFrameStatsText()const { return std::wstring(); }
+
 	static D3D12App* AppInstance;
 
 	HINSTANCE HInstance;
@@ -49,7 +69,7 @@ protected:
 	ComPtr<ID3D12DescriptorHeap> RtvHeap;
 	ComPtr<ID3D12DescriptorHeap> DsvHeap;
 	
-	UINT64 CurrentFence;
+	std::unique_ptr<D3D12QueueFence> QueueSync;
 
 	UINT CurrentBackBufferIndex;
 
@@ -59,6 +79,7 @@ protected:
     void InitCommandQueue();
 	void InitDescriptorHeap();
 	void FlushCommandQueue();
+	void UpdateFrameStats();
 
 	ID3D12Resource* CurrentBackBuffer()const;
 	D3D12_CPU_DESCRIPTOR_HANDLE CurrentBackBufferView()const;
@@ -81,4 +102,6 @@ protected:
 	DXGI_FORMAT DepthStencilFormat = DXGI_FORMAT_D24_UNORM_S8_UINT;
 
 	GameTimer Timer;
+	int FrameStatsCount = 0;
+	float FrameStatsStart = 0.0f;
 };
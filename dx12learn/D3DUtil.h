@@ -1,9 +1,14 @@
 #pragma once
 #include <DirectXCollision.h>
+#include <cassert>
 #include <unordered_map>
 #include <shlobj.h>
 #include <strsafe.h>
 #include "MathHelper.h"
+#include "MappedFile.h"
+#include "JsonUtil.h"
+#include "Material.h"
+#include "SubmeshGeometry.h"
 
 
 using Microsoft::WRL::ComPtr;
@@ -96,16 +101,6 @@ public:
         const std::string& target);
 };
 
-struct SubmeshGeometry
-{
-    UINT IndexCount = 0;
-    UINT StartIndexLocation = 0;
-    INT BaseVertexLocation = 0;
-
-    DirectX::BoundingBox Bounds;
-    std::string MaterialName;
-};
-
 struct MeshGeometry
 {
     std::string Name;
@@ -160,21 +155,6 @@ struct MaterialConstants
     XMFLOAT4X4 MatTransform = MathHelper::Identity4x4();
 };
 
-struct Material
-{
-    std::string Name;
-    int MatCBIndex = -1;
-    int DiffuseSrvHeapIndex = -1;
-    int NormalSrvHeapIndex = -1;
-    int NumFramesDirty = 3;
-    UINT MaterialPad0;
-
-    XMFLOAT4 DiffuseAlbedo = { 1.0f, 1.0f, 1.0f, 1.0f };
-    XMFLOAT3 FresnelR0 = { 0.01f, 0.01f, 0.01f };
-    float Roughness = .25f;
-    XMFLOAT4X4 MatTransform = MathHelper::Identity4x4();
-};
-
 #define MaxLights 16
 
 struct Light
@@ -191,7 +171,20 @@ template<typename T>
 class UploadBuffer
 {
 public:
+    // Mapped range of consecutive elements. Upload heap memory is write-combined:
+    // fill it front to back in whole elements and never read it back.
+    struct Span
+    {
+        T* Data = nullptr;
+        UINT Count = 0;
+
+        T* begin()const { return Data; }
+        T* end()const { return Data + Count; }
+        T& operator[](UINT i)const { return Data[i]; }
+    };
+
     UploadBuffer(ID3D12Device* device, UINT elementCount, bool isConstantBuffer) :
+        ElementCount(elementCount),
         IsConstantBuffer(isConstantBuffer)
     {
         ElementByteSize = sizeof(T);
@@ -230,15 +223,47 @@ public:
         return Buffer.Get();
     }
 
+    UINT GetElementCount()const
+    {
+        return ElementCount;
+    }
+
     void CopyData(int elementIndex, const T& data)
     {
         memcpy(&MappedData[elementIndex * ElementByteSize], &data, sizeof(T));
     }
 
+    // Copies count consecutive elements in one go. Not for constant buffers,
+    // whose elements are padded to 256 bytes.
+    void CopyData(int firstElement, const T* data, UINT count)
+    {
+        assert(!IsConstantBuffer);
+        assert(firstElement + count <= ElementCount);
+        memcpy(&MappedData[firstElement * ElementByteSize], data, count * sizeof(T));
+    }
+
+    // Typed view of mapped elements for callers that generate the data in place.
+    // Not for constant buffers.
+    Span GetSpan(UINT firstElement, UINT count)
+    {
+        assert(!IsConstantBuffer);
+        assert(firstElement + count <= ElementCount);
+        Span span;
+        span.Data = reinterpret_cast<T*>(MappedData) + firstElement;
+        span.Count = count;
+        return span;
+    }
+
+    Span GetSpan()
+    {
+        return GetSpan(0, ElementCount);
+    }
+
 private:
     Microsoft::WRL::ComPtr<ID3D12Resource> Buffer;
     BYTE* MappedData = nullptr;
 
+    UINT ElementCount = 0;
     UINT ElementByteSize = 0;
     bool IsConstantBuffer = false;
 };
@@ -264,20 +289,3 @@ struct TextureDesc
 
     TextureDesc() = delete;
 };
-
-class JsonUtil
-{
-public:
-    static bool FromJsonArray(simdjson::ondemand::array& JsonArray, XMFLOAT3& out);
-    static bool FromJsonArray(simdjson::ondemand::array& JsonArray, XMFLOAT4& out);
-    static bool FromJsonArray(simdjson::ondemand::array& JsonArray, XMFLOAT4X4& out);
-
-    static bool ExtractFieldFromObject(simdjson::ondemand::object& JsonObject, const char* key, int& out);
-    static bool ExtractFieldFromObject(simdjson::ondemand::object& JsonObject, const char* key, float& out);
-    static bool ExtractFieldFromObject(simdjson::ondemand::object& JsonObject, const char* key, std::string_view& out);
-    static bool ExtractFieldFromObject(simdjson::ondemand::object& JsonObject, const char* key, XMFLOAT3& out);
-    static bool ExtractFieldFromObject(simdjson::ondemand::object& JsonObject, const char* key, XMFLOAT4& out);
-    static bool ExtractFieldFromObject(simdjson::ondemand::object& JsonObject, const char* key, XMFLOAT4X4& out);
-
-
-};
\ No newline at end of file
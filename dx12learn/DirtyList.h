@@ -0,0 +1,60 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Constant buffer entries that some frame resource has not received yet.
+//
+// Mark queues an entry once and (re)starts its countdown at the number of frame
+// resources. Update then writes only the queued entries, once per frame, and
+// drops each one when its countdown runs out, so every frame resource gets the
+// latest value without visiting unchanged entries.
+class DirtyList
+{
+public:
+    explicit DirtyList(int frameResourceCount) : FrameResourceCount(frameResourceCount) {}
+
+    // Number of entries that can be marked; new ones start clean.
+    void Resize(size_t count) { FramesLeft.resize(count, 0); }
+    size_t GetCount()const { return FramesLeft.size(); }
+
+    void Mark(std::uint32_t index)
+    {
+        if(FramesLeft[index] == 0)
+        {
+            Indices.push_back(index);
+        }
+        FramesLeft[index] = FrameResourceCount;
+    }
+
+    bool IsDirty(std::uint32_t index)const { return FramesLeft[index] > 0; }
+    // Frame resources that still need the entry, 0 once it left the list.
+    int GetFramesLeft(std::uint32_t index)const { return FramesLeft[index]; }
+    size_t GetDirtyCount()const { return Indices.size(); }
+
+    // Calls write(index) for every queued entry, in ascending order so the
+    // writes are one forward sweep over the mapped buffer, and counts the
+    // current frame resource off.
+    template<typename WriteFn>
+    void Update(WriteFn write)
+    {
+        std::sort(Indices.begin(), Indices.end());
+        size_t kept = 0;
+        for(std::uint32_t index : Indices)
+        {
+            write(index);
+            if(--FramesLeft[index] > 0)
+            {
+                Indices[kept++] = index;
+            }
+        }
+        Indices.resize(kept);
+    }
+
+private:
+    int FrameResourceCount;
+    std::vector<std::uint32_t> Indices;
+    // per entry, 0 when it is not queued
+    std::vector<int> FramesLeft;
+};
@@ -0,0 +1,104 @@
+#include "DrawSubmission.h"
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <vector>
+
+void DrawStats::Add(const DrawStats& other)
+{
+    Draws += other.Draws;
+    PipelineSets += other.PipelineSets;
+    GeometrySets += other.GeometrySets;
+    TopologySets += other.TopologySets;
+    MaterialSets += other.MaterialSets;
+    SkippedSets += other.SkippedSets;
+}
+
+DrawStats SubmitDrawPackets(DrawRecorder& recorder, const DrawPacket* packets, size_t count)
+{
+    DrawStats stats;
+    if(count == 0)
+    {
+        return stats;
+    }
+
+    // state bound by the previous draw; packets are sorted so neighbours mostly share it
+    const DrawPacket* current = nullptr;
+    for(size_t i = 0; i < count; ++i)
+    {
+        const DrawPacket& packet = packets[i];
+
+        if(current == nullptr || packet.Pipeline != current->Pipeline)
+        {
+            recorder.SetPipeline(packet.Pipeline);
+            stats.PipelineSets++;
+        }
+        else
+        {
+            stats.SkippedSets++;
+        }
+
+        if(current == nullptr || packet.Geometry != current->Geometry)
+        {
+            recorder.SetGeometry(packet.Geometry);
+            stats.GeometrySets++;
+        }
+        else
+        {
+            stats.SkippedSets++;
+        }
+
+        if(current == nullptr || packet.Topology != current->Topology)
+        {
+            recorder.SetTopology(packet.Topology);
+            stats.TopologySets++;
+        }
+        else
+        {
+            stats.SkippedSets++;
+        }
+
+        if(current == nullptr || packet.Material != current->Material)
+        {
+            recorder.SetMaterial(packet.Material);
+            stats.MaterialSets++;
+        }
+        else
+        {
+            stats.SkippedSets++;
+        }
+
+        recorder.Draw(packet);
+        stats.Draws++;
+        current = &packet;
+    }
+    return stats;
+}
+
+size_t GetDrawChunkCount(size_t drawCount, size_t listCount, size_t minDrawsPerChunk)
+{
+    size_t chunkCount = (std::min)(listCount, drawCount / (std::max)(minDrawsPerChunk, size_t(1)));
+    return (std::max)(chunkCount, size_t(1));
+}
+
+DrawStats RecordDrawChunks(ThreadPool& pool, const DrawPacket* packets, size_t count, DrawListRecorder* const* lists, size_t listCount)
+{
+    std::vector<DrawStats> chunkStats(listCount);
+    pool.ParallelFor(listCount, [&](size_t chunk)
+    {
+        size_t first = chunk * count / listCount;
+        size_t last = (chunk + 1) * count / listCount;
+
+        DrawListRecorder& list = *lists[chunk];
+        list.Begin();
+        chunkStats[chunk] = SubmitDrawPackets(list, packets + first, last - first);
+        list.End(chunk == listCount - 1);
+    });
+
+    DrawStats stats;
+    for(const DrawStats& chunk : chunkStats)
+    {
+        stats.Add(chunk);
+    }
+    return stats;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+class ThreadPool;
+
+// One draw in submission order. Key decides the order (see
+// DemoApp::BuildDrawPackets for its layout); the other fields are the state the
+// draw needs bound, as handles only the DrawRecorder interprets. Draws with
+// equal handles share that state.
+struct DrawPacket
+{
+    std::uint64_t Key = 0;
+    std::uint32_t Pipeline = 0;
+    std::uint32_t Topology = 0;
+    const void* Geometry = nullptr;
+    const void* Material = nullptr;
+    // the render item drawn
+    const void* Item = nullptr;
+};
+
+// State set calls issued by SubmitDrawPackets, and the ones it skipped because
+// the previous draw had already set the same state.
+struct DrawStats
+{
+    std::uint32_t Draws = 0;
+    std::uint32_t PipelineSets = 0;
+    std::uint32_t GeometrySets = 0;
+    std::uint32_t TopologySets = 0;
+    std::uint32_t MaterialSets = 0;
+    std::uint32_t SkippedSets = 0;
+
+    std::uint32_t GetStateSets()const { return PipelineSets + GeometrySets + TopologySets + MaterialSets; }
+    void Add(const DrawStats& other);
+};
+
+// Where SubmitDrawPackets records to. The application implements it on a
+// command list; CountingDrawRecorder only counts, so the state changes of a
+// frame can be measured without a device.
+class DrawRecorder
+{
+public:
+    virtual ~DrawRecorder() = default;
+
+    virtual void SetPipeline(std::uint32_t pipeline) = 0;
+    virtual void SetGeometry(const void* geometry) = 0;
+    virtual void SetTopology(std::uint32_t topology) = 0;
+    virtual void SetMaterial(const void* material) = 0;
+    virtual void Draw(const DrawPacket& packet) = 0;
+};
+
+class CountingDrawRecorder : public DrawRecorder
+{
+public:
+    void SetPipeline(std::uint32_t) override { Counts.PipelineSets++; }
+    void SetGeometry(const void*) override { Counts.GeometrySets++; }
+    void SetTopology(std::uint32_t) override { Counts.TopologySets++; }
+    void SetMaterial(const void*) override { Counts.MaterialSets++; }
+    void Draw(const DrawPacket&) override { Counts.Draws++; }
+
+    // SkippedSets stays 0, the recorder never sees skipped calls.
+    DrawStats Counts;
+};
+
+// Records count packets in order and sets each piece of state only when it
+// differs from the previous draw's. Nothing is assumed to be bound before the
+// first packet.
+DrawStats SubmitDrawPackets(DrawRecorder& recorder, const DrawPacket* packets, size_t count);
+
+// A command list that records one chunk of a frame. Command lists inherit no
+// state, so Begin binds everything the draws need besides the packet state.
+class DrawListRecorder : public DrawRecorder
+{
+public:
+    // Opens the list and binds the pass.
+    virtual void Begin() = 0;
+    // Closes the list. last is set for the list that ends the frame.
+    virtual void End(bool last) = 0;
+};
+
+// How many chunks RecordDrawChunks should split drawCount draws into, given
+// listCount lists and at least minDrawsPerChunk draws per chunk. Always at least 1.
+size_t GetDrawChunkCount(size_t drawCount, size_t listCount, size_t minDrawsPerChunk);
+
+// Splits the packets into listCount contiguous chunks and records chunk i into
+// lists[i] on the pool, between its Begin and End. Executing the lists in order
+// draws the packets in order. Returns the stats of all chunks.
+//
+// An exception from a list is rethrown here after the other chunks have
+// stopped; chunks not started by then are skipped and the lists must not be
+// executed.
+DrawStats RecordDrawChunks(ThreadPool& pool, const DrawPacket* packets, size_t count, DrawListRecorder* const* lists, size_t listCount);
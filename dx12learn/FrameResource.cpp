@@ -1,16 +1,34 @@
 #include "FrameResource.h"
 
-FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount, UINT waveVertCount)
+#include <algorithm>
+
+FrameResource::FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount, UINT waveVertCount, UINT instanceCount, UINT chunkListCount)
 {
     ThrowIfFailed(device->CreateCommandAllocator(
         D3D12_COMMAND_LIST_TYPE_DIRECT,
         IID_PPV_ARGS(CmdListAlloc.GetAddressOf())));
 
+    ChunkCmdListAllocs.resize(chunkListCount);
+    ChunkCmdLists.resize(chunkListCount);
+    for(UINT i = 0; i < chunkListCount; ++i)
+    {
+        ThrowIfFailed(device->CreateCommandAllocator(
+            D3D12_COMMAND_LIST_TYPE_DIRECT,
+            IID_PPV_ARGS(ChunkCmdListAllocs[i].GetAddressOf())));
+        ThrowIfFailed(device->CreateCommandList(
+            0, D3D12_COMMAND_LIST_TYPE_DIRECT, ChunkCmdListAllocs[i].Get(), nullptr,
+            IID_PPV_ARGS(ChunkCmdLists[i].GetAddressOf())));
+        ThrowIfFailed(ChunkCmdLists[i]->Close());
+    }
+
     PassCB = std::make_unique<UploadBuffer<PassConstants>>(device, passCount, true);
     ObjectCB = std::make_unique<UploadBuffer<ObjectConstants>>(device, objectCount, true);
     MaterialCB = std::make_unique<UploadBuffer<MaterialConstants>>(device, materialCount, true);
 
     WavesVB = std::make_unique<UploadBuffer<Vertex>>(device, waveVertCount, false);
+
+    // a buffer can not be empty, keep one element for scenes without instancing
+    InstanceBuffer = std::make_unique<UploadBuffer<InstanceData>>(device, (std::max)(instanceCount, 1u), false);
 }
 
 FrameResource::~FrameResource()
@@ -1,12 +1,20 @@
 #pragma once
 
+#include <DirectXPackedVector.h>
 #include "MathHelper.h"
 #include "D3DUtil.h"
+#include "PackedVertex.h"
+#include "InstanceBatch.h"
 
 struct ObjectConstants
 {
     DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
     DirectX::XMFLOAT4X4 TexTransform = MathHelper::Identity4x4();
+    // Dequantizes PackedVertex positions: PosL = Pos * PositionScale + PositionBias.
+    XMFLOAT3 PositionScale = { 1.0f, 1.0f, 1.0f };
+    float cbPerObjectPad0 = 0.0f;
+    XMFLOAT3 PositionBias = { 0.0f, 0.0f, 0.0f };
+    float cbPerObjectPad1 = 0.0f;
 };
 
 struct PassConstants
@@ -35,30 +43,28 @@ struct PassConstants
     Light Lights[MaxLights];
 };
 
-struct Vertex
-{
-    DirectX::XMFLOAT3 Pos;
-    DirectX::XMFLOAT3 Normal;
-    DirectX::XMFLOAT2 TexC;
-    DirectX::XMFLOAT4 Color;
-};
-
 struct FrameResource
 {
 public:
 
-    FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount, UINT waveVertexCount);
+    FrameResource(ID3D12Device* device, UINT passCount, UINT objectCount, UINT materialCount, UINT waveVertexCount, UINT instanceCount, UINT chunkListCount);
     FrameResource(const FrameResource& rhs) = delete;
     FrameResource& operator=(const FrameResource& rhs) = delete;
     ~FrameResource();
 
     ComPtr<ID3D12CommandAllocator> CmdListAlloc;
 
+    // Command lists for recording draw chunks on worker threads, one allocator each.
+    // They are created closed.
+    std::vector<ComPtr<ID3D12CommandAllocator>> ChunkCmdListAllocs;
+    std::vector<ComPtr<ID3D12GraphicsCommandList>> ChunkCmdLists;
+
     std::unique_ptr<UploadBuffer<PassConstants>> PassCB = nullptr;
     std::unique_ptr<UploadBuffer<ObjectConstants>> ObjectCB = nullptr;
     std::unique_ptr<UploadBuffer<MaterialConstants>> MaterialCB = nullptr;
 
     std::unique_ptr<UploadBuffer<Vertex>> WavesVB = nullptr;
 
-    UINT64 Fence = 0;
+    // visible instances of every instanced render item, packed back to back each frame
+    std::unique_ptr<UploadBuffer<InstanceData>> InstanceBuffer = nullptr;
 };
\ No newline at end of file
@@ -0,0 +1,26 @@
+#include "FrameRing.h"
+
+#include <cassert>
+
+FrameRing::FrameRing(QueueFence& fence, size_t slotCount)
+    : Fence(fence), SlotFences(slotCount, 0)
+{
+    assert(slotCount > 0);
+    // the first BeginFrame hands out slot 0
+    CurrentSlot = slotCount - 1;
+}
+
+size_t FrameRing::BeginFrame()
+{
+    CurrentSlot = (CurrentSlot + 1) % SlotFences.size();
+    if(SlotFences[CurrentSlot] != 0)
+    {
+        Fence.WaitForValue(SlotFences[CurrentSlot]);
+    }
+    return CurrentSlot;
+}
+
+void FrameRing::EndFrame()
+{
+    SlotFences[CurrentSlot] = Fence.Signal();
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The part of a command queue that frame pacing needs: signal a fence after the
+// work submitted so far, and wait for it. D3D12QueueFence implements it on the
+// app's direct queue; the headless tests use a mock.
+class QueueFence
+{
+public:
+    virtual ~QueueFence() = default;
+
+    // Enqueues a signal behind all submitted work and returns its value. Values
+    // start at 1 and grow by one per call.
+    virtual std::uint64_t Signal() = 0;
+    virtual std::uint64_t GetCompletedValue() = 0;
+    // Blocks until the queue has passed value. Returns immediately if it already has.
+    virtual void WaitForValue(std::uint64_t value) = 0;
+
+    // Returns once everything submitted so far has finished.
+    void Flush() { WaitForValue(Signal()); }
+};
+
+// Ring of per-frame resource slots (see FrameResource).
+//
+// BeginFrame moves to the next slot and waits until the GPU is done with the
+// frame that used it last; EndFrame tags the slot with a fence after the frame
+// is submitted. The CPU can run up to GetSlotCount() frames ahead of the GPU
+// and never writes to a slot the GPU may still read.
+class FrameRing
+{
+public:
+    FrameRing(QueueFence& fence, size_t slotCount);
+    FrameRing(const FrameRing& rhs) = delete;
+    FrameRing& operator=(const FrameRing& rhs) = delete;
+
+    // Returns the slot the new frame may write to.
+    size_t BeginFrame();
+    // Call after the frame's command lists were executed.
+    void EndFrame();
+
+    size_t GetSlotCount()const { return SlotFences.size(); }
+    size_t GetCurrentSlot()const { return CurrentSlot; }
+    // Fence the slot waits for before it is reused, 0 if it was never submitted.
+    std::uint64_t GetSlotFence(size_t slot)const { return SlotFences[slot]; }
+
+private:
+    QueueFence& Fence;
+    std::vector<std::uint64_t> SlotFences;
+    size_t CurrentSlot = 0;
+};
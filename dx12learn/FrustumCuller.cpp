@@ -0,0 +1,121 @@
+#include "FrustumCuller.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <immintrin.h>
+
+using namespace DirectX;
+
+namespace
+{
+#if defined(__AVX2__)
+    typedef __m256 Lane;
+    const size_t LaneWidth = 8;
+    inline Lane LaneLoad(const float* p) { return _mm256_loadu_ps(p); }
+    inline Lane LaneSet(float v) { return _mm256_set1_ps(v); }
+    inline Lane LaneAdd(Lane a, Lane b) { return _mm256_add_ps(a, b); }
+    inline Lane LaneMul(Lane a, Lane b) { return _mm256_mul_ps(a, b); }
+    inline Lane LaneOr(Lane a, Lane b) { return _mm256_or_ps(a, b); }
+    inline Lane LaneLess(Lane a, Lane b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+    inline int LaneMask(Lane v) { return _mm256_movemask_ps(v); }
+#else
+    typedef __m128 Lane;
+    const size_t LaneWidth = 4;
+    inline Lane LaneLoad(const float* p) { return _mm_loadu_ps(p); }
+    inline Lane LaneSet(float v) { return _mm_set1_ps(v); }
+    inline Lane LaneAdd(Lane a, Lane b) { return _mm_add_ps(a, b); }
+    inline Lane LaneMul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+    inline Lane LaneOr(Lane a, Lane b) { return _mm_or_ps(a, b); }
+    inline Lane LaneLess(Lane a, Lane b) { return _mm_cmplt_ps(a, b); }
+    inline int LaneMask(Lane v) { return _mm_movemask_ps(v); }
+#endif
+}
+
+void FrustumCuller::Resize(size_t count)
+{
+    Count = count;
+
+    size_t padded = (count + LaneWidth - 1) / LaneWidth * LaneWidth;
+    CenterX.resize(padded, 0.0f);
+    CenterY.resize(padded, 0.0f);
+    CenterZ.resize(padded, 0.0f);
+    ExtentX.resize(padded, 0.0f);
+    ExtentY.resize(padded, 0.0f);
+    ExtentZ.resize(padded, 0.0f);
+}
+
+void FrustumCuller::SetBox(size_t index, const BoundingBox& box)
+{
+    assert(index < Count);
+
+    CenterX[index] = box.Center.x;
+    CenterY[index] = box.Center.y;
+    CenterZ[index] = box.Center.z;
+    ExtentX[index] = box.Extents.x;
+    ExtentY[index] = box.Extents.y;
+    ExtentZ[index] = box.Extents.z;
+}
+
+void FrustumCuller::ExtractPlanes(FXMMATRIX viewProj, XMFLOAT4 planes[6])
+{
+    // Row vectors: clip = p * viewProj, so every plane is a combination of columns.
+    XMMATRIX columns = XMMatrixTranspose(viewProj);
+
+    XMStoreFloat4(&planes[0], columns.r[3] + columns.r[0]); // left
+    XMStoreFloat4(&planes[1], columns.r[3] - columns.r[0]); // right
+    XMStoreFloat4(&planes[2], columns.r[3] + columns.r[1]); // bottom
+    XMStoreFloat4(&planes[3], columns.r[3] - columns.r[1]); // top
+    XMStoreFloat4(&planes[4], columns.r[2]);                // near
+    XMStoreFloat4(&planes[5], columns.r[3] - columns.r[2]); // far
+}
+
+size_t FrustumCuller::Cull(const XMFLOAT4 planes[6], std::vector<std::uint8_t>& visible)const
+{
+    visible.resize(Count);
+
+    Lane nx[6], ny[6], nz[6], nw[6];
+    Lane ax[6], ay[6], az[6];
+    for(int p = 0; p < 6; ++p)
+    {
+        nx[p] = LaneSet(planes[p].x);
+        ny[p] = LaneSet(planes[p].y);
+        nz[p] = LaneSet(planes[p].z);
+        nw[p] = LaneSet(planes[p].w);
+        ax[p] = LaneSet(fabsf(planes[p].x));
+        ay[p] = LaneSet(fabsf(planes[p].y));
+        az[p] = LaneSet(fabsf(planes[p].z));
+    }
+
+    size_t visibleCount = 0;
+    const Lane zero = LaneSet(0.0f);
+    for(size_t i = 0; i < Count; i += LaneWidth)
+    {
+        Lane cx = LaneLoad(&CenterX[i]);
+        Lane cy = LaneLoad(&CenterY[i]);
+        Lane cz = LaneLoad(&CenterZ[i]);
+        Lane ex = LaneLoad(&ExtentX[i]);
+        Lane ey = LaneLoad(&ExtentY[i]);
+        Lane ez = LaneLoad(&ExtentZ[i]);
+
+        // A box is outside when even its corner furthest along the plane normal
+        // is behind the plane: dot(n, c) + d + dot(|n|, e) < 0.
+        Lane outside = zero;
+        for(int p = 0; p < 6; ++p)
+        {
+            Lane distance = LaneAdd(LaneAdd(LaneMul(nx[p], cx), LaneMul(ny[p], cy)), LaneAdd(LaneMul(nz[p], cz), nw[p]));
+            Lane radius = LaneAdd(LaneAdd(LaneMul(ax[p], ex), LaneMul(ay[p], ey)), LaneMul(az[p], ez));
+            outside = LaneOr(outside, LaneLess(LaneAdd(distance, radius), zero));
+        }
+
+        int outsideMask = LaneMask(outside);
+        size_t laneCount = (std::min)(LaneWidth, Count - i);
+        for(size_t lane = 0; lane < laneCount; ++lane)
+        {
+            std::uint8_t isVisible = (outsideMask & (1 << lane)) == 0 ? 1 : 0;
+            visible[i + lane] = isVisible;
+            visibleCount += isVisible;
+        }
+    }
+    return visibleCount;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+
+// Batch frustum test for world space axis aligned boxes.
+//
+// Box centers and extents are kept in separate x, y and z arrays so one plane can
+// be tested against four boxes at a time (eight when built for AVX2). Callers
+// reserve a slot per object, refresh the boxes that moved and call Cull once per
+// frame.
+class FrustumCuller
+{
+public:
+    void Resize(size_t count);
+    size_t GetCount()const { return Count; }
+
+    void SetBox(size_t index, const DirectX::BoundingBox& box);
+
+    // The six planes, normals pointing inwards, of the frustum of a view
+    // projection matrix with D3D depth range [0, 1].
+    static void ExtractPlanes(DirectX::FXMMATRIX viewProj, DirectX::XMFLOAT4 planes[6]);
+
+    // visible[i] becomes 1 when box i is inside or intersects the frustum and 0
+    // otherwise. Returns the number of visible boxes.
+    size_t Cull(const DirectX::XMFLOAT4 planes[6], std::vector<std::uint8_t>& visible)const;
+
+private:
+    size_t Count = 0;
+
+    // Padded to a whole number of SIMD lanes; the padding is never reported.
+    std::vector<float> CenterX;
+    std::vector<float> CenterY;
+    std::vector<float> CenterZ;
+    std::vector<float> ExtentX;
+    std::vector<float> ExtentY;
+    std::vector<float> ExtentZ;
+};
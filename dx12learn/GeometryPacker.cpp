@@ -0,0 +1,122 @@
+#include "GeometryPacker.h"
+#include "ThreadPool.h"
+#include "VertexPacker.h"
+
+#include <algorithm>
+
+std::string GeometryPacker::GetLodName(const std::string &meshName, size_t level)
+{
+    return level == 0 ? meshName : meshName + "_lod" + std::to_string(level);
+}
+
+void GeometryPacker::Pack(
+    const std::vector<MeshBuildTask>& tasks,
+    const std::vector<MeshBuilder::MeshData>& meshes,
+    VertexFormat format,
+    ThreadPool& pool,
+    PackedGeometry& out)
+{
+    const size_t meshCount = meshes.size();
+    out.Format = format;
+
+    // Prefix sums give every mesh a fixed destination range, so the copies
+    // below can run in any order and still produce the same buffers.
+    std::vector<size_t> firstSubmesh(meshCount + 1, 0);
+    for(size_t i = 0; i < meshCount; ++i)
+    {
+        firstSubmesh[i + 1] = firstSubmesh[i] + 1 + meshes[i].LodIndices32.size();
+    }
+
+    out.SubmeshNames.resize(firstSubmesh[meshCount]);
+    out.Submeshes.resize(firstSubmesh[meshCount]);
+    out.SubmeshIndexFormats.resize(firstSubmesh[meshCount]);
+    UINT vertexOffset = 0;
+    UINT index16Offset = 0;
+    UINT index32Offset = 0;
+    for(size_t i = 0; i < meshCount; ++i)
+    {
+        bool use32 = meshes[i].Vertices.size() > MaxVerticesFor16BitIndices;
+        UINT& indexOffset = use32 ? index32Offset : index16Offset;
+        DirectX::BoundingBox bounds = VertexPacker::ComputeBounds(meshes[i].Vertices);
+
+        for(size_t level = 0; level <= meshes[i].LodIndices32.size(); ++level)
+        {
+            const std::vector<std::uint32_t>& indices = level == 0 ? meshes[i].Indices32 : meshes[i].LodIndices32[level - 1];
+            size_t s = firstSubmesh[i] + level;
+
+            SubmeshGeometry& submesh = out.Submeshes[s];
+            submesh.IndexCount = (UINT)indices.size();
+            submesh.StartIndexLocation = indexOffset;
+            submesh.BaseVertexLocation = (INT)vertexOffset;
+            submesh.Bounds = bounds;
+            submesh.MaterialName = tasks[i].MaterialName;
+            submesh.LodSwitchDistance = tasks[i].LodSwitchDistance;
+            out.SubmeshNames[s] = GetLodName(tasks[i].Name, level);
+            out.SubmeshIndexFormats[s] = use32 ? DXGI_FORMAT_R32_UINT : DXGI_FORMAT_R16_UINT;
+
+            indexOffset += (UINT)indices.size();
+        }
+        vertexOffset += (UINT)meshes[i].Vertices.size();
+    }
+
+    if(format == VertexFormat::Packed)
+    {
+        out.PackedVertices.resize(vertexOffset);
+    }
+    else
+    {
+        out.Vertices.resize(vertexOffset);
+    }
+    out.Indices16.resize(index16Offset);
+    out.Indices32.resize(index32Offset);
+
+    static const XMVECTORF32 colors[] = { Colors::Red, Colors::Green, Colors::Blue, Colors::Yellow, Colors::Orange, Colors::Purple, Colors::White, Colors::Black };
+    const size_t colorCount = sizeof(colors) / sizeof(colors[0]);
+
+    pool.ParallelFor(meshCount, [&](size_t i)
+    {
+        const MeshBuilder::MeshData& mesh = meshes[i];
+        const SubmeshGeometry& baseSubmesh = out.Submeshes[firstSubmesh[i]];
+
+        if(format == VertexFormat::Packed)
+        {
+            PackedVertex* vertices = out.PackedVertices.data() + baseSubmesh.BaseVertexLocation;
+            for(size_t j = 0; j < mesh.Vertices.size(); ++j)
+            {
+                vertices[j] = VertexPacker::Encode(mesh.Vertices[j], baseSubmesh.Bounds);
+            }
+        }
+        else
+        {
+            XMFLOAT4 color(colors[i % colorCount]);
+            Vertex* vertices = out.Vertices.data() + baseSubmesh.BaseVertexLocation;
+            for(size_t j = 0; j < mesh.Vertices.size(); ++j)
+            {
+                vertices[j].Pos = mesh.Vertices[j].Position;
+                vertices[j].Normal = mesh.Vertices[j].Normal;
+                vertices[j].TexC = mesh.Vertices[j].TexC;
+                vertices[j].Color = color;
+            }
+        }
+
+        for(size_t level = 0; level <= mesh.LodIndices32.size(); ++level)
+        {
+            const std::vector<std::uint32_t>& indices = level == 0 ? mesh.Indices32 : mesh.LodIndices32[level - 1];
+            size_t s = firstSubmesh[i] + level;
+            const SubmeshGeometry& submesh = out.Submeshes[s];
+
+            if(out.SubmeshIndexFormats[s] == DXGI_FORMAT_R32_UINT)
+            {
+                std::copy(indices.begin(), indices.end(), out.Indices32.begin() + submesh.StartIndexLocation);
+            }
+            else
+            {
+                std::uint16_t* indices16 = out.Indices16.data() + submesh.StartIndexLocation;
+                for(size_t j = 0; j < indices.size(); ++j)
+                {
+                    indices16[j] = static_cast<std::uint16_t>(indices[j]);
+                }
+            }
+        }
+    });
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "PackedVertex.h"
+#include "SubmeshGeometry.h"
+#include "MeshBuilder/MeshBuildTask.h"
+
+class ThreadPool;
+
+// Interleaved vertex and index data for every scene mesh, laid out in scene order
+// so submesh offsets are identical from run to run.
+//
+// All meshes share one vertex buffer. Indices are stored relative to each
+// submesh's BaseVertexLocation, so a mesh only needs 32-bit indices when it
+// alone has more than 65536 vertices; everything else goes to the 16-bit stream.
+//
+// A mesh with levels of detail gets one extra submesh per level, named
+// "<name>_lod1", "<name>_lod2" and so on. They share LOD0's vertices and index
+// format and only differ in their index range.
+//
+// Every submesh gets the bounds of its mesh. With VertexFormat::Packed those
+// bounds are also the quantization box of the mesh's positions.
+struct PackedGeometry
+{
+    // Only the vector matching Format is filled.
+    VertexFormat Format = VertexFormat::Full;
+    std::vector<Vertex> Vertices;
+    std::vector<PackedVertex> PackedVertices;
+    std::vector<std::uint16_t> Indices16;
+    std::vector<std::uint32_t> Indices32;
+
+    std::vector<std::string> SubmeshNames;
+    std::vector<SubmeshGeometry> Submeshes;
+    // DXGI_FORMAT_R16_UINT or DXGI_FORMAT_R32_UINT; StartIndexLocation is relative to that stream.
+    std::vector<DXGI_FORMAT> SubmeshIndexFormats;
+
+    const void* GetVertexData()const
+    {
+        return Format == VertexFormat::Packed ? (const void*)PackedVertices.data() : (const void*)Vertices.data();
+    }
+    UINT GetVertexCount()const
+    {
+        return (UINT)(Format == VertexFormat::Packed ? PackedVertices.size() : Vertices.size());
+    }
+    UINT GetVertexStride()const
+    {
+        return Format == VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex);
+    }
+};
+
+class GeometryPacker
+{
+public:
+    static const size_t MaxVerticesFor16BitIndices = 65536;
+
+    static std::string GetLodName(const std::string& meshName, size_t level);
+
+    static void Pack(
+        const std::vector<MeshBuildTask>& tasks,
+        const std::vector<MeshBuilder::MeshData>& meshes,
+        VertexFormat format,
+        ThreadPool& pool,
+        PackedGeometry& out);
+};
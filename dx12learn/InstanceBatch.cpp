@@ -0,0 +1,85 @@
+#include "InstanceBatch.h"
+#include "JsonUtil.h"
+
+using namespace DirectX;
+
+void InstanceBatch::ReadInstances(simdjson::ondemand::object& entry, const XMFLOAT3& worldPos, const XMFLOAT3& scale, const XMFLOAT3& euler,
+    std::vector<XMFLOAT4X4>& worlds)
+{
+    // explicit instance list, every field defaults to the entry's own
+    simdjson::ondemand::array instances;
+    if(!entry["instances"].get(instances))
+    {
+        for(auto instance : instances)
+        {
+            auto instance_value = instance.get_object().value();
+            XMFLOAT3 instanceWorldPos = worldPos;
+            XMFLOAT3 instanceScale = scale;
+            XMFLOAT3 instanceEuler = euler;
+            JsonUtil::ExtractFieldFromObject(instance_value, "world", instanceWorldPos);
+            JsonUtil::ExtractFieldFromObject(instance_value, "scale", instanceScale);
+            JsonUtil::ExtractFieldFromObject(instance_value, "euler", instanceEuler);
+
+            worlds.emplace_back();
+            XMStoreFloat4x4(&worlds.back(), MathHelper::MakeWorld(instanceWorldPos, instanceScale, instanceEuler));
+        }
+    }
+
+    // regular grid of instances starting at "world"
+    simdjson::ondemand::object grid;
+    if(!entry["grid"].get(grid))
+    {
+        XMFLOAT3 count = { 1.0f, 1.0f, 1.0f };
+        XMFLOAT3 spacing = { 1.0f, 1.0f, 1.0f };
+        JsonUtil::ExtractFieldFromObject(grid, "count", count);
+        JsonUtil::ExtractFieldFromObject(grid, "spacing", spacing);
+
+        for(int x = 0; x < (int)count.x; ++x)
+        {
+            for(int y = 0; y < (int)count.y; ++y)
+            {
+                for(int z = 0; z < (int)count.z; ++z)
+                {
+                    XMFLOAT3 instanceWorldPos = {
+                        worldPos.x + x * spacing.x,
+                        worldPos.y + y * spacing.y,
+                        worldPos.z + z * spacing.z };
+
+                    worlds.emplace_back();
+                    XMStoreFloat4x4(&worlds.back(), MathHelper::MakeWorld(instanceWorldPos, scale, euler));
+                }
+            }
+        }
+    }
+}
+
+BoundingBox InstanceBatch::Place(const BoundingBox& meshBounds, const std::vector<XMFLOAT4X4>& worlds,
+    std::vector<InstanceData>& instances, std::vector<BoundingBox>& instanceBounds)
+{
+    BoundingBox bounds;
+    instances.resize(worlds.size());
+    for(size_t k = 0; k < worlds.size(); ++k)
+    {
+        XMMATRIX world = XMLoadFloat4x4(&worlds[k]);
+        XMStoreFloat4x4(&instances[k].World, XMMatrixTranspose(world));
+
+        BoundingBox box;
+        meshBounds.Transform(box, world);
+        instanceBounds.push_back(box);
+        BoundingBox::CreateMerged(bounds, k == 0 ? box : bounds, box);
+    }
+    return bounds;
+}
+
+UINT InstanceBatch::PackVisible(const std::vector<InstanceData>& instances, const std::uint8_t* visible, InstanceData* dst)
+{
+    UINT count = 0;
+    for(size_t k = 0; k < instances.size(); ++k)
+    {
+        if(visible[k])
+        {
+            dst[count++] = instances[k];
+        }
+    }
+    return count;
+}
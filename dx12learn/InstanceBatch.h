@@ -0,0 +1,37 @@
+#pragma once
+
+#include <DirectXCollision.h>
+#include <cstdint>
+#include <vector>
+#include "simdjson.h"
+#include "MathHelper.h"
+
+// Per-instance data of hardware instanced draws, read by the vertex shader from a
+// structured buffer. World is stored transposed, like ObjectConstants::World.
+struct InstanceData
+{
+    DirectX::XMFLOAT4X4 World = MathHelper::Identity4x4();
+};
+
+// CPU side of hardware instancing: the copies a mesh_instance entry describes and
+// the per frame packing of the visible ones into the instance buffer.
+class InstanceBatch
+{
+public:
+    // Appends the world matrix of every copy in the entry's "instances" list, then
+    // of its "grid", to worlds. worldPos, scale and euler are the entry's own
+    // transform: list fields default to them and the grid starts at worldPos,
+    // walking z fastest and x slowest.
+    static void ReadInstances(simdjson::ondemand::object& entry, const XMFLOAT3& worldPos, const XMFLOAT3& scale, const XMFLOAT3& euler,
+        std::vector<XMFLOAT4X4>& worlds);
+
+    // Stores worlds transposed in instances and appends the mesh bounds each of
+    // them places to instanceBounds. Returns the box enclosing all instances;
+    // worlds must not be empty.
+    static DirectX::BoundingBox Place(const DirectX::BoundingBox& meshBounds, const std::vector<XMFLOAT4X4>& worlds,
+        std::vector<InstanceData>& instances, std::vector<DirectX::BoundingBox>& instanceBounds);
+
+    // Copies the instances whose visible flag is set back to back to dst, in
+    // order, and returns how many. dst needs room for all of them.
+    static UINT PackVisible(const std::vector<InstanceData>& instances, const std::uint8_t* visible, InstanceData* dst);
+};
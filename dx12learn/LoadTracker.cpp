@@ -0,0 +1,38 @@
+#include "LoadTracker.h"
+
+#include "ThreadPool.h"
+
+LoadTracker::LoadTracker(ThreadPool &pool) :
+    Pool(pool)
+{
+}
+
+LoadTracker::~LoadTracker()
+{
+    Wait();
+}
+
+size_t LoadTracker::Start(std::function<void()> load)
+{
+    Done.emplace_back(false);
+    std::atomic<bool>* done = &Done.back();
+
+    Pool.Submit([this, done, load = std::move(load)]()
+    {
+        load();
+
+        // Notified under the lock: once Wait has seen the last load complete, the
+        // tracker may be destroyed, so nothing of it can be touched after unlocking.
+        std::lock_guard<std::mutex> lock(CompletedMutex);
+        done->store(true, std::memory_order_release);
+        CompletedCount.fetch_add(1, std::memory_order_release);
+        Completed.notify_all();
+    });
+    return Done.size() - 1;
+}
+
+void LoadTracker::Wait()
+{
+    std::unique_lock<std::mutex> lock(CompletedMutex);
+    Completed.wait(lock, [this]() { return IsComplete(); });
+}
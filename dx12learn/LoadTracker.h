@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+class ThreadPool;
+
+// Completion bookkeeping of loads running on a ThreadPool.
+//
+// Start queues a load and returns its index. A load is complete once its function
+// returned, whether it succeeded or not. The per load flag and the completed count
+// are published with release semantics, so a thread that sees a load complete
+// also sees everything the load wrote.
+class LoadTracker
+{
+public:
+    explicit LoadTracker(ThreadPool& pool);
+    LoadTracker(const LoadTracker& rhs) = delete;
+    LoadTracker& operator=(const LoadTracker& rhs) = delete;
+    // Waits for loads that are still running.
+    ~LoadTracker();
+
+    // load runs on a worker and, like every ThreadPool task, must not throw.
+    size_t Start(std::function<void()> load);
+
+    size_t GetCount()const { return Done.size(); }
+    // Loads finished so far. Does not block.
+    size_t GetCompletedCount()const { return CompletedCount.load(std::memory_order_acquire); }
+    bool IsComplete()const { return GetCompletedCount() == GetCount(); }
+    bool IsComplete(size_t index)const { return Done[index].load(std::memory_order_acquire); }
+    // Blocks until every load started so far has finished.
+    void Wait();
+
+private:
+    ThreadPool& Pool;
+
+    // A deque, so workers can hold on to their flag while Start keeps appending.
+    std::deque<std::atomic<bool>> Done;
+    std::atomic<size_t> CompletedCount{ 0 };
+    std::mutex CompletedMutex;
+    std::condition_variable Completed;
+};
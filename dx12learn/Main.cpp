@@ -2,18 +2,28 @@
 #include <DirectXPackedVector.h>
 #include <iostream>
 #include <array>
+#include <cfloat>
+#include <stdexcept>
 
 #include "D3D12App.h"
 #include "MathHelper.h"
 #include "D3DUtil.h"
+#include "DirtyList.h"
+#include "DrawSubmission.h"
 
-#include "MeshBuilder/MeshBoxBuilder.h"
-#include "MeshBuilder/MeshSphereBuilder.h"
-#include "MeshBuilder/MeshCylinderBuilder.h"
 #include "MeshBuilder/MeshGridBuilder.h"
-#include "MeshBuilder/MeshObjBuilder.h"
+#include "MeshBuilder/MeshBuildTask.h"
 #include "Simulation/Waves.h"
 #include "FrameResource.h"
+#include "FrustumCuller.h"
+#include "GeometryPacker.h"
+#include "InstanceBatch.h"
+#include "RadixSort.h"
+#include "SceneCache.h"
+#include "TextureStreamer.h"
+#include "ThreadPool.h"
+#include "TransformHierarchy.h"
+#include "VertexPacker.h"
 
 #include "ResourceUploadBatch.h"
 #include "DDSTextureLoader.h"
@@ -38,9 +48,23 @@ enum class RenderLayer : int
 	Opaque = 0,
 	Transparent = 1,
 	AlphaTested = 2,
+	OpaquePacked = 3,
+	OpaqueInstanced = 4,
+	OpaquePackedInstanced = 5,
 	Count
 };
 
+// Order in which the layers are drawn, blended ones last.
+const RenderLayer LayerDrawOrder[] =
+{
+	RenderLayer::Opaque,
+	RenderLayer::OpaquePacked,
+	RenderLayer::OpaqueInstanced,
+	RenderLayer::OpaquePackedInstanced,
+	RenderLayer::AlphaTested,
+	RenderLayer::Transparent
+};
+static_assert(_countof(LayerDrawOrder) == (int)RenderLayer::Count, "every layer needs a place in LayerDrawOrder");
 
 class DemoApp : public D3D12App
 {
@@ -50,7 +74,6 @@ public:
 		RenderItem() = default;
 
 		XMFLOAT4X4 World = MathHelper::Identity4x4();
-		int NumFramesDirty = DemoApp::NumFrameResources;
 		UINT ObjCBIndex = -1;
 		Material* Mat = nullptr;
 		MeshGeometry* Geo = nullptr;
@@ -58,6 +81,61 @@ public:
 		UINT IndexCount = 0;
 		UINT StartIndexLocation = 0;
 		int BaseVertexLocation = 0;
+
+		// dequantization of PackedVertex positions, identity for full vertices
+		XMFLOAT3 PositionScale = { 1.0f, 1.0f, 1.0f };
+		XMFLOAT3 PositionBias = { 0.0f, 0.0f, 0.0f };
+
+		// draw args of every level of detail, finest first; empty for single level meshes
+		std::vector<const SubmeshGeometry*> Lods;
+		// camera distance covered by each level of detail before switching to the next one
+		float LodSwitchDistance = 8.0f;
+
+		// object space bounds, transformed by World for culling
+		DirectX::BoundingBox Bounds;
+
+		// Hardware instancing: the item is drawn once for all its visible instances and
+		// World stays identity, so Bounds encloses every instance in world space.
+		std::vector<InstanceData> Instances;
+		// culler slot of Instances[0], the others follow in order
+		size_t FirstInstanceSlot = 0;
+		// visible instances this frame and the first of them in FrameResource::InstanceBuffer
+		UINT InstanceCount = 1;
+		UINT InstanceBufferOffset = 0;
+
+		// Bounds transformed by World, refreshed by UpdateVisibility
+		DirectX::BoundingBox WorldBounds;
+		// small per geometry id for draw sort keys
+		UINT GeometrySortId = 0;
+	};
+
+	// Records DrawPackets into a command list with the buffers and descriptors of
+	// the current frame resource. Pipeline is a RenderLayer, Geometry a MeshGeometry,
+	// Material a Material and Item a RenderItem.
+	// With an allocator Begin resets the list, without one the list is already open.
+	// The last list of the frame transitions the back buffer to present.
+	class CommandListRecorder : public DrawListRecorder
+	{
+	public:
+		CommandListRecorder(DemoApp& app, ID3D12GraphicsCommandList* cmdList, ID3D12CommandAllocator* cmdListAlloc);
+
+		void Begin() override;
+		void End(bool last) override;
+		void SetPipeline(std::uint32_t pipeline) override;
+		void SetGeometry(const void* geometry) override;
+		void SetTopology(std::uint32_t topology) override;
+		void SetMaterial(const void* material) override;
+		void Draw(const DrawPacket& packet) override;
+
+	private:
+		DemoApp& App;
+		ID3D12GraphicsCommandList* CmdList;
+		ID3D12CommandAllocator* CmdListAlloc;
+		D3D12_GPU_VIRTUAL_ADDRESS ObjectBufferAddress;
+		D3D12_GPU_VIRTUAL_ADDRESS MaterialBufferAddress;
+		D3D12_GPU_VIRTUAL_ADDRESS InstanceBufferAddress;
+		UINT ObjCBByteSize;
+		UINT MatCBByteSize;
 	};
 
 	struct RenderItemWorldInfo
@@ -67,6 +145,16 @@ public:
 		XMFLOAT3 Scale = { 1.0f, 1.0f, 1.0f };
 		XMFLOAT3 Euler = { 0.0f, 0.0f, 0.0f };
 
+		// filled from "instances" or "grid"; the entry is then drawn instanced
+		std::vector<XMFLOAT4X4> InstanceWorlds;
+
+		// "id" other entries can name as their "parent"; with a parent the
+		// transform above is relative to it
+		std::string Id;
+		std::string ParentId;
+		// "spin" in radians per second added to Euler
+		XMFLOAT3 Spin = { 0.0f, 0.0f, 0.0f };
+
 		RenderItemWorldInfo(std::string objName, XMFLOAT3 worldPos) :
 			ObjName(objName), WorldPos(worldPos)
 		{
@@ -81,9 +169,21 @@ public:
 	}
 	DemoApp(const DemoApp& rhs) = delete;
 	DemoApp& operator=(const DemoApp& rhs) = delete;
-	~DemoApp() = default;
+	~DemoApp()
+	{
+		// frames may still be in flight and reference our resources
+		if(QueueSync != nullptr)
+		{
+			FlushCommandQueue();
+		}
+	}
 	virtual void Init() override;
 
+	// Render items that passed or failed frustum culling in the last Update.
+	// Every instance of an instanced item counts on its own.
+	size_t GetVisibleRitemCount()const { return VisibleRitemCount; }
+	size_t GetCulledRitemCount()const { return CulledRitemCount; }
+
 	const static int NumFrameResources = 3;
 protected:
 
@@ -91,6 +191,7 @@ protected:
 	virtual void Render(const GameTimer& gt) override;
 	virtual void OnResize() override;
 	virtual void OnMouseMove(WPARAM btnState, int x, int y) override;
+	virtual std::wstring GetFrameStatsText()const override;
 	virtual void OnMouseDown(WPARAM btnState, int x, int y) override
 	{
 		LastMousePos.x = x;
@@ -122,29 +223,80 @@ protected:
 	virtual void OnKeyboardInput(const GameTimer& gt);
 
 protected:
+	const std::string ScenePath = "./Assets/Data/scene.json";
+	const std::string SceneCachePath = "./Assets/Data/scene.bake";
+
 	simdjson::ondemand::document scene_doc;
+	SceneCache SceneBake;
+	VertexFormat ShapeVertexFormat = VertexFormat::Full;
 
 	ComPtr<ID3D12RootSignature> RootSignature;
 	ComPtr<ID3D12DescriptorHeap> CbvHeap;
 	ComPtr<ID3D12DescriptorHeap> SrvHeap;
 
 	std::vector<std::unique_ptr<FrameResource>> FrameResources;
+	// hands out FrameResources slots once the GPU is done with them
+	std::unique_ptr<FrameRing> FrameSlots;
 	FrameResource* CurrentFrameResource = nullptr;
-	int CurrentFrameResourceIndex = 0;
 
 	std::vector<std::unique_ptr<Texture>> Textures;
 	std::unordered_map<std::string, int> TextureNameMap;
+	// owns the texture resources and their descriptors, Textures[i] is streamed texture i
+	std::unique_ptr<TextureStreamer> TextureStreaming;
+	// "texture_budget_mb" in the scene
+	float TextureBudgetMB = 256.0f;
 
 	ComPtr<ID3DBlob> VertexShader;
+	ComPtr<ID3DBlob> PackedVertexShader;
+	ComPtr<ID3DBlob> InstancedVertexShader;
+	ComPtr<ID3DBlob> PackedInstancedVertexShader;
 	ComPtr<ID3DBlob> PixelShader;
 	ComPtr<ID3DBlob> TransparentPixelShader;
 	ComPtr<ID3DBlob> AlphaTestPixelShader;
 
 	std::vector<D3D12_INPUT_ELEMENT_DESC> InputLayout;
+	std::vector<D3D12_INPUT_ELEMENT_DESC> PackedInputLayout;
 
+	// indexed by ObjCBIndex
 	std::vector<std::unique_ptr<RenderItem>> AllRitems;
 	std::vector<RenderItem*> RitemLayer[(int)RenderLayer::Count];
 
+	// RitemLayer filtered by the view frustum, rebuilt every frame. Culler slots are ObjCBIndex.
+	std::vector<RenderItem*> VisibleRitemLayer[(int)RenderLayer::Count];
+	FrustumCuller Culler;
+	std::vector<std::uint8_t> RitemVisible;
+	size_t VisibleRitemCount = 0;
+	size_t CulledRitemCount = 0;
+
+	// instances of all instanced render items, the size of FrameResource::InstanceBuffer
+	UINT InstanceCapacity = 0;
+
+	// visible items of this frame in submission order
+	std::vector<DrawPacket> DrawPackets;
+	std::vector<DrawPacket> DrawPacketScratch;
+	ID3D12PipelineState* LayerPipelineStates[(int)RenderLayer::Count] = {};
+
+	// Frames with at least twice this many draws are recorded in parallel, in
+	// up to MaxRecordingChunks contiguous chunks of DrawPackets (see RecordDrawChunks).
+	static const size_t MinDrawsPerChunk = 128;
+	static const UINT MaxRecordingChunks = 8;
+
+	// Entries that rotate over time, replayed into Transforms every frame.
+	struct TransformAnimation
+	{
+		int Node = 0;
+		XMFLOAT3 WorldPos;
+		XMFLOAT3 Scale;
+		XMFLOAT3 Euler;
+		XMFLOAT3 Spin;
+	};
+
+	TransformHierarchy Transforms;
+	// render item driven by each node, null for "transform" entries
+	std::vector<RenderItem*> NodeRitems;
+	std::vector<TransformAnimation> TransformAnimations;
+	std::vector<int> ChangedNodes;
+
 
 	RenderItem* WaveRitem;
 
@@ -153,6 +305,9 @@ protected:
 	UINT PassCbvOffset = 0;
 
 	ComPtr<ID3D12PipelineState> OpaquePipelineState;
+	ComPtr<ID3D12PipelineState> PackedOpaquePipelineState;
+	ComPtr<ID3D12PipelineState> InstancedOpaquePipelineState;
+	ComPtr<ID3D12PipelineState> PackedInstancedOpaquePipelineState;
 	ComPtr<ID3D12PipelineState> AlphaTestPipelineState;
 	ComPtr<ID3D12PipelineState> TransparentPipelineState;
 
@@ -167,10 +322,14 @@ protected:
 
 	POINT LastMousePos;
 
-	std::unordered_map<std::string, MeshBuilder::MeshData> MeshDataMap;
 	std::unordered_map<std::string, std::unique_ptr<MeshGeometry>> GeometriesMap;
 
-	std::unordered_map<std::string, std::unique_ptr<Material>> Materials;
+	// indexed by MatCBIndex; names are only looked up while building the scene
+	std::vector<std::unique_ptr<Material>> Materials;
+	std::unordered_map<std::string, Material*> MaterialsByName;
+
+	DirtyList DirtyObjects{ NumFrameResources };
+	DirtyList DirtyMaterials{ NumFrameResources };
 
 	const CD3DX12_STATIC_SAMPLER_DESC SamplerDesc = {
 		0,
@@ -190,23 +349,47 @@ protected:
 	void BuildRootSignature();
 	void BuildShadersAndInputLayout();
 	void BuildBoxGeometry();
+	void CreateShapeGeometry(
+		const void* vertices, UINT vbByteSize, UINT vertexStride,
+		const void* indices16, UINT ib16ByteSize,
+		const void* indices32, UINT ib32ByteSize);
+	MeshGeometry* GetShapeGeometry(DXGI_FORMAT indexFormat);
+	MeshGeometry* FindShapeGeometry(const std::string& meshName);
 	void BuildLandGeometry();
 	void BuildWaveGeometry();
 	void BuildPSO();
 	void BuildRenderItems();
-	void LoadTextures();
+	// Texture tails load on the worker pool while the scene is built and are uploaded by FinishLoadTextures.
+	void BeginLoadTextures();
+	void FinishLoadTextures();
+	// Requests the mips visible items need and lets the streamer load them.
+	void UpdateTextureStreaming();
 
 	void BuildMaterials();
+	void LoadCachedMaterials();
+	void AddMaterial(std::unique_ptr<Material> mat);
+	Material* FindMaterial(const std::string& name);
+
+	// Call after changing World or the constants of a material so every frame resource gets the new value.
+	void MarkDirty(RenderItem* ritem);
+	void MarkDirty(Material* mat);
 
-	void DrawRenderItems(ID3D12GraphicsCommandList* cmdList, const std::vector<RenderItem*>& ritems);
+	void BuildDrawPackets();
+	void BindPassState(ID3D12GraphicsCommandList* cmdList);
 
 	void UpdateWave(const GameTimer& gt);
+	void UpdateLods();
+	void UpdateTransforms(const GameTimer& gt);
+	// Resolves the hierarchy and hands the new world matrices to their render items.
+	void ApplyTransforms();
+	void UpdateVisibility();
 	void UpdateMainPassCB();
 	void UpdateObjectCBs();
 	void UpdateMaterialCBs(const GameTimer& gt);
 
 
 	std::unique_ptr<Waves> Wave;
+	std::unique_ptr<ThreadPool> WorkerPool;
 };
 
 
@@ -245,13 +428,10 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
 
 void DemoApp::Render(const GameTimer& gt)
 {
-
-
-	ThrowIfFailed(CommandAllocator->Reset());
-	ThrowIfFailed(CommandList->Reset(CommandAllocator.Get(), OpaquePipelineState.Get()));
-
-	CommandList->RSSetViewports(1, &Viewport);
-	CommandList->RSSetScissorRects(1, &ScissorRect);
+	// Update already waited for the GPU to finish with this frame resource, so its allocator can be reused.
+	auto cmdListAlloc = CurrentFrameResource->CmdListAlloc;
+	ThrowIfFailed(cmdListAlloc->Reset());
+	ThrowIfFailed(CommandList->Reset(cmdListAlloc.Get(), OpaquePipelineState.Get()));
 
 	D3D12_RESOURCE_BARRIER barrier = CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
 		D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
@@ -262,38 +442,44 @@ void DemoApp::Render(const GameTimer& gt)
 	CommandList->ClearDepthStencilView(DepthStencilView(),
 		D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
 
-	D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = DepthStencilView();
-	D3D12_CPU_DESCRIPTOR_HANDLE currentBackBufferView = CurrentBackBufferView();
-	CommandList->OMSetRenderTargets(1, &currentBackBufferView, true, &depthStencilView);
-
-	ID3D12DescriptorHeap* descriptorHeaps[] = {SrvHeap.Get() };
-	CommandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
-
-	CommandList->SetGraphicsRootSignature(RootSignature.Get());
-
-	CommandList->SetGraphicsRootConstantBufferView(1, CurrentFrameResource->PassCB->Resource()->GetGPUVirtualAddress());
-
-	DrawRenderItems(CommandList.Get(), RitemLayer[(int)RenderLayer::Opaque]);
-
-	CommandList->SetPipelineState(AlphaTestPipelineState.Get());
-	DrawRenderItems(CommandList.Get(), RitemLayer[(int)RenderLayer::AlphaTested]);
-
-	CommandList->SetPipelineState(TransparentPipelineState.Get());
-	DrawRenderItems(CommandList.Get(), RitemLayer[(int)RenderLayer::Transparent]);
+	// Large frames are split into contiguous chunks of the sorted packets. Workers record
+	// them into the frame resource's chunk lists, which execute right after CommandList.
+	// Small frames are recorded inline into CommandList after the clears.
+	size_t chunkCount = GetDrawChunkCount(DrawPackets.size(), CurrentFrameResource->ChunkCmdLists.size(), MinDrawsPerChunk);
+	std::vector<ID3D12CommandList*> commandLists = { CommandList.Get() };
+	std::vector<CommandListRecorder> recorders;
+	recorders.reserve(chunkCount);
+	if(chunkCount == 1)
+	{
+		recorders.emplace_back(*this, CommandList.Get(), nullptr);
+	}
+	else
+	{
+		ThrowIfFailed(CommandList->Close());
+		for(size_t chunk = 0; chunk < chunkCount; ++chunk)
+		{
+			ID3D12GraphicsCommandList* chunkList = CurrentFrameResource->ChunkCmdLists[chunk].Get();
+			recorders.emplace_back(*this, chunkList, CurrentFrameResource->ChunkCmdListAllocs[chunk].Get());
+			commandLists.push_back(chunkList);
+		}
+	}
 
-	D3D12_RESOURCE_BARRIER renderTargetToPresent = CD3DX12_RESOURCE_BARRIER::Transition(CurrentBackBuffer(),
-		D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
-	CommandList->ResourceBarrier(1, &renderTargetToPresent);
+	std::vector<DrawListRecorder*> lists;
+	for(CommandListRecorder& recorder : recorders)
+	{
+		lists.push_back(&recorder);
+	}
+	// a failed chunk throws here, before anything of the frame is submitted
+	RecordDrawChunks(*WorkerPool, DrawPackets.data(), DrawPackets.size(), lists.data(), lists.size());
 
-	ThrowIfFailed(CommandList->Close());
+	CommandQueue->ExecuteCommandLists((UINT)commandLists.size(), commandLists.data());
 
-	ID3D12CommandList* commandLists[] = { CommandList.Get() };
-	CommandQueue->ExecuteCommandLists(_countof(commandLists), commandLists);
 	ThrowIfFailed(SwapChain->Present(0, 0));
 	CurrentBackBufferIndex = (CurrentBackBufferIndex + 1) % 2;
 
-	FlushCommandQueue();
-
+	// The CPU moves on to the next frame without waiting, FrameSlots makes Update
+	// wait before this frame resource is written again.
+	FrameSlots->EndFrame();
 }
 
 void DemoApp::Init()
@@ -302,20 +488,32 @@ void DemoApp::Init()
 	D3D12App::Init();
 
 	simdjson::ondemand::parser Parser;
-	auto json = simdjson::padded_string::load("./Assets/Data/scene.json");
+	auto json = simdjson::padded_string::load(ScenePath);
 	scene_doc = Parser.iterate(json);
 
+	WorkerPool = std::make_unique<ThreadPool>();
+
 	ThrowIfFailed(CommandList->Reset(CommandAllocator.Get(), nullptr));
 
-	LoadTextures();
-	BuildMaterials();
+	BeginLoadTextures();
+
+	if(SceneBake.Open(SceneCachePath, ScenePath))
+	{
+		LoadCachedMaterials();
+	}
+	else
+	{
+		BuildMaterials();
+	}
 
 	BuildBoxGeometry();
+	SceneBake.Close();
 	BuildLandGeometry();
 	BuildWaveGeometry();
 
 	BuildRenderItems();
 
+	FinishLoadTextures();
 	BuildDescriptorHeaps();
 	BuildFrameResources();
 	BuildShaderResourceView();
@@ -374,11 +572,12 @@ void DemoApp::BuildRootSignature()
 	CD3DX12_DESCRIPTOR_RANGE texTable;
 	texTable.Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, 0);
 
-	CD3DX12_ROOT_PARAMETER rootParameters[4];
+	CD3DX12_ROOT_PARAMETER rootParameters[5];
 	rootParameters[0].InitAsConstantBufferView(0);  // per object cbv
 	rootParameters[1].InitAsConstantBufferView(1);  // per pass cbv
 	rootParameters[2].InitAsConstantBufferView(2);  // per material cbv
 	rootParameters[3].InitAsDescriptorTable(1, &texTable, D3D12_SHADER_VISIBILITY_PIXEL);  // per material cbv
+	rootParameters[4].InitAsShaderResourceView(0, 1, D3D12_SHADER_VISIBILITY_VERTEX);  // instance data, instanced draws only
 
 	CD3DX12_ROOT_SIGNATURE_DESC rootSignatureDesc(
 		constexpr(sizeof(rootParameters) / sizeof(CD3DX12_ROOT_PARAMETER)), rootParameters, 1, &SamplerDesc,
@@ -417,7 +616,26 @@ void DemoApp::BuildShadersAndInputLayout()
 		"ALPHA_TEST", "1",
 		NULL, NULL
 	};
+	const D3D_SHADER_MACRO packedVertexDefines[] =
+	{
+		"PACKED_VERTEX", "1",
+		NULL, NULL
+	};
+	const D3D_SHADER_MACRO instancedDefines[] =
+	{
+		"INSTANCED", "1",
+		NULL, NULL
+	};
+	const D3D_SHADER_MACRO packedInstancedDefines[] =
+	{
+		"PACKED_VERTEX", "1",
+		"INSTANCED", "1",
+		NULL, NULL
+	};
 	VertexShader = D3DUtil::CompileShader(L"Shaders/VertexShader.hlsl", nullptr, "VS", "vs_5_0");
+	PackedVertexShader = D3DUtil::CompileShader(L"Shaders/VertexShader.hlsl", packedVertexDefines, "VS", "vs_5_0");
+	InstancedVertexShader = D3DUtil::CompileShader(L"Shaders/VertexShader.hlsl", instancedDefines, "VS", "vs_5_1");
+	PackedInstancedVertexShader = D3DUtil::CompileShader(L"Shaders/VertexShader.hlsl", packedInstancedDefines, "VS", "vs_5_1");
 	PixelShader = D3DUtil::CompileShader(L"Shaders/PixelShader.hlsl", defines, "PS", "ps_5_0");
 	TransparentPixelShader = D3DUtil::CompileShader(L"Shaders/PixelShader.hlsl", nullptr, "PS", "ps_5_0");
 	AlphaTestPixelShader = D3DUtil::CompileShader(L"Shaders/PixelShader.hlsl", alphaTestDefines, "PS", "ps_5_0");
@@ -429,141 +647,164 @@ void DemoApp::BuildShadersAndInputLayout()
 		D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
 		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT,0, 24,
 		D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
-		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT,0, 24,
+		{ "COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT,0, 32,
+		D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
+	};
+
+	// see PackedVertex
+	PackedInputLayout = {
+		{ "POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0,
+		D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8,
+		D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 12,
 		D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 }
 	};
 }
 
 void DemoApp::BuildBoxGeometry()
 {
-	auto mesh_array = scene_doc["mesh"].get_array();
-	std::unordered_map<std::string, std::string> MaterialNameMap;
-	for(auto element : mesh_array)
+	if(SceneBake.IsOpen())
 	{
-		std::string meshName = std::string(std::string_view(element["name"]));
-		std::string meshBuilderType = std::string(std::string_view(element["type"]));
-		auto ParamObj = element["param"].get_object();
-
-		MeshBuilder::MeshData meshData;
-
-		MaterialNameMap[meshName] = std::string(std::string_view(element["material"]));
-		
-		if(meshBuilderType == "box")
-		{
-			float width = ParamObj["width"].get_double();
-			float height = ParamObj["height"].get_double();
-			float depth = ParamObj["depth"].get_double();
-			int numSubdivisions = ParamObj["num_subdivision"].get_int64();
-			meshData = BoxBuilder().BuildBox(width, height, depth, numSubdivisions);
-		}
-		else if(meshBuilderType == "sphere")
-		{
-			float radius = ParamObj["radius"].get_double();
-			int sliceCount = ParamObj["slice"].get_int64();
-			int stackCount = ParamObj["stack"].get_int64();
-			meshData = SphereBuilder().BuildSphere(radius, sliceCount, stackCount);
-		}
-		else if(meshBuilderType == "cylinder")
-		{
-			float bottomRadius = ParamObj["bottom_radius"].get_double();
-			float topRadius = ParamObj["top_radius"].get_double();
-			float height = ParamObj["height"].get_double();
-			int sliceCount = ParamObj["slice"].get_int64();
-			int stackCount = ParamObj["stack"].get_int64();
-			meshData = CylinderBuilder().BuildCylinder(bottomRadius, topRadius, height, sliceCount, stackCount);
-		}
-		else if(meshBuilderType == "grid")
-		{
-			float width = ParamObj["width"].get_double();
-			float depth = ParamObj["depth"].get_double();
-			int m = ParamObj["m"].get_int64();
-			int n = ParamObj["n"].get_int64();
-			meshData = GridBuilder().BuildGrid(width, depth, m, n);
-		}
-		else if(meshBuilderType == "obj")
+		// cached path: the mapped payloads are already in upload layout
+		const SceneCache::Header& header = SceneBake.GetHeader();
+		ShapeVertexFormat = SceneBake.GetVertexFormat();
+		CreateShapeGeometry(
+			SceneBake.GetVertices(), SceneBake.GetVertexByteSize(), SceneBake.GetVertexStride(),
+			SceneBake.GetIndices16(), SceneBake.GetIndex16ByteSize(),
+			SceneBake.GetIndices32(), SceneBake.GetIndex32ByteSize());
+
+		const SceneCache::SubmeshRecord* records = SceneBake.GetSubmeshes();
+		for(UINT i = 0; i < header.SubmeshCount; ++i)
 		{
-			std::string filepath = std::string(std::string_view(ParamObj["path"]));
-			meshData = MeshObjBuilder().BuildByObjFile(filepath);
+			SubmeshGeometry submesh;
+			submesh.IndexCount = records[i].IndexCount;
+			submesh.StartIndexLocation = records[i].StartIndexLocation;
+			submesh.BaseVertexLocation = records[i].BaseVertexLocation;
+			submesh.Bounds.Center = XMFLOAT3(records[i].BoundsCenter);
+			submesh.Bounds.Extents = XMFLOAT3(records[i].BoundsExtents);
+			submesh.MaterialName = records[i].MaterialName;
+			submesh.LodSwitchDistance = records[i].LodSwitchDistance;
+			GetShapeGeometry((DXGI_FORMAT)records[i].IndexFormat)->DrawArgs[records[i].Name] = submesh;
 		}
-		else
-		{
-			throw std::exception("Unknown MeshBuilder Type");
-		}
-		MeshDataMap[meshName] = meshData;
+		return;
 	}
 
-
-	std::unordered_map<std::string, SubmeshGeometry> submeshGeometries;
-	UINT vertexOffset = 0;
-	UINT indexOffset = 0;
-	UINT totalVertexCount = 0;
-	for (const auto& pair : MeshDataMap)
+	std::string_view vertexFormat;
+	if(!scene_doc["vertex_format"].get_string().get(vertexFormat) && vertexFormat == "packed")
 	{
-		SubmeshGeometry submesh;
-		submesh.IndexCount = (UINT)pair.second.Indices32.size();
-		submesh.StartIndexLocation = indexOffset;
-		submesh.BaseVertexLocation = vertexOffset;
-		submesh.MaterialName = MaterialNameMap[pair.first];
-		submeshGeometries[pair.first] = submesh;
-
-		vertexOffset += (UINT)pair.second.Vertices.size();
-		indexOffset += (UINT)pair.second.Indices32.size();
-		totalVertexCount += (UINT)pair.second.Vertices.size();
+		ShapeVertexFormat = VertexFormat::Packed;
 	}
 
-	std::vector<Vertex> vertices(totalVertexCount);
-	std::vector<XMVECTORF32> colors = { Colors::Red, Colors::Green, Colors::Blue, Colors::Yellow, Colors::Orange, Colors::Purple, Colors::White, Colors::Black };
-	UINT k = 0;
-	UINT i = 0;
-	for(const auto& meshDataPair: MeshDataMap)
+	std::vector<MeshBuildTask> tasks;
+	std::vector<std::string> sourceFiles;
+	auto mesh_array = scene_doc["mesh"].get_array();
+	for(auto element : mesh_array)
 	{
-		for(size_t j = 0; j < meshDataPair.second.Vertices.size(); ++j, ++k)
+		auto element_value = element.get_object().value();
+		tasks.push_back(MeshBuildTask::FromJson(element_value));
+		if(!tasks.back().Path.empty())
 		{
-			vertices[k].Pos = meshDataPair.second.Vertices[j].Position;
-			vertices[k].Normal = meshDataPair.second.Vertices[j].Normal;
-			vertices[k].Color = XMFLOAT4(colors[i % colors.size()]);
-			vertices[k].TexC = meshDataPair.second.Vertices[j].TexC;
+			sourceFiles.push_back(tasks.back().Path);
 		}
-		++i;
 	}
 
-	std::vector<std::uint16_t> indices;
-	for(const auto& meshDataPair: MeshDataMap)
+	std::vector<MeshBuilder::MeshData> meshes(tasks.size());
+	WorkerPool->ParallelFor(tasks.size(), [&](size_t i)
 	{
-		std::vector<uint16_t> meshIndicesData = meshDataPair.second.GetIndices16();
-		indices.insert(indices.end(), std::begin(meshIndicesData), std::end(meshIndicesData));
-	}
+		meshes[i] = tasks[i].Build();
+	});
 
+	PackedGeometry packed;
+	GeometryPacker::Pack(tasks, meshes, ShapeVertexFormat, *WorkerPool, packed);
 
-	const UINT vbByteSize = (UINT)vertices.size() * sizeof(Vertex);
-	const UINT ibByteSize = (UINT)indices.size() * sizeof(std::uint16_t);
+	CreateShapeGeometry(
+		packed.GetVertexData(), packed.GetVertexCount() * packed.GetVertexStride(), packed.GetVertexStride(),
+		packed.Indices16.data(), (UINT)packed.Indices16.size() * sizeof(std::uint16_t),
+		packed.Indices32.data(), (UINT)packed.Indices32.size() * sizeof(std::uint32_t));
+
+	for(size_t i = 0; i < packed.Submeshes.size(); ++i)
+	{
+		GetShapeGeometry(packed.SubmeshIndexFormats[i])->DrawArgs[packed.SubmeshNames[i]] = packed.Submeshes[i];
+	}
 
-	std::unique_ptr<MeshGeometry> Geometry = std::make_unique<MeshGeometry>();
-	Geometry->Name = "shapeGeo";
+	// bake for the next launch, the cache is keyed on the json and every obj it references
+	std::vector<const Material*> materials(Materials.size());
+	for(size_t i = 0; i < Materials.size(); ++i)
+	{
+		materials[i] = Materials[i].get();
+	}
+	if(!SceneCache::Write(SceneCachePath, ScenePath, sourceFiles, packed, materials))
+	{
+		OutputDebugStringA("Failed to write scene cache\n");
+	}
+}
 
-	ThrowIfFailed(D3DCreateBlob(vbByteSize, Geometry->VertexBufferCPU.GetAddressOf()));
-	CopyMemory(Geometry->VertexBufferCPU->GetBufferPointer(), vertices.data(), vbByteSize);
+void DemoApp::CreateShapeGeometry(
+	const void* vertices, UINT vbByteSize, UINT vertexStride,
+	const void* indices16, UINT ib16ByteSize,
+	const void* indices32, UINT ib32ByteSize)
+{
+	// Both shape geometries share one vertex buffer and only differ in their index
+	// buffer. Meshes small enough for 16-bit indices keep the bandwidth saving,
+	// only very large meshes go through "shapeGeo32".
+	std::unique_ptr<MeshGeometry> geo16 = std::make_unique<MeshGeometry>();
+	geo16->Name = "shapeGeo";
+
+	ThrowIfFailed(D3DCreateBlob(vbByteSize, geo16->VertexBufferCPU.GetAddressOf()));
+	CopyMemory(geo16->VertexBufferCPU->GetBufferPointer(), vertices, vbByteSize);
+
+	geo16->VertexBufferGPU = D3DUtil::CreateDefaultBuffer(Device.Get(), CommandList.Get(),
+		vertices, vbByteSize, geo16->VertexBufferUploader);
+
+	geo16->VertexByteStride = vertexStride;
+	geo16->VertexBufferByteSize = vbByteSize;
+
+	std::unique_ptr<MeshGeometry> geo32 = std::make_unique<MeshGeometry>();
+	geo32->Name = "shapeGeo32";
+	geo32->VertexBufferCPU = geo16->VertexBufferCPU;
+	geo32->VertexBufferGPU = geo16->VertexBufferGPU;
+	geo32->VertexByteStride = geo16->VertexByteStride;
+	geo32->VertexBufferByteSize = geo16->VertexBufferByteSize;
+
+	const void* indices[] = { indices16, indices32 };
+	const UINT ibByteSizes[] = { ib16ByteSize, ib32ByteSize };
+	const DXGI_FORMAT formats[] = { DXGI_FORMAT_R16_UINT, DXGI_FORMAT_R32_UINT };
+	MeshGeometry* geos[] = { geo16.get(), geo32.get() };
+	for(int i = 0; i < 2; ++i)
+	{
+		MeshGeometry* geo = geos[i];
+		geo->IndexFormat = formats[i];
+		geo->IndexBufferByteSize = ibByteSizes[i];
+		if(ibByteSizes[i] == 0)
+		{
+			continue;
+		}
 
-	ThrowIfFailed(D3DCreateBlob(ibByteSize, Geometry->IndexBufferCPU.GetAddressOf()));
-	CopyMemory(Geometry->IndexBufferCPU->GetBufferPointer(), indices.data(), ibByteSize);
+		ThrowIfFailed(D3DCreateBlob(ibByteSizes[i], geo->IndexBufferCPU.GetAddressOf()));
+		CopyMemory(geo->IndexBufferCPU->GetBufferPointer(), indices[i], ibByteSizes[i]);
 
-	Geometry->VertexBufferGPU = D3DUtil::CreateDefaultBuffer(Device.Get(), CommandList.Get(),
-		vertices.data(), vbByteSize, Geometry->VertexBufferUploader);
+		geo->IndexBufferGPU = D3DUtil::CreateDefaultBuffer(Device.Get(), CommandList.Get(),
+			indices[i], ibByteSizes[i], geo->IndexBufferUploader);
+	}
 
-	Geometry->IndexBufferGPU = D3DUtil::CreateDefaultBuffer(Device.Get(), CommandList.Get(),
-		indices.data(), ibByteSize, Geometry->IndexBufferUploader);
+	GeometriesMap["shapeGeo"] = std::move(geo16);
+	GeometriesMap["shapeGeo32"] = std::move(geo32);
+}
 
-	Geometry->VertexByteStride = sizeof(Vertex);
-	Geometry->VertexBufferByteSize = vbByteSize;
-	Geometry->IndexFormat = DXGI_FORMAT_R16_UINT;
-	Geometry->IndexBufferByteSize = ibByteSize;
+MeshGeometry* DemoApp::GetShapeGeometry(DXGI_FORMAT indexFormat)
+{
+	return GeometriesMap[indexFormat == DXGI_FORMAT_R32_UINT ? "shapeGeo32" : "shapeGeo"].get();
+}
 
-	for (const auto& pair : MeshDataMap)
+MeshGeometry* DemoApp::FindShapeGeometry(const std::string& meshName)
+{
+	MeshGeometry* geo = GeometriesMap["shapeGeo"].get();
+	if(geo->DrawArgs.find(meshName) != geo->DrawArgs.end())
 	{
-		Geometry->DrawArgs[pair.first] = submeshGeometries[pair.first];
+		return geo;
 	}
-
-	GeometriesMap["shapeGeo"] = std::move(Geometry);
+	return GeometriesMap["shapeGeo32"].get();
 }
 
 void DemoApp::BuildLandGeometry()
@@ -627,6 +868,7 @@ void DemoApp::BuildLandGeometry()
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
 	submesh.MaterialName = "grass";
+	BoundingBox::CreateFromPoints(submesh.Bounds, vertices.size(), &vertices[0].Pos, sizeof(Vertex));
 
 	geo->DrawArgs["grid"] = submesh;
 
@@ -662,6 +904,31 @@ void DemoApp::BuildPSO()
 	psoDesc.DSVFormat = DepthStencilFormat;
 	ThrowIfFailed(Device->CreateGraphicsPipelineState(&psoDesc, IID_PPV_ARGS(OpaquePipelineState.GetAddressOf())));
 
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC packedPsoDesc = psoDesc;
+	packedPsoDesc.InputLayout = { PackedInputLayout.data(), (UINT)PackedInputLayout.size() };
+	packedPsoDesc.VS =
+	{
+		reinterpret_cast<BYTE*>(PackedVertexShader->GetBufferPointer()),
+		PackedVertexShader->GetBufferSize()
+	};
+	ThrowIfFailed(Device->CreateGraphicsPipelineState(&packedPsoDesc, IID_PPV_ARGS(PackedOpaquePipelineState.GetAddressOf())));
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC instancedPsoDesc = psoDesc;
+	instancedPsoDesc.VS =
+	{
+		reinterpret_cast<BYTE*>(InstancedVertexShader->GetBufferPointer()),
+		InstancedVertexShader->GetBufferSize()
+	};
+	ThrowIfFailed(Device->CreateGraphicsPipelineState(&instancedPsoDesc, IID_PPV_ARGS(InstancedOpaquePipelineState.GetAddressOf())));
+
+	D3D12_GRAPHICS_PIPELINE_STATE_DESC packedInstancedPsoDesc = packedPsoDesc;
+	packedInstancedPsoDesc.VS =
+	{
+		reinterpret_cast<BYTE*>(PackedInstancedVertexShader->GetBufferPointer()),
+		PackedInstancedVertexShader->GetBufferSize()
+	};
+	ThrowIfFailed(Device->CreateGraphicsPipelineState(&packedInstancedPsoDesc, IID_PPV_ARGS(PackedInstancedOpaquePipelineState.GetAddressOf())));
+
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC transparentPsoDesc = psoDesc;
 	D3D12_RENDER_TARGET_BLEND_DESC transparencyBlendDesc;
@@ -693,10 +960,50 @@ void DemoApp::BuildPSO()
 	alphaTestPsoDesc.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
 	ThrowIfFailed(Device->CreateGraphicsPipelineState(&alphaTestPsoDesc, IID_PPV_ARGS(AlphaTestPipelineState.GetAddressOf())));
 
+	LayerPipelineStates[(int)RenderLayer::Opaque] = OpaquePipelineState.Get();
+	LayerPipelineStates[(int)RenderLayer::Transparent] = TransparentPipelineState.Get();
+	LayerPipelineStates[(int)RenderLayer::AlphaTested] = AlphaTestPipelineState.Get();
+	LayerPipelineStates[(int)RenderLayer::OpaquePacked] = PackedOpaquePipelineState.Get();
+	LayerPipelineStates[(int)RenderLayer::OpaqueInstanced] = InstancedOpaquePipelineState.Get();
+	LayerPipelineStates[(int)RenderLayer::OpaquePackedInstanced] = PackedInstancedOpaquePipelineState.Get();
+
 }
 
 void DemoApp::BuildRenderItems()
 {
+	auto extractTransform = [](simdjson::ondemand::object& element_value, RenderItemWorldInfo& info)
+	{
+		JsonUtil::ExtractFieldFromObject(element_value, "world", info.WorldPos);
+		JsonUtil::ExtractFieldFromObject(element_value, "scale", info.Scale);
+		JsonUtil::ExtractFieldFromObject(element_value, "euler", info.Euler);
+		JsonUtil::ExtractFieldFromObject(element_value, "spin", info.Spin);
+
+		std::string_view id;
+		if(JsonUtil::ExtractFieldFromObject(element_value, "id", id))
+		{
+			info.Id = std::string(id);
+		}
+		std::string_view parentId;
+		if(JsonUtil::ExtractFieldFromObject(element_value, "parent", parentId))
+		{
+			info.ParentId = std::string(parentId);
+		}
+	};
+
+	// transforms without a mesh, only there to be parents
+	vector<RenderItemWorldInfo> transformInfos;
+	simdjson::ondemand::array transform_doc;
+	if(!scene_doc["transform"].get(transform_doc))
+	{
+		for(auto element : transform_doc)
+		{
+			auto element_value = element.get_object().value();
+			RenderItemWorldInfo transformInfo;
+			extractTransform(element_value, transformInfo);
+			transformInfos.push_back(transformInfo);
+		}
+	}
+
 	vector<RenderItemWorldInfo> renderItemWorldInfos;
 	auto instance_doc = scene_doc["mesh_instance"].get_array();
 	for(auto element : instance_doc)
@@ -707,31 +1014,70 @@ void DemoApp::BuildRenderItems()
 		renderItemWorldInfo.ObjName = meshName;
 
 
-		JsonUtil::ExtractFieldFromObject(element_value, "world", renderItemWorldInfo.WorldPos);
-		JsonUtil::ExtractFieldFromObject(element_value, "scale", renderItemWorldInfo.Scale);
-		JsonUtil::ExtractFieldFromObject(element_value, "euler", renderItemWorldInfo.Euler);
+		extractTransform(element_value, renderItemWorldInfo);
+
+		InstanceBatch::ReadInstances(element_value, renderItemWorldInfo.WorldPos, renderItemWorldInfo.Scale, renderItemWorldInfo.Euler,
+			renderItemWorldInfo.InstanceWorlds);
 
 		renderItemWorldInfos.push_back(renderItemWorldInfo);
 	}
 
+	// world space boxes of all instances, culler slots after the per item ones
+	std::vector<BoundingBox> instanceBounds;
+
 	for(size_t i = 0; i < renderItemWorldInfos.size(); ++i)
 	{
 		auto ritem = std::make_unique<RenderItem>();
-		XMMATRIX rItemWorld = XMMatrixRotationRollPitchYaw(renderItemWorldInfos[i].Euler.x, renderItemWorldInfos[i].Euler.y, renderItemWorldInfos[i].Euler.z);
-		rItemWorld = XMMatrixMultiply(rItemWorld, XMMatrixScaling(renderItemWorldInfos[i].Scale.x, renderItemWorldInfos[i].Scale.y, renderItemWorldInfos[i].Scale.z));
-		rItemWorld = XMMatrixMultiply(rItemWorld, XMMatrixTranslation(renderItemWorldInfos[i].WorldPos.x, renderItemWorldInfos[i].WorldPos.y, renderItemWorldInfos[i].WorldPos.z));
-		XMStoreFloat4x4(&ritem->World, rItemWorld);
+		XMStoreFloat4x4(&ritem->World, MathHelper::MakeWorld(renderItemWorldInfos[i].WorldPos, renderItemWorldInfos[i].Scale, renderItemWorldInfos[i].Euler));
 		const std::string& objName = renderItemWorldInfos[i].ObjName;
 		ritem->ObjCBIndex = i;
-		ritem->Geo = GeometriesMap["shapeGeo"].get();
+		ritem->Geo = FindShapeGeometry(objName);
 		ritem->PrimitiveType = D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 		ritem->IndexCount = ritem->Geo->DrawArgs[objName].IndexCount;
 		ritem->StartIndexLocation = ritem->Geo->DrawArgs[objName].StartIndexLocation;
 		ritem->BaseVertexLocation = ritem->Geo->DrawArgs[objName].BaseVertexLocation;
-		ritem->Mat = Materials[ritem->Geo->DrawArgs[objName].MaterialName].get();
+		ritem->Mat = FindMaterial(ritem->Geo->DrawArgs[objName].MaterialName);
+		ritem->Bounds = ritem->Geo->DrawArgs[objName].Bounds;
+		ritem->LodSwitchDistance = ritem->Geo->DrawArgs[objName].LodSwitchDistance;
+		if(ShapeVertexFormat == VertexFormat::Packed)
+		{
+			VertexPacker::GetDequantization(ritem->Geo->DrawArgs[objName].Bounds, ritem->PositionScale, ritem->PositionBias);
+		}
+
+		for(size_t level = 1; ; ++level)
+		{
+			auto lod = ritem->Geo->DrawArgs.find(GeometryPacker::GetLodName(objName, level));
+			if(lod == ritem->Geo->DrawArgs.end())
+			{
+				break;
+			}
+			if(level == 1)
+			{
+				ritem->Lods.push_back(&ritem->Geo->DrawArgs[objName]);
+			}
+			ritem->Lods.push_back(&lod->second);
+		}
+
+		const std::vector<XMFLOAT4X4>& instanceWorlds = renderItemWorldInfos[i].InstanceWorlds;
+		bool instanced = !instanceWorlds.empty();
+		if(instanced)
+		{
+			ritem->World = MathHelper::Identity4x4();
+			ritem->FirstInstanceSlot = instanceBounds.size();
+			ritem->Bounds = InstanceBatch::Place(ritem->Bounds, instanceWorlds, ritem->Instances, instanceBounds);
+		}
 
 		AllRitems.push_back(std::move(ritem));
-		RitemLayer[(int)RenderLayer::Opaque].push_back(AllRitems.back().get());
+		RenderLayer layer;
+		if(ShapeVertexFormat == VertexFormat::Packed)
+		{
+			layer = instanced ? RenderLayer::OpaquePackedInstanced : RenderLayer::OpaquePacked;
+		}
+		else
+		{
+			layer = instanced ? RenderLayer::OpaqueInstanced : RenderLayer::Opaque;
+		}
+		RitemLayer[(int)layer].push_back(AllRitems.back().get());
 	}
 
 	auto gridRitem = std::make_unique<RenderItem>();
@@ -742,7 +1088,8 @@ void DemoApp::BuildRenderItems()
 	gridRitem->IndexCount = gridRitem->Geo->DrawArgs["grid"].IndexCount;
 	gridRitem->StartIndexLocation = gridRitem->Geo->DrawArgs["grid"].StartIndexLocation;
 	gridRitem->BaseVertexLocation = gridRitem->Geo->DrawArgs["grid"].BaseVertexLocation;
-	gridRitem->Mat = Materials[gridRitem->Geo->DrawArgs["grid"].MaterialName].get();
+	gridRitem->Mat = FindMaterial(gridRitem->Geo->DrawArgs["grid"].MaterialName);
+	gridRitem->Bounds = gridRitem->Geo->DrawArgs["grid"].Bounds;
 	AllRitems.push_back(std::move(gridRitem));
 	RitemLayer[(int)RenderLayer::Opaque].push_back(AllRitems.back().get());
 
@@ -754,11 +1101,94 @@ void DemoApp::BuildRenderItems()
 	wavesRitem->IndexCount = wavesRitem->Geo->DrawArgs["water"].IndexCount;
 	wavesRitem->StartIndexLocation = wavesRitem->Geo->DrawArgs["water"].StartIndexLocation;
 	wavesRitem->BaseVertexLocation = wavesRitem->Geo->DrawArgs["water"].BaseVertexLocation;
-	wavesRitem->Mat = Materials["water"].get();
+	wavesRitem->Mat = FindMaterial("water");
+	wavesRitem->Bounds = wavesRitem->Geo->DrawArgs["water"].Bounds;
 	this->WaveRitem = wavesRitem.get();
 	AllRitems.push_back(std::move(wavesRitem));
 	RitemLayer[(int)RenderLayer::Transparent].push_back(AllRitems.back().get());
 
+	size_t instanceSlotBase = AllRitems.size();
+	Culler.Resize(instanceSlotBase + instanceBounds.size());
+	for(size_t k = 0; k < instanceBounds.size(); ++k)
+	{
+		Culler.SetBox(instanceSlotBase + k, instanceBounds[k]);
+	}
+	for(auto& ritem : AllRitems)
+	{
+		ritem->FirstInstanceSlot += instanceSlotBase;
+	}
+	InstanceCapacity = (UINT)instanceBounds.size();
+
+	DirtyObjects.Resize(AllRitems.size());
+	for(auto& ritem : AllRitems)
+	{
+		MarkDirty(ritem.get());
+	}
+
+	// Every "transform" entry and every mesh entry that is not instanced becomes a
+	// node. Instances are placed once, so instanced entries cannot take part.
+	std::vector<const RenderItemWorldInfo*> nodeInfos;
+	std::vector<RenderItem*> nodeRitems;
+	for(const RenderItemWorldInfo& info : transformInfos)
+	{
+		nodeInfos.push_back(&info);
+		nodeRitems.push_back(nullptr);
+	}
+	for(size_t i = 0; i < renderItemWorldInfos.size(); ++i)
+	{
+		if(renderItemWorldInfos[i].InstanceWorlds.empty())
+		{
+			nodeInfos.push_back(&renderItemWorldInfos[i]);
+			nodeRitems.push_back(AllRitems[i].get());
+		}
+	}
+
+	std::unordered_map<std::string, int> nodeIds;
+	for(size_t k = 0; k < nodeInfos.size(); ++k)
+	{
+		if(!nodeInfos[k]->Id.empty())
+		{
+			nodeIds[nodeInfos[k]->Id] = (int)k;
+		}
+	}
+	std::vector<int> parents(nodeInfos.size(), TransformHierarchy::NoParent);
+	for(size_t k = 0; k < nodeInfos.size(); ++k)
+	{
+		const std::string& parentId = nodeInfos[k]->ParentId;
+		if(!parentId.empty())
+		{
+			auto parent = nodeIds.find(parentId);
+			if(parent == nodeIds.end())
+			{
+				throw std::runtime_error("unknown transform parent");
+			}
+			parents[k] = parent->second;
+		}
+	}
+
+	std::vector<int> nodeOfInfo(nodeInfos.size());
+	for(size_t k : TransformHierarchy::SortParentsFirst(parents))
+	{
+		const RenderItemWorldInfo* info = nodeInfos[k];
+		XMFLOAT4X4 local;
+		XMStoreFloat4x4(&local, MathHelper::MakeWorld(info->WorldPos, info->Scale, info->Euler));
+		int parent = parents[k] == TransformHierarchy::NoParent ? TransformHierarchy::NoParent : nodeOfInfo[parents[k]];
+		int node = Transforms.AddNode(parent, local);
+		nodeOfInfo[k] = node;
+
+		NodeRitems.push_back(nodeRitems[k]);
+		if(info->Spin.x != 0.0f || info->Spin.y != 0.0f || info->Spin.z != 0.0f)
+		{
+			TransformAnimations.push_back({ node, info->WorldPos, info->Scale, info->Euler, info->Spin });
+		}
+	}
+	ApplyTransforms();
+
+	std::unordered_map<const MeshGeometry*, UINT> geometrySortIds;
+	for(auto& ritem : AllRitems)
+	{
+		ritem->GeometrySortId = geometrySortIds.emplace(ritem->Geo, (UINT)geometrySortIds.size()).first->second;
+	}
 }
 
 void DemoApp::BuildMaterials()
@@ -779,39 +1209,199 @@ void DemoApp::BuildMaterials()
 		JsonUtil::ExtractFieldFromObject(element_value, "roughness", mat->Roughness);
 		JsonUtil::ExtractFieldFromObject(element_value, "mat_transform", mat->MatTransform);
 
-		Materials[mat->Name] = std::move(mat);
+		AddMaterial(std::move(mat));
 		++i;
 	}
 
 }
 
-void DemoApp::DrawRenderItems(ID3D12GraphicsCommandList *cmdList, const std::vector<RenderItem *> &ritems)
+void DemoApp::LoadCachedMaterials()
 {
-	UINT objCBByteSize = D3DUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
-	UINT matCBByteSize = D3DUtil::CalcConstantBufferByteSize(sizeof(MaterialConstants));
+	const SceneCache::MaterialRecord* records = SceneBake.GetMaterials();
+	for(UINT i = 0; i < SceneBake.GetHeader().MaterialCount; ++i)
+	{
+		const SceneCache::MaterialRecord& record = records[i];
+		auto mat = std::make_unique<Material>();
+		mat->Name = record.Name;
+		mat->MatCBIndex = record.MatCBIndex;
+		mat->DiffuseSrvHeapIndex = record.DiffuseSrvHeapIndex;
+		mat->NormalSrvHeapIndex = record.NormalSrvHeapIndex;
+		mat->DiffuseAlbedo = XMFLOAT4(record.DiffuseAlbedo);
+		mat->FresnelR0 = XMFLOAT3(record.FresnelR0);
+		mat->Roughness = record.Roughness;
+		mat->MatTransform = XMFLOAT4X4(record.MatTransform);
+
+		AddMaterial(std::move(mat));
+	}
+}
+
+void DemoApp::AddMaterial(std::unique_ptr<Material> mat)
+{
+	if(mat->MatCBIndex < 0)
+	{
+		throw std::runtime_error("material without a constant buffer index");
+	}
+	if((size_t)mat->MatCBIndex >= Materials.size())
+	{
+		Materials.resize(mat->MatCBIndex + 1);
+		DirtyMaterials.Resize(Materials.size());
+	}
+	MaterialsByName[mat->Name] = mat.get();
+	MarkDirty(mat.get());
+	Materials[mat->MatCBIndex] = std::move(mat);
+}
+
+Material* DemoApp::FindMaterial(const std::string &name)
+{
+	auto it = MaterialsByName.find(name);
+	return it != MaterialsByName.end() ? it->second : nullptr;
+}
+
+void DemoApp::MarkDirty(RenderItem *ritem)
+{
+	DirtyObjects.Mark(ritem->ObjCBIndex);
+}
 
-	auto matBuffer = CurrentFrameResource->MaterialCB->Resource();
+void DemoApp::MarkDirty(Material *mat)
+{
+	DirtyMaterials.Mark(mat->MatCBIndex);
+}
+
+// Key bits from high to low: the layer's place in LayerDrawOrder (8), then for
+// opaque layers geometry (12), material (12) and view depth (32). Blended layers
+// put the inverted depth before geometry and material so they draw back to front.
+void DemoApp::BuildDrawPackets()
+{
+	XMMATRIX view = XMLoadFloat4x4(&View);
 
-	for(size_t i = 0; i < ritems.size(); ++i)
+	DrawPackets.clear();
+	for(int order = 0; order < _countof(LayerDrawOrder); ++order)
 	{
-		RenderItem* ri = ritems[i];
-		D3D12_VERTEX_BUFFER_VIEW vbv = ri->Geo->VertexBufferView();
-		D3D12_INDEX_BUFFER_VIEW ibv = ri->Geo->IndexBufferView();
-		cmdList->IASetVertexBuffers(0, 1, &vbv);
-		cmdList->IASetIndexBuffer(&ibv);
-		cmdList->IASetPrimitiveTopology(ri->PrimitiveType);
+		RenderLayer layer = LayerDrawOrder[order];
+		bool blended = layer == RenderLayer::Transparent;
+		for(RenderItem* ritem : VisibleRitemLayer[(int)layer])
+		{
+			// non-negative floats sort like their bit patterns
+			float depth = XMVectorGetZ(XMVector3TransformCoord(XMLoadFloat3(&ritem->WorldBounds.Center), view));
+			depth = (std::max)(depth, 0.0f);
+			std::uint32_t depthBits;
+			memcpy(&depthBits, &depth, sizeof(depthBits));
+
+			std::uint64_t state = ((std::uint64_t)(ritem->GeometrySortId & 0xfff) << 12) | (std::uint64_t)(ritem->Mat->MatCBIndex & 0xfff);
+
+			DrawPacket packet;
+			packet.Pipeline = (std::uint32_t)layer;
+			packet.Topology = (std::uint32_t)ritem->PrimitiveType;
+			packet.Geometry = ritem->Geo;
+			packet.Material = ritem->Mat;
+			packet.Item = ritem;
+			packet.Key = (std::uint64_t)order << 56;
+			if(blended)
+			{
+				packet.Key |= ((std::uint64_t)(std::uint32_t)~depthBits << 24) | state;
+			}
+			else
+			{
+				packet.Key |= (state << 32) | depthBits;
+			}
+			DrawPackets.push_back(packet);
+		}
+	}
+
+	RadixSort64(DrawPackets, DrawPacketScratch, [](const DrawPacket& packet) { return packet.Key; });
+}
+
+void DemoApp::BindPassState(ID3D12GraphicsCommandList *cmdList)
+{
+	cmdList->RSSetViewports(1, &Viewport);
+	cmdList->RSSetScissorRects(1, &ScissorRect);
+
+	D3D12_CPU_DESCRIPTOR_HANDLE depthStencilView = DepthStencilView();
+	D3D12_CPU_DESCRIPTOR_HANDLE currentBackBufferView = CurrentBackBufferView();
+	cmdList->OMSetRenderTargets(1, &currentBackBufferView, true, &depthStencilView);
+
+	ID3D12DescriptorHeap* descriptorHeaps[] = {SrvHeap.Get() };
+	cmdList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
 
-		cmdList->SetGraphicsRootConstantBufferView(0, CurrentFrameResource->ObjectCB->Resource()->GetGPUVirtualAddress() + ri->ObjCBIndex * objCBByteSize);
-		cmdList->SetGraphicsRootConstantBufferView(2, matBuffer->GetGPUVirtualAddress() + ri->Mat->MatCBIndex * matCBByteSize);
+	cmdList->SetGraphicsRootSignature(RootSignature.Get());
+
+	cmdList->SetGraphicsRootConstantBufferView(1, CurrentFrameResource->PassCB->Resource()->GetGPUVirtualAddress());
+}
 
-		CD3DX12_GPU_DESCRIPTOR_HANDLE tex(SrvHeap->GetGPUDescriptorHandleForHeapStart());
-		tex.Offset(ri->Mat->DiffuseSrvHeapIndex, CbvSrvUavDescriptorSize);
-		cmdList->SetGraphicsRootDescriptorTable(3, tex);
+DemoApp::CommandListRecorder::CommandListRecorder(DemoApp& app, ID3D12GraphicsCommandList* cmdList, ID3D12CommandAllocator* cmdListAlloc) :
+	App(app), CmdList(cmdList), CmdListAlloc(cmdListAlloc)
+{
+	ObjectBufferAddress = App.CurrentFrameResource->ObjectCB->Resource()->GetGPUVirtualAddress();
+	MaterialBufferAddress = App.CurrentFrameResource->MaterialCB->Resource()->GetGPUVirtualAddress();
+	InstanceBufferAddress = App.CurrentFrameResource->InstanceBuffer->Resource()->GetGPUVirtualAddress();
+	ObjCBByteSize = D3DUtil::CalcConstantBufferByteSize(sizeof(ObjectConstants));
+	MatCBByteSize = D3DUtil::CalcConstantBufferByteSize(sizeof(MaterialConstants));
+}
 
-		cmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+void DemoApp::CommandListRecorder::Begin()
+{
+	if(CmdListAlloc != nullptr)
+	{
+		ThrowIfFailed(CmdListAlloc->Reset());
+		ThrowIfFailed(CmdList->Reset(CmdListAlloc, nullptr));
+	}
+	App.BindPassState(CmdList);
+}
 
+void DemoApp::CommandListRecorder::End(bool last)
+{
+	if(last)
+	{
+		D3D12_RESOURCE_BARRIER renderTargetToPresent = CD3DX12_RESOURCE_BARRIER::Transition(App.CurrentBackBuffer(),
+			D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
+		CmdList->ResourceBarrier(1, &renderTargetToPresent);
 	}
+	ThrowIfFailed(CmdList->Close());
+}
+
+void DemoApp::CommandListRecorder::SetPipeline(std::uint32_t pipeline)
+{
+	CmdList->SetPipelineState(App.LayerPipelineStates[pipeline]);
+}
+
+void DemoApp::CommandListRecorder::SetGeometry(const void* geometry)
+{
+	const MeshGeometry* geo = static_cast<const MeshGeometry*>(geometry);
+	D3D12_VERTEX_BUFFER_VIEW vbv = geo->VertexBufferView();
+	D3D12_INDEX_BUFFER_VIEW ibv = geo->IndexBufferView();
+	CmdList->IASetVertexBuffers(0, 1, &vbv);
+	CmdList->IASetIndexBuffer(&ibv);
+}
+
+void DemoApp::CommandListRecorder::SetTopology(std::uint32_t topology)
+{
+	CmdList->IASetPrimitiveTopology((D3D12_PRIMITIVE_TOPOLOGY)topology);
+}
+
+void DemoApp::CommandListRecorder::SetMaterial(const void* material)
+{
+	const Material* mat = static_cast<const Material*>(material);
+	CmdList->SetGraphicsRootConstantBufferView(2, MaterialBufferAddress + mat->MatCBIndex * MatCBByteSize);
 
+	CD3DX12_GPU_DESCRIPTOR_HANDLE tex(App.SrvHeap->GetGPUDescriptorHandleForHeapStart());
+	tex.Offset(App.TextureStreaming->GetDescriptorIndex(mat->DiffuseSrvHeapIndex), App.CbvSrvUavDescriptorSize);
+	CmdList->SetGraphicsRootDescriptorTable(3, tex);
+}
+
+void DemoApp::CommandListRecorder::Draw(const DrawPacket& packet)
+{
+	const RenderItem* ri = static_cast<const RenderItem*>(packet.Item);
+	CmdList->SetGraphicsRootConstantBufferView(0, ObjectBufferAddress + ri->ObjCBIndex * ObjCBByteSize);
+
+	if(ri->Instances.empty())
+	{
+		CmdList->DrawIndexedInstanced(ri->IndexCount, 1, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+	}
+	else
+	{
+		CmdList->SetGraphicsRootShaderResourceView(4, InstanceBufferAddress + ri->InstanceBufferOffset * sizeof(InstanceData));
+		CmdList->DrawIndexedInstanced(ri->IndexCount, ri->InstanceCount, ri->StartIndexLocation, ri->BaseVertexLocation, 0);
+	}
 }
 
 void DemoApp::UpdateMainPassCB()
@@ -869,7 +1459,7 @@ void DemoApp::BuildDescriptorHeaps()
 	ThrowIfFailed(Device->CreateDescriptorHeap(&cbvHeapDesc, IID_PPV_ARGS(CbvHeap.GetAddressOf())));
 
 	D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc;
-	srvHeapDesc.NumDescriptors = Textures.size();
+	srvHeapDesc.NumDescriptors = TextureStreaming->GetDescriptorCount();
 	srvHeapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
 	srvHeapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 	srvHeapDesc.NodeMask = 0;
@@ -878,10 +1468,13 @@ void DemoApp::BuildDescriptorHeaps()
 
 void DemoApp::BuildFrameResources()
 {
+	// the calling thread records a chunk as well
+	UINT recordingChunks = (std::min)(WorkerPool->GetThreadCount() + 1, MaxRecordingChunks);
 	for(int i = 0; i < NumFrameResources; ++i)
 	{
-		FrameResources.push_back(std::make_unique<FrameResource>(Device.Get(), 1, (UINT)AllRitems.size(), Materials.size(), 128 * 128));
+		FrameResources.push_back(std::make_unique<FrameResource>(Device.Get(), 1, (UINT)AllRitems.size(), Materials.size(), 128 * 128, InstanceCapacity, recordingChunks));
 	}
+	FrameSlots = std::make_unique<FrameRing>(*QueueSync, FrameResources.size());
 }
 
 void DemoApp::BuildConstantBuffers()
@@ -929,58 +1522,71 @@ void DemoApp::BuildConstantBuffers()
 
 void DemoApp::BuildShaderResourceView()
 {
-	CD3DX12_CPU_DESCRIPTOR_HANDLE Descriptor(SrvHeap->GetCPUDescriptorHandleForHeapStart());
-
-	D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-	for(auto& tex : Textures)
-	{
-		srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-		srvDesc.Format = tex->Resource->GetDesc().Format;
-		srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-		srvDesc.Texture2D.MostDetailedMip = 0;
-		srvDesc.Texture2D.MipLevels = tex->Resource->GetDesc().MipLevels;
-		srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
-		Device->CreateShaderResourceView(tex->Resource.Get(), &srvDesc, Descriptor);
-		Descriptor.Offset(1, CbvSrvUavDescriptorSize);
-	}
+	TextureStreaming->CreateDescriptors(SrvHeap.Get(), 0, CbvSrvUavDescriptorSize);
 }
 
 void DemoApp::UpdateObjectCBs()
 {
-	for(auto& ritem : AllRitems)
+	auto currObjectCB = CurrentFrameResource->ObjectCB.get();
+	DirtyObjects.Update([&](UINT index)
 	{
-		if(ritem->NumFramesDirty > 0)
-		{
-			XMMATRIX world = XMLoadFloat4x4(&ritem->World);
-
-			ObjectConstants objConstants;
-			XMStoreFloat4x4(&objConstants.World, DirectX::XMMatrixTranspose(world));
-			CurrentFrameResource->ObjectCB->CopyData(ritem->ObjCBIndex, objConstants);
-
-			ritem->NumFramesDirty--;
-		}
-	}
+		RenderItem* ritem = AllRitems[index].get();
+		XMMATRIX world = XMLoadFloat4x4(&ritem->World);
+
+		ObjectConstants objConstants;
+		XMStoreFloat4x4(&objConstants.World, DirectX::XMMatrixTranspose(world));
+		objConstants.PositionScale = ritem->PositionScale;
+		objConstants.PositionBias = ritem->PositionBias;
+		currObjectCB->CopyData(ritem->ObjCBIndex, objConstants);
+	});
 }
 
 void DemoApp::UpdateMaterialCBs(const GameTimer &gt)
 {
 	auto currMaterialCB = CurrentFrameResource->MaterialCB.get();
-	for(const auto& pair: Materials)
+	DirtyMaterials.Update([&](UINT index)
 	{
-		Material* mat = pair.second.get();
-		if(mat->NumFramesDirty > 0)
-		{
-			XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
+		Material* mat = Materials[index].get();
+		XMMATRIX matTransform = XMLoadFloat4x4(&mat->MatTransform);
+
+		MaterialConstants matConstants;
+		matConstants.DiffuseAlbedo = mat->DiffuseAlbedo;
+		matConstants.FresnelR0 = mat->FresnelR0;
+		matConstants.Roughness = mat->Roughness;
+		XMStoreFloat4x4(&matConstants.MatTransform, XMMatrixTranspose(matTransform));
 
-			MaterialConstants matConstants;
-			matConstants.DiffuseAlbedo = mat->DiffuseAlbedo;
-			matConstants.FresnelR0 = mat->FresnelR0;
-			matConstants.Roughness = mat->Roughness;
-			XMStoreFloat4x4(&matConstants.MatTransform, XMMatrixTranspose(matTransform));
+		currMaterialCB->CopyData(mat->MatCBIndex, matConstants);
+	});
+}
 
-			currMaterialCB->CopyData(mat->MatCBIndex, matConstants);
+void DemoApp::UpdateTransforms(const GameTimer &gt)
+{
+	float totalTime = gt.GetTotalTime();
+	for(const TransformAnimation& animation : TransformAnimations)
+	{
+		XMFLOAT3 euler(
+			animation.Euler.x + animation.Spin.x * totalTime,
+			animation.Euler.y + animation.Spin.y * totalTime,
+			animation.Euler.z + animation.Spin.z * totalTime);
+
+		XMFLOAT4X4 local;
+		XMStoreFloat4x4(&local, MathHelper::MakeWorld(animation.WorldPos, animation.Scale, euler));
+		Transforms.SetLocal(animation.Node, local);
+	}
+	ApplyTransforms();
+}
 
-			mat->NumFramesDirty--;
+void DemoApp::ApplyTransforms()
+{
+	ChangedNodes.clear();
+	Transforms.Update(ChangedNodes);
+	for(int node : ChangedNodes)
+	{
+		RenderItem* ritem = NodeRitems[node];
+		if(ritem)
+		{
+			ritem->World = Transforms.GetWorld(node);
+			MarkDirty(ritem);
 		}
 	}
 }
@@ -991,15 +1597,6 @@ void DemoApp::Update(const GameTimer& gt)
 	float z = Radius * sinf(Phi) * sinf(Theta);
 	float y = Radius * cosf(Phi);
 
-	{
-		float deltaTime = gt.GetDeltaTime();
-		auto boxRitem = AllRitems[0].get();
-		float boxX = 2.0f * sinf(gt.GetTotalTime());
-		float boxZ = 2.0f * cosf(gt.GetTotalTime());
-		XMStoreFloat4x4(&boxRitem->World, XMMatrixTranslation(boxX, 1.0f, boxZ));
-		boxRitem->NumFramesDirty = NumFrameResources;
-	}
-
 	EyePos = { x, y, z };
 
 	XMVECTOR pos = XMVectorSet(x, y, z, 1.0f);
@@ -1011,29 +1608,115 @@ void DemoApp::Update(const GameTimer& gt)
 
 	XMMATRIX proj = XMLoadFloat4x4(&Proj);
 
-	CurrentFrameResourceIndex = (CurrentFrameResourceIndex + 1) % NumFrameResources;
-	CurrentFrameResource = FrameResources[CurrentFrameResourceIndex].get();
-
-	// wait until the gpu has completed commands up to this fence point
-	if (CurrentFrameResource->Fence != 0 && Fence->GetCompletedValue() < CurrentFrameResource->Fence)
-	{
-		HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
-		ThrowIfFailed(Fence->SetEventOnCompletion(CurrentFrameResource->Fence, eventHandle));
-		WaitForSingleObject(eventHandle, INFINITE);
-		CloseHandle(eventHandle);
-	}
+	// waits until the gpu has finished the frame that used this resource last
+	CurrentFrameResource = FrameResources[FrameSlots->BeginFrame()].get();
 
 	UpdateWave(gt);
+	UpdateTransforms(gt);
+	UpdateLods();
 	OnKeyboardInput(gt);
 
 	UpdateMainPassCB();
+	UpdateVisibility();
+	UpdateTextureStreaming();
+	BuildDrawPackets();
 	UpdateObjectCBs();
 	UpdateMaterialCBs(gt);
 }
 
+void DemoApp::UpdateVisibility()
+{
+	for(auto& ritem : AllRitems)
+	{
+		ritem->Bounds.Transform(ritem->WorldBounds, XMLoadFloat4x4(&ritem->World));
+		Culler.SetBox(ritem->ObjCBIndex, ritem->WorldBounds);
+	}
+
+	XMFLOAT4 planes[6];
+	FrustumCuller::ExtractPlanes(XMMatrixMultiply(XMLoadFloat4x4(&View), XMLoadFloat4x4(&Proj)), planes);
+	Culler.Cull(planes, RitemVisible);
+
+	// Visible instances are packed back to back, so each instanced item draws one contiguous range.
+	UploadBuffer<InstanceData>::Span instanceBuffer = CurrentFrameResource->InstanceBuffer->GetSpan(0, InstanceCapacity);
+	UINT instanceCount = 0;
+	size_t visibleCount = 0;
+	size_t totalCount = 0;
+	for(int layer = 0; layer < (int)RenderLayer::Count; ++layer)
+	{
+		VisibleRitemLayer[layer].clear();
+		for(RenderItem* ritem : RitemLayer[layer])
+		{
+			if(ritem->Instances.empty())
+			{
+				totalCount++;
+				if(RitemVisible[ritem->ObjCBIndex])
+				{
+					visibleCount++;
+					VisibleRitemLayer[layer].push_back(ritem);
+				}
+				continue;
+			}
+
+			totalCount += ritem->Instances.size();
+			ritem->InstanceBufferOffset = instanceCount;
+			ritem->InstanceCount = 0;
+			if(RitemVisible[ritem->ObjCBIndex])
+			{
+				ritem->InstanceCount = InstanceBatch::PackVisible(ritem->Instances, &RitemVisible[ritem->FirstInstanceSlot], instanceBuffer.Data + instanceCount);
+				instanceCount += ritem->InstanceCount;
+			}
+			if(ritem->InstanceCount > 0)
+			{
+				visibleCount += ritem->InstanceCount;
+				VisibleRitemLayer[layer].push_back(ritem);
+			}
+		}
+	}
+
+	VisibleRitemCount = visibleCount;
+	CulledRitemCount = totalCount - visibleCount;
+}
+
+std::wstring DemoApp::GetFrameStatsText() const
+{
+	return L"    visible: " + std::to_wstring(GetVisibleRitemCount()) + L"    culled: " + std::to_wstring(GetCulledRitemCount());
+}
+
+void DemoApp::UpdateLods()
+{
+	XMVECTOR eye = XMLoadFloat3(&EyePos);
+	for(auto& ritem : AllRitems)
+	{
+		if(ritem->Lods.empty())
+		{
+			continue;
+		}
+
+		XMVECTOR center = XMVectorSet(ritem->World._41, ritem->World._42, ritem->World._43, 1.0f);
+		float distance = XMVectorGetX(XMVector3Length(center - eye));
+		if(!ritem->Instances.empty())
+		{
+			// one level for the whole draw, picked by the closest instance; Instances hold transposed matrices
+			distance = FLT_MAX;
+			for(const InstanceData& instance : ritem->Instances)
+			{
+				center = XMVectorSet(instance.World._14, instance.World._24, instance.World._34, 1.0f);
+				distance = (std::min)(distance, XMVectorGetX(XMVector3Length(center - eye)));
+			}
+		}
+		size_t level = (std::min)((size_t)(distance / ritem->LodSwitchDistance), ritem->Lods.size() - 1);
+
+		const SubmeshGeometry* submesh = ritem->Lods[level];
+		ritem->IndexCount = submesh->IndexCount;
+		ritem->StartIndexLocation = submesh->StartIndexLocation;
+		ritem->BaseVertexLocation = submesh->BaseVertexLocation;
+	}
+}
+
 void DemoApp::BuildWaveGeometry()
 {
-	Wave = std::make_unique<Waves>(128, 128, 1.0f, 0.03f, 4.0f, 0.2f);
+	Wave = std::make_unique<Waves>(128, 128, 1.0f, 0.03f, 4.0f, 0.2f, WorkerPool.get());
+	Wave->SetInterpolation(true);
 	std::vector<std::uint16_t> indices(3 * Wave->GetTriangleCount());
 
 	int m = Wave->GetRowCount();
@@ -1077,6 +1760,9 @@ void DemoApp::BuildWaveGeometry()
 	submesh.IndexCount = (UINT)indices.size();
 	submesh.StartIndexLocation = 0;
 	submesh.BaseVertexLocation = 0;
+	// The surface moves, so leave generous room above and below the rest height.
+	submesh.Bounds.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	submesh.Bounds.Extents = XMFLOAT3(0.5f * Wave->Width(), 4.0f, 0.5f * Wave->Depth());
 
 	geo->DrawArgs["water"] = submesh;
 
@@ -1101,26 +1787,26 @@ void DemoApp::UpdateWave(const GameTimer& gt)
 
 	Wave->Update(gt.GetDeltaTime());
 
-	auto currWavesVB = CurrentFrameResource->WavesVB.get();
-	for(int i = 0; i < Wave->GetVertexCount(); ++i)
-	{
-		Vertex v;
-
-		v.Pos = Wave->GetPosition(i);
-		v.Color = XMFLOAT4(DirectX::Colors::Blue);
-		v.Normal = Wave->GetNormal(i);
-		v.TexC = Wave->GetTexC(i);
+	// Waves::WriteVertices produces the Vertex layout directly in the mapped buffer.
+	static_assert(sizeof(Vertex) == Waves::VertexFloatCount * sizeof(float), "Vertex no longer matches Waves::WriteVertices");
+	static_assert(offsetof(Vertex, Normal) == 12 && offsetof(Vertex, TexC) == 24 && offsetof(Vertex, Color) == 32, "Vertex no longer matches Waves::WriteVertices");
 
-		currWavesVB->CopyData(i, v);
-	}
+	auto currWavesVB = CurrentFrameResource->WavesVB.get();
+	UploadBuffer<Vertex>::Span vertices = currWavesVB->GetSpan(0, (UINT)Wave->GetVertexCount());
+	Wave->WriteVertices(&vertices[0].Pos.x, XMFLOAT4(DirectX::Colors::Blue));
 
 	WaveRitem->Geo->VertexBufferGPU = currWavesVB->Resource();
 }
 
-void DemoApp::LoadTextures()
+void DemoApp::BeginLoadTextures()
 {
-	DirectX::ResourceUploadBatch UploadBatch(Device.Get());
-	UploadBatch.Begin();
+	double budget;
+	if(!scene_doc["texture_budget_mb"].get_double().get(budget))
+	{
+		TextureBudgetMB = (float)budget;
+	}
+	std::uint64_t budgetBytes = (std::uint64_t)(TextureBudgetMB * 1024.0f * 1024.0f);
+	TextureStreaming = std::make_unique<TextureStreamer>(Device.Get(), *WorkerPool, budgetBytes, NumFrameResources);
 
 	simdjson::ondemand::array arr = scene_doc["texture"].get_array();
 	for (auto element : arr)
@@ -1130,14 +1816,50 @@ void DemoApp::LoadTextures()
 		auto texture = std::make_unique<Texture>();
 		texture->Name = std::string(name);
 		texture->Filename = std::wstring(path.begin(), path.end());
-		ThrowIfFailed(DirectX::CreateDDSTextureFromFile(Device.Get(), UploadBatch, texture->Filename.c_str(), texture->Resource.GetAddressOf()));
+		TextureStreaming->Add(texture->Filename);
 		TextureNameMap[texture->Name] = Textures.size();
 		Textures.push_back(std::move(texture));
 	}
+}
+
+void DemoApp::FinishLoadTextures()
+{
+	DirectX::ResourceUploadBatch UploadBatch(Device.Get());
+	UploadBatch.Begin();
+
+	TextureStreaming->FinishInitialLoads(UploadBatch);
 
 	UploadBatch.End(CommandQueue.Get());
+}
 
+void DemoApp::UpdateTextureStreaming()
+{
+	const float fovY = 0.25f * XM_PI;
+	XMVECTOR eye = XMLoadFloat3(&EyePos);
+	for(int layer = 0; layer < (int)RenderLayer::Count; ++layer)
+	{
+		for(const RenderItem* ritem : VisibleRitemLayer[layer])
+		{
+			int texture = ritem->Mat->DiffuseSrvHeapIndex;
+			if(texture < 0)
+			{
+				continue;
+			}
+
+			// texels across the item: the texture repeats by the material's scale
+			const BoundingBox& bounds = ritem->WorldBounds;
+			float radius = XMVectorGetX(XMVector3Length(XMLoadFloat3(&bounds.Extents)));
+			float distance = XMVectorGetX(XMVector3Length(XMLoadFloat3(&bounds.Center) - eye));
+			float screenSize = TextureResidency::ComputeScreenSize(radius, distance, fovY, (float)ClientHeight);
+			float tiling = (std::max)(fabsf(ritem->Mat->MatTransform._11), fabsf(ritem->Mat->MatTransform._22));
+			float texels = TextureStreaming->GetWidth(texture) * tiling;
+
+			unsigned mip = TextureResidency::ComputeDesiredMip(texels, screenSize, TextureStreaming->GetMipCount(texture));
+			TextureStreaming->Request(texture, mip, screenSize);
+		}
+	}
 
+	TextureStreaming->Update(CommandQueue.Get());
 }
 
 void DemoApp::OnKeyboardInput(const GameTimer &gt)
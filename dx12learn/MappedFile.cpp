@@ -0,0 +1,135 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::Open(const std::string &filename)
+{
+    Close();
+
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if(file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    FileHandle = file;
+
+    LARGE_INTEGER fileSize = {};
+    if(!GetFileSizeEx(file, &fileSize))
+    {
+        Close();
+        return false;
+    }
+
+    // Zero-length files cannot be mapped, but they are still valid (empty) input.
+    ViewSize = static_cast<size_t>(fileSize.QuadPart);
+    if(ViewSize == 0)
+    {
+        return true;
+    }
+
+    MappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(MappingHandle == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    View = static_cast<const char*>(MapViewOfFile(MappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if(View == nullptr)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if(View != nullptr)
+    {
+        UnmapViewOfFile(View);
+        View = nullptr;
+    }
+    if(MappingHandle != nullptr)
+    {
+        CloseHandle(MappingHandle);
+        MappingHandle = nullptr;
+    }
+    if(FileHandle != nullptr)
+    {
+        CloseHandle(FileHandle);
+        FileHandle = nullptr;
+    }
+    ViewSize = 0;
+}
+
+#else
+
+bool MappedFile::Open(const std::string &filename)
+{
+    Close();
+
+    FileDescriptor = open(filename.c_str(), O_RDONLY);
+    if(FileDescriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat fileStat = {};
+    if(fstat(FileDescriptor, &fileStat) != 0)
+    {
+        Close();
+        return false;
+    }
+
+    // Zero-length files cannot be mapped, but they are still valid (empty) input.
+    ViewSize = static_cast<size_t>(fileStat.st_size);
+    if(ViewSize == 0)
+    {
+        return true;
+    }
+
+    void* view = mmap(nullptr, ViewSize, PROT_READ, MAP_PRIVATE, FileDescriptor, 0);
+    if(view == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    View = static_cast<const char*>(view);
+    madvise(view, ViewSize, MADV_SEQUENTIAL);
+
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if(View != nullptr)
+    {
+        munmap(const_cast<char*>(View), ViewSize);
+        View = nullptr;
+    }
+    if(FileDescriptor >= 0)
+    {
+        close(FileDescriptor);
+        FileDescriptor = -1;
+    }
+    ViewSize = 0;
+}
+
+#endif
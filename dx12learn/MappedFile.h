@@ -0,0 +1,31 @@
+#pragma once
+#include <cstddef>
+#include <string>
+
+// Read-only memory mapping of a whole file. Used by loaders that parse large
+// assets in place instead of streaming them through std::ifstream.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile& rhs) = delete;
+    MappedFile& operator=(const MappedFile& rhs) = delete;
+    ~MappedFile();
+
+    bool Open(const std::string& filename);
+    void Close();
+
+    const char* Data()const { return View; }
+    size_t Size()const { return ViewSize; }
+
+private:
+#ifdef _WIN32
+    // HANDLEs, kept as void* so this header does not need Windows.h.
+    void* FileHandle = nullptr;
+    void* MappingHandle = nullptr;
+#else
+    int FileDescriptor = -1;
+#endif
+    const char* View = nullptr;
+    size_t ViewSize = 0;
+};
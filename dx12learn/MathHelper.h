@@ -65,6 +65,14 @@ public:
         return XMMatrixTranspose(XMMatrixInverse(&det, A));
     }
 
+    // Local matrix of a scene json entry from its "world", "scale" and "euler".
+    static XMMATRIX MakeWorld(const XMFLOAT3& worldPos, const XMFLOAT3& scale, const XMFLOAT3& euler)
+    {
+        XMMATRIX world = XMMatrixRotationRollPitchYaw(euler.x, euler.y, euler.z);
+        world = XMMatrixMultiply(world, XMMatrixScaling(scale.x, scale.y, scale.z));
+        return XMMatrixMultiply(world, XMMatrixTranslation(worldPos.x, worldPos.y, worldPos.z));
+    }
+
     static XMFLOAT4X4 Identity4x4()
     {
         static XMFLOAT4X4 I(
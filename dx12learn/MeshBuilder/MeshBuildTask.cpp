@@ -0,0 +1,139 @@
+#include "MeshBuildTask.h"
+#include "MeshBoxBuilder.h"
+#include "MeshSphereBuilder.h"
+#include "MeshCylinderBuilder.h"
+#include "MeshGridBuilder.h"
+#include "MeshObjBuilder.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+
+#include <stdexcept>
+
+MeshBuildTask MeshBuildTask::FromJson(simdjson::ondemand::object &element)
+{
+    MeshBuildTask task;
+    task.Name = std::string(std::string_view(element["name"]));
+    task.Type = std::string(std::string_view(element["type"]));
+    task.MaterialName = std::string(std::string_view(element["material"]));
+
+    simdjson::ondemand::object param = element["param"].get_object().value();
+
+    // options shared by every mesh type
+    JsonUtil::ExtractFieldFromObject(param, "optimize", task.Optimize);
+    JsonUtil::ExtractFieldFromObject(param, "lod_error", task.LodMaxError);
+    JsonUtil::ExtractFieldFromObject(param, "lod_distance", task.LodSwitchDistance);
+    if(!(task.LodSwitchDistance > 0.0f))
+    {
+        throw std::runtime_error("lod_distance must be positive");
+    }
+    simdjson::ondemand::array lods;
+    if(!param["lods"].get_array().get(lods))
+    {
+        for(auto ratio : lods)
+        {
+            task.LodRatios.push_back((float)ratio.get_double());
+        }
+    }
+
+    if(task.Type == "box")
+    {
+        task.Width = param["width"].get_double();
+        task.Height = param["height"].get_double();
+        task.Depth = param["depth"].get_double();
+        task.NumSubdivisions = param["num_subdivision"].get_int64();
+    }
+    else if(task.Type == "sphere")
+    {
+        task.Radius = param["radius"].get_double();
+        task.SliceCount = param["slice"].get_int64();
+        task.StackCount = param["stack"].get_int64();
+    }
+    else if(task.Type == "cylinder")
+    {
+        task.BottomRadius = param["bottom_radius"].get_double();
+        task.TopRadius = param["top_radius"].get_double();
+        task.Height = param["height"].get_double();
+        task.SliceCount = param["slice"].get_int64();
+        task.StackCount = param["stack"].get_int64();
+    }
+    else if(task.Type == "grid")
+    {
+        task.Width = param["width"].get_double();
+        task.Depth = param["depth"].get_double();
+        task.M = param["m"].get_int64();
+        task.N = param["n"].get_int64();
+    }
+    else if(task.Type == "obj")
+    {
+        task.Path = std::string(std::string_view(param["path"]));
+        JsonUtil::ExtractFieldFromObject(param, "weld_epsilon", task.WeldEpsilon);
+    }
+    else
+    {
+        throw std::runtime_error("Unknown MeshBuilder Type");
+    }
+    return task;
+}
+
+MeshBuilder::MeshData MeshBuildTask::Build(BuildStats* stats)const
+{
+    MeshBuilder::MeshData meshData = BuildMesh(stats);
+    if(!LodRatios.empty())
+    {
+        MeshSimplifier::BuildLods(meshData, LodRatios, LodMaxError);
+    }
+
+    if(stats != nullptr)
+    {
+        stats->LodTriangleCounts.assign(1, (std::uint32_t)(meshData.Indices32.size() / 3));
+        for(const std::vector<std::uint32_t>& lod : meshData.LodIndices32)
+        {
+            stats->LodTriangleCounts.push_back((std::uint32_t)(lod.size() / 3));
+        }
+    }
+
+    if(!Optimize)
+    {
+        return meshData;
+    }
+
+    if(stats != nullptr)
+    {
+        stats->CacheBefore = MeshOptimizer::AnalyzeVertexCache(meshData);
+    }
+    MeshOptimizer::OptimizeVertexCache(meshData);
+    MeshOptimizer::OptimizeOverdraw(meshData);
+    MeshOptimizer::OptimizeVertexFetch(meshData);
+    if(stats != nullptr)
+    {
+        stats->CacheAfter = MeshOptimizer::AnalyzeVertexCache(meshData);
+    }
+    return meshData;
+}
+
+MeshBuilder::MeshData MeshBuildTask::BuildMesh(BuildStats* stats)const
+{
+    if(Type == "box")
+    {
+        return BoxBuilder().BuildBox(Width, Height, Depth, NumSubdivisions);
+    }
+    else if(Type == "sphere")
+    {
+        return SphereBuilder().BuildSphere(Radius, SliceCount, StackCount);
+    }
+    else if(Type == "cylinder")
+    {
+        return CylinderBuilder().BuildCylinder(BottomRadius, TopRadius, Height, SliceCount, StackCount);
+    }
+    else if(Type == "grid")
+    {
+        return GridBuilder().BuildGrid(Width, Depth, M, N);
+    }
+    else if(Type == "obj")
+    {
+        MeshObjBuilder::WeldOptions weldOptions;
+        weldOptions.Epsilon = WeldEpsilon;
+        return MeshObjBuilder().BuildByObjFile(Path, weldOptions, stats != nullptr ? &stats->Weld : nullptr);
+    }
+    throw std::runtime_error("Unknown MeshBuilder Type");
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include "../JsonUtil.h"
+#include "MeshBuilder.h"
+#include "MeshObjBuilder.h"
+#include "MeshOptimizer.h"
+
+// Plain description of one entry of the scene's "mesh" array. Parsing the scene
+// into these first lets the builders run off the main thread without touching json.
+struct MeshBuildTask
+{
+    std::string Name;
+    std::string Type;
+    std::string MaterialName;
+
+    float Width = 0.0f;
+    float Height = 0.0f;
+    float Depth = 0.0f;
+    float Radius = 0.0f;
+    float BottomRadius = 0.0f;
+    float TopRadius = 0.0f;
+    int NumSubdivisions = 0;
+    int SliceCount = 0;
+    int StackCount = 0;
+    int M = 0;
+    int N = 0;
+
+    std::string Path;
+    float WeldEpsilon = 0.0f;
+
+    // Triangle ratio of each level of detail relative to the full mesh, LOD0 first.
+    // Empty means a single level. LodMaxError caps the simplification error,
+    // relative to the mesh extent.
+    std::vector<float> LodRatios;
+    float LodMaxError = 1.0f;
+    // Camera distance covered by each level before the next one is drawn.
+    float LodSwitchDistance = 8.0f;
+
+    // Reorder triangles and vertices for the post-transform cache after building.
+    bool Optimize = true;
+
+    // What Build did to the mesh, for tools that report on the scene's assets.
+    struct BuildStats
+    {
+        // Only filled for obj meshes.
+        MeshObjBuilder::WeldStats Weld;
+        // Only filled when Optimize is set.
+        MeshOptimizer::VertexCacheStats CacheBefore;
+        MeshOptimizer::VertexCacheStats CacheAfter;
+        // Triangles of every level of detail, LOD0 first.
+        std::vector<std::uint32_t> LodTriangleCounts;
+    };
+
+    static MeshBuildTask FromJson(simdjson::ondemand::object& element);
+
+    MeshBuilder::MeshData Build(BuildStats* stats = nullptr)const;
+
+private:
+    MeshBuilder::MeshData BuildMesh(BuildStats* stats)const;
+};
@@ -1,4 +1,5 @@
 #pragma once
+#include <cassert>
 #include <vector>
 #include "../MathHelper.h"
 
@@ -44,9 +45,18 @@ public:
     public:
         std::vector<Vertex> Vertices;
         std::vector<uint32> Indices32;
+        // Coarser levels of detail, finest first. They index the same Vertices as Indices32.
+        std::vector<std::vector<uint32>> LodIndices32;
+
+        // True when every index can be stored as 16 bits without truncation.
+        bool FitsIndices16() const
+        {
+            return Vertices.size() <= 65536;
+        }
 
         std::vector<uint16>& GetIndices16() const
         {
+            assert(FitsIndices16() && "mesh has too many vertices for 16-bit indices");
             if (mIndices16.empty())
             {
                 mIndices16.resize(Indices32.size());
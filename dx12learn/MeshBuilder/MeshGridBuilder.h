@@ -1,5 +1,4 @@
 #pragma once
-#include "../D3DUtil.h"
 #include "MeshBuilder.h"
 
 class GridBuilder : MeshBuilder
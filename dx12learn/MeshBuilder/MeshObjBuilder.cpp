@@ -1,90 +1,156 @@
 #include "MeshObjBuilder.h"
+#include "ObjFileParser.h"
 
+#include <algorithm>
 #include <array>
-#include <fstream>
-#include <sstream>
+#include <cmath>
 
-MeshBuilder::MeshData MeshObjBuilder::BuildByObjFile(const std::string &filename)
+namespace
 {
-	MeshData meshData;
-	// read obj file lines
-	std::ifstream fin(filename);
-
-	if(!fin)
-	{
-		return MeshData();
-	}
-
-	std::vector<XMFLOAT3> positions;
-	std::vector<XMFLOAT3> normals;
-	std::vector<XMFLOAT2> texcoords;
+	const std::uint32_t EmptySlot = 0xffffffff;
 
-	std::string line;
-	while(std::getline(fin, line))
+	// Open addressing table mapping a fixed-size integer key to a vertex index.
+	// Capacity is sized once up front, so lookups never rehash.
+	template<size_t N, typename T>
+	class WeldTable
 	{
-		std::istringstream iss(line);
-		char trash;
+	public:
+		using Key = std::array<T, N>;
 
-		if(!line.compare(0, 2, "v "))
+		explicit WeldTable(size_t maxEntries)
 		{
-			iss >> trash;
-			XMFLOAT3 pos;
-			iss >> pos.x >> pos.y >> pos.z;
-			positions.push_back(pos);
-		}
-		else if(!line.compare(0, 3, "vn "))
-		{
-			iss >> trash >> trash;
-			XMFLOAT3 normal;
-			iss >> normal.x >> normal.y >> normal.z;
-			normals.push_back(normal);
-		}
-		else if(!line.compare(0, 3, "vt "))
-		{
-			iss >> trash >> trash;
-			XMFLOAT2 texcoord;
-			iss >> texcoord.x >> texcoord.y;
-			texcoords.push_back(texcoord);
+			size_t capacity = 16;
+			while(capacity < maxEntries * 2)
+			{
+				capacity <<= 1;
+			}
+			Mask = capacity - 1;
+			Keys.resize(capacity);
+			Values.resize(capacity, EmptySlot);
 		}
-		else if(!line.compare(0, 2, "f "))
+
+		// Returns the existing value for key, or stores and returns value.
+		std::uint32_t FindOrInsert(const Key& key, std::uint32_t value)
 		{
-			iss >> trash;
-			std::array<uint32, 3> face = {0, 0, 0};
-			std::array<uint32, 3> normal = {0, 0, 0};
-			std::array<uint32, 3> texcoord = {0, 0, 0};
-			for(int i = 0; i < 3; i++)
+			for(size_t slot = Hash(key) & Mask; ; slot = (slot + 1) & Mask)
 			{
-				iss >> face[i];
-				if(iss.peek() == '/')
+				if(Values[slot] == EmptySlot)
+				{
+					Keys[slot] = key;
+					Values[slot] = value;
+					return value;
+				}
+				if(Keys[slot] == key)
 				{
-					iss >> trash;
-					if(iss.peek() != '/')
-					{
-						iss >> texcoord[i];
-					}
-					iss >> trash;
-					iss >> normal[i];
+					return Values[slot];
 				}
 			}
-			meshData.Indices32.push_back(face[0]-1);
-			meshData.Indices32.push_back(face[1]-1);
-			meshData.Indices32.push_back(face[2]-1);
 		}
+
+	private:
+		static size_t Hash(const Key& key)
+		{
+			std::uint64_t h = 0xcbf29ce484222325ull;
+			for(T k : key)
+			{
+				h ^= (std::uint64_t)k;
+				h *= 0x100000001b3ull;
+				h ^= h >> 29;
+			}
+			return (size_t)h;
+		}
+
+		size_t Mask = 0;
+		std::vector<Key> Keys;
+		std::vector<std::uint32_t> Values;
+	};
+
+	// Keys are 64 bit, so coordinates beyond 2^31 epsilons keep distinct keys. The clamp
+	// only keeps absurdly large or non-finite values from overflowing the conversion.
+	inline std::int64_t Quantize(float value, double invEpsilon)
+	{
+		const double limit = 4611686018427387904.0; // 2^62
+		double scaled = std::floor(value * invEpsilon + 0.5);
+		return (std::int64_t)(std::max)(-limit, (std::min)(scaled, limit));
+	}
+}
+
+MeshBuilder::MeshData MeshObjBuilder::BuildByObjFile(const std::string &filename)
+{
+	return BuildByObjFile(filename, WeldOptions());
+}
+
+MeshBuilder::MeshData MeshObjBuilder::BuildByObjFile(const std::string &filename, const WeldOptions &options, WeldStats *stats)
+{
+	ObjFileParser parser;
+	if(!parser.ParseFile(filename))
+	{
+		return MeshData();
+	}
+
+	MeshData meshData;
+	const size_t cornerCount = parser.Corners.size();
+
+	// weld identical v/vt/vn triples into one vertex each
+	WeldTable<3, std::int32_t> tripleTable(cornerCount);
+	meshData.Indices32.resize(cornerCount);
+	for(size_t i = 0; i < cornerCount; i++)
+	{
+		const ObjFileParser::Corner& corner = parser.Corners[i];
+		uint32 next = (uint32)meshData.Vertices.size();
+		uint32 index = tripleTable.FindOrInsert({ corner.Position, corner.TexCoord, corner.Normal }, next);
+
+		if(index == next)
+		{
+			Vertex vertex;
+			vertex.Position = parser.Positions[corner.Position];
+			vertex.Normal = corner.Normal >= 0 ? parser.Normals[corner.Normal] : XMFLOAT3(0.0f, 0.0f, 0.0f);
+			vertex.TangentU = XMFLOAT3(0.0f, 0.0f, 0.0f);
+			vertex.TexC = corner.TexCoord >= 0 ? parser.TexCoords[corner.TexCoord] : XMFLOAT2(0.0f, 0.0f);
+			meshData.Vertices.push_back(vertex);
+		}
+		meshData.Indices32[i] = index;
 	}
-	fin.close();
 
-	meshData.Vertices.resize(positions.size());
-	for(uint32 i = 0; i < positions.size(); i++)
+	// optionally merge vertices whose attributes only differ by less than epsilon,
+	// e.g. exporters that duplicate positions per face
+	if(options.Epsilon > 0.0f && !meshData.Vertices.empty())
 	{
-		meshData.Vertices[i].Position = positions[i];
-		if(i < normals.size())
+		const double invEpsilon = 1.0 / options.Epsilon;
+
+		WeldTable<8, std::int64_t> attributeTable(meshData.Vertices.size());
+		std::vector<uint32> remap(meshData.Vertices.size());
+		std::vector<Vertex> welded;
+		welded.reserve(meshData.Vertices.size());
+
+		for(size_t i = 0; i < meshData.Vertices.size(); i++)
 		{
-			meshData.Vertices[i].Normal = normals[i];
+			const Vertex& v = meshData.Vertices[i];
+			WeldTable<8, std::int64_t>::Key key = {
+				Quantize(v.Position.x, invEpsilon), Quantize(v.Position.y, invEpsilon), Quantize(v.Position.z, invEpsilon),
+				Quantize(v.Normal.x, invEpsilon), Quantize(v.Normal.y, invEpsilon), Quantize(v.Normal.z, invEpsilon),
+				Quantize(v.TexC.x, invEpsilon), Quantize(v.TexC.y, invEpsilon) };
+
+			uint32 next = (uint32)welded.size();
+			remap[i] = attributeTable.FindOrInsert(key, next);
+			if(remap[i] == next)
+			{
+				welded.push_back(v);
+			}
 		}
-		if(i < texcoords.size())
+
+		for(uint32& index : meshData.Indices32)
 		{
-			meshData.Vertices[i].TexC = texcoords[i];
+			index = remap[index];
 		}
+		meshData.Vertices.swap(welded);
+	}
+
+	if(stats != nullptr)
+	{
+		stats->CornerCount = (uint32)cornerCount;
+		stats->VertexCount = (uint32)meshData.Vertices.size();
 	}
-    return meshData;
+
+	return meshData;
 }
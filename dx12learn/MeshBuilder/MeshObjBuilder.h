@@ -1,9 +1,27 @@
 #pragma once
-#include "../D3DUtil.h"
 #include "MeshBuilder.h"
 
 class MeshObjBuilder : MeshBuilder
 {
 public:
+    struct WeldOptions
+    {
+        // Corners are always welded on identical v/vt/vn triples. A positive epsilon
+        // additionally merges vertices whose quantized attributes match.
+        float Epsilon = 0.0f;
+    };
+
+    struct WeldStats
+    {
+        uint32 CornerCount = 0;
+        uint32 VertexCount = 0;
+
+        float GetUniqueRatio()const
+        {
+            return CornerCount > 0 ? (float)VertexCount / (float)CornerCount : 0.0f;
+        }
+    };
+
     MeshData BuildByObjFile(const std::string& filename);
-};
\ No newline at end of file
+    MeshData BuildByObjFile(const std::string& filename, const WeldOptions& options, WeldStats* stats = nullptr);
+};
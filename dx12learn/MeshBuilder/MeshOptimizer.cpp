@@ -0,0 +1,385 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    using uint32 = std::uint32_t;
+
+    const uint32 InvalidIndex = 0xffffffff;
+
+    // Forsyth scoring parameters, see "Linear-Speed Vertex Cache Optimisation".
+    const int ForsythCacheSize = 32;
+    const float CacheDecayPower = 1.5f;
+    const float LastTriScore = 0.75f;
+    const float ValenceBoostScale = 2.0f;
+    const float ValenceBoostPower = 0.5f;
+
+    float ForsythScore(int cachePosition, uint32 remainingValence)
+    {
+        if(remainingValence == 0)
+        {
+            return -1.0f;
+        }
+
+        float score = 0.0f;
+        if(cachePosition >= 0)
+        {
+            if(cachePosition < 3)
+            {
+                // The last triangle's vertices get a fixed score so that its
+                // neighbours are not strongly preferred over other cached triangles.
+                score = LastTriScore;
+            }
+            else
+            {
+                const float scaler = 1.0f / (ForsythCacheSize - 3);
+                score = powf(1.0f - (cachePosition - 3) * scaler, CacheDecayPower);
+            }
+        }
+
+        // Boost vertices with few triangles left so they are finished off quickly.
+        score += ValenceBoostScale * powf((float)remainingValence, -ValenceBoostPower);
+        return score;
+    }
+
+    // Vertex to triangle adjacency in compressed rows.
+    struct TriangleAdjacency
+    {
+        std::vector<uint32> Offsets;
+        std::vector<uint32> Counts;
+        std::vector<uint32> Triangles;
+
+        void Build(const std::vector<uint32>& indices, size_t vertexCount)
+        {
+            Offsets.assign(vertexCount + 1, 0);
+            Counts.assign(vertexCount, 0);
+            Triangles.resize(indices.size());
+
+            for(uint32 index : indices)
+            {
+                ++Counts[index];
+            }
+            for(size_t v = 0; v < vertexCount; ++v)
+            {
+                Offsets[v + 1] = Offsets[v] + Counts[v];
+                Counts[v] = 0;
+            }
+            for(size_t i = 0; i < indices.size(); ++i)
+            {
+                uint32 v = indices[i];
+                Triangles[Offsets[v] + Counts[v]++] = (uint32)(i / 3);
+            }
+        }
+
+        void Remove(uint32 vertex, uint32 triangle)
+        {
+            uint32* begin = &Triangles[Offsets[vertex]];
+            uint32* end = begin + Counts[vertex];
+            uint32* it = std::find(begin, end, triangle);
+            if(it != end)
+            {
+                *it = end[-1];
+                --Counts[vertex];
+            }
+        }
+    };
+
+    uint32 CountCacheMisses(const uint32* indices, size_t indexCount, size_t vertexCount, uint32 cacheSize)
+    {
+        // FIFO cache: a vertex is resident while fewer than cacheSize misses happened since it was loaded.
+        std::vector<uint32> timestamps(vertexCount, 0);
+        uint32 time = cacheSize + 1;
+        uint32 misses = 0;
+        for(size_t i = 0; i < indexCount; ++i)
+        {
+            uint32 v = indices[i];
+            if(time - timestamps[v] > cacheSize)
+            {
+                timestamps[v] = time++;
+                ++misses;
+            }
+        }
+        return misses;
+    }
+}
+
+MeshOptimizer::VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const MeshBuilder::MeshData &meshData, uint32 cacheSize)
+{
+    VertexCacheStats stats;
+    stats.TriangleCount = (uint32)(meshData.Indices32.size() / 3);
+
+    std::vector<bool> referenced(meshData.Vertices.size(), false);
+    for(uint32 index : meshData.Indices32)
+    {
+        if(!referenced[index])
+        {
+            referenced[index] = true;
+            ++stats.VertexCount;
+        }
+    }
+
+    stats.TransformCount = CountCacheMisses(meshData.Indices32.data(), meshData.Indices32.size(), meshData.Vertices.size(), cacheSize);
+    return stats;
+}
+
+void MeshOptimizer::OptimizeVertexCache(MeshBuilder::MeshData &meshData)
+{
+    OptimizeVertexCache(meshData.Indices32, meshData.Vertices.size());
+    for(std::vector<uint32>& lod : meshData.LodIndices32)
+    {
+        OptimizeVertexCache(lod, meshData.Vertices.size());
+    }
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32> &indices, size_t vertexCount)
+{
+    const uint32 triangleCount = (uint32)(indices.size() / 3);
+    if(triangleCount == 0)
+    {
+        return;
+    }
+
+    TriangleAdjacency adjacency;
+    adjacency.Build(indices, vertexCount);
+
+    std::vector<float> vertexScores(vertexCount);
+    for(size_t v = 0; v < vertexCount; ++v)
+    {
+        vertexScores[v] = ForsythScore(-1, adjacency.Counts[v]);
+    }
+
+    std::vector<bool> emitted(triangleCount, false);
+    uint32 bestTriangle = 0;
+    float bestScore = -1.0f;
+    for(uint32 t = 0; t < triangleCount; ++t)
+    {
+        float score = vertexScores[indices[t * 3 + 0]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+        if(score > bestScore)
+        {
+            bestScore = score;
+            bestTriangle = t;
+        }
+    }
+
+    std::vector<uint32> cache;
+    std::vector<uint32> newCache;
+    cache.reserve(ForsythCacheSize + 3);
+    newCache.reserve(ForsythCacheSize + 3);
+
+    std::vector<uint32> output;
+    output.reserve(indices.size());
+    uint32 inputCursor = 0;
+
+    for(uint32 emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+    {
+        if(bestTriangle == InvalidIndex)
+        {
+            // Dead end: nothing in the cache has triangles left, restart from input order.
+            while(emitted[inputCursor])
+            {
+                ++inputCursor;
+            }
+            bestTriangle = inputCursor;
+        }
+
+        const uint32* tri = &indices[bestTriangle * 3];
+        output.insert(output.end(), tri, tri + 3);
+        emitted[bestTriangle] = true;
+
+        newCache.assign(tri, tri + 3);
+        for(uint32 v : cache)
+        {
+            if(v != tri[0] && v != tri[1] && v != tri[2])
+            {
+                newCache.push_back(v);
+            }
+        }
+        for(int k = 0; k < 3; ++k)
+        {
+            adjacency.Remove(tri[k], bestTriangle);
+        }
+
+        // Everything pushed past the cache end is evicted.
+        for(size_t k = ForsythCacheSize; k < newCache.size(); ++k)
+        {
+            uint32 v = newCache[k];
+            vertexScores[v] = ForsythScore(-1, adjacency.Counts[v]);
+        }
+        if(newCache.size() > (size_t)ForsythCacheSize)
+        {
+            newCache.resize(ForsythCacheSize);
+        }
+
+        for(size_t k = 0; k < newCache.size(); ++k)
+        {
+            uint32 v = newCache[k];
+            vertexScores[v] = ForsythScore((int)k, adjacency.Counts[v]);
+        }
+        cache.swap(newCache);
+
+        // Only triangles touching the cache can have changed score.
+        bestTriangle = InvalidIndex;
+        bestScore = -1.0f;
+        for(uint32 v : cache)
+        {
+            const uint32* vertexTriangles = &adjacency.Triangles[adjacency.Offsets[v]];
+            for(uint32 k = 0; k < adjacency.Counts[v]; ++k)
+            {
+                uint32 t = vertexTriangles[k];
+                float score = vertexScores[indices[t * 3 + 0]] + vertexScores[indices[t * 3 + 1]] + vertexScores[indices[t * 3 + 2]];
+                if(score > bestScore)
+                {
+                    bestScore = score;
+                    bestTriangle = t;
+                }
+            }
+        }
+    }
+
+    indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(MeshBuilder::MeshData &meshData, float threshold)
+{
+    OptimizeOverdraw(meshData.Indices32, meshData.Vertices, threshold);
+    for(std::vector<uint32>& lod : meshData.LodIndices32)
+    {
+        OptimizeOverdraw(lod, meshData.Vertices, threshold);
+    }
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32> &indices, const std::vector<MeshBuilder::Vertex> &vertices, float threshold)
+{
+    const uint32 triangleCount = (uint32)(indices.size() / 3);
+    const uint32 cacheSize = 16;
+    if(triangleCount < 2)
+    {
+        return;
+    }
+
+    // Split at hard boundaries: triangles whose three vertices all miss the cache.
+    // Reordering whole clusters then costs at most a few extra transforms each.
+    std::vector<uint32> clusterStarts;
+    {
+        std::vector<uint32> timestamps(vertices.size(), 0);
+        uint32 time = cacheSize + 1;
+        for(uint32 t = 0; t < triangleCount; ++t)
+        {
+            uint32 misses = 0;
+            for(int k = 0; k < 3; ++k)
+            {
+                uint32 v = indices[t * 3 + k];
+                if(time - timestamps[v] > cacheSize)
+                {
+                    timestamps[v] = time++;
+                    ++misses;
+                }
+            }
+            if(t == 0 || misses == 3)
+            {
+                clusterStarts.push_back(t);
+            }
+        }
+    }
+    clusterStarts.push_back(triangleCount);
+
+    const size_t clusterCount = clusterStarts.size() - 1;
+    if(clusterCount < 2)
+    {
+        return;
+    }
+
+    // Area weighted mesh centroid.
+    XMVECTOR meshCentroid = XMVectorZero();
+    float meshArea = 0.0f;
+    std::vector<XMFLOAT3> clusterCentroids(clusterCount);
+    std::vector<XMFLOAT3> clusterNormals(clusterCount);
+    for(size_t c = 0; c < clusterCount; ++c)
+    {
+        XMVECTOR centroid = XMVectorZero();
+        XMVECTOR normal = XMVectorZero();
+        float area = 0.0f;
+        for(uint32 t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t)
+        {
+            XMVECTOR p0 = XMLoadFloat3(&vertices[indices[t * 3 + 0]].Position);
+            XMVECTOR p1 = XMLoadFloat3(&vertices[indices[t * 3 + 1]].Position);
+            XMVECTOR p2 = XMLoadFloat3(&vertices[indices[t * 3 + 2]].Position);
+
+            XMVECTOR n = XMVector3Cross(p1 - p0, p2 - p0);
+            float triArea = XMVectorGetX(XMVector3Length(n));
+
+            centroid += (p0 + p1 + p2) * (triArea / 3.0f);
+            normal += n;
+            area += triArea;
+        }
+
+        meshCentroid += centroid;
+        meshArea += area;
+        XMStoreFloat3(&clusterCentroids[c], area > 0.0f ? centroid / area : centroid);
+        XMStoreFloat3(&clusterNormals[c], XMVector3Normalize(normal));
+    }
+    if(meshArea > 0.0f)
+    {
+        meshCentroid /= meshArea;
+    }
+
+    // Clusters that face away from the mesh centre are likely to be in front,
+    // so draw them first.
+    std::vector<float> sortKeys(clusterCount);
+    std::vector<uint32> order(clusterCount);
+    for(size_t c = 0; c < clusterCount; ++c)
+    {
+        XMVECTOR offset = XMLoadFloat3(&clusterCentroids[c]) - meshCentroid;
+        sortKeys[c] = XMVectorGetX(XMVector3Dot(offset, XMLoadFloat3(&clusterNormals[c])));
+        order[c] = (uint32)c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32 a, uint32 b)
+    {
+        return sortKeys[a] > sortKeys[b];
+    });
+
+    std::vector<uint32> reordered;
+    reordered.reserve(indices.size());
+    for(uint32 c : order)
+    {
+        reordered.insert(reordered.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+    }
+
+    uint32 before = CountCacheMisses(indices.data(), indices.size(), vertices.size(), cacheSize);
+    uint32 after = CountCacheMisses(reordered.data(), reordered.size(), vertices.size(), cacheSize);
+    if(after <= before * threshold)
+    {
+        indices.swap(reordered);
+    }
+}
+
+void MeshOptimizer::OptimizeVertexFetch(MeshBuilder::MeshData &meshData)
+{
+    std::vector<uint32> remap(meshData.Vertices.size(), InvalidIndex);
+    std::vector<MeshBuilder::Vertex> vertices;
+    vertices.reserve(meshData.Vertices.size());
+
+    auto renumber = [&](std::vector<uint32>& indices)
+    {
+        for(uint32& index : indices)
+        {
+            if(remap[index] == InvalidIndex)
+            {
+                remap[index] = (uint32)vertices.size();
+                vertices.push_back(meshData.Vertices[index]);
+            }
+            index = remap[index];
+        }
+    };
+
+    // Coarser levels mostly reuse LOD0's vertices; anything only they need goes last.
+    renumber(meshData.Indices32);
+    for(std::vector<uint32>& lod : meshData.LodIndices32)
+    {
+        renumber(lod);
+    }
+
+    meshData.Vertices.swap(vertices);
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "MeshBuilder.h"
+
+// Triangle and vertex reordering passes for MeshBuilder output. None of them
+// change the rendered surface, only the order the GPU sees it in.
+class MeshOptimizer
+{
+public:
+    using uint32 = std::uint32_t;
+
+    struct VertexCacheStats
+    {
+        uint32 TriangleCount = 0;
+        uint32 VertexCount = 0;
+        uint32 TransformCount = 0;
+
+        // Average cache miss ratio: transformed vertices per triangle (0.5 is ideal, 3 is worst).
+        float GetACMR()const { return TriangleCount > 0 ? (float)TransformCount / TriangleCount : 0.0f; }
+        // Average transform to vertex ratio: how often each vertex is transformed (1 is ideal).
+        float GetATVR()const { return VertexCount > 0 ? (float)TransformCount / VertexCount : 0.0f; }
+    };
+
+    // Simulates a FIFO post-transform cache of the given size over the index list.
+    static VertexCacheStats AnalyzeVertexCache(const MeshBuilder::MeshData& meshData, uint32 cacheSize = 16);
+
+    // Tom Forsyth's linear-speed vertex cache optimisation, applied to every level of detail.
+    static void OptimizeVertexCache(MeshBuilder::MeshData& meshData);
+    static void OptimizeVertexCache(std::vector<uint32>& indices, size_t vertexCount);
+
+    // Reorders the clusters produced by OptimizeVertexCache so that outward facing
+    // ones come first, which lets early depth rejection discard more of the mesh.
+    // The new order is only kept if its ACMR stays within threshold times the old one.
+    static void OptimizeOverdraw(MeshBuilder::MeshData& meshData, float threshold = 1.05f);
+    static void OptimizeOverdraw(std::vector<uint32>& indices, const std::vector<MeshBuilder::Vertex>& vertices, float threshold = 1.05f);
+
+    // Renumbers vertices in first-use order, LOD0 first, so vertex fetch walks memory
+    // linearly. Vertices no level of detail references are dropped.
+    static void OptimizeVertexFetch(MeshBuilder::MeshData& meshData);
+};
@@ -0,0 +1,585 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace
+{
+    using uint32 = std::uint32_t;
+    using uint64 = std::uint64_t;
+
+    const uint32 InvalidIndex = 0xffffffff;
+
+    // Normal xyz and texture coordinate uv.
+    const int AttributeCount = 5;
+    const float AttributeWeight = 0.5f;
+    const float BorderWeight = 10.0f;
+    // Collapses that turn any remaining triangle by more than ~78 degrees are rejected.
+    const float MinNormalDot = 0.2f;
+
+    // error(p) = p^T A p + 2 b.p + c, accumulated with weight w.
+    struct Quadric
+    {
+        float A00 = 0.0f, A11 = 0.0f, A22 = 0.0f;
+        float A01 = 0.0f, A02 = 0.0f, A12 = 0.0f;
+        float B0 = 0.0f, B1 = 0.0f, B2 = 0.0f;
+        float C = 0.0f;
+        float W = 0.0f;
+
+        // Adds weight * (n.p + d)^2.
+        void AddPlane(float nx, float ny, float nz, float d, float weight)
+        {
+            A00 += weight * nx * nx;
+            A11 += weight * ny * ny;
+            A22 += weight * nz * nz;
+            A01 += weight * nx * ny;
+            A02 += weight * nx * nz;
+            A12 += weight * ny * nz;
+            B0 += weight * nx * d;
+            B1 += weight * ny * d;
+            B2 += weight * nz * d;
+            C += weight * d * d;
+            W += weight;
+        }
+
+        void Add(const Quadric& q)
+        {
+            A00 += q.A00; A11 += q.A11; A22 += q.A22;
+            A01 += q.A01; A02 += q.A02; A12 += q.A12;
+            B0 += q.B0; B1 += q.B1; B2 += q.B2;
+            C += q.C;
+            W += q.W;
+        }
+
+        float Evaluate(const XMFLOAT3& p)const
+        {
+            float rx = A00 * p.x + A01 * p.y + A02 * p.z;
+            float ry = A01 * p.x + A11 * p.y + A12 * p.z;
+            float rz = A02 * p.x + A12 * p.y + A22 * p.z;
+            return p.x * rx + p.y * ry + p.z * rz + 2.0f * (B0 * p.x + B1 * p.y + B2 * p.z) + C;
+        }
+    };
+
+    // One attribute modelled per triangle as the linear function g.p + d. The
+    // error of giving a vertex at p the value a is sum w (g.p + d - a)^2, which
+    // expands to a plane quadric in p plus the terms below.
+    struct AttributeQuadric
+    {
+        Quadric Plane;
+        float E0 = 0.0f, E1 = 0.0f, E2 = 0.0f;
+        float F = 0.0f;
+
+        void AddGradient(float gx, float gy, float gz, float d, float weight)
+        {
+            Plane.AddPlane(gx, gy, gz, d, weight);
+            E0 += weight * gx;
+            E1 += weight * gy;
+            E2 += weight * gz;
+            F += weight * d;
+        }
+
+        void Add(const AttributeQuadric& q)
+        {
+            Plane.Add(q.Plane);
+            E0 += q.E0; E1 += q.E1; E2 += q.E2;
+            F += q.F;
+        }
+
+        float Evaluate(const XMFLOAT3& p, float a)const
+        {
+            return Plane.Evaluate(p) - 2.0f * a * (E0 * p.x + E1 * p.y + E2 * p.z + F) + a * a * Plane.W;
+        }
+    };
+
+    struct VertexQuadric
+    {
+        Quadric Position;
+        AttributeQuadric Attributes[AttributeCount];
+
+        void Add(const VertexQuadric& q)
+        {
+            Position.Add(q.Position);
+            for(int k = 0; k < AttributeCount; ++k)
+            {
+                Attributes[k].Add(q.Attributes[k]);
+            }
+        }
+    };
+
+    struct Collapse
+    {
+        uint32 From;
+        uint32 To;
+        float Cost;
+    };
+
+    inline uint64 EdgeKey(uint32 a, uint32 b)
+    {
+        return a < b ? ((uint64)a << 32) | b : ((uint64)b << 32) | a;
+    }
+
+    inline XMVECTOR TriangleNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2)
+    {
+        XMVECTOR v0 = XMLoadFloat3(&p0);
+        return XMVector3Cross(XMLoadFloat3(&p1) - v0, XMLoadFloat3(&p2) - v0);
+    }
+
+    struct PositionHash
+    {
+        size_t operator()(const XMFLOAT3& p)const
+        {
+            uint32 bits[3];
+            memcpy(bits, &p, sizeof(bits));
+            return (size_t)((bits[0] * 73856093u) ^ (bits[1] * 19349663u) ^ (bits[2] * 83492791u));
+        }
+    };
+
+    struct PositionEqual
+    {
+        bool operator()(const XMFLOAT3& a, const XMFLOAT3& b)const
+        {
+            return a.x == b.x && a.y == b.y && a.z == b.z;
+        }
+    };
+
+    // Vertex to triangle adjacency in compressed rows, rebuilt every pass.
+    struct TriangleAdjacency
+    {
+        std::vector<uint32> Offsets;
+        std::vector<uint32> Triangles;
+
+        void Build(const std::vector<uint32>& indices, size_t vertexCount)
+        {
+            Offsets.assign(vertexCount + 1, 0);
+            Triangles.resize(indices.size());
+            for(uint32 index : indices)
+            {
+                ++Offsets[index + 1];
+            }
+            for(size_t v = 0; v < vertexCount; ++v)
+            {
+                Offsets[v + 1] += Offsets[v];
+            }
+            std::vector<uint32> cursor(Offsets.begin(), Offsets.end() - 1);
+            for(size_t i = 0; i < indices.size(); ++i)
+            {
+                Triangles[cursor[indices[i]]++] = (uint32)(i / 3);
+            }
+        }
+    };
+}
+
+std::vector<MeshSimplifier::uint32> MeshSimplifier::Simplify(
+    const std::vector<MeshBuilder::Vertex>& vertices,
+    const std::vector<uint32>& sourceIndices,
+    size_t targetIndexCount,
+    float maxError,
+    float* resultError)
+{
+    std::vector<uint32> indices = sourceIndices;
+    float reachedError = 0.0f;
+    if(resultError)
+    {
+        *resultError = 0.0f;
+    }
+    if(indices.size() <= targetIndexCount || vertices.empty())
+    {
+        return indices;
+    }
+
+    const size_t vertexCount = vertices.size();
+
+    // Work in a unit cube so errors and weights do not depend on the mesh scale.
+    XMFLOAT3 minimum = vertices[0].Position;
+    XMFLOAT3 maximum = vertices[0].Position;
+    for(const MeshBuilder::Vertex& v : vertices)
+    {
+        minimum.x = (std::min)(minimum.x, v.Position.x);
+        minimum.y = (std::min)(minimum.y, v.Position.y);
+        minimum.z = (std::min)(minimum.z, v.Position.z);
+        maximum.x = (std::max)(maximum.x, v.Position.x);
+        maximum.y = (std::max)(maximum.y, v.Position.y);
+        maximum.z = (std::max)(maximum.z, v.Position.z);
+    }
+    float extent = (std::max)((std::max)(maximum.x - minimum.x, maximum.y - minimum.y), maximum.z - minimum.z);
+    float scale = extent > 0.0f ? 1.0f / extent : 1.0f;
+
+    std::vector<XMFLOAT3> positions(vertexCount);
+    std::vector<float> attributes(vertexCount * AttributeCount);
+    for(size_t i = 0; i < vertexCount; ++i)
+    {
+        const MeshBuilder::Vertex& v = vertices[i];
+        positions[i] = XMFLOAT3((v.Position.x - minimum.x) * scale, (v.Position.y - minimum.y) * scale, (v.Position.z - minimum.z) * scale);
+        float* a = &attributes[i * AttributeCount];
+        a[0] = v.Normal.x;
+        a[1] = v.Normal.y;
+        a[2] = v.Normal.z;
+        a[3] = v.TexC.x;
+        a[4] = v.TexC.y;
+    }
+
+    // Exact duplicates (as left behind by MeshBuilder::Subdivide) are folded onto
+    // one vertex first. Vertices that still share a position with another one sit
+    // on an attribute seam; moving only one side would open a crack, so they are locked.
+    std::vector<bool> locked(vertexCount, false);
+    {
+        std::vector<uint32> canonical(vertexCount);
+        std::unordered_map<XMFLOAT3, uint32, PositionHash, PositionEqual> firstAtPosition;
+        firstAtPosition.reserve(vertexCount);
+        std::vector<uint32> nextAtPosition(vertexCount, InvalidIndex);
+        for(uint32 i = 0; i < (uint32)vertexCount; ++i)
+        {
+            canonical[i] = i;
+            auto inserted = firstAtPosition.emplace(vertices[i].Position, i);
+            if(inserted.second)
+            {
+                continue;
+            }
+
+            // Walk the vertices already seen at this position.
+            bool seam = false;
+            uint32 last = inserted.first->second;
+            for(uint32 j = last; j != InvalidIndex; j = nextAtPosition[j])
+            {
+                last = j;
+                if(canonical[j] != j)
+                {
+                    continue;
+                }
+                if(memcmp(&attributes[i * AttributeCount], &attributes[j * AttributeCount], AttributeCount * sizeof(float)) == 0)
+                {
+                    canonical[i] = j;
+                }
+                else
+                {
+                    seam = true;
+                }
+            }
+            nextAtPosition[last] = i;
+
+            if(seam)
+            {
+                for(uint32 j = inserted.first->second; j != InvalidIndex; j = nextAtPosition[j])
+                {
+                    locked[j] = true;
+                }
+            }
+        }
+
+        for(uint32& index : indices)
+        {
+            index = canonical[index];
+        }
+    }
+
+    std::unordered_map<uint64, uint32> edgeCounts;
+    auto countEdges = [&indices, &edgeCounts]()
+    {
+        edgeCounts.clear();
+        for(size_t i = 0; i < indices.size(); i += 3)
+        {
+            for(int k = 0; k < 3; ++k)
+            {
+                ++edgeCounts[EdgeKey(indices[i + k], indices[i + (k + 1) % 3])];
+            }
+        }
+    };
+    countEdges();
+
+    std::vector<VertexQuadric> quadrics(vertexCount);
+    for(size_t i = 0; i < indices.size(); i += 3)
+    {
+        const uint32 tri[3] = { indices[i], indices[i + 1], indices[i + 2] };
+        const XMFLOAT3& p0 = positions[tri[0]];
+        const XMFLOAT3& p1 = positions[tri[1]];
+        const XMFLOAT3& p2 = positions[tri[2]];
+
+        XMVECTOR n = TriangleNormal(p0, p1, p2);
+        float length = XMVectorGetX(XMVector3Length(n));
+        if(length <= 0.0f)
+        {
+            continue;
+        }
+        float area = 0.5f * length;
+        XMFLOAT3 normal;
+        XMStoreFloat3(&normal, n / length);
+        float d = -(normal.x * p0.x + normal.y * p0.y + normal.z * p0.z);
+
+        for(int k = 0; k < 3; ++k)
+        {
+            quadrics[tri[k]].Position.AddPlane(normal.x, normal.y, normal.z, d, area);
+        }
+
+        // Open edges get a plane perpendicular to the triangle so the outline does not shrink.
+        for(int k = 0; k < 3; ++k)
+        {
+            uint32 a = tri[k];
+            uint32 b = tri[(k + 1) % 3];
+            if(edgeCounts[EdgeKey(a, b)] != 1)
+            {
+                continue;
+            }
+            XMVECTOR pa = XMLoadFloat3(&positions[a]);
+            XMVECTOR edge = XMLoadFloat3(&positions[b]) - pa;
+            float edgeLengthSq = XMVectorGetX(XMVector3Dot(edge, edge));
+            XMFLOAT3 m;
+            XMStoreFloat3(&m, XMVector3Normalize(XMVector3Cross(edge, XMLoadFloat3(&normal))));
+            float md = -XMVectorGetX(XMVector3Dot(XMLoadFloat3(&m), pa));
+            quadrics[a].Position.AddPlane(m.x, m.y, m.z, md, edgeLengthSq * BorderWeight);
+            quadrics[b].Position.AddPlane(m.x, m.y, m.z, md, edgeLengthSq * BorderWeight);
+        }
+
+        // Gradient of each attribute over the triangle: g.e1 = a1 - a0, g.e2 = a2 - a0, g in the triangle plane.
+        XMVECTOR e1 = XMLoadFloat3(&p1) - XMLoadFloat3(&p0);
+        XMVECTOR e2 = XMLoadFloat3(&p2) - XMLoadFloat3(&p0);
+        float e11 = XMVectorGetX(XMVector3Dot(e1, e1));
+        float e12 = XMVectorGetX(XMVector3Dot(e1, e2));
+        float e22 = XMVectorGetX(XMVector3Dot(e2, e2));
+        float det = e11 * e22 - e12 * e12;
+        if(det <= 1e-12f)
+        {
+            continue;
+        }
+        for(int c = 0; c < AttributeCount; ++c)
+        {
+            float a0 = attributes[tri[0] * AttributeCount + c];
+            float da1 = attributes[tri[1] * AttributeCount + c] - a0;
+            float da2 = attributes[tri[2] * AttributeCount + c] - a0;
+            float x = (da1 * e22 - da2 * e12) / det;
+            float y = (da2 * e11 - da1 * e12) / det;
+            XMFLOAT3 g;
+            XMStoreFloat3(&g, e1 * x + e2 * y);
+            float gd = a0 - (g.x * p0.x + g.y * p0.y + g.z * p0.z);
+            for(int k = 0; k < 3; ++k)
+            {
+                quadrics[tri[k]].Attributes[c].AddGradient(g.x, g.y, g.z, gd, area);
+            }
+        }
+    }
+
+    auto collapseCost = [&](uint32 from, uint32 to)
+    {
+        VertexQuadric q = quadrics[from];
+        q.Add(quadrics[to]);
+        const XMFLOAT3& p = positions[to];
+        const float* a = &attributes[to * AttributeCount];
+        float error = q.Position.Evaluate(p);
+        for(int c = 0; c < AttributeCount; ++c)
+        {
+            error += AttributeWeight * q.Attributes[c].Evaluate(p, a[c]);
+        }
+        return q.Position.W > 0.0f ? (std::max)(error / q.Position.W, 0.0f) : 0.0f;
+    };
+
+    const float maxErrorSq = maxError * maxError;
+    TriangleAdjacency adjacency;
+    std::vector<bool> border(vertexCount);
+    std::vector<bool> pinned(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    std::vector<uint32> marks(vertexCount, 0);
+    uint32 markStamp = 0;
+    std::vector<uint32> remap(vertexCount);
+    std::vector<Collapse> collapses;
+
+    bool errorLimitReached = false;
+    while(indices.size() > targetIndexCount && !errorLimitReached)
+    {
+        std::fill(border.begin(), border.end(), false);
+        std::copy(locked.begin(), locked.end(), pinned.begin());
+        for(const auto& edge : edgeCounts)
+        {
+            uint32 a = (uint32)(edge.first >> 32);
+            uint32 b = (uint32)(edge.first & 0xffffffff);
+            if(edge.second == 1)
+            {
+                border[a] = border[b] = true;
+            }
+            else if(edge.second > 2)
+            {
+                pinned[a] = pinned[b] = true;
+            }
+        }
+
+        collapses.clear();
+        for(const auto& edge : edgeCounts)
+        {
+            uint32 a = (uint32)(edge.first >> 32);
+            uint32 b = (uint32)(edge.first & 0xffffffff);
+            bool borderEdge = edge.second == 1;
+
+            // A border vertex may only slide along the border, anything pinned stays put.
+            bool canMoveA = !pinned[a] && (!border[a] || borderEdge);
+            bool canMoveB = !pinned[b] && (!border[b] || borderEdge);
+            float costAB = canMoveA ? collapseCost(a, b) : FLT_MAX;
+            float costBA = canMoveB ? collapseCost(b, a) : FLT_MAX;
+            if(costAB == FLT_MAX && costBA == FLT_MAX)
+            {
+                continue;
+            }
+            collapses.push_back(costAB <= costBA ? Collapse{ a, b, costAB } : Collapse{ b, a, costBA });
+        }
+        std::sort(collapses.begin(), collapses.end(), [](const Collapse& l, const Collapse& r)
+        {
+            return l.Cost < r.Cost;
+        });
+
+        adjacency.Build(indices, vertexCount);
+        std::fill(touched.begin(), touched.end(), false);
+        for(uint32 v = 0; v < (uint32)vertexCount; ++v)
+        {
+            remap[v] = v;
+        }
+
+        size_t triangleCount = indices.size() / 3;
+        const size_t targetTriangleCount = targetIndexCount / 3;
+        size_t collapsedCount = 0;
+        for(const Collapse& collapse : collapses)
+        {
+            if(triangleCount <= targetTriangleCount)
+            {
+                break;
+            }
+            if(collapse.Cost > maxErrorSq)
+            {
+                errorLimitReached = true;
+                break;
+            }
+
+            uint32 u = collapse.From;
+            uint32 v = collapse.To;
+            if(touched[u] || touched[v])
+            {
+                continue;
+            }
+
+            // Link condition: the edge's endpoints may only share the vertices
+            // opposite the edge, otherwise the collapse pinches the surface.
+            uint32 edgeUses = edgeCounts[EdgeKey(u, v)];
+            ++markStamp;
+            for(uint32 k = adjacency.Offsets[u]; k < adjacency.Offsets[u + 1]; ++k)
+            {
+                const uint32* tri = &indices[adjacency.Triangles[k] * 3];
+                for(int c = 0; c < 3; ++c)
+                {
+                    marks[tri[c]] = markStamp;
+                }
+            }
+            ++markStamp;
+            uint32 sharedNeighbours = 0;
+            for(uint32 k = adjacency.Offsets[v]; k < adjacency.Offsets[v + 1]; ++k)
+            {
+                const uint32* tri = &indices[adjacency.Triangles[k] * 3];
+                for(int c = 0; c < 3; ++c)
+                {
+                    uint32 w = tri[c];
+                    if(w != u && w != v && marks[w] == markStamp - 1)
+                    {
+                        marks[w] = markStamp;
+                        ++sharedNeighbours;
+                    }
+                }
+            }
+            if(sharedNeighbours != edgeUses)
+            {
+                continue;
+            }
+
+            // Reject collapses that fold a surviving triangle over.
+            bool flips = false;
+            for(uint32 k = adjacency.Offsets[u]; k < adjacency.Offsets[u + 1] && !flips; ++k)
+            {
+                const uint32* tri = &indices[adjacency.Triangles[k] * 3];
+                if(tri[0] == v || tri[1] == v || tri[2] == v)
+                {
+                    continue;
+                }
+                XMFLOAT3 moved[3] = { positions[tri[0]], positions[tri[1]], positions[tri[2]] };
+                for(int c = 0; c < 3; ++c)
+                {
+                    if(tri[c] == u)
+                    {
+                        moved[c] = positions[v];
+                    }
+                }
+                XMVECTOR before = TriangleNormal(positions[tri[0]], positions[tri[1]], positions[tri[2]]);
+                XMVECTOR after = TriangleNormal(moved[0], moved[1], moved[2]);
+                float lengths = XMVectorGetX(XMVector3Length(before)) * XMVectorGetX(XMVector3Length(after));
+                flips = XMVectorGetX(XMVector3Dot(before, after)) <= MinNormalDot * lengths;
+            }
+            if(flips)
+            {
+                continue;
+            }
+
+            remap[u] = v;
+            quadrics[v].Add(quadrics[u]);
+            reachedError = (std::max)(reachedError, collapse.Cost);
+            triangleCount -= edgeUses;
+            ++collapsedCount;
+
+            // Everything around u changes shape, so none of it may collapse again this pass.
+            for(uint32 k = adjacency.Offsets[u]; k < adjacency.Offsets[u + 1]; ++k)
+            {
+                const uint32* tri = &indices[adjacency.Triangles[k] * 3];
+                for(int c = 0; c < 3; ++c)
+                {
+                    touched[tri[c]] = true;
+                }
+            }
+        }
+
+        if(collapsedCount == 0)
+        {
+            break;
+        }
+
+        size_t writeIndex = 0;
+        for(size_t i = 0; i < indices.size(); i += 3)
+        {
+            uint32 a = remap[indices[i + 0]];
+            uint32 b = remap[indices[i + 1]];
+            uint32 c = remap[indices[i + 2]];
+            if(a != b && b != c && a != c)
+            {
+                indices[writeIndex++] = a;
+                indices[writeIndex++] = b;
+                indices[writeIndex++] = c;
+            }
+        }
+        indices.resize(writeIndex);
+        countEdges();
+    }
+
+    if(resultError)
+    {
+        *resultError = sqrtf(reachedError);
+    }
+    return indices;
+}
+
+void MeshSimplifier::BuildLods(MeshBuilder::MeshData& meshData, const std::vector<float>& ratios, float maxError)
+{
+    meshData.LodIndices32.clear();
+
+    const size_t baseTriangleCount = meshData.Indices32.size() / 3;
+    std::vector<uint32> previous = meshData.Indices32;
+    for(size_t level = 0; level < ratios.size(); ++level)
+    {
+        float ratio = (std::min)((std::max)(ratios[level], 0.0f), 1.0f);
+        size_t targetIndexCount = (size_t)(baseTriangleCount * ratio) * 3;
+
+        std::vector<uint32> lod = Simplify(meshData.Vertices, previous, targetIndexCount, maxError);
+        if(level == 0)
+        {
+            meshData.Indices32 = lod;
+        }
+        else
+        {
+            meshData.LodIndices32.push_back(lod);
+        }
+        previous.swap(lod);
+    }
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include "MeshBuilder.h"
+
+// Quadric error edge-collapse simplification for MeshBuilder output.
+//
+// Every collapse moves one vertex onto a neighbour, so the simplified index
+// lists reference a subset of the original vertices and the vertex buffer can be
+// shared by all levels of detail. The error metric combines the position quadric
+// with quadrics over the normal and texture coordinates. Vertices on attribute
+// seams (several vertices at one position) and non-manifold edges never move, and
+// open borders only collapse along themselves, so the outline stays intact.
+class MeshSimplifier
+{
+public:
+    using uint32 = std::uint32_t;
+
+    // Simplifies the triangle list until it has at most targetIndexCount indices
+    // or the next collapse would exceed maxError. maxError is relative to the
+    // mesh extent. Returns the new index list; resultError receives the error reached.
+    static std::vector<uint32> Simplify(
+        const std::vector<MeshBuilder::Vertex>& vertices,
+        const std::vector<uint32>& indices,
+        size_t targetIndexCount,
+        float maxError,
+        float* resultError = nullptr);
+
+    // Fills meshData.LodIndices32 from a list of triangle ratios relative to the
+    // full mesh, for example { 1.0, 0.5, 0.25 }. The first entry describes LOD0:
+    // if it is below 1 the base index list is simplified as well. Each level is
+    // simplified from the previous one, so the chain is monotonic.
+    static void BuildLods(MeshBuilder::MeshData& meshData, const std::vector<float>& ratios, float maxError);
+};
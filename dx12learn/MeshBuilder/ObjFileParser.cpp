@@ -0,0 +1,373 @@
+#include "ObjFileParser.h"
+#include "../MappedFile.h"
+
+#include <climits>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    inline bool IsDigit(char c)
+    {
+        return static_cast<unsigned char>(c - '0') < 10;
+    }
+
+    inline bool IsBlank(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    inline const char* SkipBlanks(const char* p, const char* end)
+    {
+        while(p < end && IsBlank(*p))
+        {
+            ++p;
+        }
+        return p;
+    }
+
+    inline const char* FindLineEnd(const char* p, const char* end)
+    {
+        const char* nl = static_cast<const char*>(memchr(p, '\n', end - p));
+        return nl != nullptr ? nl : end;
+    }
+
+    const double PowersOf10[] =
+    {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    // Locale independent decimal scanner. Accumulates up to 19 significant digits in
+    // an integer and applies the exponent once, which is exact enough for mesh data.
+    // Returns nullptr if no number starts at p.
+    const char* ParseFloat(const char* p, const char* end, float& out)
+    {
+        bool negative = false;
+        if(p < end && (*p == '-' || *p == '+'))
+        {
+            negative = *p == '-';
+            ++p;
+        }
+
+        std::uint64_t mantissa = 0;
+        int significant = 0;
+        int exponent = 0;
+        bool anyDigit = false;
+
+        for(; p < end && IsDigit(*p); ++p)
+        {
+            anyDigit = true;
+            if(significant < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                significant += mantissa != 0;
+            }
+            else
+            {
+                ++exponent;
+            }
+        }
+
+        if(p < end && *p == '.')
+        {
+            for(++p; p < end && IsDigit(*p); ++p)
+            {
+                anyDigit = true;
+                if(significant < 19)
+                {
+                    mantissa = mantissa * 10 + (*p - '0');
+                    significant += mantissa != 0;
+                    --exponent;
+                }
+            }
+        }
+
+        if(!anyDigit)
+        {
+            return nullptr;
+        }
+
+        if(p < end && (*p == 'e' || *p == 'E'))
+        {
+            const char* q = p + 1;
+            bool negativeExp = false;
+            if(q < end && (*q == '-' || *q == '+'))
+            {
+                negativeExp = *q == '-';
+                ++q;
+            }
+            if(q < end && IsDigit(*q))
+            {
+                int e = 0;
+                for(; q < end && IsDigit(*q); ++q)
+                {
+                    if(e < 10000)
+                    {
+                        e = e * 10 + (*q - '0');
+                    }
+                }
+                exponent += negativeExp ? -e : e;
+                p = q;
+            }
+        }
+
+        double value = static_cast<double>(mantissa);
+        if(exponent != 0 && mantissa != 0)
+        {
+            int absExp = exponent < 0 ? -exponent : exponent;
+            double scale = absExp <= 22 ? PowersOf10[absExp] : std::pow(10.0, absExp);
+            value = exponent < 0 ? value / scale : value * scale;
+        }
+
+        out = static_cast<float>(negative ? -value : value);
+        return p;
+    }
+
+    const char* ParseInt(const char* p, const char* end, int& out)
+    {
+        bool negative = false;
+        if(p < end && (*p == '-' || *p == '+'))
+        {
+            negative = *p == '-';
+            ++p;
+        }
+        if(p >= end || !IsDigit(*p))
+        {
+            return nullptr;
+        }
+
+        // Saturates at INT_MAX instead of overflowing, ResolveIndex then rejects the index.
+        int value = 0;
+        for(; p < end && IsDigit(*p); ++p)
+        {
+            int digit = *p - '0';
+            value = value <= (INT_MAX - digit) / 10 ? value * 10 + digit : INT_MAX;
+        }
+        out = negative ? -value : value;
+        return p;
+    }
+
+    // OBJ indices are 1-based, negative values are relative to the end of the list.
+    inline int ResolveIndex(int index, size_t count)
+    {
+        int resolved = index < 0 ? (int)count + index : index - 1;
+        return (resolved >= 0 && resolved < (int)count) ? resolved : -1;
+    }
+
+    const char* ParseComponents(const char* p, const char* end, float* out, int count)
+    {
+        for(int i = 0; i < count; ++i)
+        {
+            p = SkipBlanks(p, end);
+            const char* next = ParseFloat(p, end, out[i]);
+            if(next == nullptr)
+            {
+                return nullptr;
+            }
+            p = next;
+        }
+        return p;
+    }
+}
+
+bool ObjFileParser::ParseFile(const std::string &filename)
+{
+    MappedFile file;
+    if(!file.Open(filename))
+    {
+        return false;
+    }
+
+    return Parse(file.Data(), file.Data() + file.Size());
+}
+
+bool ObjFileParser::Parse(const char *begin, const char *end)
+{
+    Positions.clear();
+    Normals.clear();
+    TexCoords.clear();
+    Corners.clear();
+    Groups.clear();
+
+    if(begin == nullptr || begin == end)
+    {
+        return true;
+    }
+
+    Reserve(begin, end);
+
+    for(const char* line = begin; line < end; )
+    {
+        const char* lineEnd = FindLineEnd(line, end);
+        const char* p = SkipBlanks(line, lineEnd);
+
+        if(lineEnd - p >= 2)
+        {
+            if(p[0] == 'v' && IsBlank(p[1]))
+            {
+                XMFLOAT3 pos(0.0f, 0.0f, 0.0f);
+                if(ParseComponents(p + 2, lineEnd, &pos.x, 3) != nullptr)
+                {
+                    Positions.push_back(pos);
+                }
+            }
+            else if(p[0] == 'v' && p[1] == 'n')
+            {
+                XMFLOAT3 normal(0.0f, 0.0f, 0.0f);
+                if(ParseComponents(p + 2, lineEnd, &normal.x, 3) != nullptr)
+                {
+                    Normals.push_back(normal);
+                }
+            }
+            else if(p[0] == 'v' && p[1] == 't')
+            {
+                XMFLOAT2 texcoord(0.0f, 0.0f);
+                if(ParseComponents(p + 2, lineEnd, &texcoord.x, 2) != nullptr)
+                {
+                    TexCoords.push_back(texcoord);
+                }
+            }
+            else if(p[0] == 'f' && IsBlank(p[1]))
+            {
+                ParseFace(p + 2, lineEnd);
+            }
+            else if((p[0] == 'g' || p[0] == 'o') && IsBlank(p[1]))
+            {
+                const char* nameBegin = SkipBlanks(p + 2, lineEnd);
+                const char* nameEnd = lineEnd;
+                while(nameEnd > nameBegin && IsBlank(nameEnd[-1]))
+                {
+                    --nameEnd;
+                }
+                BeginGroup(nameBegin, nameEnd);
+            }
+        }
+
+        line = lineEnd + 1;
+    }
+
+    if(!Groups.empty())
+    {
+        Groups.back().TriangleCount = GetTriangleCount() - Groups.back().FirstTriangle;
+    }
+
+    return true;
+}
+
+void ObjFileParser::Reserve(const char *begin, const char *end)
+{
+    // Cheap first pass over line heads so the element vectors never reallocate
+    // while parsing. Faces are assumed to be triangles; n-gons only grow Corners.
+    size_t positionCount = 0;
+    size_t normalCount = 0;
+    size_t texcoordCount = 0;
+    size_t faceCount = 0;
+
+    for(const char* line = begin; line < end; )
+    {
+        const char* lineEnd = FindLineEnd(line, end);
+        const char* p = SkipBlanks(line, lineEnd);
+        if(lineEnd - p >= 2)
+        {
+            if(p[0] == 'v')
+            {
+                positionCount += IsBlank(p[1]);
+                normalCount += p[1] == 'n';
+                texcoordCount += p[1] == 't';
+            }
+            else if(p[0] == 'f')
+            {
+                faceCount += IsBlank(p[1]);
+            }
+        }
+        line = lineEnd + 1;
+    }
+
+    Positions.reserve(positionCount);
+    Normals.reserve(normalCount);
+    TexCoords.reserve(texcoordCount);
+    Corners.reserve(faceCount * 3);
+}
+
+void ObjFileParser::BeginGroup(const char *nameBegin, const char *nameEnd)
+{
+    uint32 triangleCount = GetTriangleCount();
+    if(!Groups.empty())
+    {
+        Groups.back().TriangleCount = triangleCount - Groups.back().FirstTriangle;
+    }
+    else if(triangleCount > 0)
+    {
+        // Faces before the first group statement belong to the default group.
+        Group defaultGroup;
+        defaultGroup.Name = "default";
+        defaultGroup.TriangleCount = triangleCount;
+        Groups.push_back(defaultGroup);
+    }
+
+    Group group;
+    group.Name.assign(nameBegin, nameEnd);
+    group.FirstTriangle = triangleCount;
+    Groups.push_back(group);
+}
+
+void ObjFileParser::ParseFace(const char *p, const char *lineEnd)
+{
+    FaceScratch.clear();
+
+    for(p = SkipBlanks(p, lineEnd); p < lineEnd; p = SkipBlanks(p, lineEnd))
+    {
+        int value = 0;
+        const char* next = ParseInt(p, lineEnd, value);
+        if(next == nullptr)
+        {
+            break;
+        }
+
+        Corner corner;
+        corner.Position = ResolveIndex(value, Positions.size());
+        p = next;
+
+        if(p < lineEnd && *p == '/')
+        {
+            ++p;
+            next = ParseInt(p, lineEnd, value);
+            if(next != nullptr)
+            {
+                corner.TexCoord = ResolveIndex(value, TexCoords.size());
+                p = next;
+            }
+            if(p < lineEnd && *p == '/')
+            {
+                ++p;
+                next = ParseInt(p, lineEnd, value);
+                if(next != nullptr)
+                {
+                    corner.Normal = ResolveIndex(value, Normals.size());
+                    p = next;
+                }
+            }
+        }
+
+        // A face referencing a missing position cannot be drawn, drop it.
+        if(corner.Position < 0)
+        {
+            return;
+        }
+        FaceScratch.push_back(corner);
+    }
+
+    if(FaceScratch.size() < 3)
+    {
+        return;
+    }
+
+    // Fan triangulation, matching the winding of the source polygon.
+    for(size_t i = 1; i + 1 < FaceScratch.size(); ++i)
+    {
+        Corners.push_back(FaceScratch[0]);
+        Corners.push_back(FaceScratch[i]);
+        Corners.push_back(FaceScratch[i + 1]);
+    }
+}
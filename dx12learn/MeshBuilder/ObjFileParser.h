@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "../MathHelper.h"
+
+// Single-pass Wavefront OBJ reader working directly on a memory-mapped file.
+// Faces are fan-triangulated and every corner keeps its own v/vt/vn triple,
+// already resolved to zero-based indices (negative OBJ indices included).
+class ObjFileParser
+{
+public:
+    using uint32 = std::uint32_t;
+
+    struct Corner
+    {
+        int Position = -1;
+        int TexCoord = -1;
+        int Normal = -1;
+    };
+
+    struct Group
+    {
+        std::string Name;
+        uint32 FirstTriangle = 0;
+        uint32 TriangleCount = 0;
+    };
+
+    bool ParseFile(const std::string& filename);
+    bool Parse(const char* begin, const char* end);
+
+    uint32 GetTriangleCount()const { return (uint32)Corners.size() / 3; }
+
+    std::vector<XMFLOAT3> Positions;
+    std::vector<XMFLOAT3> Normals;
+    std::vector<XMFLOAT2> TexCoords;
+
+    // Three corners per triangle.
+    std::vector<Corner> Corners;
+    std::vector<Group> Groups;
+
+private:
+    void Reserve(const char* begin, const char* end);
+    void BeginGroup(const char* nameBegin, const char* nameEnd);
+    void ParseFace(const char* p, const char* lineEnd);
+
+    std::vector<Corner> FaceScratch;
+};
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstdint>
+#include <DirectXPackedVector.h>
+
+// Vertex layout of the scene geometry and the waves.
+struct Vertex
+{
+    DirectX::XMFLOAT3 Pos;
+    DirectX::XMFLOAT3 Normal;
+    DirectX::XMFLOAT2 TexC;
+    DirectX::XMFLOAT4 Color;
+};
+
+// 16 byte alternative to Vertex for static geometry. Positions are 16-bit unorm
+// inside the submesh bounds, normals are octahedral encoded and texture
+// coordinates are half floats. There is no color; shaders take it from the material.
+struct PackedVertex
+{
+    DirectX::PackedVector::XMUSHORTN4 Pos;
+    DirectX::PackedVector::XMSHORTN2 Normal;
+    DirectX::PackedVector::XMHALF2 TexC;
+};
+
+enum class VertexFormat : std::uint32_t
+{
+    Full = 0,
+    Packed = 1
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// Stable LSD radix sort of items by a 64-bit key, eight bits per pass.
+//
+// Passes in which every key has the same digit are skipped, so keys that only
+// use a few of their bits cost only a few passes. scratch is resized to match
+// items and can be kept between calls to avoid reallocating.
+template<typename T, typename KeyFn>
+void RadixSort64(std::vector<T>& items, std::vector<T>& scratch, KeyFn key)
+{
+    const size_t count = items.size();
+    if(count < 2)
+    {
+        return;
+    }
+    scratch.resize(count);
+
+    // Histograms of all eight digits in one sweep.
+    std::uint32_t histograms[8][256];
+    memset(histograms, 0, sizeof(histograms));
+    for(size_t i = 0; i < count; ++i)
+    {
+        std::uint64_t k = key(items[i]);
+        for(int digit = 0; digit < 8; ++digit)
+        {
+            histograms[digit][(k >> (digit * 8)) & 0xff]++;
+        }
+    }
+
+    T* source = items.data();
+    T* destination = scratch.data();
+    for(int digit = 0; digit < 8; ++digit)
+    {
+        std::uint32_t* histogram = histograms[digit];
+        const int shift = digit * 8;
+        if(histogram[(key(source[0]) >> shift) & 0xff] == count)
+        {
+            continue;
+        }
+
+        std::uint32_t offset = 0;
+        for(int bucket = 0; bucket < 256; ++bucket)
+        {
+            std::uint32_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+
+        for(size_t i = 0; i < count; ++i)
+        {
+            destination[histogram[(key(source[i]) >> shift) & 0xff]++] = source[i];
+        }
+        std::swap(source, destination);
+    }
+
+    if(source != items.data())
+    {
+        items.swap(scratch);
+    }
+}
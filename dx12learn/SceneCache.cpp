@@ -0,0 +1,270 @@
+#include "SceneCache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+namespace
+{
+    const std::uint64_t SectionAlignment = 16;
+
+    std::uint64_t AlignUp(std::uint64_t value)
+    {
+        return (value + SectionAlignment - 1) & ~(SectionAlignment - 1);
+    }
+
+    // True when count elements of elementSize bytes at offset lie within fileSize and
+    // start on a section boundary. Nothing here can wrap: offset is checked against
+    // fileSize before the subtraction, and count and elementSize both fit in 32 bits.
+    bool SectionFits(std::uint64_t offset, std::uint32_t count, std::uint64_t elementSize, std::uint64_t fileSize)
+    {
+        return offset <= fileSize && offset % SectionAlignment == 0 &&
+            count * elementSize <= fileSize - offset;
+    }
+
+    inline std::uint64_t Mix(std::uint64_t h, std::uint64_t k)
+    {
+        k *= 0x87c37b91114253d5ull;
+        k = (k << 31) | (k >> 33);
+        k *= 0x4cf5ad432745937full;
+        h ^= k;
+        h = (h << 27) | (h >> 37);
+        return h * 5 + 0x52dce729;
+    }
+
+    // Word-at-a-time hash; only used to detect changed inputs, not for security.
+    std::uint64_t HashBytes(const char* data, size_t size, std::uint64_t h)
+    {
+        size_t words = size / 8;
+        for(size_t i = 0; i < words; ++i)
+        {
+            std::uint64_t k;
+            memcpy(&k, data + i * 8, 8);
+            h = Mix(h, k);
+        }
+
+        std::uint64_t tail = 0;
+        if(size % 8 != 0)
+        {
+            memcpy(&tail, data + words * 8, size % 8);
+        }
+        h = Mix(h, tail ^ size);
+
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    bool CopyName(char* dest, size_t destSize, const std::string& name)
+    {
+        if(name.size() >= destSize)
+        {
+            return false;
+        }
+        memset(dest, 0, destSize);
+        memcpy(dest, name.data(), name.size());
+        return true;
+    }
+
+    void WritePadding(std::ofstream& fout, std::uint64_t offset)
+    {
+        static const char zeros[SectionAlignment] = {};
+        std::uint64_t position = (std::uint64_t)fout.tellp();
+        fout.write(zeros, offset - position);
+    }
+}
+
+bool SceneCache::HashSources(const std::string &scenePath, const std::vector<std::string> &sourceFiles, uint64 &hash)
+{
+    hash = HashBytes(scenePath.data(), scenePath.size(), 0x9e3779b97f4a7c15ull);
+
+    std::vector<std::string> paths;
+    paths.push_back(scenePath);
+    paths.insert(paths.end(), sourceFiles.begin(), sourceFiles.end());
+
+    for(const std::string& path : paths)
+    {
+        MappedFile file;
+        if(!file.Open(path))
+        {
+            return false;
+        }
+        hash = HashBytes(file.Data(), file.Size(), hash);
+    }
+    return true;
+}
+
+bool SceneCache::Write(
+    const std::string &cachePath,
+    const std::string &scenePath,
+    const std::vector<std::string> &sourceFiles,
+    const PackedGeometry &geometry,
+    const std::vector<const Material*> &materials)
+{
+    Header header = {};
+    header.Magic = Magic;
+    header.Version = Version;
+    if(!HashSources(scenePath, sourceFiles, header.SourceHash))
+    {
+        return false;
+    }
+
+    std::vector<SourceFileRecord> sourceRecords(sourceFiles.size());
+    for(size_t i = 0; i < sourceFiles.size(); ++i)
+    {
+        if(!CopyName(sourceRecords[i].Path, MaxPathLength, sourceFiles[i]))
+        {
+            return false;
+        }
+    }
+
+    std::vector<SubmeshRecord> submeshRecords(geometry.Submeshes.size());
+    for(size_t i = 0; i < geometry.Submeshes.size(); ++i)
+    {
+        const SubmeshGeometry& submesh = geometry.Submeshes[i];
+        SubmeshRecord& record = submeshRecords[i];
+        if(!CopyName(record.Name, MaxNameLength, geometry.SubmeshNames[i]) ||
+            !CopyName(record.MaterialName, MaxNameLength, submesh.MaterialName))
+        {
+            return false;
+        }
+        record.IndexFormat = (uint32)geometry.SubmeshIndexFormats[i];
+        record.IndexCount = submesh.IndexCount;
+        record.StartIndexLocation = submesh.StartIndexLocation;
+        record.BaseVertexLocation = submesh.BaseVertexLocation;
+        memcpy(record.BoundsCenter, &submesh.Bounds.Center, sizeof(record.BoundsCenter));
+        memcpy(record.BoundsExtents, &submesh.Bounds.Extents, sizeof(record.BoundsExtents));
+        record.LodSwitchDistance = submesh.LodSwitchDistance;
+    }
+
+    std::vector<MaterialRecord> materialRecords(materials.size());
+    for(size_t i = 0; i < materials.size(); ++i)
+    {
+        const Material* mat = materials[i];
+        MaterialRecord& record = materialRecords[i];
+        if(!CopyName(record.Name, MaxNameLength, mat->Name))
+        {
+            return false;
+        }
+        record.MatCBIndex = mat->MatCBIndex;
+        record.DiffuseSrvHeapIndex = mat->DiffuseSrvHeapIndex;
+        record.NormalSrvHeapIndex = mat->NormalSrvHeapIndex;
+        memcpy(record.DiffuseAlbedo, &mat->DiffuseAlbedo, sizeof(record.DiffuseAlbedo));
+        memcpy(record.FresnelR0, &mat->FresnelR0, sizeof(record.FresnelR0));
+        record.Roughness = mat->Roughness;
+        memcpy(record.MatTransform, &mat->MatTransform, sizeof(record.MatTransform));
+    }
+
+    header.SourceFileCount = (uint32)sourceRecords.size();
+    header.SubmeshCount = (uint32)submeshRecords.size();
+    header.MaterialCount = (uint32)materialRecords.size();
+    header.VertexFormat = (uint32)geometry.Format;
+    header.VertexStride = geometry.GetVertexStride();
+    header.VertexCount = geometry.GetVertexCount();
+    header.Index16Count = (uint32)geometry.Indices16.size();
+    header.Index32Count = (uint32)geometry.Indices32.size();
+
+    header.SourceFileOffset = AlignUp(sizeof(Header));
+    header.SubmeshOffset = AlignUp(header.SourceFileOffset + sourceRecords.size() * sizeof(SourceFileRecord));
+    header.MaterialOffset = AlignUp(header.SubmeshOffset + submeshRecords.size() * sizeof(SubmeshRecord));
+    header.VertexOffset = AlignUp(header.MaterialOffset + materialRecords.size() * sizeof(MaterialRecord));
+    header.Index16Offset = AlignUp(header.VertexOffset + (uint64)header.VertexCount * header.VertexStride);
+    header.Index32Offset = AlignUp(header.Index16Offset + (uint64)header.Index16Count * sizeof(std::uint16_t));
+    header.FileSize = header.Index32Offset + (uint64)header.Index32Count * sizeof(std::uint32_t);
+
+    // Write to a temporary name first so a crash never leaves a truncated cache behind.
+    std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream fout(tempPath, std::ios::binary | std::ios::trunc);
+        if(!fout)
+        {
+            return false;
+        }
+
+        fout.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        WritePadding(fout, header.SourceFileOffset);
+        fout.write(reinterpret_cast<const char*>(sourceRecords.data()), sourceRecords.size() * sizeof(SourceFileRecord));
+        WritePadding(fout, header.SubmeshOffset);
+        fout.write(reinterpret_cast<const char*>(submeshRecords.data()), submeshRecords.size() * sizeof(SubmeshRecord));
+        WritePadding(fout, header.MaterialOffset);
+        fout.write(reinterpret_cast<const char*>(materialRecords.data()), materialRecords.size() * sizeof(MaterialRecord));
+        WritePadding(fout, header.VertexOffset);
+        fout.write(reinterpret_cast<const char*>(geometry.GetVertexData()), (std::streamsize)header.VertexCount * header.VertexStride);
+        WritePadding(fout, header.Index16Offset);
+        fout.write(reinterpret_cast<const char*>(geometry.Indices16.data()), (std::streamsize)header.Index16Count * sizeof(std::uint16_t));
+        WritePadding(fout, header.Index32Offset);
+        fout.write(reinterpret_cast<const char*>(geometry.Indices32.data()), (std::streamsize)header.Index32Count * sizeof(std::uint32_t));
+
+        if(!fout)
+        {
+            return false;
+        }
+    }
+
+#ifdef _WIN32
+    return MoveFileExA(tempPath.c_str(), cachePath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(tempPath.c_str(), cachePath.c_str()) == 0;
+#endif
+}
+
+bool SceneCache::Open(const std::string &cachePath, const std::string &scenePath)
+{
+    Close();
+
+    if(!File.Open(cachePath) || File.Size() < sizeof(Header))
+    {
+        Close();
+        return false;
+    }
+
+    const Header* header = reinterpret_cast<const Header*>(File.Data());
+    if(header->Magic != Magic || header->Version != Version ||
+        header->VertexStride != (header->VertexFormat == (uint32)VertexFormat::Packed ? sizeof(PackedVertex) : sizeof(Vertex)) ||
+        header->FileSize != File.Size() ||
+        !SectionFits(header->SourceFileOffset, header->SourceFileCount, sizeof(SourceFileRecord), header->FileSize) ||
+        !SectionFits(header->SubmeshOffset, header->SubmeshCount, sizeof(SubmeshRecord), header->FileSize) ||
+        !SectionFits(header->MaterialOffset, header->MaterialCount, sizeof(MaterialRecord), header->FileSize) ||
+        !SectionFits(header->VertexOffset, header->VertexCount, header->VertexStride, header->FileSize) ||
+        !SectionFits(header->Index16Offset, header->Index16Count, sizeof(std::uint16_t), header->FileSize) ||
+        !SectionFits(header->Index32Offset, header->Index32Count, sizeof(std::uint32_t), header->FileSize) ||
+        header->SourceFileOffset < sizeof(Header) ||
+        header->SourceFileOffset + (uint64)header->SourceFileCount * sizeof(SourceFileRecord) > header->SubmeshOffset ||
+        header->SubmeshOffset + (uint64)header->SubmeshCount * sizeof(SubmeshRecord) > header->MaterialOffset ||
+        header->MaterialOffset + (uint64)header->MaterialCount * sizeof(MaterialRecord) > header->VertexOffset ||
+        header->VertexOffset + (uint64)header->VertexCount * header->VertexStride > header->Index16Offset ||
+        header->Index16Offset + (uint64)header->Index16Count * sizeof(std::uint16_t) > header->Index32Offset ||
+        header->Index32Offset + (uint64)header->Index32Count * sizeof(std::uint32_t) != header->FileSize)
+    {
+        Close();
+        return false;
+    }
+
+    std::vector<std::string> sourceFiles;
+    const SourceFileRecord* sourceRecords = reinterpret_cast<const SourceFileRecord*>(File.Data() + header->SourceFileOffset);
+    for(uint32 i = 0; i < header->SourceFileCount; ++i)
+    {
+        sourceFiles.emplace_back(sourceRecords[i].Path, strnlen(sourceRecords[i].Path, MaxPathLength));
+    }
+
+    uint64 hash = 0;
+    if(!HashSources(scenePath, sourceFiles, hash) || hash != header->SourceHash)
+    {
+        Close();
+        return false;
+    }
+
+    Head = header;
+    return true;
+}
+
+void SceneCache::Close()
+{
+    Head = nullptr;
+    File.Close();
+}
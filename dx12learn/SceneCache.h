@@ -0,0 +1,119 @@
+#pragma once
+
+#include "GeometryPacker.h"
+#include "MappedFile.h"
+#include "Material.h"
+
+// Baked copy of the scene's packed shape geometry and material table.
+//
+// The file is written once after a full json build and memory-mapped on later
+// launches. Every table is stored in the exact layout the upload code consumes,
+// so loading is a validation pass plus pointer arithmetic. The header carries a
+// hash over the scene json and every file it references; any change to those
+// invalidates the cache and triggers a rebuild.
+class SceneCache
+{
+public:
+    using uint32 = std::uint32_t;
+    using uint64 = std::uint64_t;
+
+    static const uint32 Magic = 0x43535844; // 'DXSC'
+    static const uint32 Version = 5;
+    static const uint32 MaxNameLength = 64;
+    static const uint32 MaxPathLength = 260;
+
+    struct Header
+    {
+        uint32 Magic;
+        uint32 Version;
+        uint64 SourceHash;
+
+        uint32 SourceFileCount;
+        uint32 SubmeshCount;
+        uint32 MaterialCount;
+        uint32 VertexStride;
+        uint32 VertexCount;
+        uint32 Index16Count;
+        uint32 Index32Count;
+        uint32 VertexFormat; // ::VertexFormat of the vertex section
+
+        uint64 SourceFileOffset;
+        uint64 SubmeshOffset;
+        uint64 MaterialOffset;
+        uint64 VertexOffset;
+        uint64 Index16Offset;
+        uint64 Index32Offset;
+        uint64 FileSize;
+    };
+
+    struct SourceFileRecord
+    {
+        char Path[MaxPathLength];
+    };
+
+    struct SubmeshRecord
+    {
+        char Name[MaxNameLength];
+        char MaterialName[MaxNameLength];
+        uint32 IndexFormat; // DXGI_FORMAT of the stream StartIndexLocation refers to
+        uint32 IndexCount;
+        uint32 StartIndexLocation;
+        std::int32_t BaseVertexLocation;
+        float BoundsCenter[3];
+        float BoundsExtents[3];
+        float LodSwitchDistance;
+    };
+
+    struct MaterialRecord
+    {
+        char Name[MaxNameLength];
+        std::int32_t MatCBIndex;
+        std::int32_t DiffuseSrvHeapIndex;
+        std::int32_t NormalSrvHeapIndex;
+        float DiffuseAlbedo[4];
+        float FresnelR0[3];
+        float Roughness;
+        float MatTransform[16];
+    };
+
+    // Hashes the scene file followed by each referenced file, in order.
+    // Returns false if any of them cannot be read.
+    static bool HashSources(const std::string& scenePath, const std::vector<std::string>& sourceFiles, uint64& hash);
+
+    static bool Write(
+        const std::string& cachePath,
+        const std::string& scenePath,
+        const std::vector<std::string>& sourceFiles,
+        const PackedGeometry& geometry,
+        const std::vector<const Material*>& materials);
+
+    // Maps the cache and checks it against the current sources. On failure the
+    // cache is closed and the caller should fall back to building from json.
+    bool Open(const std::string& cachePath, const std::string& scenePath);
+    void Close();
+
+    bool IsOpen()const { return Head != nullptr; }
+
+    const Header& GetHeader()const { return *Head; }
+    const SubmeshRecord* GetSubmeshes()const { return Section<SubmeshRecord>(Head->SubmeshOffset); }
+    const MaterialRecord* GetMaterials()const { return Section<MaterialRecord>(Head->MaterialOffset); }
+    ::VertexFormat GetVertexFormat()const { return (::VertexFormat)Head->VertexFormat; }
+    const void* GetVertices()const { return Section<char>(Head->VertexOffset); }
+    const std::uint16_t* GetIndices16()const { return Section<std::uint16_t>(Head->Index16Offset); }
+    const std::uint32_t* GetIndices32()const { return Section<std::uint32_t>(Head->Index32Offset); }
+
+    UINT GetVertexStride()const { return Head->VertexStride; }
+    UINT GetVertexByteSize()const { return Head->VertexCount * Head->VertexStride; }
+    UINT GetIndex16ByteSize()const { return Head->Index16Count * sizeof(std::uint16_t); }
+    UINT GetIndex32ByteSize()const { return Head->Index32Count * sizeof(std::uint32_t); }
+
+private:
+    template<typename T>
+    const T* Section(uint64 offset)const
+    {
+        return reinterpret_cast<const T*>(File.Data() + offset);
+    }
+
+    MappedFile File;
+    const Header* Head = nullptr;
+};
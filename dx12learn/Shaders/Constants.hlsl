@@ -3,8 +3,22 @@ cbuffer cbPerObject : register( b0 )
 {
 	float4x4 World;
 	float4x4 TexTransform;
+	float3 PositionScale;
+	float cbPerObjectPad0;
+	float3 PositionBias;
+	float cbPerObjectPad1;
+};
+
+#ifdef INSTANCED
+// see InstanceData in FrameResource.h
+struct InstanceData
+{
+	float4x4 World;
 };
 
+StructuredBuffer<InstanceData> Instances : register(t0, space1);
+#endif
+
 cbuffer cbPass : register(b1)
 {
 	float4x4 View;
@@ -40,6 +54,15 @@ cbuffer cbMaterial : register(b2)
 };
 
 
+#ifdef PACKED_VERTEX
+// see PackedVertex in PackedVertex.h
+struct VertexIn
+{
+	float4 PosQ : POSITION;
+	float2 NormalOct : NORMAL;
+	float2 Tex : TEXCOORD;
+};
+#else
 struct VertexIn
 {
 	float3 PosL : POSITION;
@@ -47,6 +70,7 @@ struct VertexIn
 	float2 Tex : TEXCOORD;
 	float4 Color : COLOR;
 };
+#endif
 
 struct VertexOut
 {
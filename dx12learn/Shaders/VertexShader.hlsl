@@ -1,15 +1,41 @@
 #include "LightingUtil.hlsl"
 #include "Constants.hlsl"
 
-VertexOut VS( VertexIn vin )
+#ifdef PACKED_VERTEX
+float3 DecodeOctahedralNormal(float2 e)
+{
+	float3 n = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+	float t = saturate(-n.z);
+	n.xy += n.xy >= 0.0f ? -t : t;
+	return normalize(n);
+}
+#endif
+
+VertexOut VS( VertexIn vin, uint instanceID : SV_InstanceID )
 {
 	VertexOut vout;
 
-	float4 posW = mul( float4( vin.PosL, 1.0f ), World);
+#ifdef INSTANCED
+	float4x4 world = Instances[instanceID].World;
+#else
+	float4x4 world = World;
+#endif
+
+#ifdef PACKED_VERTEX
+	float3 posL = vin.PosQ.xyz * PositionScale + PositionBias;
+	float3 normalL = DecodeOctahedralNormal(vin.NormalOct);
+	float4 color = DiffuseAlbedo;
+#else
+	float3 posL = vin.PosL;
+	float3 normalL = vin.NormalL;
+	float4 color = vin.Color;
+#endif
+
+	float4 posW = mul( float4( posL, 1.0f ), world);
 	vout.PosW = posW.xyz;
-	vout.NormalW = mul( vin.NormalL, (float3x3)World );
+	vout.NormalW = mul( normalL, (float3x3)world );
 	vout.PosH = mul(posW, ViewProj);
-	vout.Color = vin.Color;
+	vout.Color = color;
 	float4 texC = mul( float4( vin.Tex, 0.0f, 1.0f ), TexTransform);
 	vout.Tex = mul(texC, MatTransform).xy;
 	return vout;
@@ -1,11 +1,54 @@
 #include "Waves.h"
+#include "../ThreadPool.h"
 
 #include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <immintrin.h>
 
 using namespace DirectX;
 
-Waves::Waves(int m, int n, float dx, float dt, float speed, float damping)
+namespace
+{
+    // Bands smaller than this many vertices are not worth a task.
+    const int MinBandVertexCount = 16384;
+
+    // The kernels are written once against these helpers: 8 lanes when the
+    // build targets AVX2, 4 SSE lanes otherwise.
+#if defined(__AVX2__)
+    typedef __m256 Lane;
+    const int LaneWidth = 8;
+    inline Lane LaneLoad(const float* p) { return _mm256_loadu_ps(p); }
+    inline void LaneStore(float* p, Lane v) { _mm256_storeu_ps(p, v); }
+    inline Lane LaneSet(float v) { return _mm256_set1_ps(v); }
+    inline Lane LaneAdd(Lane a, Lane b) { return _mm256_add_ps(a, b); }
+    inline Lane LaneSub(Lane a, Lane b) { return _mm256_sub_ps(a, b); }
+    inline Lane LaneMul(Lane a, Lane b) { return _mm256_mul_ps(a, b); }
+    inline Lane LaneMulAdd(Lane a, Lane b, Lane c) { return _mm256_fmadd_ps(a, b, c); }
+    inline Lane LaneRsqrtEstimate(Lane v) { return _mm256_rsqrt_ps(v); }
+#else
+    typedef __m128 Lane;
+    const int LaneWidth = 4;
+    inline Lane LaneLoad(const float* p) { return _mm_loadu_ps(p); }
+    inline void LaneStore(float* p, Lane v) { _mm_storeu_ps(p, v); }
+    inline Lane LaneSet(float v) { return _mm_set1_ps(v); }
+    inline Lane LaneAdd(Lane a, Lane b) { return _mm_add_ps(a, b); }
+    inline Lane LaneSub(Lane a, Lane b) { return _mm_sub_ps(a, b); }
+    inline Lane LaneMul(Lane a, Lane b) { return _mm_mul_ps(a, b); }
+    inline Lane LaneMulAdd(Lane a, Lane b, Lane c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    inline Lane LaneRsqrtEstimate(Lane v) { return _mm_rsqrt_ps(v); }
+#endif
+
+    // One Newton-Raphson step takes the ~12 bit estimate to nearly full float precision.
+    inline Lane LaneRsqrt(Lane v)
+    {
+        Lane y = LaneRsqrtEstimate(v);
+        Lane halfVyy = LaneMul(LaneMul(LaneSet(0.5f), v), LaneMul(y, y));
+        return LaneMul(y, LaneSub(LaneSet(1.5f), halfVyy));
+    }
+}
+
+Waves::Waves(int m, int n, float dx, float dt, float speed, float damping, ThreadPool* pool)
 {
     NumRows = m;
     NumCols = n;
@@ -22,27 +65,32 @@ Waves::Waves(int m, int n, float dx, float dt, float speed, float damping)
     K2 = (4.0f - 8.0f * e) / d;
     K3 = (2.0f * e) / d;
 
-    PrevSolution.resize(VertexCount);
-    CurrSolution.resize(VertexCount);
-    Normals.resize(VertexCount);
-    TangentX.resize(VertexCount);
+    Pool = pool;
+
+    ColumnX.resize(n);
+    RowZ.resize(m);
+    PrevHeights.assign(VertexCount, 0.0f);
+    CurrHeights.assign(VertexCount, 0.0f);
+    NormalX.assign(VertexCount, 0.0f);
+    NormalY.assign(VertexCount, 1.0f);
+    NormalZ.assign(VertexCount, 0.0f);
+    TangentXX.assign(VertexCount, 1.0f);
+    TangentXY.assign(VertexCount, 0.0f);
     TexCoord.resize(VertexCount);
 
     // Generate grid vertices in system memory.
 
     float halfWidth = (n - 1) * dx * 0.5f;
     float halfDepth = (m - 1) * dx * 0.5f;
+    for (int j = 0; j < n; ++j)
+    {
+        ColumnX[j] = -halfWidth + j * dx;
+    }
     for (int i = 0; i < m; ++i)
     {
-        float z = halfDepth - i * dx;
+        RowZ[i] = halfDepth - i * dx;
         for (int j = 0; j < n; ++j)
         {
-            float x = -halfWidth + j * dx;
-
-            PrevSolution[i * n + j] = XMFLOAT3(x, 0.0f, z);
-            CurrSolution[i * n + j] = XMFLOAT3(x, 0.0f, z);
-            Normals[i * n + j] = XMFLOAT3(0.0f, 1.0f, 0.0f);
-            TangentX[i * n + j] = XMFLOAT3(1.0f, 0.0f, 0.0f);
             TexCoord[i * n + j] = XMFLOAT2(j / (n - 1.0f), i / (m - 1.0f));
         }
     }
@@ -82,51 +130,213 @@ float Waves::Depth()const
     return NumRows * SpatialStep;
 }
 
-void Waves::Update(float dt)
+int Waves::Update(float dt)
 {
-    static float t = 0;
+    Accumulator += dt;
+
+    int steps = 0;
+    while(Accumulator >= TimeStep && steps < MaxSubSteps)
+    {
+        ForEachRowBand(&Waves::StepRows);
+
+        std::swap(PrevHeights, CurrHeights);
 
-    t += dt;
+        Accumulator -= TimeStep;
+        ++steps;
+    }
+
+    if(Accumulator >= TimeStep)
+    {
+        // Too far behind: keep the phase within the step and drop the whole steps.
+        Accumulator = fmodf(Accumulator, TimeStep);
+    }
 
-    if(t >= TimeStep)
+    // Only the latest solution is ever shaded, so the normals are rebuilt once.
+    if(steps > 0)
     {
-        for(int i = 1; i < NumRows-1; ++i)
+        ForEachRowBand(&Waves::UpdateNormalRows);
+    }
+
+    return steps;
+}
+
+void Waves::UpdateAll(const std::vector<Waves*>& waves, float dt, ThreadPool& pool)
+{
+    pool.ParallelFor(waves.size(), [&waves, dt](size_t i)
+    {
+        waves[i]->Update(dt);
+    });
+}
+
+void Waves::WriteVertices(float* dst, const XMFLOAT4& color)const
+{
+    assert((reinterpret_cast<uintptr_t>(dst) & 15) == 0);
+
+    // Four vertices at a time: the SoA lanes are transposed into the first two
+    // float4 of each vertex and the constant color fills the third.
+    const __m128 colorLane = _mm_loadu_ps(&color.x);
+    const __m128 alphaLane = _mm_set1_ps(GetInterpolationFactor());
+    const float alpha = GetInterpolationFactor();
+
+    for(int i = 0; i < NumRows; ++i)
+    {
+        const int row = i * NumCols;
+        const __m128 zLane = _mm_set1_ps(RowZ[i]);
+        float* out = dst + row * VertexFloatCount;
+
+        int j = 0;
+        for(; j + 4 <= NumCols; j += 4)
         {
-            for(int j = 1; j < NumCols-1; ++j)
+            const int k = row + j;
+            __m128 y = _mm_loadu_ps(&CurrHeights[k]);
+            if(Interpolate)
             {
-                PrevSolution[i*NumCols+j].y = 
-                    K1*PrevSolution[i*NumCols+j].y +
-                    K2*CurrSolution[i*NumCols+j].y +
-                    K3*(CurrSolution[(i+1)*NumCols+j].y + 
-                        CurrSolution[(i-1)*NumCols+j].y + 
-                        CurrSolution[i*NumCols+j+1].y + 
-                        CurrSolution[i*NumCols+j-1].y);
+                __m128 prev = _mm_loadu_ps(&PrevHeights[k]);
+                y = _mm_add_ps(prev, _mm_mul_ps(_mm_sub_ps(y, prev), alphaLane));
             }
+            __m128 uv01 = _mm_loadu_ps(&TexCoord[k].x);
+            __m128 uv23 = _mm_loadu_ps(&TexCoord[k + 2].x);
+
+            __m128 a0 = _mm_loadu_ps(&ColumnX[j]);
+            __m128 a1 = y;
+            __m128 a2 = zLane;
+            __m128 a3 = _mm_loadu_ps(&NormalX[k]);
+            _MM_TRANSPOSE4_PS(a0, a1, a2, a3);
+
+            __m128 b0 = _mm_loadu_ps(&NormalY[k]);
+            __m128 b1 = _mm_loadu_ps(&NormalZ[k]);
+            __m128 b2 = _mm_shuffle_ps(uv01, uv23, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 b3 = _mm_shuffle_ps(uv01, uv23, _MM_SHUFFLE(3, 1, 3, 1));
+            _MM_TRANSPOSE4_PS(b0, b1, b2, b3);
+
+            _mm_stream_ps(out + 0, a0);
+            _mm_stream_ps(out + 4, b0);
+            _mm_stream_ps(out + 8, colorLane);
+            _mm_stream_ps(out + 12, a1);
+            _mm_stream_ps(out + 16, b1);
+            _mm_stream_ps(out + 20, colorLane);
+            _mm_stream_ps(out + 24, a2);
+            _mm_stream_ps(out + 28, b2);
+            _mm_stream_ps(out + 32, colorLane);
+            _mm_stream_ps(out + 36, a3);
+            _mm_stream_ps(out + 40, b3);
+            _mm_stream_ps(out + 44, colorLane);
+            out += 4 * VertexFloatCount;
+        }
+        for(; j < NumCols; ++j)
+        {
+            const int k = row + j;
+            float y = Interpolate ? PrevHeights[k] + (CurrHeights[k] - PrevHeights[k]) * alpha : CurrHeights[k];
+            _mm_stream_ps(out + 0, _mm_setr_ps(ColumnX[j], y, RowZ[i], NormalX[k]));
+            _mm_stream_ps(out + 4, _mm_setr_ps(NormalY[k], NormalZ[k], TexCoord[k].x, TexCoord[k].y));
+            _mm_stream_ps(out + 8, colorLane);
+            out += VertexFloatCount;
         }
+    }
+
+    // Streaming stores are weakly ordered; publish them before the GPU work is submitted.
+    _mm_sfence();
+}
+
+void Waves::ForEachRowBand(void (Waves::*kernel)(int, int))
+{
+    const int interiorRows = NumRows - 2;
+    if(interiorRows <= 0)
+    {
+        return;
+    }
+
+    const int rowsPerBand = (std::max)(1, MinBandVertexCount / NumCols);
+    const int bandCount = (interiorRows + rowsPerBand - 1) / rowsPerBand;
+    if(Pool == nullptr || bandCount == 1)
+    {
+        (this->*kernel)(1, NumRows - 1);
+        return;
+    }
 
-        std::swap(PrevSolution, CurrSolution);
+    // Every band only writes its own rows, so bands never race.
+    Pool->ParallelFor(bandCount, [this, kernel, rowsPerBand](size_t band)
+    {
+        int firstRow = 1 + (int)band * rowsPerBand;
+        int lastRow = (std::min)(firstRow + rowsPerBand, NumRows - 1);
+        (this->*kernel)(firstRow, lastRow);
+    });
+}
 
-        t = 0.0f;
+void Waves::StepRows(int firstRow, int lastRow)
+{
+    const Lane k1 = LaneSet(K1);
+    const Lane k2 = LaneSet(K2);
+    const Lane k3 = LaneSet(K3);
 
-        for(int i = 1; i < NumRows - 1; ++i)
+    for(int i = firstRow; i < lastRow; ++i)
+    {
+        float* prev = &PrevHeights[i * NumCols];
+        const float* curr = &CurrHeights[i * NumCols];
+        const float* up = curr - NumCols;
+        const float* down = curr + NumCols;
+
+        int j = 1;
+        for(; j + LaneWidth <= NumCols - 1; j += LaneWidth)
         {
-            for(int j = 1; j < NumCols - 1; ++j)
-            {
-                float l = CurrSolution[i*NumCols+j - 1].y;
-                float r = CurrSolution[i*NumCols+j + 1].y;
-                float t = CurrSolution[(i - 1)*NumCols+j].y;
-                float b = CurrSolution[(i + 1)*NumCols+j].y;
-                Normals[i*NumCols+j].x = -r + l;
-                Normals[i*NumCols+j].y = 2.0f * SpatialStep;
-                Normals[i*NumCols+j].z = b - t;
-
-                XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&Normals[i*NumCols+j]));
-                XMStoreFloat3(&Normals[i*NumCols+j], n);
-
-                TangentX[i*NumCols+j] = XMFLOAT3(2.0f * SpatialStep, r - l, 0.0f);
-                XMVECTOR T = XMVector3Normalize(XMLoadFloat3(&TangentX[i*NumCols+j]));
-                XMStoreFloat3(&TangentX[i*NumCols+j], T);
-            }
+            Lane neighbours = LaneAdd(
+                LaneAdd(LaneLoad(down + j), LaneLoad(up + j)),
+                LaneAdd(LaneLoad(curr + j + 1), LaneLoad(curr + j - 1)));
+            Lane result = LaneMulAdd(k1, LaneLoad(prev + j), LaneMulAdd(k2, LaneLoad(curr + j), LaneMul(k3, neighbours)));
+            LaneStore(prev + j, result);
+        }
+        for(; j < NumCols - 1; ++j)
+        {
+            prev[j] = K1 * prev[j] + K2 * curr[j] + K3 * (down[j] + up[j] + curr[j + 1] + curr[j - 1]);
+        }
+    }
+}
+
+void Waves::UpdateNormalRows(int firstRow, int lastRow)
+{
+    const float twoDx = 2.0f * SpatialStep;
+    const Lane twoDxLane = LaneSet(twoDx);
+    const Lane twoDxSq = LaneSet(twoDx * twoDx);
+
+    for(int i = firstRow; i < lastRow; ++i)
+    {
+        const int row = i * NumCols;
+        const float* curr = &CurrHeights[row];
+        const float* up = curr - NumCols;
+        const float* down = curr + NumCols;
+
+        // normal = (l - r, 2dx, b - t), tangent = (2dx, r - l, 0), both normalized
+        int j = 1;
+        for(; j + LaneWidth <= NumCols - 1; j += LaneWidth)
+        {
+            Lane l = LaneLoad(curr + j - 1);
+            Lane r = LaneLoad(curr + j + 1);
+            Lane nx = LaneSub(l, r);
+            Lane nz = LaneSub(LaneLoad(down + j), LaneLoad(up + j));
+
+            Lane invN = LaneRsqrt(LaneMulAdd(nx, nx, LaneMulAdd(nz, nz, twoDxSq)));
+            LaneStore(&NormalX[row + j], LaneMul(nx, invN));
+            LaneStore(&NormalY[row + j], LaneMul(twoDxLane, invN));
+            LaneStore(&NormalZ[row + j], LaneMul(nz, invN));
+
+            Lane ty = LaneSub(r, l);
+            Lane invT = LaneRsqrt(LaneMulAdd(ty, ty, twoDxSq));
+            LaneStore(&TangentXX[row + j], LaneMul(twoDxLane, invT));
+            LaneStore(&TangentXY[row + j], LaneMul(ty, invT));
+        }
+        for(; j < NumCols - 1; ++j)
+        {
+            float nx = curr[j - 1] - curr[j + 1];
+            float nz = down[j] - up[j];
+            float invN = 1.0f / sqrtf(nx * nx + twoDx * twoDx + nz * nz);
+            NormalX[row + j] = nx * invN;
+            NormalY[row + j] = twoDx * invN;
+            NormalZ[row + j] = nz * invN;
+
+            float ty = -nx;
+            float invT = 1.0f / sqrtf(twoDx * twoDx + ty * ty);
+            TangentXX[row + j] = twoDx * invT;
+            TangentXY[row + j] = ty * invT;
         }
     }
 }
@@ -138,9 +348,9 @@ void Waves::Disturb(int i, int j, float magnitude)
 
     float halfMag = 0.5f * magnitude;
 
-    CurrSolution[i*NumCols+j].y += magnitude;
-    CurrSolution[i*NumCols+j + 1].y += halfMag;
-    CurrSolution[i*NumCols+j - 1].y += halfMag;
-    CurrSolution[(i + 1)*NumCols+j].y += halfMag;
-    CurrSolution[(i - 1)*NumCols+j].y += halfMag;
-}
\ No newline at end of file
+    CurrHeights[i*NumCols+j] += magnitude;
+    CurrHeights[i*NumCols+j + 1] += halfMag;
+    CurrHeights[i*NumCols+j - 1] += halfMag;
+    CurrHeights[(i + 1)*NumCols+j] += halfMag;
+    CurrHeights[(i - 1)*NumCols+j] += halfMag;
+}
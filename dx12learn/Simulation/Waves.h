@@ -2,10 +2,18 @@
 
 #include <vector>
 
+class ThreadPool;
+
+// Height field water on an m x n grid.
+//
+// The solution is stored as separate float arrays (heights, normal and tangent
+// components) rather than an array of XMFLOAT3, so the stencil update and the
+// normal pass stream contiguous floats through SIMD lanes. Grids large enough to
+// benefit are split into row bands and run on the thread pool.
 class Waves
 {
 public:
-    Waves(int m, int n, float dx, float dt, float speed, float damping);
+    Waves(int m, int n, float dx, float dt, float speed, float damping, ThreadPool* pool = nullptr);
     Waves(const Waves& rhs) = delete;
     Waves& operator=(const Waves& rhs) = delete;
     ~Waves();
@@ -17,15 +25,46 @@ public:
     float Width()const;
     float Depth()const;
 
-    const DirectX::XMFLOAT3& GetPosition(int i)const { return CurrSolution[i]; }
-    const DirectX::XMFLOAT3& GetNormal(int i)const { return Normals[i]; }
-    const DirectX::XMFLOAT3& GetTangentX(int i)const { return TangentX[i]; }
+    // Height of vertex i, blended between the last two solutions when interpolation is on.
+    float GetHeight(int i)const { return Interpolate ? PrevHeights[i] + (CurrHeights[i] - PrevHeights[i]) * GetInterpolationFactor() : CurrHeights[i]; }
+    DirectX::XMFLOAT3 GetPosition(int i)const { return DirectX::XMFLOAT3(ColumnX[i % NumCols], GetHeight(i), RowZ[i / NumCols]); }
+    DirectX::XMFLOAT3 GetNormal(int i)const { return DirectX::XMFLOAT3(NormalX[i], NormalY[i], NormalZ[i]); }
+    DirectX::XMFLOAT3 GetTangentX(int i)const { return DirectX::XMFLOAT3(TangentXX[i], TangentXY[i], 0.0f); }
     const DirectX::XMFLOAT2& GetTexC(int i)const { return TexCoord[i]; }
 
-    void Update(float dt);
+    // Advances the simulation by dt in fixed steps of the time step passed to the
+    // constructor. Time that does not fill a whole step carries over to the next
+    // call. At most MaxSubSteps steps run per call; a larger backlog is dropped so a
+    // long frame cannot make the next one longer. Returns the number of steps taken.
+    int Update(float dt);
     void Disturb(int i, int j, float magnitude);
 
+    // Writes every vertex of the current (or interpolated) solution to dst as 12
+    // floats: position, normal, texture coordinate and color. This is the layout of
+    // Vertex in PackedVertex.h. dst must be 16-byte aligned; it is written front to
+    // back with streaming stores, so it may point straight into an upload heap.
+    void WriteVertices(float* dst, const DirectX::XMFLOAT4& color)const;
+    static const int VertexFloatCount = 12;
+
+    // Updates independent simulations concurrently, one task per Waves. Each one may
+    // split its own update into row bands on its pool, which nests inside this one.
+    static void UpdateAll(const std::vector<Waves*>& waves, float dt, ThreadPool& pool);
+
+    void SetMaxSubSteps(int count) { MaxSubSteps = count > 0 ? count : 1; }
+    int GetMaxSubSteps()const { return MaxSubSteps; }
+
+    // With interpolation on, GetHeight and GetPosition lag one step behind and blend
+    // the two most recent solutions by the carried over time. Normals are not blended.
+    void SetInterpolation(bool enabled) { Interpolate = enabled; }
+    bool GetInterpolation()const { return Interpolate; }
+    float GetInterpolationFactor()const { return Accumulator / TimeStep; }
+
 private:
+    void StepRows(int firstRow, int lastRow);
+    void UpdateNormalRows(int firstRow, int lastRow);
+    // Runs kernel over the interior rows, in parallel bands when there is a pool and enough work.
+    void ForEachRowBand(void (Waves::*kernel)(int, int));
+
     int NumRows = 0;
     int NumCols = 0;
 
@@ -39,9 +78,24 @@ private:
     float TimeStep = 0.0f;
     float SpatialStep = 0.0f;
 
-    std::vector<DirectX::XMFLOAT3> PrevSolution;
-    std::vector<DirectX::XMFLOAT3> CurrSolution;
-    std::vector<DirectX::XMFLOAT3> Normals;
-    std::vector<DirectX::XMFLOAT3> TangentX;
+    // Simulated time not yet consumed by a step, always in [0, TimeStep).
+    float Accumulator = 0.0f;
+    int MaxSubSteps = 4;
+    bool Interpolate = false;
+
+    ThreadPool* Pool = nullptr;
+
+    // x of every column and z of every row; the grid itself never moves horizontally.
+    std::vector<float> ColumnX;
+    std::vector<float> RowZ;
+
+    std::vector<float> PrevHeights;
+    std::vector<float> CurrHeights;
+    std::vector<float> NormalX;
+    std::vector<float> NormalY;
+    std::vector<float> NormalZ;
+    // The x tangent has no z component.
+    std::vector<float> TangentXX;
+    std::vector<float> TangentXY;
     std::vector<DirectX::XMFLOAT2> TexCoord;
-};
\ No newline at end of file
+};
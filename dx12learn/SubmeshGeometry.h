@@ -0,0 +1,19 @@
+#pragma once
+
+#include <DirectXCollision.h>
+#include <string>
+
+// A range of a MeshGeometry's index buffer drawn as one mesh. Kept apart from
+// D3DUtil.h so the geometry packing and scene cache code builds without D3D12.
+struct SubmeshGeometry
+{
+    UINT IndexCount = 0;
+    UINT StartIndexLocation = 0;
+    INT BaseVertexLocation = 0;
+
+    DirectX::BoundingBox Bounds;
+    std::string MaterialName;
+
+    // Camera distance covered by each level of detail of the mesh before the next one is used.
+    float LodSwitchDistance = 8.0f;
+};
@@ -0,0 +1,128 @@
+#include "TestUtil.h"
+#include "../DirtyList.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace
+{
+    const int FrameResourceCount = 3;
+
+    // One frame: the entries Update writes, in order.
+    std::vector<std::uint32_t> RunFrame(DirtyList& dirty)
+    {
+        std::vector<std::uint32_t> written;
+        dirty.Update([&](std::uint32_t index) { written.push_back(index); });
+        return written;
+    }
+
+    void TestCountdown()
+    {
+        DirtyList dirty(FrameResourceCount);
+        dirty.Resize(8);
+        CHECK(dirty.GetCount() == 8);
+        CHECK(dirty.GetDirtyCount() == 0);
+        CHECK(RunFrame(dirty).empty());
+
+        // marked twice, queued once
+        dirty.Mark(5);
+        dirty.Mark(2);
+        dirty.Mark(5);
+        CHECK(dirty.GetDirtyCount() == 2);
+
+        // rewritten for exactly one frame per frame resource, ascending
+        for(int frame = 0; frame < FrameResourceCount; ++frame)
+        {
+            CHECK(dirty.IsDirty(2) && dirty.IsDirty(5));
+            CHECK(dirty.GetFramesLeft(5) == FrameResourceCount - frame);
+            std::vector<std::uint32_t> written = RunFrame(dirty);
+            CHECK(written.size() == 2);
+            CHECK(written[0] == 2 && written[1] == 5);
+        }
+
+        // then the entries leave the list
+        CHECK(dirty.GetDirtyCount() == 0);
+        CHECK(!dirty.IsDirty(2) && !dirty.IsDirty(5));
+        CHECK(RunFrame(dirty).empty());
+    }
+
+    void TestMarkedMidCountdown()
+    {
+        DirtyList dirty(FrameResourceCount);
+        dirty.Resize(4);
+        dirty.Mark(1);
+        dirty.Mark(3);
+        CHECK(RunFrame(dirty).size() == 2);
+        CHECK(RunFrame(dirty).size() == 2);
+
+        // Entry 3 changes again with one frame resource left to update: the frame
+        // resources that already have the old value need the new one too.
+        dirty.Mark(3);
+        CHECK(dirty.GetDirtyCount() == 2);
+        CHECK(dirty.GetFramesLeft(1) == 1);
+        CHECK(dirty.GetFramesLeft(3) == FrameResourceCount);
+
+        std::vector<std::uint32_t> written = RunFrame(dirty);
+        CHECK(written.size() == 2 && written[0] == 1 && written[1] == 3);
+        CHECK(!dirty.IsDirty(1));
+
+        for(int frame = 1; frame < FrameResourceCount; ++frame)
+        {
+            written = RunFrame(dirty);
+            CHECK(written.size() == 1 && written[0] == 3);
+        }
+        CHECK(dirty.GetDirtyCount() == 0);
+        CHECK(RunFrame(dirty).empty());
+
+        // an entry that left the list is queued again like a new one
+        dirty.Mark(1);
+        CHECK(dirty.GetDirtyCount() == 1);
+        for(int frame = 0; frame < FrameResourceCount; ++frame)
+        {
+            written = RunFrame(dirty);
+            CHECK(written.size() == 1 && written[0] == 1);
+        }
+        CHECK(RunFrame(dirty).empty());
+    }
+
+    void TestMarkedInEveryFrame()
+    {
+        // An entry changing every frame stays queued and is written once per frame.
+        DirtyList dirty(FrameResourceCount);
+        dirty.Resize(2);
+        for(int frame = 0; frame < 10; ++frame)
+        {
+            dirty.Mark(0);
+            std::vector<std::uint32_t> written = RunFrame(dirty);
+            CHECK(written.size() == 1 && written[0] == 0);
+            CHECK(dirty.GetFramesLeft(0) == FrameResourceCount - 1);
+        }
+        CHECK(RunFrame(dirty).size() == 1);
+        CHECK(RunFrame(dirty).size() == 1);
+        CHECK(RunFrame(dirty).empty());
+    }
+
+    void TestResize()
+    {
+        // materials grow the list one at a time while the scene is built
+        DirtyList dirty(FrameResourceCount);
+        dirty.Resize(1);
+        dirty.Mark(0);
+        dirty.Resize(3);
+        CHECK(dirty.IsDirty(0));
+        CHECK(!dirty.IsDirty(1) && !dirty.IsDirty(2));
+        dirty.Mark(2);
+        std::vector<std::uint32_t> written = RunFrame(dirty);
+        CHECK(written.size() == 2 && written[0] == 0 && written[1] == 2);
+    }
+}
+
+int main()
+{
+    TestCountdown();
+    TestMarkedMidCountdown();
+    TestMarkedInEveryFrame();
+    TestResize();
+    std::printf("DirtyListTest passed\n");
+    return 0;
+}
@@ -0,0 +1,193 @@
+#include "TestUtil.h"
+#include "../DrawSubmission.h"
+#include "../ThreadPool.h"
+
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+    // Stands in for a command list: it must be opened before recording and
+    // closed once, starts without any bound state, and keeps the items it drew.
+    class MockCommandList : public DrawListRecorder
+    {
+    public:
+        void Begin() override
+        {
+            CHECK(!Open && !Closed);
+            Open = true;
+            Bound = 0;
+        }
+        void End(bool last) override
+        {
+            CHECK(Open);
+            Open = false;
+            Closed = true;
+            EndsFrame = last;
+        }
+
+        void SetPipeline(std::uint32_t pipeline) override { Record(PipelineBit); Pipeline = pipeline; Counts.PipelineSets++; }
+        void SetGeometry(const void* geometry) override { Record(GeometryBit); Geometry = geometry; Counts.GeometrySets++; }
+        void SetTopology(std::uint32_t topology) override { Record(TopologyBit); Topology = topology; Counts.TopologySets++; }
+        void SetMaterial(const void* material) override { Record(MaterialBit); Material = material; Counts.MaterialSets++; }
+        void Draw(const DrawPacket& packet) override
+        {
+            CHECK(Open);
+            // nothing may be inherited from another list
+            CHECK(Bound == (PipelineBit | GeometryBit | TopologyBit | MaterialBit));
+            CHECK(Pipeline == packet.Pipeline && Geometry == packet.Geometry);
+            CHECK(Topology == packet.Topology && Material == packet.Material);
+            if(packet.Item == FailingItem)
+            {
+                throw std::runtime_error("recording failed");
+            }
+            Drawn.push_back(packet.Item);
+            Counts.Draws++;
+        }
+
+        bool Open = false;
+        bool Closed = false;
+        bool EndsFrame = false;
+        const void* FailingItem = nullptr;
+        std::vector<const void*> Drawn;
+        DrawStats Counts;
+
+    private:
+        enum : unsigned { PipelineBit = 1, GeometryBit = 2, TopologyBit = 4, MaterialBit = 8 };
+
+        void Record(unsigned bit)
+        {
+            CHECK(Open);
+            Bound |= bit;
+        }
+
+        unsigned Bound = 0;
+        std::uint32_t Pipeline = 0;
+        std::uint32_t Topology = 0;
+        const void* Geometry = nullptr;
+        const void* Material = nullptr;
+    };
+
+    struct Frame
+    {
+        std::vector<int> Items;
+        std::vector<int> States;
+        std::vector<DrawPacket> Packets;
+
+        // runs of ten draws share their state, like sorted packets do
+        explicit Frame(size_t count) : Items(count), States(count / 10 + 1), Packets(count)
+        {
+            for(size_t i = 0; i < count; ++i)
+            {
+                DrawPacket& packet = Packets[i];
+                packet.Key = i;
+                packet.Pipeline = (std::uint32_t)(i / 100);
+                packet.Topology = 4;
+                packet.Geometry = &States[i / 10];
+                packet.Material = &States[i / 20];
+                packet.Item = &Items[i];
+            }
+        }
+    };
+
+    std::vector<std::unique_ptr<MockCommandList>> MakeLists(size_t count, std::vector<DrawListRecorder*>& pointers)
+    {
+        std::vector<std::unique_ptr<MockCommandList>> lists;
+        pointers.clear();
+        for(size_t i = 0; i < count; ++i)
+        {
+            lists.push_back(std::make_unique<MockCommandList>());
+            pointers.push_back(lists.back().get());
+        }
+        return lists;
+    }
+
+    void TestChunkCount()
+    {
+        CHECK(GetDrawChunkCount(0, 8, 128) == 1);
+        CHECK(GetDrawChunkCount(255, 8, 128) == 1);
+        CHECK(GetDrawChunkCount(256, 8, 128) == 2);
+        CHECK(GetDrawChunkCount(100000, 8, 128) == 8);
+        CHECK(GetDrawChunkCount(100000, 0, 128) == 1);
+        CHECK(GetDrawChunkCount(5, 4, 0) == 4);
+    }
+
+    void TestRecordsInOrder(ThreadPool& pool)
+    {
+        for(size_t count : { 0, 1, 7, 1000, 4099 })
+        {
+            Frame frame(count);
+            for(size_t listCount : { 1, 2, 3, 8 })
+            {
+                std::vector<DrawListRecorder*> pointers;
+                auto lists = MakeLists(listCount, pointers);
+                DrawStats stats = RecordDrawChunks(pool, frame.Packets.data(), count, pointers.data(), pointers.size());
+
+                // executing the lists in order replays the packets in order
+                std::vector<const void*> drawn;
+                DrawStats counts;
+                for(size_t i = 0; i < listCount; ++i)
+                {
+                    CHECK(lists[i]->Closed);
+                    CHECK(lists[i]->EndsFrame == (i == listCount - 1));
+                    drawn.insert(drawn.end(), lists[i]->Drawn.begin(), lists[i]->Drawn.end());
+                    counts.Add(lists[i]->Counts);
+                }
+                CHECK(drawn.size() == count);
+                for(size_t i = 0; i < count; ++i)
+                {
+                    CHECK(drawn[i] == frame.Packets[i].Item);
+                }
+
+                CHECK(stats.Draws == count);
+                CHECK(stats.GetStateSets() == counts.GetStateSets());
+                CHECK(stats.GetStateSets() + stats.SkippedSets == 4 * count);
+                // every non-empty chunk but the first binds its state again
+                CountingDrawRecorder single;
+                SubmitDrawPackets(single, frame.Packets.data(), count);
+                CHECK(stats.GetStateSets() >= single.Counts.GetStateSets());
+                CHECK(stats.GetStateSets() <= single.Counts.GetStateSets() + 4 * (listCount - 1));
+            }
+        }
+    }
+
+    void TestFailingList(ThreadPool& pool)
+    {
+        Frame frame(1000);
+        for(size_t failing : { size_t(0), size_t(3), size_t(7) })
+        {
+            std::vector<DrawListRecorder*> pointers;
+            auto lists = MakeLists(8, pointers);
+            lists[failing]->FailingItem = frame.Packets[failing * 125 + 60].Item;
+
+            bool caught = false;
+            try
+            {
+                RecordDrawChunks(pool, frame.Packets.data(), frame.Packets.size(), pointers.data(), pointers.size());
+            }
+            catch(const std::runtime_error&)
+            {
+                caught = true;
+            }
+            CHECK(caught);
+            CHECK(!lists[failing]->Closed);
+        }
+
+        // the pool records the next frame normally
+        TestRecordsInOrder(pool);
+    }
+}
+
+int main()
+{
+    TestChunkCount();
+    for(unsigned threadCount : { 1u, 3u, 8u })
+    {
+        ThreadPool pool(threadCount);
+        TestRecordsInOrder(pool);
+        TestFailingList(pool);
+    }
+    std::printf("DrawChunkTest passed\n");
+    return 0;
+}
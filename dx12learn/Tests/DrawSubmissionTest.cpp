@@ -0,0 +1,180 @@
+#include "TestUtil.h"
+#include "../DrawSubmission.h"
+#include "../RadixSort.h"
+
+#include <random>
+#include <set>
+#include <utility>
+#include <vector>
+
+namespace
+{
+    // Tracks what a command list would have bound and checks that every draw
+    // sees exactly the state of its packet.
+    class ValidatingRecorder : public DrawRecorder
+    {
+    public:
+        void SetPipeline(std::uint32_t pipeline) override { Pipeline = pipeline; HasPipeline = true; Counts.PipelineSets++; }
+        void SetGeometry(const void* geometry) override { Geometry = geometry; HasGeometry = true; Counts.GeometrySets++; }
+        void SetTopology(std::uint32_t topology) override { Topology = topology; HasTopology = true; Counts.TopologySets++; }
+        void SetMaterial(const void* material) override { Material = material; HasMaterial = true; Counts.MaterialSets++; }
+        void Draw(const DrawPacket& packet) override
+        {
+            CHECK(HasPipeline && Pipeline == packet.Pipeline);
+            CHECK(HasGeometry && Geometry == packet.Geometry);
+            CHECK(HasTopology && Topology == packet.Topology);
+            CHECK(HasMaterial && Material == packet.Material);
+            Drawn.push_back(packet.Item);
+            Counts.Draws++;
+        }
+
+        DrawStats Counts;
+        std::vector<const void*> Drawn;
+
+    private:
+        std::uint32_t Pipeline = 0;
+        std::uint32_t Topology = 0;
+        const void* Geometry = nullptr;
+        const void* Material = nullptr;
+        bool HasPipeline = false;
+        bool HasGeometry = false;
+        bool HasTopology = false;
+        bool HasMaterial = false;
+    };
+
+    void CheckSameSets(const DrawStats& a, const DrawStats& b)
+    {
+        CHECK(a.Draws == b.Draws);
+        CHECK(a.PipelineSets == b.PipelineSets);
+        CHECK(a.GeometrySets == b.GeometrySets);
+        CHECK(a.TopologySets == b.TopologySets);
+        CHECK(a.MaterialSets == b.MaterialSets);
+    }
+
+    // Submits packets to a validating and a counting recorder and checks that
+    // both agree with the returned stats.
+    DrawStats Submit(const std::vector<DrawPacket>& packets)
+    {
+        ValidatingRecorder validating;
+        DrawStats stats = SubmitDrawPackets(validating, packets.data(), packets.size());
+        CheckSameSets(stats, validating.Counts);
+        CHECK(stats.GetStateSets() + stats.SkippedSets == 4 * stats.Draws);
+        CHECK(validating.Drawn.size() == packets.size());
+        for(size_t i = 0; i < packets.size(); ++i)
+        {
+            CHECK(validating.Drawn[i] == packets[i].Item);
+        }
+
+        CountingDrawRecorder counting;
+        CheckSameSets(SubmitDrawPackets(counting, packets.data(), packets.size()), counting.Counts);
+        CheckSameSets(stats, counting.Counts);
+        return stats;
+    }
+
+    void TestSkipsRepeatedState()
+    {
+        int geometry[2];
+        int material[2];
+        int items[4];
+        std::vector<DrawPacket> packets(4);
+        for(int i = 0; i < 4; ++i)
+        {
+            packets[i].Pipeline = 1;
+            packets[i].Topology = 4;
+            packets[i].Geometry = &geometry[0];
+            packets[i].Material = &material[0];
+            packets[i].Item = &items[i];
+        }
+        packets[2].Material = &material[1];
+        packets[3].Material = &material[1];
+        packets[3].Geometry = &geometry[1];
+
+        DrawStats stats = Submit(packets);
+        CHECK(stats.Draws == 4);
+        CHECK(stats.PipelineSets == 1);
+        CHECK(stats.TopologySets == 1);
+        CHECK(stats.GeometrySets == 2);
+        CHECK(stats.MaterialSets == 2);
+        CHECK(stats.SkippedSets == 10);
+
+        CHECK(Submit({}).Draws == 0);
+    }
+
+    // A frame shaped like the demo's: a few layers, shared meshes and materials,
+    // keyed like DemoApp::BuildDrawPackets (opaque layers only).
+    void TestSortingReducesStateSets()
+    {
+        const int pipelineCount = 4;
+        const int geometryCount = 24;
+        const int materialCount = 40;
+        std::vector<int> geometries(geometryCount);
+        std::vector<int> materials(materialCount);
+
+        std::mt19937 random(7);
+        for(size_t itemCount : { 1000, 20000 })
+        {
+            std::vector<int> items(itemCount);
+            std::vector<DrawPacket> packets(itemCount);
+            std::set<std::pair<std::uint32_t, const void*>> pipelineGeometries;
+            std::set<std::uint32_t> pipelines;
+            for(size_t i = 0; i < itemCount; ++i)
+            {
+                std::uint32_t pipeline = random() % pipelineCount;
+                std::uint32_t geometry = random() % geometryCount;
+                std::uint32_t material = random() % materialCount;
+                std::uint32_t depth = random() & 0x7fffffff;
+
+                DrawPacket& packet = packets[i];
+                packet.Pipeline = pipeline;
+                packet.Topology = 4;
+                packet.Geometry = &geometries[geometry];
+                packet.Material = &materials[material];
+                packet.Item = &items[i];
+                packet.Key = ((std::uint64_t)pipeline << 56) | ((std::uint64_t)geometry << 44) | ((std::uint64_t)material << 32) | depth;
+
+                pipelines.insert(pipeline);
+                pipelineGeometries.insert({ pipeline, packet.Geometry });
+            }
+
+            DrawStats unsorted = Submit(packets);
+
+            std::vector<DrawPacket> scratch;
+            RadixSort64(packets, scratch, [](const DrawPacket& packet) { return packet.Key; });
+            DrawStats sorted = Submit(packets);
+
+            CHECK(sorted.PipelineSets == pipelines.size());
+            CHECK(sorted.GeometrySets == pipelineGeometries.size());
+            CHECK(sorted.TopologySets == 1);
+            CHECK(sorted.MaterialSets <= pipelineGeometries.size() * materialCount);
+            CHECK(sorted.GetStateSets() < unsorted.GetStateSets());
+
+            std::printf("%6zu draws: %6u state sets unsorted, %6u sorted\n",
+                itemCount, unsorted.GetStateSets(), sorted.GetStateSets());
+        }
+    }
+
+    void TestAdd()
+    {
+        DrawStats a;
+        a.Draws = 1;
+        a.PipelineSets = 2;
+        a.GeometrySets = 3;
+        a.TopologySets = 4;
+        a.MaterialSets = 5;
+        a.SkippedSets = 6;
+        DrawStats b = a;
+        b.Add(a);
+        CHECK(b.Draws == 2 && b.PipelineSets == 4 && b.GeometrySets == 6);
+        CHECK(b.TopologySets == 8 && b.MaterialSets == 10 && b.SkippedSets == 12);
+        CHECK(b.GetStateSets() == 28);
+    }
+}
+
+int main()
+{
+    TestSkipsRepeatedState();
+    TestSortingReducesStateSets();
+    TestAdd();
+    std::printf("DrawSubmissionTest passed\n");
+    return 0;
+}
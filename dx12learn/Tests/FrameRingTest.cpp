@@ -0,0 +1,239 @@
+#include "TestUtil.h"
+#include "../FrameRing.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Single threaded queue: nothing completes on its own, the test advances the
+    // "GPU" with Complete(). WaitForValue completes everything up to the value and
+    // records the wait, like a CPU stall on a real fence.
+    class ManualQueueFence : public QueueFence
+    {
+    public:
+        std::uint64_t Signal() override { return ++LastValue; }
+        std::uint64_t GetCompletedValue() override { return CompletedValue; }
+        void WaitForValue(std::uint64_t value) override
+        {
+            CHECK(value <= LastValue);
+            if(value > CompletedValue)
+            {
+                Waits.push_back(value);
+                CompletedValue = value;
+            }
+        }
+
+        void Complete(std::uint64_t value)
+        {
+            CHECK(value <= LastValue);
+            CompletedValue = (std::max)(CompletedValue, value);
+        }
+
+        std::uint64_t LastValue = 0;
+        std::uint64_t CompletedValue = 0;
+        std::vector<std::uint64_t> Waits;
+    };
+
+    void TestPacing()
+    {
+        for(size_t slotCount : { 1, 2, 3 })
+        {
+            ManualQueueFence fence;
+            FrameRing ring(fence, slotCount);
+
+            // The first slotCount frames find fresh slots and never wait.
+            for(size_t frame = 0; frame < slotCount; ++frame)
+            {
+                CHECK(ring.BeginFrame() == frame);
+                ring.EndFrame();
+                CHECK(ring.GetSlotFence(frame) == frame + 1);
+            }
+            CHECK(fence.Waits.empty());
+
+            // With the GPU stalled every further frame waits for the one submitted
+            // slotCount frames earlier, so at most slotCount frames are in flight.
+            for(std::uint64_t frame = slotCount + 1; frame <= 20; ++frame)
+            {
+                size_t slot = ring.BeginFrame();
+                CHECK(slot == (frame - 1) % slotCount);
+                CHECK(fence.Waits.size() == frame - slotCount);
+                CHECK(fence.Waits.back() == frame - slotCount);
+                CHECK(fence.LastValue - fence.CompletedValue < slotCount);
+                ring.EndFrame();
+            }
+
+            // A GPU that keeps up never stalls the CPU.
+            size_t waits = fence.Waits.size();
+            for(int frame = 0; frame < 10; ++frame)
+            {
+                fence.Complete(fence.LastValue);
+                ring.BeginFrame();
+                ring.EndFrame();
+            }
+            CHECK(fence.Waits.size() == waits);
+
+            // A GPU one frame behind only stalls a single slot ring.
+            for(int frame = 0; frame < 10; ++frame)
+            {
+                fence.Complete(fence.LastValue - 1);
+                ring.BeginFrame();
+                ring.EndFrame();
+            }
+            CHECK(fence.Waits.size() == waits + (slotCount == 1 ? 10 : 0));
+
+            fence.Flush();
+            CHECK(fence.GetCompletedValue() == fence.LastValue);
+        }
+    }
+
+    // The GPU runs on its own thread and takes its time. Each frame writes its
+    // number into its slot, and the GPU checks that the slot still holds that
+    // number when it gets to the frame: a slot handed out before the GPU was done
+    // with it would be overwritten by a later frame.
+    class ThreadedQueueFence : public QueueFence
+    {
+    public:
+        explicit ThreadedQueueFence(std::vector<std::atomic<int>>& slots)
+            : Slots(slots), Gpu([this] { Run(); })
+        {
+        }
+
+        ~ThreadedQueueFence()
+        {
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                Stop = true;
+            }
+            WorkAdded.notify_one();
+            Gpu.join();
+        }
+
+        // Queues a frame that reads slot.
+        void Execute(size_t slot, int frame)
+        {
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                Pending.push_back({ slot, frame, 0 });
+            }
+            WorkAdded.notify_one();
+        }
+
+        std::uint64_t Signal() override
+        {
+            std::uint64_t value;
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                value = ++LastValue;
+                Pending.push_back({ 0, 0, value });
+            }
+            WorkAdded.notify_one();
+            return value;
+        }
+
+        std::uint64_t GetCompletedValue() override
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            return CompletedValue;
+        }
+
+        void WaitForValue(std::uint64_t value) override
+        {
+            std::unique_lock<std::mutex> lock(Mutex);
+            WorkDone.wait(lock, [&] { return CompletedValue >= value; });
+        }
+
+        std::atomic<int> FramesChecked{ 0 };
+
+    private:
+        struct Command
+        {
+            size_t Slot;
+            int Frame;
+            std::uint64_t FenceValue; // 0 for a frame
+        };
+
+        void Run()
+        {
+            std::unique_lock<std::mutex> lock(Mutex);
+            for(;;)
+            {
+                WorkAdded.wait(lock, [&] { return Stop || !Pending.empty(); });
+                if(Pending.empty())
+                {
+                    return;
+                }
+                Command command = Pending.front();
+                Pending.pop_front();
+                lock.unlock();
+
+                if(command.FenceValue == 0)
+                {
+                    // "read" the frame resource for a while
+                    for(int i = 0; i < 50; ++i)
+                    {
+                        CHECK(Slots[command.Slot].load() == command.Frame);
+                        std::this_thread::yield();
+                    }
+                    FramesChecked.fetch_add(1);
+                }
+
+                lock.lock();
+                if(command.FenceValue != 0)
+                {
+                    CompletedValue = command.FenceValue;
+                    WorkDone.notify_all();
+                }
+            }
+        }
+
+        std::vector<std::atomic<int>>& Slots;
+        std::mutex Mutex;
+        std::condition_variable WorkAdded;
+        std::condition_variable WorkDone;
+        std::deque<Command> Pending;
+        std::uint64_t LastValue = 0;
+        std::uint64_t CompletedValue = 0;
+        bool Stop = false;
+        std::thread Gpu;
+    };
+
+    void TestResourceLifetime()
+    {
+        const int frameCount = 2000;
+        for(size_t slotCount : { 1, 2, 3 })
+        {
+            std::vector<std::atomic<int>> slots(slotCount);
+            for(auto& slot : slots)
+            {
+                slot.store(-1);
+            }
+
+            ThreadedQueueFence fence(slots);
+            FrameRing ring(fence, slotCount);
+            for(int frame = 0; frame < frameCount; ++frame)
+            {
+                size_t slot = ring.BeginFrame();
+                slots[slot].store(frame);
+                fence.Execute(slot, frame);
+                ring.EndFrame();
+                CHECK(fence.GetCompletedValue() + slotCount >= ring.GetSlotFence(slot));
+            }
+            fence.Flush();
+            CHECK(fence.FramesChecked.load() == frameCount);
+        }
+    }
+}
+
+int main()
+{
+    TestPacing();
+    TestResourceLifetime();
+    std::printf("FrameRingTest passed\n");
+    return 0;
+}
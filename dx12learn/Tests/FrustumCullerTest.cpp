@@ -0,0 +1,160 @@
+#include "TestUtil.h"
+#include "../FrustumCuller.h"
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // Camera at the origin looking down +z, 90 degree field of view, square
+    // aspect: the side planes are x = +-z and y = +-z, near z = 1, far z = 100.
+    // The tables below list one entry per plane in ExtractPlanes order: left,
+    // right, bottom, top, near, far.
+    void GetPlanes(XMFLOAT4 planes[6])
+    {
+        XMMATRIX view = XMMatrixLookAtLH(XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f), XMVectorSet(0.0f, 0.0f, 1.0f, 1.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+        XMMATRIX proj = XMMatrixPerspectiveFovLH(0.5f * XM_PI, 1.0f, 1.0f, 100.0f);
+        FrustumCuller::ExtractPlanes(XMMatrixMultiply(view, proj), planes);
+    }
+
+    float Distance(const XMFLOAT4& plane, float x, float y, float z)
+    {
+        return plane.x * x + plane.y * y + plane.z * z + plane.w;
+    }
+
+    // The test Cull runs on every lane, one box at a time.
+    bool IsVisible(const XMFLOAT4 planes[6], const BoundingBox& box)
+    {
+        for(int p = 0; p < 6; ++p)
+        {
+            const XMFLOAT4& n = planes[p];
+            float radius = std::fabs(n.x) * box.Extents.x + std::fabs(n.y) * box.Extents.y + std::fabs(n.z) * box.Extents.z;
+            if(Distance(n, box.Center.x, box.Center.y, box.Center.z) + radius < 0.0f)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void TestExtractPlanes()
+    {
+        XMFLOAT4 planes[6];
+        GetPlanes(planes);
+
+        // every plane faces inwards
+        for(int p = 0; p < 6; ++p)
+        {
+            CHECK(Distance(planes[p], 0.0f, 0.0f, 50.0f) > 0.0f);
+        }
+
+        // a point just past one plane is only behind that one
+        const float outside[6][3] = {
+            { -51.0f, 0.0f, 50.0f }, { 51.0f, 0.0f, 50.0f },
+            { 0.0f, -51.0f, 50.0f }, { 0.0f, 51.0f, 50.0f },
+            { 0.0f, 0.0f, 0.99f }, { 0.0f, 0.0f, 100.5f } };
+        for(int p = 0; p < 6; ++p)
+        {
+            for(int q = 0; q < 6; ++q)
+            {
+                float d = Distance(planes[q], outside[p][0], outside[p][1], outside[p][2]);
+                CHECK(p == q ? d < 0.0f : d > 0.0f);
+            }
+        }
+
+        // and the planes pass through the frustum's edges, up to float precision at the far plane
+        const float surface[6][3] = {
+            { -50.0f, 0.0f, 50.0f }, { 50.0f, 0.0f, 50.0f },
+            { 0.0f, -50.0f, 50.0f }, { 0.0f, 50.0f, 50.0f },
+            { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 100.0f } };
+        for(int p = 0; p < 6; ++p)
+        {
+            const XMFLOAT4& n = planes[p];
+            float length = std::sqrt(n.x * n.x + n.y * n.y + n.z * n.z);
+            CHECK_NEAR(Distance(n, surface[p][0], surface[p][1], surface[p][2]) / length, 0.0, 1e-3);
+        }
+    }
+
+    void TestStraddlingBoxes()
+    {
+        XMFLOAT4 planes[6];
+        GetPlanes(planes);
+
+        // Per plane one box that straddles it and one just beyond it, moved out along the plane's axis.
+        const XMFLOAT3 straddling[6] = {
+            { -52.0f, 0.0f, 50.0f }, { 52.0f, 0.0f, 50.0f },
+            { 0.0f, -52.0f, 50.0f }, { 0.0f, 52.0f, 50.0f },
+            { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, 101.0f } };
+        const XMFLOAT3 beyond[6] = {
+            { -60.0f, 0.0f, 50.0f }, { 60.0f, 0.0f, 50.0f },
+            { 0.0f, -60.0f, 50.0f }, { 0.0f, 60.0f, 50.0f },
+            { 0.0f, 0.0f, -2.5f }, { 0.0f, 0.0f, 104.0f } };
+        const XMFLOAT3 extents(3.0f, 3.0f, 3.0f);
+
+        FrustumCuller culler;
+        culler.Resize(12);
+        for(int p = 0; p < 6; ++p)
+        {
+            culler.SetBox(2 * p, BoundingBox(straddling[p], extents));
+            culler.SetBox(2 * p + 1, BoundingBox(beyond[p], extents));
+        }
+
+        std::vector<std::uint8_t> visible;
+        CHECK(culler.Cull(planes, visible) == 6);
+        CHECK(visible.size() == 12);
+        for(int p = 0; p < 6; ++p)
+        {
+            CHECK(visible[2 * p] == 1);
+            CHECK(visible[2 * p + 1] == 0);
+        }
+    }
+
+    void TestTail()
+    {
+        XMFLOAT4 planes[6];
+        GetPlanes(planes);
+
+        std::mt19937 random(7);
+        std::uniform_real_distribution<float> position(-150.0f, 150.0f);
+        std::uniform_real_distribution<float> extent(0.0f, 20.0f);
+
+        // Counts around both lane widths, none a multiple of 8 except 16 and 64.
+        FrustumCuller culler;
+        std::vector<std::uint8_t> visible;
+        for(size_t count : { 0, 1, 3, 5, 7, 9, 16, 29, 64, 1001 })
+        {
+            std::vector<BoundingBox> boxes(count);
+            culler.Resize(count);
+            CHECK(culler.GetCount() == count);
+            size_t expectedCount = 0;
+            for(size_t i = 0; i < count; ++i)
+            {
+                boxes[i] = BoundingBox(XMFLOAT3(position(random), position(random), 0.5f * position(random) + 50.0f),
+                    XMFLOAT3(extent(random), extent(random), extent(random)));
+                culler.SetBox(i, boxes[i]);
+                expectedCount += IsVisible(planes, boxes[i]) ? 1 : 0;
+            }
+
+            // visible is resized to exactly one entry per box
+            visible.assign(count + 8, 2);
+            CHECK(culler.Cull(planes, visible) == expectedCount);
+            CHECK(visible.size() == count);
+            for(size_t i = 0; i < count; ++i)
+            {
+                CHECK(visible[i] == (IsVisible(planes, boxes[i]) ? 1 : 0));
+            }
+        }
+    }
+}
+
+int main()
+{
+    TestExtractPlanes();
+    TestStraddlingBoxes();
+    TestTail();
+    std::printf("FrustumCullerTest passed\n");
+    return 0;
+}
@@ -0,0 +1,118 @@
+#include "TestUtil.h"
+#include "../GeometryPacker.h"
+#include "../ThreadPool.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    // A strip of count vertices along x; triangle t uses vertices t, t + 1 and t + 2.
+    MeshBuilder::MeshData MakeStrip(size_t count)
+    {
+        MeshBuilder::MeshData mesh;
+        mesh.Vertices.resize(count);
+        for(size_t i = 0; i < count; ++i)
+        {
+            mesh.Vertices[i] = MeshBuilder::Vertex((float)i, (float)(i % 2), 0, 0, 0, 1, 1, 0, 0, 0, 0);
+        }
+        for(size_t i = 0; i + 2 < count; ++i)
+        {
+            mesh.Indices32.push_back((MeshBuilder::uint32)i);
+            mesh.Indices32.push_back((MeshBuilder::uint32)i + 1);
+            mesh.Indices32.push_back((MeshBuilder::uint32)i + 2);
+        }
+        return mesh;
+    }
+
+    // Every index of submesh s, read back from its stream and made absolute.
+    std::vector<std::uint32_t> ReadIndices(const PackedGeometry& packed, size_t s)
+    {
+        const SubmeshGeometry& submesh = packed.Submeshes[s];
+        std::vector<std::uint32_t> indices(submesh.IndexCount);
+        for(UINT i = 0; i < submesh.IndexCount; ++i)
+        {
+            std::uint32_t index = packed.SubmeshIndexFormats[s] == DXGI_FORMAT_R32_UINT ?
+                packed.Indices32[submesh.StartIndexLocation + i] :
+                packed.Indices16[submesh.StartIndexLocation + i];
+            indices[i] = index + (std::uint32_t)submesh.BaseVertexLocation;
+        }
+        return indices;
+    }
+
+    void TestIndexFormatPerMesh(ThreadPool& pool, VertexFormat format)
+    {
+        // The large mesh sits between two small ones, so the second small mesh's
+        // vertices start far beyond what 16 bits can address.
+        const size_t largeCount = GeometryPacker::MaxVerticesFor16BitIndices + 100;
+        std::vector<MeshBuilder::MeshData> meshes = { MakeStrip(300), MakeStrip(largeCount), MakeStrip(GeometryPacker::MaxVerticesFor16BitIndices) };
+        meshes[2].LodIndices32 = { { 0, 1, 2, 65535, 65534, 65533 } };
+
+        std::vector<MeshBuildTask> tasks(meshes.size());
+        tasks[0].Name = "small";
+        tasks[1].Name = "large";
+        tasks[2].Name = "limit";
+
+        PackedGeometry packed;
+        GeometryPacker::Pack(tasks, meshes, format, pool, packed);
+
+        CHECK(packed.Submeshes.size() == 4);
+        CHECK(packed.SubmeshNames[3] == "limit_lod1");
+        CHECK(packed.GetVertexCount() == 300 + largeCount + GeometryPacker::MaxVerticesFor16BitIndices);
+
+        // only the mesh with more than 65536 vertices needs 32 bits
+        CHECK(packed.SubmeshIndexFormats[0] == DXGI_FORMAT_R16_UINT);
+        CHECK(packed.SubmeshIndexFormats[1] == DXGI_FORMAT_R32_UINT);
+        CHECK(packed.SubmeshIndexFormats[2] == DXGI_FORMAT_R16_UINT);
+        CHECK(packed.SubmeshIndexFormats[3] == DXGI_FORMAT_R16_UINT);
+        CHECK(packed.Indices32.size() == meshes[1].Indices32.size());
+        CHECK(packed.Indices16.size() == meshes[0].Indices32.size() + meshes[2].Indices32.size() + 6);
+
+        // vertices are shared in scene order, index ranges per stream
+        CHECK(packed.Submeshes[0].BaseVertexLocation == 0);
+        CHECK(packed.Submeshes[1].BaseVertexLocation == 300);
+        CHECK(packed.Submeshes[2].BaseVertexLocation == (INT)(300 + largeCount));
+        CHECK(packed.Submeshes[3].BaseVertexLocation == packed.Submeshes[2].BaseVertexLocation);
+        CHECK(packed.Submeshes[0].StartIndexLocation == 0);
+        CHECK(packed.Submeshes[1].StartIndexLocation == 0);
+        CHECK(packed.Submeshes[2].StartIndexLocation == meshes[0].Indices32.size());
+        CHECK(packed.Submeshes[3].StartIndexLocation == meshes[0].Indices32.size() + meshes[2].Indices32.size());
+        CHECK(packed.Submeshes[3].IndexCount == 6);
+
+        // 16-bit indices are relative to the submesh and reach the full 0..65535 range
+        CHECK(packed.Indices16[packed.Submeshes[2].StartIndexLocation + meshes[2].Indices32.size() - 1] == 65535);
+
+        const size_t meshOfSubmesh[] = { 0, 1, 2, 2 };
+        for(size_t s = 0; s < packed.Submeshes.size(); ++s)
+        {
+            const MeshBuilder::MeshData& mesh = meshes[meshOfSubmesh[s]];
+            const std::vector<std::uint32_t>& source = s == 3 ? mesh.LodIndices32[0] : mesh.Indices32;
+            std::vector<std::uint32_t> indices = ReadIndices(packed, s);
+            CHECK(indices.size() == source.size());
+            for(size_t i = 0; i < indices.size(); ++i)
+            {
+                CHECK(indices[i] == source[i] + (std::uint32_t)packed.Submeshes[s].BaseVertexLocation);
+            }
+        }
+
+        // the indices land on the right vertices
+        if(format == VertexFormat::Full)
+        {
+            for(size_t s = 0; s < 3; ++s)
+            {
+                std::vector<std::uint32_t> indices = ReadIndices(packed, s);
+                const MeshBuilder::MeshData& mesh = meshes[s];
+                CHECK_NEAR(packed.Vertices[indices.back()].Pos.x, mesh.Vertices[mesh.Indices32.back()].Position.x, 0.0);
+            }
+        }
+    }
+}
+
+int main()
+{
+    ThreadPool pool(2);
+    TestIndexFormatPerMesh(pool, VertexFormat::Full);
+    TestIndexFormatPerMesh(pool, VertexFormat::Packed);
+    std::printf("GeometryPackerTest passed\n");
+    return 0;
+}
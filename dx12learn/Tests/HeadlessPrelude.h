@@ -0,0 +1,26 @@
+#pragma once
+
+// Force-included into the engine sources built by the headless tests in place
+// of stdafx.h: the math and standard headers they rely on, no Windows or D3D12.
+#include <DirectXMath.h>
+#include <DirectXColors.h>
+#include <DirectXCollision.h>
+#include <DirectXPackedVector.h>
+
+#include <string>
+
+// The few Windows types the portable sources use. GeometryPacker tags index
+// streams with DXGI_FORMAT; only the two index formats are needed.
+#ifdef _WIN32
+#include <dxgiformat.h>
+#else
+typedef unsigned int UINT;
+typedef int INT;
+
+enum DXGI_FORMAT
+{
+    DXGI_FORMAT_UNKNOWN = 0,
+    DXGI_FORMAT_R32_UINT = 42,
+    DXGI_FORMAT_R16_UINT = 57
+};
+#endif
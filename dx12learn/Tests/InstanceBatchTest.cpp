@@ -0,0 +1,169 @@
+#include "TestUtil.h"
+#include "../InstanceBatch.h"
+
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // Reads the instances of a mesh_instance entry placed at world (1, 2, 3) with scale 2.
+    std::vector<XMFLOAT4X4> Read(const std::string& entryJson)
+    {
+        simdjson::ondemand::parser parser;
+        simdjson::padded_string json(entryJson);
+        simdjson::ondemand::document document = parser.iterate(json);
+        simdjson::ondemand::object entry = document.get_object().value();
+
+        std::vector<XMFLOAT4X4> worlds;
+        InstanceBatch::ReadInstances(entry, XMFLOAT3(1.0f, 2.0f, 3.0f), XMFLOAT3(2.0f, 2.0f, 2.0f), XMFLOAT3(0.0f, 0.0f, 0.0f), worlds);
+        return worlds;
+    }
+
+    void CheckSame(const XMFLOAT4X4& a, XMMATRIX expected)
+    {
+        XMFLOAT4X4 b;
+        XMStoreFloat4x4(&b, expected);
+        for(int r = 0; r < 4; ++r)
+        {
+            for(int c = 0; c < 4; ++c)
+            {
+                CHECK_NEAR(a.m[r][c], b.m[r][c], 1e-6);
+            }
+        }
+    }
+
+    void CheckTranslation(const XMFLOAT4X4& world, float x, float y, float z)
+    {
+        CHECK(world._41 == x && world._42 == y && world._43 == z);
+    }
+
+    void TestInstanceList()
+    {
+        std::vector<XMFLOAT4X4> worlds = Read(
+            "{ \"name\": \"sphere\", \"instances\": [ { \"world\": [5, 0, 0] }, "
+            "{ \"scale\": [1, 1, 1], \"euler\": [0, 1.5, 0] }, {} ] }");
+        CHECK(worlds.size() == 3);
+
+        // every field the instance leaves out comes from the entry
+        CheckSame(worlds[0], MathHelper::MakeWorld(XMFLOAT3(5.0f, 0.0f, 0.0f), XMFLOAT3(2.0f, 2.0f, 2.0f), XMFLOAT3(0.0f, 0.0f, 0.0f)));
+        CheckSame(worlds[1], MathHelper::MakeWorld(XMFLOAT3(1.0f, 2.0f, 3.0f), XMFLOAT3(1.0f, 1.0f, 1.0f), XMFLOAT3(0.0f, 1.5f, 0.0f)));
+        CheckSame(worlds[2], MathHelper::MakeWorld(XMFLOAT3(1.0f, 2.0f, 3.0f), XMFLOAT3(2.0f, 2.0f, 2.0f), XMFLOAT3(0.0f, 0.0f, 0.0f)));
+
+        CHECK(Read("{ \"name\": \"sphere\" }").empty());
+        CHECK(Read("{ \"name\": \"sphere\", \"instances\": [] }").empty());
+    }
+
+    void TestGrid()
+    {
+        std::vector<XMFLOAT4X4> worlds = Read("{ \"grid\": { \"count\": [2, 3, 2], \"spacing\": [1, 2, 4] } }");
+        CHECK(worlds.size() == 12);
+
+        // z fastest, x slowest, starting at the entry's world position
+        size_t i = 0;
+        for(int x = 0; x < 2; ++x)
+        {
+            for(int y = 0; y < 3; ++y)
+            {
+                for(int z = 0; z < 2; ++z)
+                {
+                    CheckTranslation(worlds[i], 1.0f + x, 2.0f + 2.0f * y, 3.0f + 4.0f * z);
+                    CHECK(worlds[i]._11 == 2.0f && worlds[i]._22 == 2.0f && worlds[i]._33 == 2.0f);
+                    ++i;
+                }
+            }
+        }
+
+        // count and spacing default to 1, a zero count places nothing
+        worlds = Read("{ \"grid\": { \"count\": [3, 1, 1] } }");
+        CHECK(worlds.size() == 3);
+        CheckTranslation(worlds[2], 3.0f, 2.0f, 3.0f);
+        CHECK(Read("{ \"grid\": {} }").size() == 1);
+        CHECK(Read("{ \"grid\": { \"count\": [4, 0, 4] } }").empty());
+
+        // the list comes first, then the grid, whatever order the json has them in
+        worlds = Read("{ \"grid\": { \"count\": [2, 1, 1] }, \"instances\": [ { \"world\": [9, 9, 9] } ] }");
+        CHECK(worlds.size() == 3);
+        CheckTranslation(worlds[0], 9.0f, 9.0f, 9.0f);
+        CheckTranslation(worlds[1], 1.0f, 2.0f, 3.0f);
+        CheckTranslation(worlds[2], 2.0f, 2.0f, 3.0f);
+    }
+
+    void TestPlace()
+    {
+        std::vector<XMFLOAT4X4> worlds(3);
+        XMStoreFloat4x4(&worlds[0], XMMatrixTranslation(10.0f, 0.0f, 0.0f));
+        XMStoreFloat4x4(&worlds[1], XMMatrixMultiply(XMMatrixScaling(2.0f, 2.0f, 2.0f), XMMatrixTranslation(0.0f, -5.0f, 0.0f)));
+        XMStoreFloat4x4(&worlds[2], XMMatrixTranslation(0.0f, 0.0f, 20.0f));
+
+        // boxes of earlier items stay in front
+        std::vector<BoundingBox> instanceBounds(2);
+        std::vector<InstanceData> instances;
+        BoundingBox meshBounds(XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f));
+        BoundingBox bounds = InstanceBatch::Place(meshBounds, worlds, instances, instanceBounds);
+
+        // the vertex shader reads the matrices transposed
+        CHECK(instances.size() == 3);
+        for(size_t k = 0; k < 3; ++k)
+        {
+            CheckSame(instances[k].World, XMMatrixTranspose(XMLoadFloat4x4(&worlds[k])));
+        }
+        CHECK(instances[0].World._14 == 10.0f && instances[2].World._34 == 20.0f);
+
+        CHECK(instanceBounds.size() == 5);
+        CHECK(instanceBounds[2].Center.x == 10.0f && instanceBounds[2].Center.y == 1.0f);
+        CHECK(instanceBounds[3].Center.y == -3.0f && instanceBounds[3].Extents.x == 2.0f);
+        CHECK(instanceBounds[4].Center.z == 20.0f && instanceBounds[4].Extents.z == 1.0f);
+
+        // x from -2 to 11, y from -5 to 2, z from -2 to 21
+        CHECK_NEAR(bounds.Center.x, 4.5, 1e-5);
+        CHECK_NEAR(bounds.Extents.x, 6.5, 1e-5);
+        CHECK_NEAR(bounds.Center.y, -1.5, 1e-5);
+        CHECK_NEAR(bounds.Extents.y, 3.5, 1e-5);
+        CHECK_NEAR(bounds.Center.z, 9.5, 1e-5);
+        CHECK_NEAR(bounds.Extents.z, 11.5, 1e-5);
+    }
+
+    void TestPackVisible()
+    {
+        std::vector<InstanceData> instances(7);
+        for(size_t k = 0; k < instances.size(); ++k)
+        {
+            instances[k].World._14 = (float)k;
+        }
+
+        // Two items share the buffer; the second starts where the first ended.
+        const std::uint8_t visible[] = { 1, 0, 0, 1, 1, 0, 1 };
+        const std::uint8_t secondVisible[] = { 0, 1, 0, 0, 0, 0, 1 };
+        std::vector<InstanceData> buffer(16);
+        buffer[6].World._14 = -1.0f;
+
+        UINT count = InstanceBatch::PackVisible(instances, visible, buffer.data());
+        CHECK(count == 4);
+        UINT secondCount = InstanceBatch::PackVisible(instances, secondVisible, buffer.data() + count);
+        CHECK(secondCount == 2);
+
+        const float expected[] = { 0.0f, 3.0f, 4.0f, 6.0f, 1.0f, 6.0f };
+        for(int i = 0; i < 6; ++i)
+        {
+            CHECK(buffer[i].World._14 == expected[i]);
+        }
+        // nothing is written past the visible ones
+        CHECK(buffer[6].World._14 == -1.0f);
+
+        const std::uint8_t hidden[7] = {};
+        CHECK(InstanceBatch::PackVisible(instances, hidden, buffer.data() + 6) == 0);
+        CHECK(buffer[6].World._14 == -1.0f);
+    }
+}
+
+int main()
+{
+    TestInstanceList();
+    TestGrid();
+    TestPlace();
+    TestPackVisible();
+    std::printf("InstanceBatchTest passed\n");
+    return 0;
+}
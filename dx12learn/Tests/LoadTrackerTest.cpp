@@ -0,0 +1,209 @@
+#include "TestUtil.h"
+#include "../LoadTracker.h"
+#include "../ThreadPool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    // Stands in for the device TextureLoader creates textures on. CreateTexture
+    // blocks until the test lets it through, so the test decides when loads finish.
+    class FakeDevice
+    {
+    public:
+        // Returns false for names starting with "missing", like a failed load.
+        bool CreateTexture(const std::string& name)
+        {
+            std::unique_lock<std::mutex> lock(Mutex);
+            Released.wait(lock, [this]() { return Permits > 0; });
+            Permits--;
+            Created++;
+            return name.compare(0, 7, "missing") != 0;
+        }
+
+        // Lets count more CreateTexture calls return.
+        void Allow(int count)
+        {
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                Permits += count;
+            }
+            Released.notify_all();
+        }
+
+        int GetCreatedCount()
+        {
+            std::lock_guard<std::mutex> lock(Mutex);
+            return Created;
+        }
+
+    private:
+        std::mutex Mutex;
+        std::condition_variable Released;
+        int Permits = 0;
+        int Created = 0;
+    };
+
+    // What a load hands back to the caller, written without synchronization: the
+    // tracker's completion flags are what make it visible.
+    struct FakeTexture
+    {
+        std::string Name;
+        int Width = 0;
+        bool Succeeded = false;
+    };
+
+    size_t StartLoad(LoadTracker& loads, FakeDevice& device, FakeTexture& texture)
+    {
+        return loads.Start([&device, &texture]()
+        {
+            texture.Succeeded = device.CreateTexture(texture.Name);
+            texture.Width = texture.Succeeded ? (int)texture.Name.size() : 0;
+        });
+    }
+
+    void WaitForCompletedCount(const LoadTracker& loads, size_t count)
+    {
+        while(loads.GetCompletedCount() < count)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    void TestCompletionCount(ThreadPool& pool)
+    {
+        FakeDevice device;
+        LoadTracker loads(pool);
+        CHECK(loads.GetCount() == 0);
+        CHECK(loads.IsComplete());
+
+        const size_t count = 24;
+        std::vector<FakeTexture> textures(count);
+        for(size_t i = 0; i < count; ++i)
+        {
+            textures[i].Name = (i % 5 == 3 ? "missing" : "texture") + std::to_string(i);
+            CHECK(StartLoad(loads, device, textures[i]) == i);
+        }
+        CHECK(loads.GetCount() == count);
+        CHECK(loads.GetCompletedCount() == 0);
+        CHECK(!loads.IsComplete());
+
+        // One load at a time: the count follows exactly, and every load reported
+        // complete has its results visible.
+        for(size_t finished = 1; finished <= count; ++finished)
+        {
+            device.Allow(1);
+            WaitForCompletedCount(loads, finished);
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            CHECK(loads.GetCompletedCount() == finished);
+            CHECK(loads.IsComplete() == (finished == count));
+
+            size_t complete = 0;
+            for(size_t i = 0; i < count; ++i)
+            {
+                if(loads.IsComplete(i))
+                {
+                    complete++;
+                    bool missing = textures[i].Name.compare(0, 7, "missing") == 0;
+                    CHECK(textures[i].Succeeded == !missing);
+                    CHECK(textures[i].Width == (missing ? 0 : (int)textures[i].Name.size()));
+                }
+            }
+            CHECK(complete == finished);
+        }
+        CHECK(device.GetCreatedCount() == (int)count);
+    }
+
+    void TestWait(ThreadPool& pool)
+    {
+        FakeDevice device;
+        LoadTracker loads(pool);
+        loads.Wait();
+
+        std::vector<FakeTexture> textures(8);
+        for(size_t i = 0; i < textures.size(); ++i)
+        {
+            textures[i].Name = "texture" + std::to_string(i);
+            StartLoad(loads, device, textures[i]);
+        }
+
+        // Wait blocks while any load is still running.
+        std::atomic<bool> waited{ false };
+        std::thread waiter([&]()
+        {
+            loads.Wait();
+            waited.store(true);
+        });
+        device.Allow((int)textures.size() - 1);
+        WaitForCompletedCount(loads, textures.size() - 1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        CHECK(!waited.load());
+        CHECK(!loads.IsComplete());
+
+        device.Allow(1);
+        waiter.join();
+        CHECK(waited.load());
+        CHECK(loads.IsComplete());
+        for(size_t i = 0; i < textures.size(); ++i)
+        {
+            CHECK(loads.IsComplete(i) && textures[i].Succeeded);
+        }
+
+        // loads started after a Wait are counted on top
+        FakeTexture late;
+        late.Name = "missing late";
+        CHECK(StartLoad(loads, device, late) == textures.size());
+        CHECK(!loads.IsComplete());
+        CHECK(!loads.IsComplete(textures.size()));
+        device.Allow(1);
+        loads.Wait();
+        CHECK(loads.GetCompletedCount() == textures.size() + 1);
+        CHECK(loads.IsComplete(textures.size()) && !late.Succeeded);
+    }
+
+    void TestDestructorWaits(ThreadPool& pool)
+    {
+        FakeDevice device;
+        std::vector<FakeTexture> textures(6);
+        std::thread releaser;
+        {
+            LoadTracker loads(pool);
+            for(FakeTexture& texture : textures)
+            {
+                texture.Name = "texture";
+                StartLoad(loads, device, texture);
+            }
+            releaser = std::thread([&]()
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                device.Allow((int)textures.size());
+            });
+        }
+        // the tracker is gone only after every load returned
+        CHECK(device.GetCreatedCount() == (int)textures.size());
+        for(const FakeTexture& texture : textures)
+        {
+            CHECK(texture.Succeeded);
+        }
+        releaser.join();
+    }
+}
+
+int main()
+{
+    for(unsigned threadCount : { 1u, 3u, 8u })
+    {
+        ThreadPool pool(threadCount);
+        TestCompletionCount(pool);
+        TestWait(pool);
+        TestDestructorWaits(pool);
+    }
+    std::printf("LoadTrackerTest passed\n");
+    return 0;
+}
@@ -0,0 +1,171 @@
+#include "TestUtil.h"
+#include "../MeshBuilder/MeshObjBuilder.h"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+namespace
+{
+    // MeshObjBuilder reads files only; the obj text goes to a file in the working directory.
+    MeshBuilder::MeshData Build(const std::string& text, const MeshObjBuilder::WeldOptions& options, MeshObjBuilder::WeldStats& stats)
+    {
+        const char* path = "MeshObjBuilderTest.wobj";
+        {
+            std::ofstream file(path, std::ios::binary);
+            file << text;
+        }
+        MeshObjBuilder builder;
+        MeshBuilder::MeshData mesh = builder.BuildByObjFile(path, options, &stats);
+        std::remove(path);
+        return mesh;
+    }
+
+    void TestIdenticalTriplesCollapse()
+    {
+        MeshObjBuilder::WeldStats stats;
+        MeshBuilder::MeshData mesh = Build(
+            "v 0 0 0\n"
+            "v 1 0 0\n"
+            "v 1 1 0\n"
+            "v 0 1 0\n"
+            "vt 0 0\n"
+            "vt 1 0\n"
+            "vt 1 1\n"
+            "vt 0 1\n"
+            "vn 0 0 1\n"
+            "f 1/1/1 2/2/1 3/3/1\n"
+            "f 1/1/1 3/3/1 4/4/1\n", MeshObjBuilder::WeldOptions(), stats);
+
+        CHECK(stats.CornerCount == 6);
+        CHECK(stats.VertexCount == 4);
+        CHECK(mesh.Vertices.size() == 4);
+        CHECK(mesh.Indices32.size() == 6);
+        // the shared edge 1-3 is referenced by both triangles
+        CHECK(mesh.Indices32[3] == mesh.Indices32[0]);
+        CHECK(mesh.Indices32[4] == mesh.Indices32[2]);
+        CHECK(mesh.Indices32[5] == 3);
+        CHECK_NEAR(mesh.Vertices[mesh.Indices32[5]].TexC.y, 1.0, 0.0);
+        CHECK_NEAR(stats.GetUniqueRatio(), 4.0 / 6.0, 1e-6);
+    }
+
+    void TestSeamsStaySplit()
+    {
+        MeshObjBuilder::WeldStats stats;
+        MeshBuilder::MeshData mesh = Build(
+            "v 0 0 0\n"
+            "v 1 0 0\n"
+            "v 0 1 0\n"
+            "vt 0 0\n"
+            "vt 0.5 0\n"
+            "vn 0 0 1\n"
+            "vn 0 0 -1\n"
+            // same positions, once with another uv on vertex 1 and once with another normal
+            "f 1/1/1 2/1/1 3/1/1\n"
+            "f 1/2/1 2/1/1 3/1/1\n"
+            "f 1/1/2 2/1/1 3/1/1\n", MeshObjBuilder::WeldOptions(), stats);
+
+        CHECK(stats.CornerCount == 9);
+        CHECK(stats.VertexCount == 5);
+        CHECK(mesh.Indices32[0] != mesh.Indices32[3]);
+        CHECK(mesh.Indices32[0] != mesh.Indices32[6]);
+        CHECK(mesh.Indices32[3] != mesh.Indices32[6]);
+        CHECK(mesh.Indices32[1] == mesh.Indices32[4] && mesh.Indices32[1] == mesh.Indices32[7]);
+        CHECK(mesh.Indices32[2] == mesh.Indices32[5] && mesh.Indices32[2] == mesh.Indices32[8]);
+        CHECK_NEAR(mesh.Vertices[mesh.Indices32[3]].TexC.x, 0.5, 0.0);
+        CHECK_NEAR(mesh.Vertices[mesh.Indices32[6]].Normal.z, -1.0, 0.0);
+    }
+
+    void TestEpsilonWeld()
+    {
+        // Near-duplicate positions, as some exporters write them: vertices 4 and 5
+        // are within 1e-5 of 1 and 3, vertex 6 is 0.1 away from everything.
+        const std::string text =
+            "v 0 0 0\n"
+            "v 1 0 0\n"
+            "v 1 1 0\n"
+            "v 0.00001 0 0\n"
+            "v 1 1.00001 0\n"
+            "v 0 1.1 0\n"
+            "vt 0 0\n"
+            "vn 0 0 1\n"
+            "f 1/1/1 2/1/1 3/1/1\n"
+            "f 4/1/1 3/1/1 6/1/1\n"
+            "f 4/1/1 5/1/1 6/1/1\n";
+
+        MeshObjBuilder::WeldStats exactStats;
+        MeshBuilder::MeshData exact = Build(text, MeshObjBuilder::WeldOptions(), exactStats);
+        CHECK(exactStats.CornerCount == 9);
+        CHECK(exactStats.VertexCount == 6);
+        CHECK(exact.Vertices.size() == 6);
+
+        MeshObjBuilder::WeldOptions options;
+        options.Epsilon = 1e-3f;
+        MeshObjBuilder::WeldStats stats;
+        MeshBuilder::MeshData mesh = Build(text, options, stats);
+        CHECK(stats.CornerCount == 9);
+        CHECK(stats.VertexCount == 4);
+        CHECK(mesh.Vertices.size() == 4);
+        CHECK(mesh.Indices32.size() == 9);
+        // 4 onto 1, 5 onto 3, 6 stays apart
+        CHECK(mesh.Indices32[3] == mesh.Indices32[0]);
+        CHECK(mesh.Indices32[6] == mesh.Indices32[0]);
+        CHECK(mesh.Indices32[7] == mesh.Indices32[2]);
+        CHECK(mesh.Indices32[5] == mesh.Indices32[8]);
+        CHECK(mesh.Indices32[5] != mesh.Indices32[2]);
+        for(MeshBuilder::uint32 index : mesh.Indices32)
+        {
+            CHECK(index < mesh.Vertices.size());
+        }
+    }
+
+    void TestEpsilonWeldLargeCoordinates()
+    {
+        // With epsilon 1e-6 these are billions of epsilons from the origin, beyond 32-bit
+        // keys. Only the repeated 3000 and -3000 lines are the same position.
+        const std::string text =
+            "v 2500 0 0\n"
+            "v 3000 0 0\n"
+            "v 3000 4000 0\n"
+            "v 3000 0 0\n"
+            "v -3000 -4000 0\n"
+            "v -3000 -4000 0\n"
+            "v 1e30 0 0\n"
+            "v 2e30 0 0\n"
+            "vt 0 0\n"
+            "vn 0 0 1\n"
+            "f 1/1/1 2/1/1 3/1/1\n"
+            "f 4/1/1 3/1/1 5/1/1\n"
+            "f 6/1/1 7/1/1 8/1/1\n";
+
+        MeshObjBuilder::WeldOptions options;
+        options.Epsilon = 1e-6f;
+        MeshObjBuilder::WeldStats stats;
+        MeshBuilder::MeshData mesh = Build(text, options, stats);
+        CHECK(stats.CornerCount == 9);
+        CHECK(mesh.Indices32.size() == 9);
+        // 4 onto 2, 6 onto 5
+        CHECK(mesh.Indices32[3] == mesh.Indices32[1]);
+        CHECK(mesh.Indices32[6] == mesh.Indices32[5]);
+        CHECK(mesh.Indices32[0] != mesh.Indices32[1]);
+        CHECK(mesh.Indices32[1] != mesh.Indices32[2]);
+        CHECK(mesh.Indices32[0] != mesh.Indices32[2]);
+        CHECK(mesh.Indices32[5] != mesh.Indices32[0] && mesh.Indices32[5] != mesh.Indices32[2]);
+        // 1e30 and 2e30 are past the clamp, so they share a key instead of overflowing it
+        CHECK(mesh.Indices32[7] == mesh.Indices32[8]);
+        CHECK(stats.VertexCount == 5);
+        CHECK(mesh.Vertices.size() == 5);
+        CHECK_NEAR(mesh.Vertices[mesh.Indices32[0]].Position.x, 2500.0, 0.0);
+        CHECK_NEAR(mesh.Vertices[mesh.Indices32[2]].Position.y, 4000.0, 0.0);
+    }
+}
+
+int main()
+{
+    TestIdenticalTriplesCollapse();
+    TestSeamsStaySplit();
+    TestEpsilonWeld();
+    TestEpsilonWeldLargeCoordinates();
+    std::printf("MeshObjBuilderTest passed\n");
+    return 0;
+}
@@ -0,0 +1,83 @@
+// Builds every mesh of a scene the way the application does and reports what
+// the vertex cache optimizer did to it. Fails if a mesh got worse.
+//
+//   MeshOptimizerTest [scene.json]   (default Assets/Data/scene.json)
+//
+// Relative obj paths in the scene are resolved against the dx12learn directory.
+#include "TestUtil.h"
+#include "../MeshBuilder/MeshBuildTask.h"
+
+#include <string>
+#include <vector>
+
+namespace
+{
+    void CheckIndices(const std::vector<std::uint32_t>& indices, size_t vertexCount)
+    {
+        CHECK(indices.size() % 3 == 0);
+        for(std::uint32_t index : indices)
+        {
+            CHECK(index < vertexCount);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::string engineDir = ENGINE_DIR;
+    std::string scenePath = argc > 1 ? argv[1] : engineDir + "/Assets/Data/scene.json";
+
+    simdjson::ondemand::parser parser;
+    simdjson::padded_string json;
+    CHECK(!simdjson::padded_string::load(scenePath).get(json));
+    simdjson::ondemand::document scene = parser.iterate(json);
+
+    std::vector<MeshBuildTask> tasks;
+    for(auto element : scene["mesh"].get_array())
+    {
+        simdjson::ondemand::object object = element.get_object().value();
+        tasks.push_back(MeshBuildTask::FromJson(object));
+        if(!tasks.back().Path.empty() && tasks.back().Path[0] == '.')
+        {
+            tasks.back().Path = engineDir + "/" + tasks.back().Path;
+        }
+    }
+    CHECK(!tasks.empty());
+
+    std::printf("%-12s %10s %16s %16s  %s\n", "mesh", "triangles", "ACMR", "ATVR", "LOD triangles");
+    for(const MeshBuildTask& task : tasks)
+    {
+        MeshBuildTask::BuildStats stats;
+        MeshBuilder::MeshData mesh = task.Build(&stats);
+
+        std::string lods;
+        for(std::uint32_t count : stats.LodTriangleCounts)
+        {
+            lods += std::to_string(count) + " ";
+        }
+        std::printf("%-12s %10u %7.3f -> %5.3f %7.3f -> %5.3f  %s\n", task.Name.c_str(),
+            stats.CacheAfter.TriangleCount,
+            stats.CacheBefore.GetACMR(), stats.CacheAfter.GetACMR(),
+            stats.CacheBefore.GetATVR(), stats.CacheAfter.GetATVR(),
+            lods.c_str());
+
+        CHECK(!mesh.Indices32.empty());
+        CheckIndices(mesh.Indices32, mesh.Vertices.size());
+        for(const std::vector<std::uint32_t>& lod : mesh.LodIndices32)
+        {
+            CheckIndices(lod, mesh.Vertices.size());
+        }
+        CHECK(stats.LodTriangleCounts.size() == mesh.LodIndices32.size() + 1);
+
+        if(task.Optimize)
+        {
+            // Reordering never adds or drops triangles, and must not make the cache behave worse.
+            CHECK(stats.CacheAfter.TriangleCount == stats.CacheBefore.TriangleCount);
+            CHECK(stats.CacheAfter.GetACMR() <= stats.CacheBefore.GetACMR() + 1e-4f);
+            CHECK(stats.CacheAfter.GetATVR() >= 1.0f);
+            CHECK(stats.CacheAfter.GetACMR() >= 0.5f || stats.CacheAfter.TriangleCount < 2);
+        }
+    }
+    std::printf("MeshOptimizerTest passed\n");
+    return 0;
+}
@@ -0,0 +1,285 @@
+#include "TestUtil.h"
+#include "../MeshBuilder/MeshGridBuilder.h"
+#include "../MeshBuilder/MeshSimplifier.h"
+#include "../MeshBuilder/MeshSphereBuilder.h"
+
+#include <cstdint>
+#include <map>
+#include <vector>
+
+namespace
+{
+    using uint32 = std::uint32_t;
+    using uint64 = std::uint64_t;
+
+    const float GridSize = 8.0f;
+    const uint32 GridVertexCount = 33;
+    const uint32 SeamColumn = 16;
+
+    uint64 EdgeKey(uint32 a, uint32 b)
+    {
+        return a < b ? ((uint64)a << 32) | b : ((uint64)b << 32) | a;
+    }
+
+    std::map<uint64, int> CountEdges(const std::vector<uint32>& indices)
+    {
+        std::map<uint64, int> edges;
+        for(size_t i = 0; i < indices.size(); i += 3)
+        {
+            for(int k = 0; k < 3; ++k)
+            {
+                ++edges[EdgeKey(indices[i + k], indices[i + (k + 1) % 3])];
+            }
+        }
+        return edges;
+    }
+
+    std::vector<bool> FindReferenced(const std::vector<uint32>& indices, size_t vertexCount)
+    {
+        std::vector<bool> referenced(vertexCount, false);
+        for(uint32 index : indices)
+        {
+            referenced[index] = true;
+        }
+        return referenced;
+    }
+
+    // Vertices on an edge only one triangle uses.
+    std::vector<bool> FindBorder(const std::vector<uint32>& indices, size_t vertexCount)
+    {
+        std::vector<bool> border(vertexCount, false);
+        for(const auto& edge : CountEdges(indices))
+        {
+            if(edge.second == 1)
+            {
+                border[(uint32)(edge.first >> 32)] = true;
+                border[(uint32)(edge.first & 0xffffffff)] = true;
+            }
+        }
+        return border;
+    }
+
+    // Vertices that share their position with a vertex of different attributes.
+    std::vector<bool> FindSeams(const std::vector<MeshBuilder::Vertex>& vertices)
+    {
+        std::vector<bool> seams(vertices.size(), false);
+        for(size_t i = 0; i < vertices.size(); ++i)
+        {
+            for(size_t j = i + 1; j < vertices.size(); ++j)
+            {
+                const MeshBuilder::Vertex& a = vertices[i];
+                const MeshBuilder::Vertex& b = vertices[j];
+                bool samePosition = a.Position.x == b.Position.x && a.Position.y == b.Position.y && a.Position.z == b.Position.z;
+                bool sameTexC = a.TexC.x == b.TexC.x && a.TexC.y == b.TexC.y;
+                if(samePosition && !sameTexC)
+                {
+                    seams[i] = seams[j] = true;
+                }
+            }
+        }
+        return seams;
+    }
+
+    size_t CountTrue(const std::vector<bool>& flags)
+    {
+        size_t count = 0;
+        for(bool flag : flags)
+        {
+            count += flag ? 1 : 0;
+        }
+        return count;
+    }
+
+    // Checks a level simplified from source: it only drops vertices, keeps every seam
+    // vertex, and no vertex enters or leaves an open border.
+    void CheckLod(const MeshBuilder::MeshData& mesh, const std::vector<uint32>& source, const std::vector<uint32>& lod)
+    {
+        const size_t vertexCount = mesh.Vertices.size();
+        CHECK(lod.size() % 3 == 0);
+        CHECK(lod.size() <= source.size());
+        for(size_t i = 0; i < lod.size(); i += 3)
+        {
+            CHECK(lod[i] != lod[i + 1] && lod[i + 1] != lod[i + 2] && lod[i] != lod[i + 2]);
+        }
+
+        std::vector<bool> sourceVertices = FindReferenced(source, vertexCount);
+        std::vector<bool> lodVertices = FindReferenced(lod, vertexCount);
+        std::vector<bool> seams = FindSeams(mesh.Vertices);
+        std::vector<bool> sourceBorder = FindBorder(source, vertexCount);
+        std::vector<bool> lodBorder = FindBorder(lod, vertexCount);
+        for(size_t v = 0; v < vertexCount; ++v)
+        {
+            CHECK(!lodVertices[v] || sourceVertices[v]);
+            CHECK(!seams[v] || !sourceVertices[v] || lodVertices[v]);
+            CHECK(!lodVertices[v] || lodBorder[v] == sourceBorder[v]);
+        }
+    }
+
+    // A grid split into two texture charts at SeamColumn: everything right of it has u
+    // shifted by one, and its triangles use copies of the column's vertices, so the
+    // column is a UV seam.
+    MeshBuilder::MeshData BuildSeamGrid()
+    {
+        GridBuilder builder;
+        MeshBuilder::MeshData mesh = builder.BuildGrid(GridSize, GridSize, GridVertexCount, GridVertexCount);
+        for(uint32 v = 0; v < (uint32)mesh.Vertices.size(); ++v)
+        {
+            if(v % GridVertexCount > SeamColumn)
+            {
+                mesh.Vertices[v].TexC.x += 1.0f;
+            }
+        }
+
+        const uint32 firstCopy = (uint32)mesh.Vertices.size();
+        for(uint32 row = 0; row < GridVertexCount; ++row)
+        {
+            MeshBuilder::Vertex copy = mesh.Vertices[row * GridVertexCount + SeamColumn];
+            copy.TexC.x += 1.0f;
+            mesh.Vertices.push_back(copy);
+        }
+        for(size_t i = 0; i < mesh.Indices32.size(); i += 3)
+        {
+            uint32* tri = &mesh.Indices32[i];
+            bool rightOfSeam = tri[0] % GridVertexCount > SeamColumn || tri[1] % GridVertexCount > SeamColumn || tri[2] % GridVertexCount > SeamColumn;
+            for(int k = 0; k < 3 && rightOfSeam; ++k)
+            {
+                if(tri[k] % GridVertexCount == SeamColumn)
+                {
+                    tri[k] = firstCopy + tri[k] / GridVertexCount;
+                }
+            }
+        }
+        return mesh;
+    }
+
+    // Every open edge of the grid lies on its outline or on the seam, and together they
+    // are as long as the outline plus both sides of the seam: no corner was cut off.
+    void CheckGridOutline(const MeshBuilder::MeshData& mesh, const std::vector<uint32>& indices)
+    {
+        const float half = 0.5f * GridSize;
+        const float seamX = mesh.Vertices[SeamColumn].Position.x;
+        double length = 0.0;
+        for(const auto& edge : CountEdges(indices))
+        {
+            if(edge.second != 1)
+            {
+                continue;
+            }
+            const XMFLOAT3& a = mesh.Vertices[(uint32)(edge.first >> 32)].Position;
+            const XMFLOAT3& b = mesh.Vertices[(uint32)(edge.first & 0xffffffff)].Position;
+            bool onOutline =
+                (a.x == -half && b.x == -half) || (a.x == half && b.x == half) ||
+                (a.z == -half && b.z == -half) || (a.z == half && b.z == half);
+            bool onSeam = a.x == seamX && b.x == seamX;
+            CHECK(onOutline || onSeam);
+            length += std::sqrt((double)(b.x - a.x) * (b.x - a.x) + (double)(b.z - a.z) * (b.z - a.z));
+        }
+        CHECK_NEAR(length, 4.0 * GridSize + 2.0 * GridSize, 1e-3);
+    }
+
+    void TestGridSeam()
+    {
+        MeshBuilder::MeshData mesh = BuildSeamGrid();
+        const size_t triangleCount = mesh.Indices32.size() / 3;
+        CHECK(CountTrue(FindSeams(mesh.Vertices)) == 2 * GridVertexCount);
+        CheckGridOutline(mesh, mesh.Indices32);
+
+        // The grid is flat, so every ratio is reached without error, down to what the
+        // seam and the outline leave.
+        std::vector<uint32> previous = mesh.Indices32;
+        for(float ratio : { 0.5f, 0.25f, 0.1f })
+        {
+            const size_t target = (size_t)(triangleCount * ratio) * 3;
+            float error = -1.0f;
+            std::vector<uint32> lod = MeshSimplifier::Simplify(mesh.Vertices, mesh.Indices32, target, 0.01f, &error);
+            CHECK(lod.size() <= target);
+            CHECK_NEAR(error, 0.0, 1e-3);
+            CheckLod(mesh, mesh.Indices32, lod);
+            CheckGridOutline(mesh, lod);
+
+            // a coarser target never keeps more triangles
+            CHECK(lod.size() <= previous.size());
+            previous = lod;
+        }
+
+        // Far below what the seam and the outline allow: collapsing a corner along a side
+        // costs more than the bound, so it stops there, with both intact.
+        float error = -1.0f;
+        std::vector<uint32> lod = MeshSimplifier::Simplify(mesh.Vertices, mesh.Indices32, 0, 0.01f, &error);
+        CHECK(!lod.empty());
+        CHECK(error >= 0.0f && error <= 0.01f);
+        CheckLod(mesh, mesh.Indices32, lod);
+        CheckGridOutline(mesh, lod);
+
+        // A loose enough bound does cut corners, which is what the bound is there to prevent.
+        std::vector<uint32> loose = MeshSimplifier::Simplify(mesh.Vertices, mesh.Indices32, 0, 1.0f, &error);
+        CHECK(loose.size() < lod.size());
+        CHECK(error > 0.01f && error <= 1.0f);
+    }
+
+    void TestSphereLods()
+    {
+        SphereBuilder builder;
+        MeshBuilder::MeshData mesh = builder.BuildSphere(2.0f, 32, 16);
+        const std::vector<uint32> full = mesh.Indices32;
+        const size_t triangleCount = full.size() / 3;
+
+        // With a generous error bound every level reaches its ratio, each one simplified
+        // from the previous, so the chain is monotonic and only ever drops vertices.
+        const std::vector<float> ratios = { 1.0f, 0.5f, 0.25f, 0.1f };
+        MeshSimplifier::BuildLods(mesh, ratios, 1.0f);
+        CHECK(mesh.Indices32 == full);
+        CHECK(mesh.LodIndices32.size() == ratios.size() - 1);
+        const std::vector<uint32>* previous = &mesh.Indices32;
+        for(size_t level = 0; level < mesh.LodIndices32.size(); ++level)
+        {
+            const std::vector<uint32>& lod = mesh.LodIndices32[level];
+            CHECK(lod.size() <= (size_t)(triangleCount * ratios[level + 1]) * 3);
+            CHECK(lod.size() >= triangleCount * ratios[level + 1] * 3 / 2);
+            CheckLod(mesh, *previous, lod);
+            previous = &lod;
+        }
+
+        // A ratio below 1 for the first entry simplifies the base level too.
+        MeshBuilder::MeshData reduced = builder.BuildSphere(2.0f, 32, 16);
+        MeshSimplifier::BuildLods(reduced, { 0.5f, 0.25f }, 1.0f);
+        CHECK(reduced.Indices32.size() <= (size_t)(triangleCount * 0.5f) * 3);
+        CHECK(reduced.LodIndices32.size() == 1);
+        CheckLod(reduced, full, reduced.Indices32);
+        CheckLod(reduced, reduced.Indices32, reduced.LodIndices32[0]);
+
+        // A tight bound stops short of the target, within the bound; loosening it gets further.
+        const size_t target = (size_t)(triangleCount * 0.1f) * 3;
+        float previousError = 0.0f;
+        size_t previousCount = full.size();
+        for(float maxError : { 0.002f, 0.01f, 0.05f })
+        {
+            float error = -1.0f;
+            std::vector<uint32> lod = MeshSimplifier::Simplify(mesh.Vertices, full, target, maxError, &error);
+            CHECK(error >= 0.0f && error <= maxError);
+            CHECK(error >= previousError);
+            CHECK(lod.size() <= previousCount);
+            CheckLod(mesh, full, lod);
+            if(maxError < 0.05f)
+            {
+                CHECK(lod.size() > target);
+            }
+            previousError = error;
+            previousCount = lod.size();
+        }
+        CHECK(previousCount < full.size());
+
+        // Already at or below the target: nothing to do.
+        float error = -1.0f;
+        CHECK(MeshSimplifier::Simplify(mesh.Vertices, full, full.size(), 0.0f, &error) == full);
+        CHECK(error == 0.0f);
+    }
+}
+
+int main()
+{
+    TestGridSeam();
+    TestSphereLods();
+    std::printf("MeshSimplifierTest passed\n");
+    return 0;
+}
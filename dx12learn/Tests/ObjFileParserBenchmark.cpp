@@ -0,0 +1,194 @@
+// Compares ObjFileParser against the istringstream loop MeshObjBuilder used
+// before it, on the teapot asset and on a large synthetic OBJ.
+//
+//   ObjFileParserBenchmark [face count]   (default 10000000)
+//
+// The synthetic file is written next to the executable on first use.
+#include "TestUtil.h"
+#include "../MappedFile.h"
+#include "../MeshBuilder/ObjFileParser.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct LegacyMesh
+    {
+        std::vector<XMFLOAT3> Positions;
+        std::vector<XMFLOAT3> Normals;
+        std::vector<XMFLOAT2> TexCoords;
+        std::vector<std::uint32_t> Indices;
+    };
+
+    // The line-by-line std::getline + std::istringstream reader ObjFileParser replaced,
+    // minus building the MeshData vertices.
+    bool LegacyParse(const std::string& filename, LegacyMesh& mesh)
+    {
+        std::ifstream fin(filename);
+        if(!fin)
+        {
+            return false;
+        }
+
+        std::string line;
+        while(std::getline(fin, line))
+        {
+            std::istringstream iss(line);
+            char trash;
+
+            if(!line.compare(0, 2, "v "))
+            {
+                iss >> trash;
+                XMFLOAT3 pos;
+                iss >> pos.x >> pos.y >> pos.z;
+                mesh.Positions.push_back(pos);
+            }
+            else if(!line.compare(0, 3, "vn "))
+            {
+                iss >> trash >> trash;
+                XMFLOAT3 normal;
+                iss >> normal.x >> normal.y >> normal.z;
+                mesh.Normals.push_back(normal);
+            }
+            else if(!line.compare(0, 3, "vt "))
+            {
+                iss >> trash >> trash;
+                XMFLOAT2 texcoord;
+                iss >> texcoord.x >> texcoord.y;
+                mesh.TexCoords.push_back(texcoord);
+            }
+            else if(!line.compare(0, 2, "f "))
+            {
+                iss >> trash;
+                std::array<std::uint32_t, 3> face = { 0, 0, 0 };
+                std::array<std::uint32_t, 3> normal = { 0, 0, 0 };
+                std::array<std::uint32_t, 3> texcoord = { 0, 0, 0 };
+                for(int i = 0; i < 3; i++)
+                {
+                    iss >> face[i];
+                    if(iss.peek() == '/')
+                    {
+                        iss >> trash;
+                        if(iss.peek() != '/')
+                        {
+                            iss >> texcoord[i];
+                        }
+                        iss >> trash;
+                        iss >> normal[i];
+                    }
+                }
+                mesh.Indices.push_back(face[0] - 1);
+                mesh.Indices.push_back(face[1] - 1);
+                mesh.Indices.push_back(face[2] - 1);
+            }
+        }
+        return true;
+    }
+
+    // Writes a height field of roughly faceCount triangles with v/vt/vn corners.
+    bool WriteSyntheticObj(const std::string& filename, size_t faceCount)
+    {
+        size_t side = (size_t)std::ceil(std::sqrt(faceCount / 2.0)) + 1;
+        FILE* file = std::fopen(filename.c_str(), "wb");
+        if(file == nullptr)
+        {
+            return false;
+        }
+
+        std::vector<char> buffer(1 << 20);
+        std::setvbuf(file, buffer.data(), _IOFBF, buffer.size());
+
+        std::fprintf(file, "# synthetic grid, %zu faces\ng grid\n", faceCount);
+        for(size_t z = 0; z < side; ++z)
+        {
+            for(size_t x = 0; x < side; ++x)
+            {
+                float height = 0.25f * std::sin(0.05f * x) * std::cos(0.07f * z);
+                std::fprintf(file, "v %.6f %.6f %.6f\n", x * 0.1f, height, z * 0.1f);
+            }
+        }
+        for(size_t z = 0; z < side; ++z)
+        {
+            for(size_t x = 0; x < side; ++x)
+            {
+                std::fprintf(file, "vt %.6f %.6f\n", (float)x / (side - 1), (float)z / (side - 1));
+            }
+        }
+        std::fprintf(file, "vn 0.000000 1.000000 0.000000\n");
+
+        size_t written = 0;
+        for(size_t z = 0; z + 1 < side && written < faceCount; ++z)
+        {
+            for(size_t x = 0; x + 1 < side && written < faceCount; ++x)
+            {
+                size_t a = z * side + x + 1;
+                size_t b = a + 1;
+                size_t c = a + side;
+                size_t d = c + 1;
+                std::fprintf(file, "f %zu/%zu/1 %zu/%zu/1 %zu/%zu/1\n", a, a, c, c, b, b);
+                if(++written < faceCount)
+                {
+                    std::fprintf(file, "f %zu/%zu/1 %zu/%zu/1 %zu/%zu/1\n", b, b, c, c, d, d);
+                    ++written;
+                }
+            }
+        }
+
+        return std::fclose(file) == 0;
+    }
+
+    void Compare(const char* label, const std::string& filename, int repeats)
+    {
+        MappedFile file;
+        if(!file.Open(filename))
+        {
+            std::printf("%s: cannot open %s\n", label, filename.c_str());
+            return;
+        }
+        double megabytes = file.Size() / (1024.0 * 1024.0);
+        file.Close();
+
+        double parserSeconds = 1e30;
+        double legacySeconds = 1e30;
+        size_t parserTriangles = 0;
+        size_t legacyTriangles = 0;
+        for(int i = 0; i < repeats; ++i)
+        {
+            ObjFileParser parser;
+            parserSeconds = (std::min)(parserSeconds, MeasureSeconds([&]() { parser.ParseFile(filename); }));
+            parserTriangles = parser.GetTriangleCount();
+
+            LegacyMesh mesh;
+            legacySeconds = (std::min)(legacySeconds, MeasureSeconds([&]() { LegacyParse(filename, mesh); }));
+            legacyTriangles = mesh.Indices.size() / 3;
+        }
+
+        std::printf("%s: %.1f MB, %zu triangles (legacy %zu)\n", label, megabytes, parserTriangles, legacyTriangles);
+        std::printf("  istringstream  %8.3f s  %8.1f MB/s\n", legacySeconds, megabytes / legacySeconds);
+        std::printf("  ObjFileParser  %8.3f s  %8.1f MB/s  (%.1fx)\n", parserSeconds, megabytes / parserSeconds,
+            legacySeconds / parserSeconds);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t faceCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10000000;
+
+    Compare("teapot.wobj", std::string(ENGINE_DIR) + "/Assets/Model/teapot.wobj", 5);
+
+    std::string synthetic = "synthetic_" + std::to_string(faceCount) + ".obj";
+    std::ifstream existing(synthetic);
+    if(!existing && !WriteSyntheticObj(synthetic, faceCount))
+    {
+        std::printf("cannot write %s\n", synthetic.c_str());
+        return 1;
+    }
+    Compare(synthetic.c_str(), synthetic, 1);
+    return 0;
+}
@@ -0,0 +1,109 @@
+#include "TestUtil.h"
+#include "../MeshBuilder/ObjFileParser.h"
+
+#include <cstring>
+#include <string>
+
+namespace
+{
+    bool Parse(ObjFileParser& parser, const std::string& text)
+    {
+        return parser.Parse(text.data(), text.data() + text.size());
+    }
+
+    void TestTriangulation()
+    {
+        ObjFileParser parser;
+        CHECK(Parse(parser,
+            "v 0 0 0\n"
+            "v 1 0 0\n"
+            "v 1 1 0\n"
+            "v 0 1 0\n"
+            "vt 0.5 0.25\n"
+            "vn 0 0 1\n"
+            "g quad\n"
+            "f 1/1/1 2/1/1 3/1/1 -1/-1/-1\n"));
+
+        CHECK(parser.Positions.size() == 4);
+        CHECK(parser.TexCoords.size() == 1);
+        CHECK(parser.Normals.size() == 1);
+        CHECK(parser.GetTriangleCount() == 2);
+        CHECK(parser.Corners[5].Position == 3);
+        CHECK(parser.Corners[5].TexCoord == 0);
+        CHECK(parser.Corners[5].Normal == 0);
+        CHECK(parser.Groups.size() == 1);
+        CHECK(parser.Groups[0].Name == "quad");
+        CHECK(parser.Groups[0].TriangleCount == 2);
+        CHECK_NEAR(parser.TexCoords[0].y, 0.25, 0.0);
+    }
+
+    void TestIndentedLines()
+    {
+        std::string text;
+        const int lineCount = 1000;
+        for(int i = 0; i < lineCount; ++i)
+        {
+            text += " \tv 1.5 -2 3e1\n";
+        }
+        text += "  f 1 2 3\n";
+
+        ObjFileParser parser;
+        CHECK(Parse(parser, text));
+        CHECK(parser.Positions.size() == lineCount);
+        CHECK(parser.GetTriangleCount() == 1);
+        CHECK_NEAR(parser.Positions[0].z, 30.0, 0.0);
+
+        // The reserve pass has to count indented lines too, otherwise the vectors
+        // grow geometrically while parsing and end up with spare capacity.
+        CHECK(parser.Positions.capacity() == parser.Positions.size());
+        CHECK(parser.Corners.capacity() == parser.Corners.size());
+    }
+
+    void TestIndexOverflow()
+    {
+        ObjFileParser parser;
+        CHECK(Parse(parser,
+            "v 0 0 0\n"
+            "v 1 0 0\n"
+            "v 1 1 0\n"
+            "f 1 2 99999999999999999999\n"
+            "f 1 2 -99999999999999999999\n"
+            "f 1 2 4294967299\n"
+            "f 1/2147483648 2 3\n"));
+
+        // Out of range positions drop the face, an out of range texcoord is only ignored.
+        CHECK(parser.GetTriangleCount() == 1);
+        CHECK(parser.Corners[0].Position == 0);
+        CHECK(parser.Corners[0].TexCoord == -1);
+    }
+
+    void TestEmptyAndMissingFile()
+    {
+        ObjFileParser parser;
+        CHECK(Parse(parser, ""));
+        CHECK(parser.GetTriangleCount() == 0);
+        CHECK(!parser.ParseFile(std::string(ENGINE_DIR) + "/Assets/Model/missing.wobj"));
+    }
+
+    void TestAssetFile()
+    {
+        ObjFileParser parser;
+        CHECK(parser.ParseFile(std::string(ENGINE_DIR) + "/Assets/Model/cube.wobj"));
+        CHECK(parser.GetTriangleCount() > 0);
+        for(const ObjFileParser::Corner& corner : parser.Corners)
+        {
+            CHECK(corner.Position >= 0 && corner.Position < (int)parser.Positions.size());
+        }
+    }
+}
+
+int main()
+{
+    TestTriangulation();
+    TestIndentedLines();
+    TestIndexOverflow();
+    TestEmptyAndMissingFile();
+    TestAssetFile();
+    std::printf("ObjFileParserTest passed\n");
+    return 0;
+}
@@ -0,0 +1,219 @@
+#include "TestUtil.h"
+#include "../GeometryPacker.h"
+#include "../SceneCache.h"
+#include "../ThreadPool.h"
+#include "../MeshBuilder/MeshBoxBuilder.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+namespace
+{
+    // The cache and the sources it hashes live in the working directory.
+    const char* CachePath = "SceneCacheTest.bake";
+    const char* ScenePath = "SceneCacheTest.json";
+    const char* SourcePath = "SceneCacheTest.wobj";
+
+    std::string ReadBytes(const std::string& path)
+    {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    void WriteBytes(const std::string& path, const std::string& contents)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), (std::streamsize)contents.size());
+        CHECK(file.good());
+    }
+
+    template<typename T>
+    void PatchHeader(std::string& bake, size_t offset, T value)
+    {
+        CHECK(offset + sizeof(T) <= bake.size());
+        std::memcpy(&bake[offset], &value, sizeof(T));
+    }
+
+    void BuildGeometry(ThreadPool& pool, PackedGeometry& packed)
+    {
+        std::vector<MeshBuildTask> tasks(2);
+        tasks[0].Name = "box";
+        tasks[0].MaterialName = "stone";
+        tasks[1].Name = "quad";
+        tasks[1].MaterialName = "grass";
+        tasks[1].LodSwitchDistance = 20.0f;
+
+        std::vector<MeshBuilder::MeshData> meshes(2);
+        BoxBuilder box;
+        meshes[0] = box.BuildBox(1.0f, 2.0f, 3.0f, 1);
+        meshes[1].Vertices = {
+            MeshBuilder::Vertex(0, 0, 0, 0, 1, 0, 1, 0, 0, 0, 0),
+            MeshBuilder::Vertex(1, 0, 0, 0, 1, 0, 1, 0, 0, 1, 0),
+            MeshBuilder::Vertex(1, 0, 1, 0, 1, 0, 1, 0, 0, 1, 1),
+            MeshBuilder::Vertex(0, 0, 1, 0, 1, 0, 1, 0, 0, 0, 1) };
+        meshes[1].Indices32 = { 0, 1, 2, 0, 2, 3 };
+        meshes[1].LodIndices32 = { { 0, 1, 2 } };
+
+        GeometryPacker::Pack(tasks, meshes, VertexFormat::Full, pool, packed);
+    }
+
+    bool Write(const PackedGeometry& packed, const std::vector<const Material*>& materials)
+    {
+        return SceneCache::Write(CachePath, ScenePath, { SourcePath }, packed, materials);
+    }
+
+    void TestRoundTrip(const PackedGeometry& packed, const Material& material)
+    {
+        CHECK(Write(packed, { &material }));
+
+        SceneCache cache;
+        CHECK(cache.Open(CachePath, ScenePath));
+        CHECK(cache.IsOpen());
+
+        const SceneCache::Header& header = cache.GetHeader();
+        CHECK(header.SourceFileCount == 1);
+        CHECK(header.SubmeshCount == packed.Submeshes.size());
+        CHECK(header.MaterialCount == 1);
+        CHECK(cache.GetVertexFormat() == VertexFormat::Full);
+        CHECK(cache.GetVertexStride() == sizeof(Vertex));
+        CHECK(cache.GetVertexByteSize() == packed.Vertices.size() * sizeof(Vertex));
+        CHECK(std::memcmp(cache.GetVertices(), packed.Vertices.data(), cache.GetVertexByteSize()) == 0);
+        CHECK(cache.GetIndex16ByteSize() == packed.Indices16.size() * sizeof(std::uint16_t));
+        CHECK(std::memcmp(cache.GetIndices16(), packed.Indices16.data(), cache.GetIndex16ByteSize()) == 0);
+        CHECK(cache.GetIndex32ByteSize() == 0);
+
+        const SceneCache::SubmeshRecord* submeshes = cache.GetSubmeshes();
+        for(size_t i = 0; i < packed.Submeshes.size(); ++i)
+        {
+            const SubmeshGeometry& expected = packed.Submeshes[i];
+            CHECK(packed.SubmeshNames[i] == submeshes[i].Name);
+            CHECK(expected.MaterialName == submeshes[i].MaterialName);
+            CHECK(submeshes[i].IndexFormat == (std::uint32_t)packed.SubmeshIndexFormats[i]);
+            CHECK(submeshes[i].IndexCount == expected.IndexCount);
+            CHECK(submeshes[i].StartIndexLocation == expected.StartIndexLocation);
+            CHECK(submeshes[i].BaseVertexLocation == expected.BaseVertexLocation);
+            CHECK(submeshes[i].BoundsCenter[1] == expected.Bounds.Center.y);
+            CHECK(submeshes[i].BoundsExtents[2] == expected.Bounds.Extents.z);
+            CHECK(submeshes[i].LodSwitchDistance == expected.LodSwitchDistance);
+        }
+
+        const SceneCache::MaterialRecord& record = cache.GetMaterials()[0];
+        CHECK(material.Name == record.Name);
+        CHECK(record.MatCBIndex == material.MatCBIndex);
+        CHECK(record.DiffuseSrvHeapIndex == material.DiffuseSrvHeapIndex);
+        CHECK(record.DiffuseAlbedo[2] == material.DiffuseAlbedo.z);
+        CHECK(record.Roughness == material.Roughness);
+        CHECK(record.MatTransform[12] == material.MatTransform._41);
+    }
+
+    void TestSourceChange()
+    {
+        SceneCache cache;
+        const std::string source = ReadBytes(SourcePath);
+
+        WriteBytes(SourcePath, source + "v 0 0 0\n");
+        CHECK(!cache.Open(CachePath, ScenePath));
+        CHECK(!cache.IsOpen());
+
+        const std::string scene = ReadBytes(ScenePath);
+        WriteBytes(SourcePath, source);
+        WriteBytes(ScenePath, scene + " ");
+        CHECK(!cache.Open(CachePath, ScenePath));
+
+        // The bake is only stale, not damaged: restoring the sources makes it valid again.
+        WriteBytes(ScenePath, scene);
+        CHECK(cache.Open(CachePath, ScenePath));
+    }
+
+    void TestVersionBump()
+    {
+        const std::string bake = ReadBytes(CachePath);
+        std::string patched = bake;
+        PatchHeader(patched, offsetof(SceneCache::Header, Version), SceneCache::Version + 1);
+        WriteBytes(CachePath, patched);
+
+        SceneCache cache;
+        CHECK(!cache.Open(CachePath, ScenePath));
+
+        WriteBytes(CachePath, bake);
+        CHECK(cache.Open(CachePath, ScenePath));
+    }
+
+    void TestDamagedFile()
+    {
+        const std::string bake = ReadBytes(CachePath);
+        SceneCache cache;
+
+        for(size_t size : { bake.size() - 1, bake.size() / 2, sizeof(SceneCache::Header), sizeof(SceneCache::Header) - 1, size_t(0) })
+        {
+            WriteBytes(CachePath, bake.substr(0, size));
+            CHECK(!cache.Open(CachePath, ScenePath));
+        }
+
+        // section tables must not overlap the header
+        std::string patched = bake;
+        PatchHeader(patched, offsetof(SceneCache::Header, SourceFileOffset), std::uint64_t(0));
+        WriteBytes(CachePath, patched);
+        CHECK(!cache.Open(CachePath, ScenePath));
+
+        // an offset near 2^64, where offset + size wraps around to before the next section
+        patched = bake;
+        PatchHeader(patched, offsetof(SceneCache::Header, SourceFileOffset), ~std::uint64_t(15));
+        WriteBytes(CachePath, patched);
+        CHECK(!cache.Open(CachePath, ScenePath));
+
+        // a section that does not start on a section boundary
+        SceneCache::Header header;
+        std::memcpy(&header, bake.data(), sizeof(header));
+        patched = bake;
+        PatchHeader(patched, offsetof(SceneCache::Header, MaterialOffset), header.MaterialOffset + 4);
+        WriteBytes(CachePath, patched);
+        CHECK(!cache.Open(CachePath, ScenePath));
+
+        WriteBytes(CachePath, bake);
+        CHECK(cache.Open(CachePath, ScenePath));
+    }
+
+    void TestMissingSource()
+    {
+        SceneCache cache;
+        std::remove(SourcePath);
+        CHECK(!cache.Open(CachePath, ScenePath));
+        CHECK(!SceneCache::Write(CachePath, ScenePath, { SourcePath }, PackedGeometry(), {}));
+    }
+}
+
+int main()
+{
+    WriteBytes(ScenePath, "{ \"mesh\": [ { \"name\": \"quad\", \"type\": \"obj\", \"path\": \"SceneCacheTest.wobj\" } ] }\n");
+    WriteBytes(SourcePath, "v 0 0 0\nv 1 0 0\nv 1 0 1\nf 1 2 3\n");
+
+    ThreadPool pool(2);
+    PackedGeometry packed;
+    BuildGeometry(pool, packed);
+    CHECK(packed.Submeshes.size() == 3);
+
+    Material material;
+    material.Name = "stone";
+    material.MatCBIndex = 4;
+    material.DiffuseSrvHeapIndex = 2;
+    material.DiffuseAlbedo = XMFLOAT4(0.5f, 0.25f, 0.125f, 1.0f);
+    material.Roughness = 0.75f;
+    material.MatTransform._41 = 3.0f;
+
+    TestRoundTrip(packed, material);
+    TestSourceChange();
+    TestVersionBump();
+    TestDamagedFile();
+    TestMissingSource();
+
+    std::remove(CachePath);
+    std::remove(ScenePath);
+    std::printf("SceneCacheTest passed\n");
+    return 0;
+}
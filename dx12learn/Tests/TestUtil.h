@@ -0,0 +1,40 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+// Minimal checks for the headless tests. A failed check prints its location and
+// ends the test with a non-zero exit code, which is all ctest looks at.
+#define CHECK(condition) \
+    do \
+    { \
+        if(!(condition)) \
+        { \
+            std::fprintf(stderr, "%s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            std::exit(1); \
+        } \
+    } while(0)
+
+#define CHECK_NEAR(a, b, tolerance) \
+    do \
+    { \
+        double checkA = (a); \
+        double checkB = (b); \
+        if(!(std::fabs(checkA - checkB) <= (tolerance))) \
+        { \
+            std::fprintf(stderr, "%s(%d): CHECK_NEAR(%s, %s) failed: %g vs %g\n", \
+                __FILE__, __LINE__, #a, #b, checkA, checkB); \
+            std::exit(1); \
+        } \
+    } while(0)
+
+// Wall-clock seconds spent in fn().
+template<typename Fn>
+double MeasureSeconds(Fn&& fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,310 @@
+#include "TestUtil.h"
+#include "../TextureResidency.h"
+
+#include <cmath>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // levelBytes of a square RGBA8 texture with a full mip chain.
+    std::vector<std::uint64_t> MakeLevels(unsigned size)
+    {
+        std::vector<std::uint64_t> levels;
+        for(unsigned s = size; s > 0; s /= 2)
+        {
+            levels.push_back((std::uint64_t)s * s * 4);
+        }
+        for(size_t m = levels.size() - 1; m-- > 0;)
+        {
+            levels[m] += levels[m + 1];
+        }
+        return levels;
+    }
+
+    // Runs Schedule and completes every action right away.
+    std::vector<TextureResidency::Action> ScheduleAndComplete(TextureResidency& residency, size_t maxLoads)
+    {
+        std::vector<TextureResidency::Action> actions = residency.Schedule(maxLoads);
+        for(const TextureResidency::Action& action : actions)
+        {
+            CHECK(residency.IsLoading(action.Texture));
+            residency.CompleteLoad(action.Texture);
+            CHECK(residency.GetResidentMip(action.Texture) == action.Mip);
+        }
+        CHECK(residency.GetLoadingCount() == 0);
+        return actions;
+    }
+
+    void TestComputeDesiredMip()
+    {
+        CHECK(TextureResidency::ComputeDesiredMip(1024, 2000, 11) == 0);
+        CHECK(TextureResidency::ComputeDesiredMip(1024, 1024, 11) == 0);
+        CHECK(TextureResidency::ComputeDesiredMip(1024, 512, 11) == 1);
+        CHECK(TextureResidency::ComputeDesiredMip(1024, 100, 11) == 3);
+        CHECK(TextureResidency::ComputeDesiredMip(1024, 0.5f, 11) == 10);
+        CHECK(TextureResidency::ComputeDesiredMip(1 << 20, 1, 5) == 4);
+        CHECK(TextureResidency::ComputeDesiredMip(1024, 1, 1) == 0);
+
+        CHECK(TextureResidency::ComputeScreenSize(2, 1, 1.0f, 720) == 720);
+        CHECK_NEAR(TextureResidency::ComputeScreenSize(1, 10, 0.785f, 1000), 100 / std::tan(0.3925), 1e-3);
+        CHECK(TextureResidency::ComputeScreenSize(1, 1.01f, 0.1f, 720) == 720);
+    }
+
+    void TestLoadsOneLevelAtATime()
+    {
+        std::vector<std::uint64_t> levels = MakeLevels(256);
+        TextureResidency residency(1 << 30);
+        size_t texture = residency.AddTexture(levels, 5);
+        CHECK(residency.GetResidentMip(texture) == 5);
+        CHECK(residency.GetTailMip(texture) == 5);
+        CHECK(residency.GetCommittedBytes() == levels[5]);
+
+        // not requested: nothing to do
+        CHECK(ScheduleAndComplete(residency, 4).empty());
+
+        for(unsigned mip = 5; mip-- > 2;)
+        {
+            residency.Request(texture, 4, 1.0f);
+            residency.Request(texture, 2, 0.5f);
+            std::vector<TextureResidency::Action> actions = ScheduleAndComplete(residency, 4);
+            CHECK(actions.size() == 1);
+            CHECK(actions[0].Texture == texture && actions[0].Mip == mip && !actions[0].Evict);
+            CHECK(residency.GetCommittedBytes() == levels[mip]);
+        }
+
+        residency.Request(texture, 2, 1.0f);
+        CHECK(ScheduleAndComplete(residency, 4).empty());
+    }
+
+    void TestPriorityAndMaxLoads()
+    {
+        std::vector<std::uint64_t> levels = MakeLevels(256);
+        TextureResidency residency(1 << 30);
+        size_t low = residency.AddTexture(levels, 6);
+        size_t high = residency.AddTexture(levels, 6);
+        size_t far = residency.AddTexture(levels, 6);
+
+        residency.Request(low, 0, 1.0f);
+        residency.Request(high, 0, 4.0f);
+        // missing fewer levels at a slightly higher priority is less urgent
+        residency.Request(far, 5, 1.5f);
+        std::vector<TextureResidency::Action> actions = residency.Schedule(2);
+        CHECK(actions.size() == 2);
+        CHECK(actions[0].Texture == high && actions[1].Texture == low);
+
+        // a texture in flight is not planned again
+        residency.Request(low, 0, 1.0f);
+        residency.Request(high, 0, 4.0f);
+        residency.Request(far, 5, 1.5f);
+        actions = residency.Schedule(2);
+        CHECK(actions.size() == 1 && actions[0].Texture == far);
+        CHECK(residency.GetLoadingCount() == 3);
+
+        residency.CompleteLoad(high);
+        residency.CompleteLoad(low);
+        residency.CompleteLoad(far);
+        CHECK(residency.GetResidentMip(high) == 5 && residency.GetResidentMip(far) == 5);
+        CHECK(residency.GetCommittedBytes() == 3 * levels[5]);
+    }
+
+    void TestCancel()
+    {
+        std::vector<std::uint64_t> levels = MakeLevels(128);
+        TextureResidency residency(1 << 30);
+        size_t texture = residency.AddTexture(levels, 4);
+        residency.Request(texture, 0, 1.0f);
+        residency.Schedule(1);
+        CHECK(residency.GetCommittedBytes() == levels[3]);
+
+        residency.CancelLoad(texture);
+        CHECK(!residency.IsLoading(texture));
+        CHECK(residency.GetResidentMip(texture) == 4);
+        CHECK(residency.GetCommittedBytes() == levels[4]);
+
+        // and is retried next frame
+        residency.Request(texture, 0, 1.0f);
+        std::vector<TextureResidency::Action> actions = ScheduleAndComplete(residency, 1);
+        CHECK(actions.size() == 1 && actions[0].Mip == 3);
+    }
+
+    // Three textures at mip 1, used in frames A < B < C, then the budget shrinks.
+    void TestEvictsLeastRecentlyUsed()
+    {
+        std::vector<std::uint64_t> levels = MakeLevels(256);
+        std::vector<std::uint64_t> bigLevels = MakeLevels(1024);
+        TextureResidency residency(1 << 30);
+        size_t a = residency.AddTexture(levels, 4);
+        size_t b = residency.AddTexture(levels, 4);
+        size_t c = residency.AddTexture(levels, 4);
+        size_t d = residency.AddTexture(bigLevels, 3);
+        for(int frame = 0; frame < 3; ++frame)
+        {
+            residency.Request(a, 1, 1.0f);
+            residency.Request(b, 1, 1.0f);
+            residency.Request(c, 1, 1.0f);
+            ScheduleAndComplete(residency, 3);
+        }
+        residency.Request(b, 1, 1.0f);
+        ScheduleAndComplete(residency, 3);
+        residency.Request(c, 1, 1.0f);
+        ScheduleAndComplete(residency, 3);
+        CHECK(residency.GetResidentMip(a) == 1 && residency.GetResidentMip(c) == 1);
+
+        // d's next level needs more than the slack plus what a gives up, so a and
+        // then b drop one level each; c is in use this frame and keeps its level.
+        std::uint64_t slack = 150000;
+        std::uint64_t growth = bigLevels[2] - bigLevels[3];
+        std::uint64_t drop = levels[1] - levels[2];
+        CHECK(growth > slack + drop && growth <= slack + 2 * drop);
+        residency.SetBudget(residency.GetCommittedBytes() + slack);
+
+        residency.Request(c, 1, 1.0f);
+        residency.Request(d, 0, 1.0f);
+        std::vector<TextureResidency::Action> actions = residency.Schedule(1);
+        CHECK(actions.size() == 3);
+        CHECK(actions[0].Texture == a && actions[0].Evict && actions[0].Mip == 2);
+        CHECK(actions[1].Texture == b && actions[1].Evict && actions[1].Mip == 2);
+        CHECK(actions[2].Texture == d && !actions[2].Evict && actions[2].Mip == 2);
+        CHECK(residency.GetCommittedBytes() <= residency.GetBudget());
+        for(const TextureResidency::Action& action : actions)
+        {
+            residency.CompleteLoad(action.Texture);
+        }
+        CHECK(residency.GetResidentMip(c) == 1);
+    }
+
+    void TestEvictionLimits()
+    {
+        std::vector<std::uint64_t> levels = MakeLevels(64);
+        TextureResidency residency(levels[4] * 2);
+        size_t a = residency.AddTexture(levels, 4);
+        size_t b = residency.AddTexture(levels, 4);
+
+        // Textures at their tail have nothing to give: the load is skipped and the
+        // tail stays resident.
+        residency.Request(a, 0, 1.0f);
+        residency.Request(b, 4, 1.0f);
+        CHECK(ScheduleAndComplete(residency, 4).empty());
+        CHECK(residency.GetResidentMip(a) == 4 && residency.GetResidentMip(b) == 4);
+
+        // Lower priority loses the tie between textures last used in the same frame.
+        residency.SetBudget(1 << 30);
+        residency.Request(a, 2, 2.0f);
+        residency.Request(b, 2, 1.0f);
+        ScheduleAndComplete(residency, 2);
+        residency.Request(a, 2, 2.0f);
+        residency.Request(b, 2, 1.0f);
+        ScheduleAndComplete(residency, 2);
+        CHECK(residency.GetResidentMip(a) == 2 && residency.GetResidentMip(b) == 2);
+
+        size_t c = residency.AddTexture(levels, 4);
+        residency.SetBudget(residency.GetCommittedBytes());
+        residency.Request(c, 3, 1.0f);
+        std::vector<TextureResidency::Action> actions = ScheduleAndComplete(residency, 1);
+        CHECK(actions.size() == 2);
+        CHECK(actions[0].Texture == b && actions[0].Evict);
+        CHECK(actions[1].Texture == c && !actions[1].Evict);
+    }
+
+    // Random requests, completions and cancels; the committed bytes always match
+    // the resident and in-flight levels.
+    void TestRandomized()
+    {
+        std::mt19937 random(11);
+        std::vector<std::vector<std::uint64_t>> textureLevels;
+        std::vector<unsigned> tails;
+        std::uint64_t tailBytes = 0;
+        for(int i = 0; i < 40; ++i)
+        {
+            textureLevels.push_back(MakeLevels(16u << (random() % 7)));
+            tails.push_back((unsigned)textureLevels.back().size() - 1 - random() % 3);
+            tailBytes += textureLevels.back()[tails.back()];
+        }
+
+        TextureResidency residency(tailBytes + (8u << 20));
+        for(size_t i = 0; i < textureLevels.size(); ++i)
+        {
+            residency.AddTexture(textureLevels[i], tails[i]);
+        }
+
+        std::map<size_t, unsigned> inFlight;
+        for(int frame = 0; frame < 2000; ++frame)
+        {
+            for(int r = 0; r < 12; ++r)
+            {
+                size_t texture = random() % textureLevels.size();
+                residency.Request(texture, random() % (tails[texture] + 1), (float)(random() % 100));
+            }
+            std::uint64_t committedBefore = residency.GetCommittedBytes();
+            bool loads = false;
+            for(const TextureResidency::Action& action : residency.Schedule(1 + random() % 4))
+            {
+                loads |= !action.Evict;
+                CHECK(inFlight.count(action.Texture) == 0);
+                unsigned resident = residency.GetResidentMip(action.Texture);
+                CHECK(action.Mip == (action.Evict ? resident + 1 : resident - 1));
+                CHECK(action.Mip <= tails[action.Texture]);
+                inFlight[action.Texture] = action.Mip;
+            }
+            // A cancelled eviction can leave the budget exceeded; Schedule only evicts
+            // to make room for loads and never plans one that does not fit.
+            if(loads)
+            {
+                CHECK(residency.GetCommittedBytes() <= residency.GetBudget());
+            }
+            else
+            {
+                CHECK(residency.GetCommittedBytes() <= committedBefore);
+            }
+
+            for(auto it = inFlight.begin(); it != inFlight.end();)
+            {
+                unsigned roll = random() % 4;
+                if(roll == 0)
+                {
+                    ++it;
+                    continue;
+                }
+                if(roll == 1)
+                {
+                    unsigned before = residency.GetResidentMip(it->first);
+                    residency.CancelLoad(it->first);
+                    CHECK(residency.GetResidentMip(it->first) == before);
+                }
+                else
+                {
+                    residency.CompleteLoad(it->first);
+                    CHECK(residency.GetResidentMip(it->first) == it->second);
+                }
+                it = inFlight.erase(it);
+            }
+
+            std::uint64_t committed = 0;
+            for(size_t i = 0; i < textureLevels.size(); ++i)
+            {
+                auto it = inFlight.find(i);
+                unsigned mip = it != inFlight.end() ? it->second : residency.GetResidentMip(i);
+                committed += textureLevels[i][mip];
+                CHECK(residency.GetResidentMip(i) <= tails[i]);
+                CHECK(residency.IsLoading(i) == (it != inFlight.end()));
+            }
+            CHECK(residency.GetCommittedBytes() == committed);
+            CHECK(residency.GetLoadingCount() == inFlight.size());
+        }
+    }
+}
+
+int main()
+{
+    TestComputeDesiredMip();
+    TestLoadsOneLevelAtATime();
+    TestPriorityAndMaxLoads();
+    TestCancel();
+    TestEvictsLeastRecentlyUsed();
+    TestEvictionLimits();
+    TestRandomized();
+    std::printf("TextureResidencyTest passed\n");
+    return 0;
+}
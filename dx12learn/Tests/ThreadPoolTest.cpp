@@ -0,0 +1,104 @@
+#include "TestUtil.h"
+#include "../ThreadPool.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    void TestCoversEveryIndex(ThreadPool& pool)
+    {
+        for(size_t count : { 1, 2, 3, 64, 10000 })
+        {
+            std::vector<std::atomic<int>> hits(count);
+            pool.ParallelFor(count, [&](size_t i) { hits[i].fetch_add(1); });
+            for(size_t i = 0; i < count; ++i)
+            {
+                CHECK(hits[i].load() == 1);
+            }
+        }
+    }
+
+    void TestNested(ThreadPool& pool)
+    {
+        std::atomic<size_t> total{ 0 };
+        pool.ParallelFor(16, [&](size_t)
+        {
+            pool.ParallelFor(100, [&](size_t i) { total.fetch_add(i); });
+        });
+        CHECK(total.load() == 16 * 4950);
+    }
+
+    void TestException(ThreadPool& pool)
+    {
+        for(size_t failing : { size_t(0), size_t(500), size_t(999) })
+        {
+            std::atomic<int> active{ 0 };
+            std::atomic<size_t> calls{ 0 };
+            bool caught = false;
+            try
+            {
+                pool.ParallelFor(1000, [&](size_t i)
+                {
+                    active.fetch_add(1);
+                    calls.fetch_add(1);
+                    if(i == failing)
+                    {
+                        active.fetch_sub(1);
+                        throw std::runtime_error("index failed");
+                    }
+                    std::this_thread::yield();
+                    active.fetch_sub(1);
+                });
+            }
+            catch(const std::runtime_error&)
+            {
+                caught = true;
+            }
+
+            // Rethrown on the caller, and only after no helper is inside body anymore.
+            CHECK(caught);
+            CHECK(active.load() == 0);
+            size_t callsAtReturn = calls.load();
+            CHECK(callsAtReturn >= 1 && callsAtReturn <= 1000);
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            CHECK(calls.load() == callsAtReturn);
+        }
+    }
+
+    void TestEveryIndexThrows(ThreadPool& pool)
+    {
+        int caught = 0;
+        for(int round = 0; round < 100; ++round)
+        {
+            try
+            {
+                pool.ParallelFor(64, [](size_t i) { throw (int)i; });
+            }
+            catch(int)
+            {
+                ++caught;
+            }
+        }
+        CHECK(caught == 100);
+
+        // The pool is still usable afterwards.
+        TestCoversEveryIndex(pool);
+    }
+}
+
+int main()
+{
+    for(unsigned threadCount : { 1u, 3u, 8u })
+    {
+        ThreadPool pool(threadCount);
+        TestCoversEveryIndex(pool);
+        TestNested(pool);
+        TestException(pool);
+        TestEveryIndexThrows(pool);
+    }
+    std::printf("ThreadPoolTest passed\n");
+    return 0;
+}
@@ -0,0 +1,190 @@
+#include "TestUtil.h"
+#include "../TransformHierarchy.h"
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    XMFLOAT4X4 Translation(float x, float y, float z)
+    {
+        XMFLOAT4X4 local;
+        XMStoreFloat4x4(&local, XMMatrixTranslation(x, y, z));
+        return local;
+    }
+
+    void CheckWorldPosition(const TransformHierarchy& transforms, int node, float x, float y, float z)
+    {
+        const XMFLOAT4X4& world = transforms.GetWorld(node);
+        CHECK_NEAR(world._41, x, 1e-5);
+        CHECK_NEAR(world._42, y, 1e-5);
+        CHECK_NEAR(world._43, z, 1e-5);
+    }
+
+    void CheckChanged(const std::vector<int>& changed, const std::vector<int>& expected)
+    {
+        CHECK(changed == expected);
+    }
+
+    // Runs SortParentsFirst and returns the message of the exception it throws.
+    std::string SortError(const std::vector<int>& parents)
+    {
+        try
+        {
+            TransformHierarchy::SortParentsFirst(parents);
+        }
+        catch(const std::runtime_error& e)
+        {
+            return e.what();
+        }
+        return std::string();
+    }
+
+    void TestSortParentsFirst()
+    {
+        const int none = TransformHierarchy::NoParent;
+        const std::vector<int> parents = { 3, none, 0, 1, 1, 2, none, 6 };
+        std::vector<size_t> order = TransformHierarchy::SortParentsFirst(parents);
+        CHECK(order.size() == parents.size());
+
+        // every node once, each after its parent
+        std::vector<int> position(parents.size(), -1);
+        for(size_t k = 0; k < order.size(); ++k)
+        {
+            CHECK(order[k] < parents.size());
+            CHECK(position[order[k]] == -1);
+            position[order[k]] = (int)k;
+        }
+        for(size_t i = 0; i < parents.size(); ++i)
+        {
+            if(parents[i] != none)
+            {
+                CHECK(position[parents[i]] < position[i]);
+            }
+        }
+
+        // roots first, in their own order
+        CHECK(order[0] == 1 && order[1] == 6);
+
+        // breadth first: roots, then their children, then grandchildren
+        order = TransformHierarchy::SortParentsFirst({ none, 0, 1, none, 3 });
+        CHECK(order.size() == 5);
+        CHECK(order[0] == 0 && order[1] == 3 && order[2] == 1 && order[3] == 4 && order[4] == 2);
+
+        CHECK(TransformHierarchy::SortParentsFirst({}).empty());
+    }
+
+    void TestSortErrors()
+    {
+        const int none = TransformHierarchy::NoParent;
+        CHECK(SortError({ 0 }) == "transform hierarchy has a cycle");
+        CHECK(SortError({ 1, 0 }) == "transform hierarchy has a cycle");
+        // a cycle hanging off nothing, next to a valid tree
+        CHECK(SortError({ none, 0, 3, 2 }) == "transform hierarchy has a cycle");
+
+        CHECK(SortError({ none, 2 }) == "transform parent out of range");
+        CHECK(SortError({ none, -2 }) == "transform parent out of range");
+
+        CHECK(SortError({ none, 0 }).empty());
+    }
+
+    // root (0) - a (1) - b (2) - c (3), root - d (4), and a second root e (5)
+    void BuildTree(TransformHierarchy& transforms)
+    {
+        const int none = TransformHierarchy::NoParent;
+        CHECK(transforms.AddNode(none, Translation(1.0f, 0.0f, 0.0f)) == 0);
+        CHECK(transforms.AddNode(0, Translation(0.0f, 1.0f, 0.0f)) == 1);
+        CHECK(transforms.AddNode(1, Translation(0.0f, 0.0f, 1.0f)) == 2);
+        CHECK(transforms.AddNode(2, Translation(1.0f, 0.0f, 0.0f)) == 3);
+        CHECK(transforms.AddNode(0, Translation(0.0f, 5.0f, 0.0f)) == 4);
+        CHECK(transforms.AddNode(none, Translation(0.0f, 0.0f, 7.0f)) == 5);
+        CHECK(transforms.GetCount() == 6);
+        CHECK(transforms.GetParent(3) == 2 && transforms.GetParent(5) == none);
+    }
+
+    void TestDirtyPropagation()
+    {
+        TransformHierarchy transforms;
+        BuildTree(transforms);
+
+        // new nodes are dirty
+        std::vector<int> changed;
+        transforms.Update(changed);
+        CheckChanged(changed, { 0, 1, 2, 3, 4, 5 });
+        CheckWorldPosition(transforms, 3, 2.0f, 1.0f, 1.0f);
+        CheckWorldPosition(transforms, 4, 1.0f, 5.0f, 0.0f);
+        CheckWorldPosition(transforms, 5, 0.0f, 0.0f, 7.0f);
+
+        changed.clear();
+        transforms.Update(changed);
+        CHECK(changed.empty());
+
+        // a moved node takes all its descendants along, and nothing else
+        transforms.SetLocal(1, Translation(0.0f, 2.0f, 0.0f));
+        transforms.Update(changed);
+        CheckChanged(changed, { 1, 2, 3 });
+        CheckWorldPosition(transforms, 1, 1.0f, 2.0f, 0.0f);
+        CheckWorldPosition(transforms, 2, 1.0f, 2.0f, 1.0f);
+        CheckWorldPosition(transforms, 3, 2.0f, 2.0f, 1.0f);
+        CheckWorldPosition(transforms, 4, 1.0f, 5.0f, 0.0f);
+
+        // moving the root reaches the whole tree, but not the other root
+        changed.clear();
+        transforms.SetLocal(0, Translation(-1.0f, 0.0f, 0.0f));
+        transforms.Update(changed);
+        CheckChanged(changed, { 0, 1, 2, 3, 4 });
+        CheckWorldPosition(transforms, 3, 0.0f, 2.0f, 1.0f);
+        CheckWorldPosition(transforms, 4, -1.0f, 5.0f, 0.0f);
+        CheckWorldPosition(transforms, 5, 0.0f, 0.0f, 7.0f);
+
+        // a leaf moves alone
+        changed.clear();
+        transforms.SetLocal(3, Translation(0.0f, 0.0f, 0.0f));
+        transforms.Update(changed);
+        CheckChanged(changed, { 3 });
+        CheckWorldPosition(transforms, 3, -1.0f, 2.0f, 1.0f);
+        CHECK(transforms.GetLocal(3)._41 == 0.0f);
+    }
+
+    void TestChangedAscending()
+    {
+        TransformHierarchy transforms;
+        BuildTree(transforms);
+        std::vector<int> changed;
+        transforms.Update(changed);
+
+        // Set out of order, with a node and its ancestor both set: every node is
+        // reported once, in ascending order, after what changed already held.
+        changed.assign(1, 100);
+        transforms.SetLocal(5, Translation(0.0f, 0.0f, 8.0f));
+        transforms.SetLocal(3, Translation(2.0f, 0.0f, 0.0f));
+        transforms.SetLocal(2, Translation(0.0f, 0.0f, 2.0f));
+        transforms.SetLocal(4, Translation(0.0f, 6.0f, 0.0f));
+        transforms.Update(changed);
+        CheckChanged(changed, { 100, 2, 3, 4, 5 });
+        CheckWorldPosition(transforms, 3, 3.0f, 1.0f, 2.0f);
+        CheckWorldPosition(transforms, 4, 1.0f, 6.0f, 0.0f);
+        CheckWorldPosition(transforms, 5, 0.0f, 0.0f, 8.0f);
+
+        // a node added later is recomputed with the subtree it hangs in
+        changed.clear();
+        CHECK(transforms.AddNode(3, Translation(0.0f, 1.0f, 0.0f)) == 6);
+        transforms.SetLocal(1, Translation(0.0f, 1.0f, 0.0f));
+        transforms.Update(changed);
+        CheckChanged(changed, { 1, 2, 3, 6 });
+        CheckWorldPosition(transforms, 6, 3.0f, 2.0f, 2.0f);
+    }
+}
+
+int main()
+{
+    TestSortParentsFirst();
+    TestSortErrors();
+    TestDirtyPropagation();
+    TestChangedAscending();
+    std::printf("TransformHierarchyTest passed\n");
+    return 0;
+}
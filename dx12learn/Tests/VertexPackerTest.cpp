@@ -0,0 +1,119 @@
+// Round trips meshes through the packed vertex format and checks the worst error
+// against what the encoding allows:
+//   position  16-bit unorm per axis over the mesh bounds: half a step per axis,
+//             |Extents| / 65535 in length
+//   normal    octahedral 2 x 16-bit snorm: about 0.003 degrees, but the angle is
+//             measured with a float acos, which cannot resolve less than ~0.03
+//   texcoord  half float, 11 significant bits: 2^-11 relative to the value
+#include "TestUtil.h"
+#include "../VertexPacker.h"
+#include "../MeshBuilder/MeshBoxBuilder.h"
+#include "../MeshBuilder/MeshCylinderBuilder.h"
+#include "../MeshBuilder/MeshObjBuilder.h"
+#include "../MeshBuilder/MeshSphereBuilder.h"
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    const double MaxNormalErrorDegrees = 0.05;
+
+    void CheckRoundTrip(const char* name, const std::vector<MeshBuilder::Vertex>& vertices)
+    {
+        CHECK(!vertices.empty());
+        DirectX::BoundingBox bounds = VertexPacker::ComputeBounds(vertices);
+        VertexPacker::Precision precision = VertexPacker::MeasureRoundTrip(vertices, bounds);
+
+        const XMFLOAT3& e = bounds.Extents;
+        double extentLength = std::sqrt((double)e.x * e.x + (double)e.y * e.y + (double)e.z * e.z);
+        // Half a quantization step per axis, plus float rounding in the scale and bias.
+        double positionBound = extentLength / 65535.0 + extentLength * 1e-6;
+
+        float maxTexC = 0.0f;
+        for(const MeshBuilder::Vertex& v : vertices)
+        {
+            maxTexC = (std::max)(maxTexC, (std::max)(std::fabs(v.TexC.x), std::fabs(v.TexC.y)));
+        }
+        double texCBound = (std::max)(maxTexC, 6.1e-5f) * std::ldexp(1.0, -11);
+
+        std::printf("%-10s %7zu vertices  position %.3g (< %.3g)  normal %.4f deg (< %.2f)  texcoord %.3g (< %.3g)\n",
+            name, vertices.size(), precision.MaxPositionError, positionBound,
+            precision.MaxNormalErrorDegrees, MaxNormalErrorDegrees, precision.MaxTexCError, texCBound);
+
+        CHECK(precision.MaxPositionError <= positionBound);
+        CHECK(precision.MaxNormalErrorDegrees <= MaxNormalErrorDegrees);
+        CHECK(precision.MaxTexCError <= texCBound);
+    }
+
+    std::vector<MeshBuilder::Vertex> RandomVertices(size_t count, float extent, float texCRange)
+    {
+        std::mt19937 random(1234);
+        std::uniform_real_distribution<float> position(-extent, extent);
+        std::normal_distribution<float> direction(0.0f, 1.0f);
+        std::uniform_real_distribution<float> texC(0.0f, texCRange);
+
+        std::vector<MeshBuilder::Vertex> vertices(count);
+        for(MeshBuilder::Vertex& v : vertices)
+        {
+            v.Position = XMFLOAT3(position(random), position(random) * 0.1f, position(random));
+            XMFLOAT3 n(direction(random), direction(random), direction(random));
+            XMStoreFloat3(&v.Normal, XMVector3Normalize(XMLoadFloat3(&n)));
+            v.TexC = XMFLOAT2(texC(random), texC(random));
+        }
+        return vertices;
+    }
+
+    void TestFlatAxis()
+    {
+        // A grid is flat in y: zero extent must decode exactly, not divide by zero.
+        std::vector<MeshBuilder::Vertex> vertices = RandomVertices(1000, 10.0f, 1.0f);
+        for(MeshBuilder::Vertex& v : vertices)
+        {
+            v.Position.y = 2.5f;
+        }
+        DirectX::BoundingBox bounds = VertexPacker::ComputeBounds(vertices);
+        CHECK(bounds.Extents.y == 0.0f);
+        for(const MeshBuilder::Vertex& v : vertices)
+        {
+            MeshBuilder::Vertex decoded = VertexPacker::Decode(VertexPacker::Encode(v, bounds), bounds);
+            CHECK(decoded.Position.y == 2.5f);
+        }
+        CheckRoundTrip("flat", vertices);
+    }
+
+    void TestAxisNormals()
+    {
+        // The octahedron's corners and the folded lower half.
+        const XMFLOAT3 normals[] =
+        {
+            { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+            { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f }
+        };
+        for(const XMFLOAT3& n : normals)
+        {
+            XMFLOAT3 decoded = VertexPacker::DecodeNormal(VertexPacker::EncodeNormal(n));
+            CHECK_NEAR(decoded.x, n.x, 1e-4);
+            CHECK_NEAR(decoded.y, n.y, 1e-4);
+            CHECK_NEAR(decoded.z, n.z, 1e-4);
+        }
+    }
+}
+
+int main()
+{
+    static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay 16 bytes");
+
+    TestAxisNormals();
+    TestFlatAxis();
+    CheckRoundTrip("box", BoxBuilder().BuildBox(1.0f, 1.5f, 1.5f, 3).Vertices);
+    CheckRoundTrip("sphere", SphereBuilder().BuildSphere(0.5f, 20, 20).Vertices);
+    CheckRoundTrip("cylinder", CylinderBuilder().BuildCylinder(0.5f, 0.3f, 3.0f, 20, 20).Vertices);
+    CheckRoundTrip("teapot", MeshObjBuilder().BuildByObjFile(std::string(ENGINE_DIR) + "/Assets/Model/teapot.wobj").Vertices);
+    CheckRoundTrip("random", RandomVertices(100000, 50.0f, 1.0f));
+    CheckRoundTrip("tiled", RandomVertices(100000, 0.01f, 8.0f));
+    std::printf("VertexPackerTest passed\n");
+    return 0;
+}
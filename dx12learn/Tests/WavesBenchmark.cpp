@@ -0,0 +1,177 @@
+// Steps per second of Waves against the array-of-XMFLOAT3 solver it replaced,
+// on 128^2, 512^2 and 2048^2 grids, single threaded and on the thread pool.
+//
+//   WavesBenchmark [seconds per measurement]   (default 1)
+#include "../Simulation/Waves.h"
+#include "../ThreadPool.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // The solver before the structure-of-arrays rewrite: one XMFLOAT3 per vertex,
+    // scalar stencil, XMVector3Normalize per normal and tangent. Each Update call
+    // takes exactly one step.
+    class ReferenceWaves
+    {
+    public:
+        ReferenceWaves(int m, int n, float dx, float dt, float speed, float damping)
+            : NumRows(m), NumCols(n), SpatialStep(dx)
+        {
+            float d = damping * dt + 2.0f;
+            float e = (speed * speed) * (dt * dt) / (dx * dx);
+            K1 = (damping * dt - 2.0f) / d;
+            K2 = (4.0f - 8.0f * e) / d;
+            K3 = (2.0f * e) / d;
+
+            PrevSolution.resize(m * n);
+            CurrSolution.resize(m * n);
+            Normals.resize(m * n);
+            TangentX.resize(m * n);
+
+            float halfWidth = (n - 1) * dx * 0.5f;
+            float halfDepth = (m - 1) * dx * 0.5f;
+            for(int i = 0; i < m; ++i)
+            {
+                for(int j = 0; j < n; ++j)
+                {
+                    XMFLOAT3 position(-halfWidth + j * dx, 0.0f, halfDepth - i * dx);
+                    PrevSolution[i * n + j] = position;
+                    CurrSolution[i * n + j] = position;
+                    Normals[i * n + j] = XMFLOAT3(0.0f, 1.0f, 0.0f);
+                    TangentX[i * n + j] = XMFLOAT3(1.0f, 0.0f, 0.0f);
+                }
+            }
+        }
+
+        const XMFLOAT3& GetPosition(int i)const { return CurrSolution[i]; }
+        const XMFLOAT3& GetNormal(int i)const { return Normals[i]; }
+
+        void Update()
+        {
+            for(int i = 1; i < NumRows - 1; ++i)
+            {
+                for(int j = 1; j < NumCols - 1; ++j)
+                {
+                    PrevSolution[i * NumCols + j].y =
+                        K1 * PrevSolution[i * NumCols + j].y +
+                        K2 * CurrSolution[i * NumCols + j].y +
+                        K3 * (CurrSolution[(i + 1) * NumCols + j].y +
+                            CurrSolution[(i - 1) * NumCols + j].y +
+                            CurrSolution[i * NumCols + j + 1].y +
+                            CurrSolution[i * NumCols + j - 1].y);
+                }
+            }
+
+            std::swap(PrevSolution, CurrSolution);
+
+            for(int i = 1; i < NumRows - 1; ++i)
+            {
+                for(int j = 1; j < NumCols - 1; ++j)
+                {
+                    float l = CurrSolution[i * NumCols + j - 1].y;
+                    float r = CurrSolution[i * NumCols + j + 1].y;
+                    float t = CurrSolution[(i - 1) * NumCols + j].y;
+                    float b = CurrSolution[(i + 1) * NumCols + j].y;
+                    Normals[i * NumCols + j] = XMFLOAT3(-r + l, 2.0f * SpatialStep, b - t);
+                    XMStoreFloat3(&Normals[i * NumCols + j], XMVector3Normalize(XMLoadFloat3(&Normals[i * NumCols + j])));
+
+                    TangentX[i * NumCols + j] = XMFLOAT3(2.0f * SpatialStep, r - l, 0.0f);
+                    XMStoreFloat3(&TangentX[i * NumCols + j], XMVector3Normalize(XMLoadFloat3(&TangentX[i * NumCols + j])));
+                }
+            }
+        }
+
+        void Disturb(int i, int j, float magnitude)
+        {
+            float halfMag = 0.5f * magnitude;
+            CurrSolution[i * NumCols + j].y += magnitude;
+            CurrSolution[i * NumCols + j + 1].y += halfMag;
+            CurrSolution[i * NumCols + j - 1].y += halfMag;
+            CurrSolution[(i + 1) * NumCols + j].y += halfMag;
+            CurrSolution[(i - 1) * NumCols + j].y += halfMag;
+        }
+
+    private:
+        int NumRows = 0;
+        int NumCols = 0;
+        float K1 = 0.0f;
+        float K2 = 0.0f;
+        float K3 = 0.0f;
+        float SpatialStep = 0.0f;
+
+        std::vector<XMFLOAT3> PrevSolution;
+        std::vector<XMFLOAT3> CurrSolution;
+        std::vector<XMFLOAT3> Normals;
+        std::vector<XMFLOAT3> TangentX;
+    };
+
+    const float TimeStep = 0.03f;
+
+    // Calls step() until at least the given time has passed, returns steps per second.
+    template<typename Step>
+    double MeasureStepsPerSecond(double seconds, Step&& step)
+    {
+        using Clock = std::chrono::steady_clock;
+        Clock::time_point start = Clock::now();
+        long long steps = 0;
+        double elapsed = 0.0;
+        do
+        {
+            step();
+            ++steps;
+            elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+        } while(elapsed < seconds);
+        return steps / elapsed;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    double seconds = argc > 1 ? std::atof(argv[1]) : 1.0;
+    ThreadPool pool;
+
+    std::printf("thread pool: %u workers plus the caller\n", pool.GetThreadCount());
+    std::printf("%10s %14s %14s %14s %10s\n", "grid", "reference/s", "Waves/s", "Waves+pool/s", "max diff");
+    for(int size : { 128, 512, 2048 })
+    {
+        ReferenceWaves reference(size, size, 1.0f, TimeStep, 4.0f, 0.2f);
+        Waves single(size, size, 1.0f, TimeStep, 4.0f, 0.2f);
+        Waves pooled(size, size, 1.0f, TimeStep, 4.0f, 0.2f, &pool);
+        reference.Disturb(size / 2, size / 2, 1.0f);
+        single.Disturb(size / 2, size / 2, 1.0f);
+        pooled.Disturb(size / 2, size / 2, 1.0f);
+
+        // Same number of steps on each so the solutions can be compared afterwards.
+        const int compareSteps = 16;
+        for(int i = 0; i < compareSteps; ++i)
+        {
+            reference.Update();
+            single.Update(TimeStep);
+            pooled.Update(TimeStep);
+        }
+        float maxDifference = 0.0f;
+        for(int i = 0; i < single.GetVertexCount(); ++i)
+        {
+            maxDifference = (std::max)(maxDifference, std::fabs(reference.GetPosition(i).y - pooled.GetPosition(i).y));
+            maxDifference = (std::max)(maxDifference, std::fabs(reference.GetNormal(i).y - pooled.GetNormal(i).y));
+        }
+
+        double referenceRate = MeasureStepsPerSecond(seconds, [&]() { reference.Update(); });
+        double singleRate = MeasureStepsPerSecond(seconds, [&]() { single.Update(TimeStep); });
+        double pooledRate = MeasureStepsPerSecond(seconds, [&]() { pooled.Update(TimeStep); });
+
+        char grid[32];
+        std::snprintf(grid, sizeof(grid), "%d^2", size);
+        std::printf("%10s %14.1f %14.1f %14.1f %10.2g\n", grid, referenceRate, singleRate, pooledRate, maxDifference);
+        std::printf("%10s %14s %13.1fx %13.1fx\n", "", "", singleRate / referenceRate, pooledRate / referenceRate);
+    }
+    return 0;
+}
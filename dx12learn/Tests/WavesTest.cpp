@@ -0,0 +1,282 @@
+#include "TestUtil.h"
+#include "../PackedVertex.h"
+#include "../Simulation/Waves.h"
+#include "../ThreadPool.h"
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+    // A power of two, so every sum of the time slices below is exact.
+    const float TimeStep = 0.25f;
+
+    std::unique_ptr<Waves> MakeWaves(int rows = 16, int columns = 16, ThreadPool* pool = nullptr)
+    {
+        auto waves = std::make_unique<Waves>(rows, columns, 1.0f, TimeStep, 1.0f, 0.2f, pool);
+        waves->Disturb(rows / 2, columns / 2, 1.0f);
+        return waves;
+    }
+
+    // WriteVertices needs 16-byte aligned memory, like the upload heap it writes to in the app.
+    struct VertexBuffer
+    {
+        struct alignas(16) Lane
+        {
+            float Floats[4];
+        };
+
+        explicit VertexBuffer(int vertexCount) : Storage(vertexCount * Waves::VertexFloatCount / 4) {}
+
+        float* GetFloats() { return reinterpret_cast<float*>(Storage.data()); }
+        const Vertex& operator[](int i)const { return reinterpret_cast<const Vertex*>(Storage.data())[i]; }
+
+        std::vector<Lane> Storage;
+    };
+
+    // Compares every vertex against the per-vertex accessors of Waves.
+    void CheckVertices(const Waves& waves, const VertexBuffer& vertices, const XMFLOAT4& color)
+    {
+        for(int i = 0; i < waves.GetVertexCount(); ++i)
+        {
+            const Vertex& v = vertices[i];
+            XMFLOAT3 position = waves.GetPosition(i);
+            XMFLOAT3 normal = waves.GetNormal(i);
+            CHECK(v.Pos.x == position.x);
+            CHECK_NEAR(v.Pos.y, position.y, 1e-6);
+            CHECK(v.Pos.z == position.z);
+            CHECK(v.Normal.x == normal.x && v.Normal.y == normal.y && v.Normal.z == normal.z);
+            CHECK(v.TexC.x == waves.GetTexC(i).x && v.TexC.y == waves.GetTexC(i).y);
+            CHECK(v.Color.x == color.x && v.Color.y == color.y && v.Color.z == color.z && v.Color.w == color.w);
+        }
+    }
+
+    void CheckSameHeights(const Waves& a, const Waves& b)
+    {
+        for(int i = 0; i < a.GetVertexCount(); ++i)
+        {
+            CHECK(a.GetHeight(i) == b.GetHeight(i));
+        }
+    }
+
+    void CheckSameNormals(const Waves& a, const Waves& b)
+    {
+        for(int i = 0; i < a.GetVertexCount(); ++i)
+        {
+            XMFLOAT3 na = a.GetNormal(i);
+            XMFLOAT3 nb = b.GetNormal(i);
+            CHECK(na.x == nb.x && na.y == nb.y && na.z == nb.z);
+        }
+    }
+
+    void TestFixedStep()
+    {
+        auto waves = MakeWaves();
+        CHECK(waves->Update(0.125f) == 0);
+        CHECK_NEAR(waves->GetInterpolationFactor(), 0.5, 0.0);
+        CHECK(waves->Update(0.0625f) == 0);
+        CHECK_NEAR(waves->GetInterpolationFactor(), 0.75, 0.0);
+        // the carried over time completes a step
+        CHECK(waves->Update(0.125f) == 1);
+        CHECK_NEAR(waves->GetInterpolationFactor(), 0.25, 0.0);
+        CHECK(waves->Update(0.5f) == 2);
+        CHECK_NEAR(waves->GetInterpolationFactor(), 0.25, 0.0);
+    }
+
+    void TestFrameRateIndependent()
+    {
+        // 24 steps worth of time, in slices of a quarter, half, one and three steps
+        auto reference = MakeWaves();
+        for(int i = 0; i < 24; ++i)
+        {
+            CHECK(reference->Update(TimeStep) == 1);
+        }
+
+        for(float slice : { 0.0625f, 0.125f, 0.25f, 0.75f })
+        {
+            auto waves = MakeWaves();
+            int steps = 0;
+            for(float time = 0.0f; time < 24 * TimeStep; time += slice)
+            {
+                steps += waves->Update(slice);
+            }
+            CHECK(steps == 24);
+            CHECK_NEAR(waves->GetInterpolationFactor(), 0.0, 0.0);
+            CheckSameHeights(*reference, *waves);
+        }
+    }
+
+    void TestMaxSubSteps()
+    {
+        auto waves = MakeWaves();
+        CHECK(waves->GetMaxSubSteps() == 4);
+
+        // within the limit a long frame catches up completely
+        CHECK(waves->Update(3.5f * TimeStep) == 3);
+        CHECK_NEAR(waves->GetInterpolationFactor(), 0.5, 0.0);
+
+        // beyond it the whole steps left over are dropped, only the phase is kept
+        CHECK(waves->Update(10.25f * TimeStep) == 4);
+        CHECK_NEAR(waves->GetInterpolationFactor(), 0.75, 0.0);
+        CHECK(waves->Update(0.0f) == 0);
+        CHECK(waves->Update(0.25f * TimeStep) == 1);
+        CHECK_NEAR(waves->GetInterpolationFactor(), 0.0, 0.0);
+
+        waves->SetMaxSubSteps(1);
+        CHECK(waves->Update(100.0f * TimeStep) == 1);
+        CHECK(waves->GetInterpolationFactor() < 1.0f);
+
+        waves->SetMaxSubSteps(0);
+        CHECK(waves->GetMaxSubSteps() == 1);
+    }
+
+    void TestInterpolation()
+    {
+        auto previous = MakeWaves();
+        auto current = MakeWaves();
+        auto interpolated = MakeWaves();
+        interpolated->SetInterpolation(true);
+
+        for(int i = 0; i < 5; ++i)
+        {
+            previous->Update(TimeStep);
+        }
+        for(int i = 0; i < 6; ++i)
+        {
+            current->Update(TimeStep);
+        }
+        CHECK(interpolated->Update(6.25f * TimeStep) == 4);
+        CHECK(interpolated->Update(2.0f * TimeStep) == 2);
+        CHECK_NEAR(interpolated->GetInterpolationFactor(), 0.25, 0.0);
+
+        // a quarter of the way from the solution after 5 steps to the one after 6
+        bool moved = false;
+        for(int i = 0; i < interpolated->GetVertexCount(); ++i)
+        {
+            float expected = previous->GetHeight(i) + (current->GetHeight(i) - previous->GetHeight(i)) * 0.25f;
+            CHECK_NEAR(interpolated->GetHeight(i), expected, 1e-6);
+            CHECK(interpolated->GetPosition(i).y == interpolated->GetHeight(i));
+            moved = moved || previous->GetHeight(i) != current->GetHeight(i);
+        }
+        CHECK(moved);
+
+        interpolated->SetInterpolation(false);
+        CheckSameHeights(*interpolated, *current);
+    }
+
+    void TestUpdateAll()
+    {
+        // The two large grids have the pool too and split into row bands, so their
+        // ParallelFor nests inside the one of UpdateAll; the small one runs serially.
+        const int sizes[][2] = { { 256, 256 }, { 200, 300 }, { 16, 16 } };
+        for(unsigned threadCount : { 1u, 3u, 8u })
+        {
+            ThreadPool pool(threadCount);
+            std::vector<std::unique_ptr<Waves>> serial;
+            std::vector<std::unique_ptr<Waves>> parallel;
+            std::vector<Waves*> waves;
+            for(const auto& size : sizes)
+            {
+                ThreadPool* gridPool = size[0] * size[1] > 16384 ? &pool : nullptr;
+                serial.push_back(MakeWaves(size[0], size[1]));
+                parallel.push_back(MakeWaves(size[0], size[1], gridPool));
+                waves.push_back(parallel.back().get());
+            }
+
+            for(int frame = 0; frame < 12; ++frame)
+            {
+                const float dt = (frame % 3 + 1) * 0.375f * TimeStep;
+                for(size_t k = 0; k < serial.size(); ++k)
+                {
+                    if(frame % 4 == 1)
+                    {
+                        int row = 2 + (frame * 7 + (int)k) % (sizes[k][0] - 4);
+                        int column = 2 + (frame * 5 + (int)k) % (sizes[k][1] - 4);
+                        serial[k]->Disturb(row, column, 0.5f);
+                        parallel[k]->Disturb(row, column, 0.5f);
+                    }
+                    serial[k]->Update(dt);
+                }
+                Waves::UpdateAll(waves, dt, pool);
+
+                for(size_t k = 0; k < serial.size(); ++k)
+                {
+                    CHECK(parallel[k]->GetInterpolationFactor() == serial[k]->GetInterpolationFactor());
+                    CheckSameHeights(*serial[k], *parallel[k]);
+                    CheckSameNormals(*serial[k], *parallel[k]);
+                }
+            }
+        }
+
+        ThreadPool pool(2);
+        Waves::UpdateAll({}, TimeStep, pool);
+    }
+
+    void TestWriteVertices()
+    {
+        static_assert(sizeof(Vertex) == Waves::VertexFloatCount * sizeof(float), "Vertex no longer matches Waves::WriteVertices");
+        const XMFLOAT4 color(0.1f, 0.2f, 0.3f, 1.0f);
+
+        // 16 columns run only the four-wide path; 7 and 13 leave 3 and 1 for the scalar tail
+        for(int columns : { 16, 7, 13 })
+        {
+            auto waves = MakeWaves(9, columns);
+            waves->Update(3.0f * TimeStep);
+
+            VertexBuffer vertices(waves->GetVertexCount());
+            waves->WriteVertices(vertices.GetFloats(), color);
+            CheckVertices(*waves, vertices, color);
+
+            waves->SetInterpolation(true);
+            waves->Update(0.375f * TimeStep);
+            CHECK_NEAR(waves->GetInterpolationFactor(), 0.375, 0.0);
+            waves->WriteVertices(vertices.GetFloats(), color);
+            CheckVertices(*waves, vertices, color);
+        }
+    }
+
+    void TestWriteVerticesVisibleToOtherThreads()
+    {
+        // Streaming stores are not ordered with the release store below; the
+        // sfence at the end of WriteVertices is what makes them visible with it.
+        auto waves = MakeWaves(64, 61);
+        waves->SetInterpolation(true);
+        const XMFLOAT4 color(1.0f, 0.5f, 0.25f, 1.0f);
+
+        for(int round = 0; round < 50; ++round)
+        {
+            waves->Update(0.625f * TimeStep);
+            VertexBuffer vertices(waves->GetVertexCount());
+            std::atomic<bool> written{ false };
+
+            std::thread reader([&]()
+            {
+                while(!written.load(std::memory_order_acquire))
+                {
+                    std::this_thread::yield();
+                }
+                CheckVertices(*waves, vertices, color);
+            });
+            waves->WriteVertices(vertices.GetFloats(), color);
+            written.store(true, std::memory_order_release);
+            reader.join();
+        }
+    }
+}
+
+int main()
+{
+    TestFixedStep();
+    TestFrameRateIndependent();
+    TestMaxSubSteps();
+    TestInterpolation();
+    TestUpdateAll();
+    TestWriteVertices();
+    TestWriteVerticesVisibleToOtherThreads();
+    std::printf("WavesTest passed\n");
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include "TextureLoader.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include "DDSTextureLoader.h"
+#include "ResourceUploadBatch.h"
+
+namespace
+{
+    // The 'DDS ' magic is followed by DDS_HEADER, whose height, width and mip count
+    // are the 3rd, 4th and 7th DWORD.
+    const size_t DdsHeightOffset = 4 + 2 * sizeof(DWORD);
+    const size_t DdsWidthOffset = 4 + 3 * sizeof(DWORD);
+    const size_t DdsMipCountOffset = 4 + 6 * sizeof(DWORD);
+
+    DWORD ReadDword(const std::uint8_t* data, size_t offset)
+    {
+        DWORD value;
+        memcpy(&value, data + offset, sizeof(value));
+        return value;
+    }
+}
+
+TextureLoader::TextureLoader(ID3D12Device *device, ThreadPool &pool) :
+    Device(device),
+    Loads(pool)
+{
+}
+
+TextureLoader::~TextureLoader()
+{
+    Wait();
+}
+
+size_t TextureLoader::Load(const std::wstring &filename, size_t maxSize)
+{
+    auto request = std::make_unique<Request>();
+    request->Filename = filename;
+    request->MaxSize = maxSize;
+    Request* pending = request.get();
+    Requests.push_back(std::move(request));
+
+    size_t index = Loads.Start([this, pending]()
+    {
+        pending->Result = DirectX::LoadDDSTextureFromFileEx(Device, pending->Filename.c_str(), pending->MaxSize,
+            D3D12_RESOURCE_FLAG_NONE, DirectX::DDS_LOADER_DEFAULT,
+            pending->Resource.ReleaseAndGetAddressOf(), pending->DdsData, pending->Subresources);
+
+        if(SUCCEEDED(pending->Result))
+        {
+            // the loader has validated the header already
+            const std::uint8_t* header = pending->DdsData.get();
+            pending->Source.Width = ReadDword(header, DdsWidthOffset);
+            pending->Source.Height = ReadDword(header, DdsHeightOffset);
+            pending->Source.MipCount = (std::max)(ReadDword(header, DdsMipCountOffset), (DWORD)1);
+        }
+    });
+    assert(index == Requests.size() - 1);
+    return index;
+}
+
+void TextureLoader::Upload(DirectX::ResourceUploadBatch &batch)
+{
+    Wait();
+
+    for(size_t i = 0; i < Requests.size(); ++i)
+    {
+        if(Requests[i] && !Requests[i]->Uploaded && FAILED(Upload(i, batch)))
+        {
+            ThrowLoadError(i);
+        }
+    }
+}
+
+HRESULT TextureLoader::Upload(size_t index, DirectX::ResourceUploadBatch &batch)
+{
+    Request& request = *Requests[index];
+    assert(IsComplete(index) && !request.Uploaded);
+
+    if(FAILED(request.Result))
+    {
+        return request.Result;
+    }
+
+    batch.Upload(request.Resource.Get(), 0, request.Subresources.data(), (UINT)request.Subresources.size());
+    batch.Transition(request.Resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    // the batch copied the texels into its own upload buffer
+    request.Subresources.clear();
+    request.DdsData.reset();
+    request.Uploaded = true;
+    return S_OK;
+}
+
+void TextureLoader::ThrowLoadError(size_t index)const
+{
+    const Request& request = *Requests[index];
+    assert(IsComplete(index) && FAILED(request.Result));
+
+    int size = WideCharToMultiByte(CP_UTF8, 0, request.Filename.c_str(), (int)request.Filename.size(), nullptr, 0, nullptr, nullptr);
+    std::string filename(size, '\0');
+    WideCharToMultiByte(CP_UTF8, 0, request.Filename.c_str(), (int)request.Filename.size(), &filename[0], size, nullptr, nullptr);
+
+    char result[16];
+    snprintf(result, sizeof(result), "0x%08x", (unsigned)request.Result);
+    throw std::runtime_error("failed to load texture " + filename + " (hr " + result + ")");
+}
+
+void TextureLoader::Release(size_t index)
+{
+    assert(IsComplete(index));
+    Requests[index].reset();
+}
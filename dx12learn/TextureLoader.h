@@ -0,0 +1,92 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "D3DUtil.h"
+#include "LoadTracker.h"
+
+class ThreadPool;
+
+namespace DirectX
+{
+    class ResourceUploadBatch;
+}
+
+// Loads DDS textures on a thread pool.
+//
+// Load returns at once. Reading the file, parsing the DDS header, laying out the
+// subresources and creating the default heap texture happen on a worker. Only
+// Upload, which records the copies into a ResourceUploadBatch, runs on the calling
+// thread, so it can build the rest of the scene while the files stream in.
+class TextureLoader
+{
+public:
+    TextureLoader(ID3D12Device* device, ThreadPool& pool);
+    TextureLoader(const TextureLoader& rhs) = delete;
+    TextureLoader& operator=(const TextureLoader& rhs) = delete;
+    // Waits for loads that are still running.
+    ~TextureLoader();
+
+    // Size of a DDS file's top mip and its mip count, as stored in the header.
+    struct SourceInfo
+    {
+        UINT Width = 0;
+        UINT Height = 0;
+        UINT MipCount = 0;
+    };
+
+    // Starts loading filename and returns the index the other calls take for it. A
+    // nonzero maxSize skips the mips wider or taller than maxSize.
+    size_t Load(const std::wstring& filename, size_t maxSize = 0);
+
+    size_t GetCount()const { return Loads.GetCount(); }
+    // Loads finished so far, successful or not. Does not block.
+    size_t GetCompletedCount()const { return Loads.GetCompletedCount(); }
+    bool IsComplete()const { return Loads.IsComplete(); }
+    bool IsComplete(size_t index)const { return Loads.IsComplete(index); }
+    bool IsUploaded(size_t index)const { return Requests[index]->Uploaded; }
+    // Blocks until every load started so far has finished.
+    void Wait() { Loads.Wait(); }
+
+    // Waits, then records the upload of every texture not uploaded yet into batch,
+    // followed by its transition to a pixel shader resource. Throws if a load failed.
+    void Upload(DirectX::ResourceUploadBatch& batch);
+
+    // Records the upload and transition of one completed load. Returns the load's
+    // result; a failed load records nothing.
+    HRESULT Upload(size_t index, DirectX::ResourceUploadBatch& batch);
+    // Throws std::runtime_error naming the file and the HRESULT of a failed load.
+    [[noreturn]] void ThrowLoadError(size_t index)const;
+
+    // Valid once load index is complete.
+    ComPtr<ID3D12Resource> GetResource(size_t index)const { return Requests[index]->Resource; }
+    const SourceInfo& GetSourceInfo(size_t index)const { return Requests[index]->Source; }
+
+    // Frees what is left of a completed load. Its index must not be used again.
+    void Release(size_t index);
+
+private:
+    struct Request
+    {
+        std::wstring Filename;
+        size_t MaxSize = 0;
+        ComPtr<ID3D12Resource> Resource;
+        SourceInfo Source;
+        // file contents, Subresources point into it until the upload is recorded
+        std::unique_ptr<std::uint8_t[]> DdsData;
+        std::vector<D3D12_SUBRESOURCE_DATA> Subresources;
+        HRESULT Result = E_PENDING;
+        bool Uploaded = false;
+    };
+
+    ID3D12Device* Device = nullptr;
+
+    // Workers fill requests through stable pointers while Load keeps appending.
+    // Released requests leave a null entry behind.
+    std::vector<std::unique_ptr<Request>> Requests;
+    // indexed like Requests; declared after them so it waits before they go away
+    LoadTracker Loads;
+};
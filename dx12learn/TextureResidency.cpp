@@ -0,0 +1,203 @@
+#include "TextureResidency.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+TextureResidency::TextureResidency(std::uint64_t budgetBytes) :
+    Budget(budgetBytes)
+{
+}
+
+size_t TextureResidency::AddTexture(const std::vector<std::uint64_t> &levelBytes, unsigned tailMip)
+{
+    assert(!levelBytes.empty() && tailMip < levelBytes.size());
+
+    Entry entry;
+    entry.LevelBytes = levelBytes;
+    entry.TailMip = tailMip;
+    entry.ResidentMip = tailMip;
+    entry.RequestedMip = tailMip;
+    Committed += levelBytes[tailMip];
+    Entries.push_back(entry);
+    return Entries.size() - 1;
+}
+
+void TextureResidency::Request(size_t texture, unsigned mip, float priority)
+{
+    Entry& entry = Entries[texture];
+    if(entry.LastUsedFrame != Frame)
+    {
+        entry.LastUsedFrame = Frame;
+        entry.RequestedMip = entry.TailMip;
+        entry.Priority = 0.0f;
+    }
+    entry.RequestedMip = (std::min)(entry.RequestedMip, mip);
+    entry.Priority = (std::max)(entry.Priority, priority);
+}
+
+const std::vector<TextureResidency::Action>& TextureResidency::Schedule(size_t maxLoads)
+{
+    Actions.clear();
+    EvictCandidatesSorted = false;
+
+    // Textures missing more levels go first at equal priority.
+    LoadCandidates.clear();
+    for(size_t i = 0; i < Entries.size(); ++i)
+    {
+        const Entry& entry = Entries[i];
+        if(entry.LastUsedFrame == Frame && !entry.Loading && entry.RequestedMip < entry.ResidentMip)
+        {
+            LoadCandidates.push_back(i);
+        }
+    }
+    auto urgency = [this](size_t i)
+    {
+        const Entry& entry = Entries[i];
+        return entry.Priority * (float)(entry.ResidentMip - entry.RequestedMip);
+    };
+    std::stable_sort(LoadCandidates.begin(), LoadCandidates.end(), [&urgency](size_t a, size_t b)
+    {
+        return urgency(a) > urgency(b);
+    });
+
+    size_t loads = 0;
+    for(size_t i : LoadCandidates)
+    {
+        if(loads == maxLoads)
+        {
+            break;
+        }
+
+        Entry& entry = Entries[i];
+        unsigned mip = entry.ResidentMip - 1;
+        std::uint64_t growth = entry.LevelBytes[mip] - entry.LevelBytes[entry.ResidentMip];
+        bool fits = true;
+        while(Committed + growth > Budget)
+        {
+            if(!EvictOne(i))
+            {
+                fits = false;
+                break;
+            }
+        }
+        if(!fits)
+        {
+            // nothing left to evict, but a smaller load further down may still fit
+            continue;
+        }
+
+        Begin(entry, i, mip, false);
+        ++loads;
+    }
+
+    ++Frame;
+    return Actions;
+}
+
+bool TextureResidency::EvictOne(size_t keep)
+{
+    if(!EvictCandidatesSorted)
+    {
+        // Textures unused this frame, or holding levels finer than this frame asked
+        // for, can give up a level. Oldest use first, then lowest priority.
+        EvictCandidates.clear();
+        for(size_t i = 0; i < Entries.size(); ++i)
+        {
+            const Entry& entry = Entries[i];
+            bool unused = entry.LastUsedFrame != Frame;
+            if(!entry.Loading && entry.ResidentMip < entry.TailMip && (unused || entry.ResidentMip < entry.RequestedMip))
+            {
+                EvictCandidates.push_back(i);
+            }
+        }
+        std::stable_sort(EvictCandidates.begin(), EvictCandidates.end(), [this](size_t a, size_t b)
+        {
+            const Entry& left = Entries[a];
+            const Entry& right = Entries[b];
+            if(left.LastUsedFrame != right.LastUsedFrame)
+            {
+                return left.LastUsedFrame < right.LastUsedFrame;
+            }
+            return left.Priority < right.Priority;
+        });
+        NextEvictCandidate = 0;
+        EvictCandidatesSorted = true;
+    }
+
+    // One level per texture and frame: the dropped texture is in flight afterwards.
+    for(; NextEvictCandidate < EvictCandidates.size(); ++NextEvictCandidate)
+    {
+        size_t i = EvictCandidates[NextEvictCandidate];
+        Entry& entry = Entries[i];
+        if(i == keep || entry.Loading)
+        {
+            continue;
+        }
+        ++NextEvictCandidate;
+        Begin(entry, i, entry.ResidentMip + 1, true);
+        return true;
+    }
+    return false;
+}
+
+void TextureResidency::Begin(Entry &entry, size_t texture, unsigned mip, bool evict)
+{
+    Committed = Committed - entry.LevelBytes[entry.ResidentMip] + entry.LevelBytes[mip];
+    entry.LoadingMip = mip;
+    entry.Loading = true;
+    ++LoadingCount;
+
+    Action action;
+    action.Texture = texture;
+    action.Mip = mip;
+    action.Evict = evict;
+    Actions.push_back(action);
+}
+
+void TextureResidency::CompleteLoad(size_t texture)
+{
+    Entry& entry = Entries[texture];
+    assert(entry.Loading);
+    entry.ResidentMip = entry.LoadingMip;
+    entry.Loading = false;
+    --LoadingCount;
+}
+
+void TextureResidency::CancelLoad(size_t texture)
+{
+    Entry& entry = Entries[texture];
+    assert(entry.Loading);
+    Committed = Committed - entry.LevelBytes[entry.LoadingMip] + entry.LevelBytes[entry.ResidentMip];
+    entry.Loading = false;
+    --LoadingCount;
+}
+
+unsigned TextureResidency::ComputeDesiredMip(float textureTexels, float screenPixels, unsigned mipCount)
+{
+    if(mipCount <= 1)
+    {
+        return 0;
+    }
+    if(screenPixels < 1.0f)
+    {
+        return mipCount - 1;
+    }
+
+    float ratio = textureTexels / screenPixels;
+    if(ratio <= 1.0f)
+    {
+        return 0;
+    }
+    unsigned mip = (unsigned)floorf(log2f(ratio));
+    return (std::min)(mip, mipCount - 1);
+}
+
+float TextureResidency::ComputeScreenSize(float radius, float distance, float fovY, float viewportHeight)
+{
+    if(distance <= radius)
+    {
+        return viewportHeight;
+    }
+    return (std::min)(radius / (distance * tanf(0.5f * fovY)) * viewportHeight, viewportHeight);
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Decides which mip levels of streamed textures should be resident.
+//
+// Pure bookkeeping without any D3D calls. Every texture has a tail level that
+// always stays resident. Each frame the renderer requests the finest level it
+// needs per texture, with a priority. Schedule then plans loads one level
+// finer than what is resident, most important first. When a load would exceed
+// the memory budget, Schedule first plans evictions: the least recently used
+// textures drop one level each. The caller performs both kinds of action and
+// reports each one through CompleteLoad or CancelLoad.
+class TextureResidency
+{
+public:
+    struct Action
+    {
+        size_t Texture = 0;
+        // level that becomes the finest resident mip
+        unsigned Mip = 0;
+        // true when the texture drops a level to make room
+        bool Evict = false;
+    };
+
+    explicit TextureResidency(std::uint64_t budgetBytes);
+
+    void SetBudget(std::uint64_t budgetBytes) { Budget = budgetBytes; }
+    std::uint64_t GetBudget()const { return Budget; }
+    // Bytes of the resident levels, with actions in flight counted at their target.
+    std::uint64_t GetCommittedBytes()const { return Committed; }
+
+    // levelBytes[m] is the memory a texture takes with mips m..end resident, so it
+    // never grows with m. tailMip is the level loaded up front.
+    size_t AddTexture(const std::vector<std::uint64_t>& levelBytes, unsigned tailMip);
+    size_t GetCount()const { return Entries.size(); }
+
+    // Called for every use of a texture in the current frame. The finest mip and the
+    // highest priority of all calls count.
+    void Request(size_t texture, unsigned mip, float priority);
+
+    // Plans the current frame's actions and starts the next frame. At most maxLoads
+    // loads are planned. A texture with an action in flight is not planned again.
+    const std::vector<Action>& Schedule(size_t maxLoads);
+
+    void CompleteLoad(size_t texture);
+    // The action failed; the texture keeps its previous level.
+    void CancelLoad(size_t texture);
+
+    unsigned GetResidentMip(size_t texture)const { return Entries[texture].ResidentMip; }
+    unsigned GetTailMip(size_t texture)const { return Entries[texture].TailMip; }
+    bool IsLoading(size_t texture)const { return Entries[texture].Loading; }
+    size_t GetLoadingCount()const { return LoadingCount; }
+
+    // Finest mip worth having when textureTexels texels are spread over screenPixels
+    // pixels, one texel per pixel, clamped to [0, mipCount - 1].
+    static unsigned ComputeDesiredMip(float textureTexels, float screenPixels, unsigned mipCount);
+    // Height in pixels covered by a sphere of radius at distance from the eye, for a
+    // perspective projection with vertical field of view fovY.
+    static float ComputeScreenSize(float radius, float distance, float fovY, float viewportHeight);
+
+private:
+    struct Entry
+    {
+        std::vector<std::uint64_t> LevelBytes;
+        unsigned TailMip = 0;
+        unsigned ResidentMip = 0;
+        // target of the action in flight
+        unsigned LoadingMip = 0;
+        bool Loading = false;
+
+        // requests of the current frame
+        unsigned RequestedMip = 0;
+        float Priority = 0.0f;
+        std::uint64_t LastUsedFrame = 0;
+    };
+
+    // Plans one level of eviction on the least recently used texture that can lose
+    // one, other than keep. Returns false when there is none.
+    bool EvictOne(size_t keep);
+    void Begin(Entry& entry, size_t texture, unsigned mip, bool evict);
+
+    std::vector<Entry> Entries;
+    std::uint64_t Budget = 0;
+    std::uint64_t Committed = 0;
+    size_t LoadingCount = 0;
+    // frame whose requests are being collected; 0 means never used
+    std::uint64_t Frame = 1;
+
+    std::vector<Action> Actions;
+    std::vector<size_t> LoadCandidates;
+    // eviction candidates sorted once per Schedule, most recently used last
+    std::vector<size_t> EvictCandidates;
+    size_t NextEvictCandidate = 0;
+    bool EvictCandidatesSorted = false;
+};
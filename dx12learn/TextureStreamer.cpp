@@ -0,0 +1,197 @@
+#include "TextureStreamer.h"
+
+#include <algorithm>
+#include <chrono>
+
+TextureStreamer::TextureStreamer(ID3D12Device *device, ThreadPool &pool, std::uint64_t budgetBytes, UINT framesInFlight) :
+    Device(device),
+    Loader(device, pool),
+    Residency(budgetBytes),
+    UploadBatch(device),
+    FramesInFlight(framesInFlight),
+    // a descriptor is rewritten at the earliest framesInFlight + 1 swaps later
+    DescriptorsPerTexture(framesInFlight + 1)
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+    Loader.Wait();
+    for(std::future<void>& upload : UploadsInFlight)
+    {
+        upload.wait();
+    }
+}
+
+size_t TextureStreamer::Add(const std::wstring &filename)
+{
+    StreamedTexture texture;
+    texture.Filename = filename;
+    texture.Load = Loader.Load(filename, TailSize);
+    Textures.push_back(texture);
+    return Textures.size() - 1;
+}
+
+void TextureStreamer::FinishInitialLoads(DirectX::ResourceUploadBatch &batch)
+{
+    Loader.Wait();
+
+    // No mip fits in the tail, load these whole.
+    bool reloaded = false;
+    for(StreamedTexture& texture : Textures)
+    {
+        if(FAILED(Loader.Upload(texture.Load, batch)))
+        {
+            Loader.Release(texture.Load);
+            texture.Load = Loader.Load(texture.Filename);
+            reloaded = true;
+        }
+    }
+    if(reloaded)
+    {
+        Loader.Wait();
+    }
+
+    for(size_t i = 0; i < Textures.size(); ++i)
+    {
+        StreamedTexture& texture = Textures[i];
+        if(reloaded && !Loader.IsUploaded(texture.Load) && FAILED(Loader.Upload(texture.Load, batch)))
+        {
+            Loader.ThrowLoadError(texture.Load);
+        }
+        texture.Resource = Loader.GetResource(texture.Load);
+        texture.Source = Loader.GetSourceInfo(texture.Load);
+        Loader.Release(texture.Load);
+        texture.Load = NoLoad;
+
+        unsigned tailMip = texture.Source.MipCount - texture.Resource->GetDesc().MipLevels;
+        size_t added = Residency.AddTexture(ComputeLevelBytes(texture, tailMip), tailMip);
+        assert(added == i);
+    }
+}
+
+void TextureStreamer::CreateDescriptors(ID3D12DescriptorHeap *heap, UINT firstDescriptor, UINT descriptorSize)
+{
+    Heap = heap;
+    FirstDescriptor = firstDescriptor;
+    DescriptorSize = descriptorSize;
+    for(size_t i = 0; i < Textures.size(); ++i)
+    {
+        WriteDescriptor(i);
+    }
+}
+
+void TextureStreamer::WriteDescriptor(size_t texture)
+{
+    ID3D12Resource* resource = Textures[texture].Resource.Get();
+
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Format = resource->GetDesc().Format;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MostDetailedMip = 0;
+    srvDesc.Texture2D.MipLevels = resource->GetDesc().MipLevels;
+    srvDesc.Texture2D.ResourceMinLODClamp = 0.0f;
+
+    CD3DX12_CPU_DESCRIPTOR_HANDLE descriptor(Heap->GetCPUDescriptorHandleForHeapStart());
+    descriptor.Offset(GetDescriptorIndex(texture), DescriptorSize);
+    Device->CreateShaderResourceView(resource, &srvDesc, descriptor);
+}
+
+void TextureStreamer::Update(ID3D12CommandQueue *queue)
+{
+    ++Frame;
+
+    // The frame that last sampled a retired resource was before the swap, and the
+    // caller has waited for the frame framesInFlight back.
+    Retired.erase(std::remove_if(Retired.begin(), Retired.end(), [this](const RetiredResource& retired)
+    {
+        return Frame - retired.Frame > FramesInFlight;
+    }), Retired.end());
+
+    UploadsInFlight.erase(std::remove_if(UploadsInFlight.begin(), UploadsInFlight.end(), [](std::future<void>& upload)
+    {
+        if(upload.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+        {
+            return false;
+        }
+        upload.get();
+        return true;
+    }), UploadsInFlight.end());
+
+    // Swap in finished loads. The batch executes on queue before this frame's
+    // command lists, so the new descriptors can be written right away.
+    bool recording = false;
+    size_t kept = 0;
+    for(size_t i : LoadingTextures)
+    {
+        StreamedTexture& texture = Textures[i];
+        if(!Loader.IsComplete(texture.Load))
+        {
+            LoadingTextures[kept++] = i;
+            continue;
+        }
+
+        if(!recording)
+        {
+            UploadBatch.Begin();
+            recording = true;
+        }
+        if(SUCCEEDED(Loader.Upload(texture.Load, UploadBatch)))
+        {
+            Retired.push_back({ texture.Resource, Frame });
+            texture.Resource = Loader.GetResource(texture.Load);
+            texture.Descriptor = (texture.Descriptor + 1) % DescriptorsPerTexture;
+            WriteDescriptor(i);
+            Residency.CompleteLoad(i);
+        }
+        else
+        {
+            Residency.CancelLoad(i);
+        }
+        Loader.Release(texture.Load);
+        texture.Load = NoLoad;
+    }
+    LoadingTextures.resize(kept);
+    if(recording)
+    {
+        UploadsInFlight.push_back(UploadBatch.End(queue));
+    }
+
+    size_t loadsInFlight = Residency.GetLoadingCount();
+    size_t maxLoads = loadsInFlight < MaxLoadsInFlight ? MaxLoadsInFlight - loadsInFlight : 0;
+    for(const TextureResidency::Action& action : Residency.Schedule(maxLoads))
+    {
+        StreamedTexture& texture = Textures[action.Texture];
+        texture.Load = Loader.Load(texture.Filename, GetMaxSize(texture, action.Mip));
+        LoadingTextures.push_back(action.Texture);
+    }
+}
+
+UINT TextureStreamer::GetMaxSize(const StreamedTexture &texture, unsigned mip)const
+{
+    UINT width = (std::max)(texture.Source.Width >> mip, 1u);
+    UINT height = (std::max)(texture.Source.Height >> mip, 1u);
+    return (std::max)(width, height);
+}
+
+std::vector<std::uint64_t> TextureStreamer::ComputeLevelBytes(const StreamedTexture &texture, unsigned tailMip)const
+{
+    D3D12_RESOURCE_DESC desc = texture.Resource->GetDesc();
+    std::vector<std::uint64_t> levelBytes(tailMip + 1);
+    for(unsigned mip = tailMip + 1; mip-- > 0; )
+    {
+        desc.Width = (std::max)(texture.Source.Width >> mip, 1u);
+        desc.Height = (std::max)(texture.Source.Height >> mip, 1u);
+        desc.MipLevels = (UINT16)(texture.Source.MipCount - mip);
+        desc.Alignment = 0;
+        levelBytes[mip] = Device->GetResourceAllocationInfo(0, 1, &desc).SizeInBytes;
+
+        // a description the device rejects still needs a size that grows with the level
+        if(levelBytes[mip] == UINT64_MAX)
+        {
+            levelBytes[mip] = mip < tailMip ? 4 * levelBytes[mip + 1] : 0;
+        }
+    }
+    return levelBytes;
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "D3DUtil.h"
+#include "ResourceUploadBatch.h"
+#include "TextureLoader.h"
+#include "TextureResidency.h"
+
+class ThreadPool;
+
+// Streams the mips of DDS textures under a memory budget.
+//
+// Add loads only the mip tail, the mips no larger than TailSize. After that the
+// renderer requests the level it needs from each texture every frame. Update lets
+// TextureResidency choose loads and evictions. The affected files are reloaded on
+// the worker pool, starting at the new finest mip, and the new resources are
+// swapped in once their upload is recorded.
+//
+// Each level is a separate resource, so a swap also replaces the shader resource
+// view. Every texture owns a ring of descriptors and a swap writes the next one,
+// which leaves the descriptors used by frames in flight untouched.
+class TextureStreamer
+{
+public:
+    static const UINT TailSize = 64;
+    // no new loads are planned while this many loads and evictions are in flight
+    static const size_t MaxLoadsInFlight = 4;
+
+    TextureStreamer(ID3D12Device* device, ThreadPool& pool, std::uint64_t budgetBytes, UINT framesInFlight);
+    TextureStreamer(const TextureStreamer& rhs) = delete;
+    TextureStreamer& operator=(const TextureStreamer& rhs) = delete;
+    ~TextureStreamer();
+
+    // Starts loading the tail of filename and returns the texture's index.
+    size_t Add(const std::wstring& filename);
+    // Waits for the tail loads and records their uploads into batch. Files whose
+    // mips are all larger than TailSize are loaded whole and never streamed.
+    void FinishInitialLoads(DirectX::ResourceUploadBatch& batch);
+
+    size_t GetCount()const { return Textures.size(); }
+    UINT GetWidth(size_t texture)const { return Textures[texture].Source.Width; }
+    UINT GetMipCount(size_t texture)const { return Textures[texture].Source.MipCount; }
+
+    UINT GetDescriptorCount()const { return (UINT)Textures.size() * DescriptorsPerTexture; }
+    // Writes the first descriptor of every texture, the ring starts at heap index
+    // firstDescriptor. Call after FinishInitialLoads.
+    void CreateDescriptors(ID3D12DescriptorHeap* heap, UINT firstDescriptor, UINT descriptorSize);
+    // Heap index of the descriptor to draw texture with this frame.
+    UINT GetDescriptorIndex(size_t texture)const { return FirstDescriptor + (UINT)texture * DescriptorsPerTexture + Textures[texture].Descriptor; }
+
+    void Request(size_t texture, unsigned mip, float priority) { Residency.Request(texture, mip, priority); }
+
+    // Call once per frame, after the requests and after waiting for the frame
+    // resource. Swaps in finished loads, whose uploads go to queue ahead of the
+    // frame's command lists, and starts the loads for the next levels.
+    void Update(ID3D12CommandQueue* queue);
+
+    const TextureResidency& GetResidency()const { return Residency; }
+
+private:
+    static const size_t NoLoad = SIZE_MAX;
+
+    struct StreamedTexture
+    {
+        std::wstring Filename;
+        TextureLoader::SourceInfo Source;
+        ComPtr<ID3D12Resource> Resource;
+        // request in Loader that will replace Resource
+        size_t Load = NoLoad;
+        // current descriptor in the texture's ring
+        UINT Descriptor = 0;
+    };
+
+    // Kept until no frame in flight can still sample it.
+    struct RetiredResource
+    {
+        ComPtr<ID3D12Resource> Resource;
+        std::uint64_t Frame = 0;
+    };
+
+    void WriteDescriptor(size_t texture);
+    // Memory the texture takes at every level from 0 to tailMip.
+    std::vector<std::uint64_t> ComputeLevelBytes(const StreamedTexture& texture, unsigned tailMip)const;
+    UINT GetMaxSize(const StreamedTexture& texture, unsigned mip)const;
+
+    ID3D12Device* Device = nullptr;
+    TextureLoader Loader;
+    TextureResidency Residency;
+    DirectX::ResourceUploadBatch UploadBatch;
+    // an upload batch future blocks when destroyed, so they are dropped once ready
+    std::vector<std::future<void>> UploadsInFlight;
+
+    std::vector<StreamedTexture> Textures;
+    std::vector<size_t> LoadingTextures;
+    std::vector<RetiredResource> Retired;
+
+    UINT FramesInFlight = 0;
+    UINT DescriptorsPerTexture = 0;
+    std::uint64_t Frame = 0;
+
+    ID3D12DescriptorHeap* Heap = nullptr;
+    UINT FirstDescriptor = 0;
+    UINT DescriptorSize = 0;
+};
@@ -0,0 +1,175 @@
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned threadCount)
+{
+    if(threadCount == 0)
+    {
+        unsigned hardwareThreads = std::thread::hardware_concurrency();
+        threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+    }
+
+    for(unsigned i = 0; i < threadCount; ++i)
+    {
+        Queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for(unsigned i = 0; i < threadCount; ++i)
+    {
+        Workers.emplace_back(&ThreadPool::WorkerMain, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(WakeMutex);
+        Stopping = true;
+    }
+    WakeCondition.notify_all();
+
+    for(std::thread& worker : Workers)
+    {
+        worker.join();
+    }
+}
+
+void ThreadPool::Submit(Task task)
+{
+    unsigned index = NextQueue.fetch_add(1, std::memory_order_relaxed) % (unsigned)Queues.size();
+
+    // Count the task before publishing it so a fast worker can never decrement first.
+    {
+        std::lock_guard<std::mutex> lock(WakeMutex);
+        QueuedTaskCount.fetch_add(1, std::memory_order_release);
+    }
+    {
+        std::lock_guard<std::mutex> lock(Queues[index]->Mutex);
+        Queues[index]->Tasks.push_back(std::move(task));
+    }
+    WakeCondition.notify_one();
+}
+
+void ThreadPool::ParallelFor(size_t count, const std::function<void(size_t)>& body)
+{
+    if(count == 0)
+    {
+        return;
+    }
+
+    struct Batch
+    {
+        std::atomic<size_t> Next{ 0 };
+        std::atomic<size_t> Done{ 0 };
+        size_t Count = 0;
+        const std::function<void(size_t)>* Body = nullptr;
+        std::mutex Mutex;
+        std::condition_variable Finished;
+
+        // First exception thrown by Body, guarded by Mutex. Once set, the remaining
+        // indices are still claimed and counted but Body is no longer called.
+        std::exception_ptr Error;
+        std::atomic<bool> Failed{ false };
+
+        // Claims indices until the range is exhausted. Returns once nothing is left
+        // and never throws, so helpers always report their indices as done.
+        void Run()
+        {
+            size_t completed = 0;
+            for(size_t i = Next.fetch_add(1); i < Count; i = Next.fetch_add(1))
+            {
+                if(!Failed.load(std::memory_order_relaxed))
+                {
+                    try
+                    {
+                        (*Body)(i);
+                    }
+                    catch(...)
+                    {
+                        std::lock_guard<std::mutex> lock(Mutex);
+                        if(!Error)
+                        {
+                            Error = std::current_exception();
+                        }
+                        Failed.store(true, std::memory_order_relaxed);
+                    }
+                }
+                ++completed;
+            }
+            if(completed > 0 && Done.fetch_add(completed) + completed == Count)
+            {
+                std::lock_guard<std::mutex> lock(Mutex);
+                Finished.notify_all();
+            }
+        }
+    };
+
+    auto batch = std::make_shared<Batch>();
+    batch->Count = count;
+    batch->Body = &body;
+
+    size_t helperCount = count - 1 < Workers.size() ? count - 1 : Workers.size();
+    for(size_t i = 0; i < helperCount; ++i)
+    {
+        Submit([batch]() { batch->Run(); });
+    }
+
+    batch->Run();
+
+    // Wait even if an index failed: helpers dereference Body until Done reaches Count.
+    std::unique_lock<std::mutex> lock(batch->Mutex);
+    batch->Finished.wait(lock, [&batch]() { return batch->Done.load() == batch->Count; });
+    if(batch->Error)
+    {
+        std::rethrow_exception(batch->Error);
+    }
+}
+
+void ThreadPool::WorkerMain(unsigned index)
+{
+    for(;;)
+    {
+        Task task;
+        if(TryPop(index, task) || TrySteal(index, task))
+        {
+            QueuedTaskCount.fetch_sub(1, std::memory_order_acq_rel);
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(WakeMutex);
+        WakeCondition.wait(lock, [this]() { return Stopping || QueuedTaskCount.load(std::memory_order_acquire) > 0; });
+        if(Stopping && QueuedTaskCount.load(std::memory_order_acquire) == 0)
+        {
+            return;
+        }
+    }
+}
+
+bool ThreadPool::TryPop(unsigned index, Task& task)
+{
+    WorkerQueue& queue = *Queues[index];
+    std::lock_guard<std::mutex> lock(queue.Mutex);
+    if(queue.Tasks.empty())
+    {
+        return false;
+    }
+    task = std::move(queue.Tasks.back());
+    queue.Tasks.pop_back();
+    return true;
+}
+
+bool ThreadPool::TrySteal(unsigned thief, Task& task)
+{
+    unsigned queueCount = (unsigned)Queues.size();
+    for(unsigned offset = 1; offset < queueCount; ++offset)
+    {
+        WorkerQueue& queue = *Queues[(thief + offset) % queueCount];
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        if(!queue.Tasks.empty())
+        {
+            task = std::move(queue.Tasks.front());
+            queue.Tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads. Every worker owns a task deque: it pops its
+// own work from the back and steals from the front of the other deques when idle.
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+    // threadCount == 0 uses one worker per hardware thread except the caller's.
+    explicit ThreadPool(unsigned threadCount = 0);
+    ThreadPool(const ThreadPool& rhs) = delete;
+    ThreadPool& operator=(const ThreadPool& rhs) = delete;
+    ~ThreadPool();
+
+    unsigned GetThreadCount()const { return (unsigned)Workers.size(); }
+
+    // Tasks must handle their own errors: like with std::thread, an exception
+    // escaping a task terminates the process.
+    void Submit(Task task);
+
+    // Runs body(i) for every i in [0, count) and blocks until all calls returned.
+    // The calling thread takes part, so this is safe to call from a worker.
+    // If body throws, the indices not started yet are skipped and the first
+    // exception is rethrown on the calling thread once every helper is done.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& body);
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex Mutex;
+        std::deque<Task> Tasks;
+    };
+
+    void WorkerMain(unsigned index);
+    bool TryPop(unsigned index, Task& task);
+    bool TrySteal(unsigned thief, Task& task);
+
+    std::vector<std::unique_ptr<WorkerQueue>> Queues;
+    std::vector<std::thread> Workers;
+
+    std::mutex WakeMutex;
+    std::condition_variable WakeCondition;
+    std::atomic<size_t> QueuedTaskCount{ 0 };
+    std::atomic<unsigned> NextQueue{ 0 };
+    bool Stopping = false;
+};
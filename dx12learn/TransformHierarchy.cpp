@@ -0,0 +1,116 @@
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+using namespace DirectX;
+
+std::vector<size_t> TransformHierarchy::SortParentsFirst(const std::vector<int> &parents)
+{
+    const size_t count = parents.size();
+
+    // children of every node as contiguous ranges, roots first in their own order
+    std::vector<size_t> childStart(count + 1, 0);
+    std::vector<size_t> roots;
+    for(size_t i = 0; i < count; ++i)
+    {
+        int parent = parents[i];
+        if(parent == NoParent)
+        {
+            roots.push_back(i);
+        }
+        else if(parent < 0 || (size_t)parent >= count)
+        {
+            throw std::runtime_error("transform parent out of range");
+        }
+        else
+        {
+            childStart[parent + 1]++;
+        }
+    }
+    for(size_t i = 0; i < count; ++i)
+    {
+        childStart[i + 1] += childStart[i];
+    }
+    std::vector<size_t> children(childStart[count]);
+    std::vector<size_t> fill(childStart.begin(), childStart.end() - 1);
+    for(size_t i = 0; i < count; ++i)
+    {
+        if(parents[i] != NoParent)
+        {
+            children[fill[parents[i]]++] = i;
+        }
+    }
+
+    // breadth first from the roots; nodes on a cycle are never reached
+    std::vector<size_t> order = roots;
+    order.reserve(count);
+    for(size_t next = 0; next < order.size(); ++next)
+    {
+        size_t node = order[next];
+        order.insert(order.end(), children.begin() + childStart[node], children.begin() + childStart[node + 1]);
+    }
+    if(order.size() != count)
+    {
+        throw std::runtime_error("transform hierarchy has a cycle");
+    }
+    return order;
+}
+
+int TransformHierarchy::AddNode(int parent, const XMFLOAT4X4 &local)
+{
+    int node = (int)Parents.size();
+    assert(parent == NoParent || (parent >= 0 && parent < node));
+
+    Parents.push_back(parent);
+    Locals.emplace_back();
+    XMStoreFloat4x4A(&Locals.back(), XMLoadFloat4x4(&local));
+    Worlds.emplace_back();
+    XMStoreFloat4x4A(&Worlds.back(), XMMatrixIdentity());
+    Dirty.push_back(1);
+    FirstDirty = (std::min)(FirstDirty, (size_t)node);
+    return node;
+}
+
+void TransformHierarchy::SetLocal(int node, const XMFLOAT4X4 &local)
+{
+    XMStoreFloat4x4A(&Locals[node], XMLoadFloat4x4(&local));
+    Dirty[node] = 1;
+    FirstDirty = (std::min)(FirstDirty, (size_t)node);
+}
+
+void TransformHierarchy::Update(std::vector<int> &changed)
+{
+    const size_t count = Parents.size();
+    const size_t firstChanged = changed.size();
+
+    const int* parents = Parents.data();
+    const XMFLOAT4X4A* locals = Locals.data();
+    XMFLOAT4X4A* worlds = Worlds.data();
+    std::uint8_t* dirty = Dirty.data();
+    for(size_t i = FirstDirty; i < count; ++i)
+    {
+        int parent = parents[i];
+        if(parent == NoParent)
+        {
+            if(dirty[i])
+            {
+                worlds[i] = locals[i];
+                changed.push_back((int)i);
+            }
+        }
+        else if(dirty[i] || dirty[parent])
+        {
+            XMStoreFloat4x4A(&worlds[i], XMMatrixMultiply(XMLoadFloat4x4A(&locals[i]), XMLoadFloat4x4A(&worlds[parent])));
+            dirty[i] = 1;
+            changed.push_back((int)i);
+        }
+    }
+
+    for(size_t k = firstChanged; k < changed.size(); ++k)
+    {
+        dirty[changed[k]] = 0;
+    }
+    FirstDirty = count;
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <cstdint>
+#include <vector>
+
+// Parent/child transforms.
+//
+// Nodes are stored parents first, with parent index, local matrix, world matrix
+// and dirty flag in separate arrays, so Update resolves every world matrix in one
+// forward pass: by the time a node is reached its parent is final. Only nodes
+// whose local matrix changed, and their descendants, are recomputed.
+class TransformHierarchy
+{
+public:
+    static const int NoParent = -1;
+
+    // An order in which nodes with these parents can be added, every parent before
+    // its children. parents[i] indexes the same array. Throws on cycles and on
+    // parents out of range.
+    static std::vector<size_t> SortParentsFirst(const std::vector<int>& parents);
+
+    // parent is NoParent or a node added before. Returns the new node.
+    int AddNode(int parent, const DirectX::XMFLOAT4X4& local);
+    size_t GetCount()const { return Parents.size(); }
+
+    int GetParent(int node)const { return Parents[node]; }
+    const DirectX::XMFLOAT4X4& GetLocal(int node)const { return Locals[node]; }
+    // valid for nodes that have been through Update
+    const DirectX::XMFLOAT4X4& GetWorld(int node)const { return Worlds[node]; }
+
+    void SetLocal(int node, const DirectX::XMFLOAT4X4& local);
+
+    // Recomputes the world matrix of every node set since the last call and of all
+    // their descendants, and appends those nodes to changed in ascending order.
+    void Update(std::vector<int>& changed);
+
+private:
+    std::vector<int> Parents;
+    std::vector<DirectX::XMFLOAT4X4A> Locals;
+    std::vector<DirectX::XMFLOAT4X4A> Worlds;
+    // Set by SetLocal; during Update it also marks nodes recomputed so far, which
+    // is how children see that their parent moved.
+    std::vector<std::uint8_t> Dirty;
+    // no node before this one is dirty
+    size_t FirstDirty = 0;
+};
@@ -0,0 +1,137 @@
+#include "VertexPacker.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX::PackedVector;
+
+namespace
+{
+    inline float SignNotZero(float v)
+    {
+        return v >= 0.0f ? 1.0f : -1.0f;
+    }
+}
+
+DirectX::BoundingBox VertexPacker::ComputeBounds(const std::vector<MeshBuilder::Vertex> &vertices)
+{
+    DirectX::BoundingBox bounds;
+    if(vertices.empty())
+    {
+        bounds.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        bounds.Extents = XMFLOAT3(0.0f, 0.0f, 0.0f);
+        return bounds;
+    }
+
+    XMVECTOR minimum = XMLoadFloat3(&vertices[0].Position);
+    XMVECTOR maximum = minimum;
+    for(const MeshBuilder::Vertex& v : vertices)
+    {
+        XMVECTOR p = XMLoadFloat3(&v.Position);
+        minimum = XMVectorMin(minimum, p);
+        maximum = XMVectorMax(maximum, p);
+    }
+    XMStoreFloat3(&bounds.Center, (minimum + maximum) * 0.5f);
+    XMStoreFloat3(&bounds.Extents, (maximum - minimum) * 0.5f);
+    return bounds;
+}
+
+void VertexPacker::GetDequantization(const DirectX::BoundingBox &bounds, XMFLOAT3 &scale, XMFLOAT3 &bias)
+{
+    scale = XMFLOAT3(2.0f * bounds.Extents.x, 2.0f * bounds.Extents.y, 2.0f * bounds.Extents.z);
+    bias = XMFLOAT3(bounds.Center.x - bounds.Extents.x, bounds.Center.y - bounds.Extents.y, bounds.Center.z - bounds.Extents.z);
+}
+
+XMSHORTN2 VertexPacker::EncodeNormal(const XMFLOAT3 &normal)
+{
+    // Project onto the octahedron |x| + |y| + |z| = 1 and fold the lower half over the diagonals.
+    float l1 = fabsf(normal.x) + fabsf(normal.y) + fabsf(normal.z);
+    float x = l1 > 0.0f ? normal.x / l1 : 0.0f;
+    float y = l1 > 0.0f ? normal.y / l1 : 0.0f;
+    if(normal.z < 0.0f)
+    {
+        float foldedX = (1.0f - fabsf(y)) * SignNotZero(x);
+        float foldedY = (1.0f - fabsf(x)) * SignNotZero(y);
+        x = foldedX;
+        y = foldedY;
+    }
+
+    XMSHORTN2 encoded;
+    XMStoreShortN2(&encoded, XMVectorSet(x, y, 0.0f, 0.0f));
+    return encoded;
+}
+
+XMFLOAT3 VertexPacker::DecodeNormal(const XMSHORTN2 &encoded)
+{
+    XMFLOAT2 e;
+    XMStoreFloat2(&e, XMLoadShortN2(&encoded));
+
+    XMFLOAT3 n(e.x, e.y, 1.0f - fabsf(e.x) - fabsf(e.y));
+    float t = (std::max)(-n.z, 0.0f);
+    n.x += n.x >= 0.0f ? -t : t;
+    n.y += n.y >= 0.0f ? -t : t;
+
+    XMFLOAT3 result;
+    XMStoreFloat3(&result, XMVector3Normalize(XMLoadFloat3(&n)));
+    return result;
+}
+
+PackedVertex VertexPacker::Encode(const MeshBuilder::Vertex &vertex, const DirectX::BoundingBox &bounds)
+{
+    XMFLOAT3 scale;
+    XMFLOAT3 bias;
+    GetDequantization(bounds, scale, bias);
+
+    // A flat axis has zero scale; any value decodes to the bias there.
+    XMFLOAT3 unorm(
+        scale.x > 0.0f ? (vertex.Position.x - bias.x) / scale.x : 0.0f,
+        scale.y > 0.0f ? (vertex.Position.y - bias.y) / scale.y : 0.0f,
+        scale.z > 0.0f ? (vertex.Position.z - bias.z) / scale.z : 0.0f);
+
+    PackedVertex packed;
+    XMStoreUShortN4(&packed.Pos, XMVectorSet(unorm.x, unorm.y, unorm.z, 0.0f));
+    packed.Normal = EncodeNormal(vertex.Normal);
+    XMStoreHalf2(&packed.TexC, XMLoadFloat2(&vertex.TexC));
+    return packed;
+}
+
+MeshBuilder::Vertex VertexPacker::Decode(const PackedVertex &vertex, const DirectX::BoundingBox &bounds)
+{
+    XMFLOAT3 scale;
+    XMFLOAT3 bias;
+    GetDequantization(bounds, scale, bias);
+
+    MeshBuilder::Vertex decoded;
+    XMVECTOR unorm = XMLoadUShortN4(&vertex.Pos);
+    XMStoreFloat3(&decoded.Position, unorm * XMLoadFloat3(&scale) + XMLoadFloat3(&bias));
+    decoded.Normal = DecodeNormal(vertex.Normal);
+    decoded.TangentU = XMFLOAT3(0.0f, 0.0f, 0.0f);
+    XMStoreFloat2(&decoded.TexC, XMLoadHalf2(&vertex.TexC));
+    return decoded;
+}
+
+VertexPacker::Precision VertexPacker::MeasureRoundTrip(const std::vector<MeshBuilder::Vertex> &vertices, const DirectX::BoundingBox &bounds)
+{
+    Precision precision;
+    float minNormalDot = 1.0f;
+    for(const MeshBuilder::Vertex& source : vertices)
+    {
+        MeshBuilder::Vertex decoded = Decode(Encode(source, bounds), bounds);
+
+        XMVECTOR positionError = XMLoadFloat3(&decoded.Position) - XMLoadFloat3(&source.Position);
+        precision.MaxPositionError = (std::max)(precision.MaxPositionError, XMVectorGetX(XMVector3Length(positionError)));
+
+        // Meshes without normals (obj files without vn) have nothing to compare.
+        XMVECTOR sourceNormal = XMLoadFloat3(&source.Normal);
+        if(XMVectorGetX(XMVector3Dot(sourceNormal, sourceNormal)) > 1e-6f)
+        {
+            sourceNormal = XMVector3Normalize(sourceNormal);
+            minNormalDot = (std::min)(minNormalDot, XMVectorGetX(XMVector3Dot(sourceNormal, XMLoadFloat3(&decoded.Normal))));
+        }
+
+        precision.MaxTexCError = (std::max)(precision.MaxTexCError, fabsf(decoded.TexC.x - source.TexC.x));
+        precision.MaxTexCError = (std::max)(precision.MaxTexCError, fabsf(decoded.TexC.y - source.TexC.y));
+    }
+    precision.MaxNormalErrorDegrees = XMConvertToDegrees(acosf((std::min)((std::max)(minNormalDot, -1.0f), 1.0f)));
+    return precision;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <DirectXCollision.h>
+#include "PackedVertex.h"
+#include "MeshBuilder/MeshBuilder.h"
+
+// Encode and decode routines for PackedVertex.
+//
+// Positions are quantized relative to a bounding box, so the same box has to be
+// handed to the shader (see ObjectConstants::PositionScale/PositionBias) or to
+// Decode. The decode side mirrors the vertex shader exactly, which is what the
+// precision report below measures.
+class VertexPacker
+{
+public:
+    struct Precision
+    {
+        // Largest position error in object space units.
+        float MaxPositionError = 0.0f;
+        // Largest angle between the source and decoded normal, in degrees.
+        float MaxNormalErrorDegrees = 0.0f;
+        // Largest texture coordinate error.
+        float MaxTexCError = 0.0f;
+    };
+
+    static DirectX::BoundingBox ComputeBounds(const std::vector<MeshBuilder::Vertex>& vertices);
+
+    // Scale and bias that map a decoded unorm position back into the box.
+    static void GetDequantization(const DirectX::BoundingBox& bounds, XMFLOAT3& scale, XMFLOAT3& bias);
+
+    static DirectX::PackedVector::XMSHORTN2 EncodeNormal(const XMFLOAT3& normal);
+    static XMFLOAT3 DecodeNormal(const DirectX::PackedVector::XMSHORTN2& encoded);
+
+    static PackedVertex Encode(const MeshBuilder::Vertex& vertex, const DirectX::BoundingBox& bounds);
+    static MeshBuilder::Vertex Decode(const PackedVertex& vertex, const DirectX::BoundingBox& bounds);
+
+    // Round trips every vertex through Encode and Decode and reports the worst error.
+    static Precision MeasureRoundTrip(const std::vector<MeshBuilder::Vertex>& vertices, const DirectX::BoundingBox& bounds);
+};